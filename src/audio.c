@@ -17,6 +17,22 @@ static int song_volume;
 static int sfx_volume;
 static float sfx_volumef;
 
+/**
+ * Play a sound effect (loading it, if it isn't ready yet)
+ * 
+ * @param aud The sound effect
+ * @param volume The volume
+ */
+static void sfx_play(glAudio aud, float volume) {
+    GFraMe_audio *pAud;
+    
+    if (isSfxMuted)
+        return;
+    pAud = gl_getAudio(aud);
+    if (pAud)
+        GFraMe_audio_play(pAud, volume);
+}
+
 int audio_getVolume() {
     return song_volume;
 }
@@ -61,11 +77,20 @@ void sfx_setVolume(int val) {
 }
 
 
+/**
+ * Mute both songs and sound effects, without ever touching the audio player
+ * (e.g., when running headless)
+ */
+void audio_disable() {
+    isSongMuted = 1;
+    isSfxMuted = 1;
+}
+
 void audio_muteSong() {
     if (!isSongMuted) {
         isSongMuted = 1;
 #if defined(EMCC)
-        GFraMe_audio_player_play_bgm(gl_aud_menu, 0.f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_menu), 0.f);
 #else
         GFraMe_audio_player_play_bgm(0, 0.60f);
 #endif
@@ -105,124 +130,130 @@ void audio_unmuteSong() {
 
 void audio_playMenu() {
     if (curSong != SONG_MENU && !isSongMuted) {
-        GFraMe_audio_player_play_bgm(gl_aud_menu, song_volume / 100.0f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_menu),
+                song_volume / 100.0f);
     }
     curSong = SONG_MENU;
 }
 
 void audio_playIntro() {
     if (curSong != SONG_INTRO && !isSongMuted) {
-        GFraMe_audio_player_play_bgm(gl_aud_intro, song_volume / 100.0f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_intro),
+                song_volume / 100.0f);
     }
     curSong = SONG_INTRO;
 }
 
 void audio_playMovingOn() {
     if (curSong != SONG_MOVINGON && !isSongMuted) {
-        GFraMe_audio_player_play_bgm(gl_aud_movingOn, song_volume / 100.0f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_movingOn),
+                song_volume / 100.0f);
     }
     curSong = SONG_MOVINGON;
 }
 
 void audio_playBoss() {
     if (curSong != SONG_BOSSBATTLE && !isSongMuted) {
-        GFraMe_audio_player_play_bgm(gl_aud_bossBattle, song_volume / 100.0f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_bossBattle),
+                song_volume / 100.0f);
     }
     curSong = SONG_BOSSBATTLE;
 }
 
 void audio_playVictory() {
     if (curSong != SONG_VICTORY && !isSongMuted) {
-        GFraMe_audio_player_play_bgm(gl_aud_victory, song_volume / 100.0f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_victory),
+                song_volume / 100.0f);
     }
     curSong = SONG_VICTORY;
 }
 
 void audio_playTensionGoesUp() {
     if (curSong != SONG_TENSIONGOESUP && !isSongMuted) {
-        GFraMe_audio_player_play_bgm(gl_aud_tensionGoesUp, song_volume / 100.0f);
+        GFraMe_audio_player_play_bgm(gl_getAudio(GL_AUD_tensionGoesUp),
+                song_volume / 100.0f);
     }
     curSong = SONG_TENSIONGOESUP;
 }
 
 void sfx_menuMove() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_menuMove, sfx_volumef);
+    sfx_play(GL_AUD_menuMove, sfx_volumef);
 }
 void sfx_menuSelect() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_menuSelect, sfx_volumef);
+    sfx_play(GL_AUD_menuSelect, sfx_volumef);
 }
 void sfx_text() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_text, sfx_volumef);
+    sfx_play(GL_AUD_text, sfx_volumef);
 }
 void sfx_plJump() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_jump, sfx_volumef);
+    sfx_play(GL_AUD_jump, sfx_volumef);
 }
 void sfx_plHighJump() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_highjump, sfx_volumef);
+    sfx_play(GL_AUD_highjump, sfx_volumef);
 }
 void sfx_teleport() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_teleport, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_teleport, 0.8f * sfx_volumef);
 }
 void sfx_plFall() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_fall, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_fall, 0.8f * sfx_volumef);
 }
 void sfx_switchItem() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_switchItem, sfx_volumef);
+    sfx_play(GL_AUD_switchItem, sfx_volumef);
 }
 void sfx_plDeath() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_plDeath, 1.4f * sfx_volumef);
+    sfx_play(GL_AUD_plDeath, 1.4f * sfx_volumef);
 }
 void sfx_plHurt() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_plHit, 1.5f * sfx_volumef);
+    sfx_play(GL_AUD_plHit, 1.5f * sfx_volumef);
 }
 void sfx_plStep() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_plStep, sfx_volumef);
+    sfx_play(GL_AUD_plStep, sfx_volumef);
 }
 void sfx_bossExpl() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_bossExpl, 0.72f * sfx_volumef);
+    sfx_play(GL_AUD_bossExpl, 0.72f * sfx_volumef);
 }
 void sfx_bossHit() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_plDeath, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_plDeath, 0.8f * sfx_volumef);
 }
 void sfx_jumperJump() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_jumperJump, 0.3f * sfx_volumef);
+    sfx_play(GL_AUD_jumperJump, 0.3f * sfx_volumef);
 }
 void sfx_jumperFall() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_jumperFall, 0.7f * sfx_volumef);
+    sfx_play(GL_AUD_jumperFall, 0.7f * sfx_volumef);
 }
 void sfx_shootEn() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_shootEn, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_shootEn, 0.8f * sfx_volumef);
 }
 void sfx_charger() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_charger, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_charger, 0.8f * sfx_volumef);
 }
 void sfx_shootBoss() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_shootBoss, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_shootBoss, 0.8f * sfx_volumef);
 }
 void sfx_bossMove() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_bossMove, sfx_volumef);
+    sfx_play(GL_AUD_bossMove, sfx_volumef);
 }
 void sfx_bombExpl() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_bombExpl, 0.7f * sfx_volumef);
+    sfx_play(GL_AUD_bombExpl, 0.7f * sfx_volumef);
 }
 void sfx_door() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_door, 0.6f * sfx_volumef);
+    sfx_play(GL_AUD_door, 0.6f * sfx_volumef);
 }
 void sfx_bulHit() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_blHit, sfx_volumef);
+    sfx_play(GL_AUD_blHit, sfx_volumef);
 }
 void sfx_heartUp() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_heartup, sfx_volumef);
+    sfx_play(GL_AUD_heartup, sfx_volumef);
 }
 void sfx_terminal() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_terminal, 0.6f * sfx_volumef);
+    sfx_play(GL_AUD_terminal, 0.6f * sfx_volumef);
 }
 void sfx_getItem() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_getItem, 1.5f * sfx_volumef);
+    sfx_play(GL_AUD_getItem, 1.5f * sfx_volumef);
 }
 void sfx_pause() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_pause, 0.8f * sfx_volumef);
+    sfx_play(GL_AUD_pause, 0.8f * sfx_volumef);
 }
 void sfx_signaler() {
-    if (!isSfxMuted) GFraMe_audio_play(gl_aud_signaler, 0.86f * sfx_volumef);
+    sfx_play(GL_AUD_signaler, 0.86f * sfx_volumef);
 }
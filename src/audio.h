@@ -16,6 +16,8 @@ void sfx_Unmute();
 int sfx_getVolume();
 void sfx_setVolume(int val);
 
+void audio_disable();
+
 void audio_playMenu();
 void audio_playIntro();
 void audio_playMovingOn();
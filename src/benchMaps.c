@@ -0,0 +1,372 @@
+/**
+ * @file src/benchMaps.c
+ * 
+ * Headless benchmark for loading maps (built by 'make bench_maps'). Every
+ * shipped map is loaded (without the cache) a few times, then a fixed set of
+ * pseudo-random rays and areas is tested against its walls, and a JSON
+ * summary is printed to stdout, so it may be compared between commits. No
+ * window nor audio is ever created, so it may run on a machine without a
+ * display (it must be run from the directory containing the 'assets/' one).
+ * 
+ * Usage: bench_maps [iterations]
+ */
+#include <GFraMe/GFraMe_error.h>
+
+#include <SDL2/SDL_timer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "map.h"
+#include "mapCache.h"
+#include "registry.h"
+
+/** Required since GFraMe's header doesn't export it */
+GFraMe_ret GFraMe_assets_clean_filename(char *dst, char *src, int *len);
+
+/** Default number of times each map is loaded */
+#define BENCH_ITERATIONS 10
+/** Map that isn't indexed, but that is loaded by the menu */
+#define BENCH_MENU_MAP "maps/mainmenu.gfm"
+/** Number of rays (and of areas) tested on each map */
+#define BENCH_QUERIES (1 << 20)
+/** Longest ray (and widest/tallest area), in pixels */
+#define BENCH_QUERY_DIM 256
+
+/** Results for a single map */
+struct stBenchResult {
+    /** The map's file */
+    char *fn;
+    /** Size of the map's file, in bytes */
+    long bytes;
+    /** Fastest parse, in milliseconds */
+    double parseMin;
+    /** Total time spent parsing, in milliseconds */
+    double parseTotal;
+    /** Fastest wall generation, in milliseconds */
+    double wallsMin;
+    /** Total time spent generating walls, in milliseconds */
+    double wallsTotal;
+    /** Number of walls */
+    int walls;
+    /** Number of animated tiles */
+    int animTiles;
+    /** Allocations on the first load (i.e., before buffers are recycled) */
+    int allocsFirst;
+    /** Allocations on the last load */
+    int allocsLast;
+    /** Bytes requested on the first load */
+    long allocBytesFirst;
+    /** Rays cast per second */
+    double raysPerSec;
+    /** How many rays hit a wall */
+    int rayHits;
+    /** Areas tested per second */
+    double areasPerSec;
+    /** How many areas overlapped a wall */
+    int areaHits;
+};
+typedef struct stBenchResult benchResult;
+
+/** Number of allocations (malloc, calloc or realloc) since the last reset */
+static int _bench_allocs = 0;
+/** Bytes requested since the last reset */
+static long _bench_allocBytes = 0;
+
+/*
+ * Every allocation is accounted for by wrapping the allocator on link time
+ * (i.e., -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc)
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    _bench_allocs++;
+    _bench_allocBytes += (long)size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t num, size_t size) {
+    _bench_allocs++;
+    _bench_allocBytes += (long)(num * size);
+    return __real_calloc(num, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    _bench_allocs++;
+    _bench_allocBytes += (long)size;
+    return __real_realloc(ptr, size);
+}
+
+/**
+ * Get the size of a map's file
+ * 
+ * @param fn The map's filename (relative to the assets)
+ * @return The file's size or -1, on error
+ */
+static long bench_getFileSize(char *fn) {
+    char name[256];
+    FILE *fp;
+    GFraMe_ret rv;
+    int len;
+    long size;
+    
+    len = sizeof(name);
+    rv = GFraMe_assets_clean_filename(name, fn, &len);
+    if (rv != GFraMe_ret_ok)
+        return -1;
+    
+    fp = fopen(name, "rb");
+    if (!fp)
+        return -1;
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fclose(fp);
+    
+    return size;
+}
+
+/**
+ * Retrieve the next pseudo-random number (so every run tests the same queries)
+ * 
+ * @param pSeed The generator's state
+ * @param max The number's upper bound (exclusive)
+ * @return A number in [0, max)
+ */
+static int bench_rand(unsigned int *pSeed, int max) {
+    *pSeed = *pSeed * 1103515245u + 12345u;
+    return (int)((*pSeed >> 8) % (unsigned int)max);
+}
+
+/**
+ * Get how long has passed since a given time
+ * 
+ * @param start The initial time (from SDL_GetPerformanceCounter)
+ * @return The elapsed time, in milliseconds
+ */
+static double bench_getElapsedMs(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Cast rays and test areas against the currently loaded map
+ * 
+ * @param pRes The map's results
+ * @param pM The map
+ */
+static void bench_queries(benchResult *pRes, map *pM) {
+    unsigned int seed;
+    Uint64 start;
+    double ms;
+    int h, i, w;
+    
+    map_getDimensions(pM, &w, &h);
+    
+    seed = 0x4a4a4154;
+    pRes->rayHits = 0;
+    start = SDL_GetPerformanceCounter();
+    i = 0;
+    while (i < BENCH_QUERIES) {
+        int x, y;
+        
+        x = bench_rand(&seed, w);
+        y = bench_rand(&seed, h);
+        if (map_raycast(NULL, NULL, pM, x, y,
+                x + bench_rand(&seed, BENCH_QUERY_DIM) - BENCH_QUERY_DIM / 2,
+                y + bench_rand(&seed, BENCH_QUERY_DIM) - BENCH_QUERY_DIM / 2)
+                == GFraMe_ret_ok)
+            pRes->rayHits++;
+        i++;
+    }
+    ms = bench_getElapsedMs(start);
+    pRes->raysPerSec = (ms > 0.0) ? BENCH_QUERIES * 1000.0 / ms : 0.0;
+    
+    seed = 0x4a4a4154;
+    pRes->areaHits = 0;
+    start = SDL_GetPerformanceCounter();
+    i = 0;
+    while (i < BENCH_QUERIES) {
+        int x, y;
+        
+        x = bench_rand(&seed, w);
+        y = bench_rand(&seed, h);
+        if (map_isAreaSolid(pM, x, y, 1 + bench_rand(&seed, BENCH_QUERY_DIM),
+                1 + bench_rand(&seed, BENCH_QUERY_DIM)) == GFraMe_ret_ok)
+            pRes->areaHits++;
+        i++;
+    }
+    ms = bench_getElapsedMs(start);
+    pRes->areasPerSec = (ms > 0.0) ? BENCH_QUERIES * 1000.0 / ms : 0.0;
+}
+
+/**
+ * Load a map a few times and accumulate its results
+ * 
+ * @param pRes The map's results (its fn must be set)
+ * @param pM The map
+ * @param index The map's index (or -1 for the menu's map)
+ * @param iterations How many times it should be loaded
+ * @return GFraMe error code
+ */
+static GFraMe_ret bench_map(benchResult *pRes, map *pM, int index,
+    int iterations) {
+    GFraMe_ret rv;
+    int i;
+    
+    pRes->bytes = bench_getFileSize(pRes->fn);
+    
+    i = 0;
+    while (i < iterations) {
+        mapLoadStats stats;
+        
+        _bench_allocs = 0;
+        _bench_allocBytes = 0;
+        
+        if (index >= 0) {
+            rv = map_loadi(pM, index);
+            ASSERT_NR(rv == GFraMe_ret_ok);
+        }
+        else {
+            rv = map_loadf(pM, pRes->fn);
+            ASSERT_NR(rv == GFraMe_ret_ok);
+            // Walls are only generated on the following update
+            map_update(pM, 0);
+        }
+        map_getLoadStats(&stats, pM);
+        
+        if (i == 0 || stats.parseMs < pRes->parseMin)
+            pRes->parseMin = stats.parseMs;
+        if (i == 0 || stats.wallsMs < pRes->wallsMin)
+            pRes->wallsMin = stats.wallsMs;
+        pRes->parseTotal += stats.parseMs;
+        pRes->wallsTotal += stats.wallsMs;
+        pRes->walls = stats.walls;
+        pRes->animTiles = stats.animTiles;
+        if (i == 0) {
+            pRes->allocsFirst = _bench_allocs;
+            pRes->allocBytesFirst = _bench_allocBytes;
+        }
+        pRes->allocsLast = _bench_allocs;
+        
+        i++;
+    }
+    
+    bench_queries(pRes, pM);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Print every result as JSON
+ * 
+ * @param pRes The results
+ * @param num How many results there are
+ * @param iterations How many times each map was loaded
+ */
+static void bench_print(benchResult *pRes, int num, int iterations) {
+    double areas, parse, rays, walls;
+    long bytes;
+    int i;
+    
+    parse = 0.0;
+    walls = 0.0;
+    rays = 0.0;
+    areas = 0.0;
+    bytes = 0;
+    
+    printf("{\n");
+    printf("  \"iterations\": %i,\n", iterations);
+    printf("  \"maps\": [\n");
+    i = 0;
+    while (i < num) {
+        benchResult *pR;
+        
+        pR = &pRes[i];
+        printf("    {\"file\": \"%s\", \"bytes\": %li, "
+            "\"parseMs\": {\"min\": %.4f, \"avg\": %.4f}, "
+            "\"genWallsMs\": {\"min\": %.4f, \"avg\": %.4f}, "
+            "\"walls\": %i, \"animTiles\": %i, "
+            "\"allocs\": {\"first\": %i, \"last\": %i, \"firstBytes\": %li}, "
+            "\"rays\": {\"perSec\": %.0f, \"hits\": %i}, "
+            "\"areas\": {\"perSec\": %.0f, \"hits\": %i}}%s\n",
+            pR->fn, pR->bytes, pR->parseMin, pR->parseTotal / iterations,
+            pR->wallsMin, pR->wallsTotal / iterations, pR->walls,
+            pR->animTiles, pR->allocsFirst, pR->allocsLast,
+            pR->allocBytesFirst, pR->raysPerSec, pR->rayHits,
+            pR->areasPerSec, pR->areaHits, (i + 1 < num) ? "," : "");
+        
+        parse += pR->parseMin;
+        walls += pR->wallsMin;
+        rays += pR->raysPerSec;
+        areas += pR->areasPerSec;
+        bytes += pR->bytes;
+        i++;
+    }
+    printf("  ],\n");
+    printf("  \"total\": {\"maps\": %i, \"bytes\": %li, \"parseMs\": %.4f, "
+        "\"genWallsMs\": %.4f, \"raysPerSec\": %.0f, \"areasPerSec\": %.0f}\n",
+        num, bytes, parse, walls, rays / num, areas / num);
+    printf("}\n");
+}
+
+int main(int argc, char *argv[]) {
+    benchResult *pRes;
+    GFraMe_ret rv;
+    int i, iterations, num;
+    map *pM;
+    
+    pM = NULL;
+    pRes = NULL;
+    
+    iterations = BENCH_ITERATIONS;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    GFraMe_assertRV(iterations > 0, "Usage: bench_maps [iterations]",
+        rv = GFraMe_ret_bad_param, __ret);
+    
+    // Every load must actually parse the map
+    mc_setMaxMemory(0);
+    
+    rv = rg_init();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init registry", __ret);
+    rv = map_init(&pM);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init map", __ret);
+    
+    // Count every indexed map (plus the menu's one)
+    num = 0;
+    while (map_getFilename(num))
+        num++;
+    pRes = (benchResult*)calloc(num + 1, sizeof(benchResult));
+    GFraMe_assertRV(pRes, "Failed to alloc results", rv = GFraMe_ret_memory_error,
+        __ret);
+    
+    i = 0;
+    while (i < num) {
+        pRes[i].fn = map_getFilename(i);
+        rv = bench_map(&pRes[i], pM, i, iterations);
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+        i++;
+    }
+    pRes[num].fn = BENCH_MENU_MAP;
+    rv = bench_map(&pRes[num], pM, -1, iterations);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    
+    bench_print(pRes, num + 1, iterations);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    if (pRes)
+        free(pRes);
+    map_clean(&pM);
+    mc_clean();
+    rg_clean();
+    
+    return rv;
+}
+
@@ -0,0 +1,366 @@
+/**
+ * @file src/benchStress.c
+ * 
+ * Headless benchmark for how updates scale with the number of entities (built
+ * by 'make bench_stress'). A synthetic map (see stressMap.h) is generated for
+ * an increasing number of each entity (on a 1-3-10 sequence, from 100 to
+ * 10000, by default), loaded from memory and updated a fixed number of times
+ * (by the same function the playstate uses), timing every phase of the update
+ * on its own. A JSON summary is printed to stdout, so it may be compared
+ * between commits. No window nor audio is ever created, so it may run on a
+ * machine without a display.
+ * 
+ * Unless '--lod' is set, every mob is updated regardless of where the camera
+ * is, so the worst case is measured.
+ * 
+ * Usage: bench_stress [--ticks N] [--min N] [--max N] [--cols N] [--seed N]
+ *                     [--lod] [--dump PREFIX]
+ * 
+ * (--cols sets how many rooms there are on each row, instead of making the
+ * maps roughly square, and --dump writes each generated map into
+ * PREFIX<N>.gfm)
+ */
+#include <GFraMe/GFraMe_error.h>
+
+#include <SDL2/SDL_timer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio.h"
+#include "camera.h"
+#include "controller.h"
+#include "global.h"
+#include "globalVar.h"
+#include "map.h"
+#include "mob.h"
+#include "player.h"
+#include "playstate.h"
+#include "registry.h"
+#include "save.h"
+#include "stressMap.h"
+#include "triggerGrid.h"
+#include "types.h"
+
+#include "quadtree/quadtree.h"
+
+/** Default number of updates simulated on each map */
+#define BENCH_TICKS 300
+/** Default number of each entity on the first map */
+#define BENCH_MIN 100
+/** Default (maximum) number of each entity on the last map */
+#define BENCH_MAX 10000
+
+/** Labels of every phase */
+static char *_bench_phaseLabels[PS_PHASE_MAX] = {
+#define X(phase, label) \
+    label,
+    PS_PHASES
+#undef X
+};
+
+/** Results for a single map */
+struct stBenchResult {
+    /** How many of each entity there are */
+    int num;
+    /** Map's width, in tiles */
+    int w;
+    /** Map's height, in tiles */
+    int h;
+    /** Size of the generated map, in bytes */
+    int bytes;
+    /** Time spent generating the map, in milliseconds */
+    double genMs;
+    /** Time spent parsing the map, in milliseconds */
+    double parseMs;
+    /** Time spent generating walls (on the first update), in milliseconds */
+    double wallsMs;
+    /** Number of walls */
+    int walls;
+    /** Number of mobs (as loaded) */
+    int mobs;
+    /** Number of objects */
+    int objects;
+    /** Number of events */
+    int events;
+    /** Number of updates */
+    int ticks;
+    /** Total time spent updating, in milliseconds */
+    double tickTotal;
+    /** Slowest update, in milliseconds */
+    double tickMax;
+    /** Total time spent on each phase, in milliseconds */
+    double phaseTotal[PS_PHASE_MAX];
+    /** Slowest update of each phase, in milliseconds */
+    double phaseMax[PS_PHASE_MAX];
+};
+typedef struct stBenchResult benchResult;
+
+/** Time when the current phase started */
+static Uint64 _bench_phaseStart = 0;
+
+/**
+ * Get how long has passed since a given time
+ * 
+ * @param start The initial time (from SDL_GetPerformanceCounter)
+ * @return The elapsed time, in milliseconds
+ */
+static double bench_getElapsedMs(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Stop timing the phase that just finished, accumulate it and start timing
+ * the next one (called by the playstate after each phase of an update)
+ * 
+ * @param phase The phase that just finished
+ * @param pCtx The map's results
+ */
+static void bench_onPhase(psPhase phase, void *pCtx) {
+    benchResult *pRes;
+    double ms;
+    
+    pRes = (benchResult*)pCtx;
+    ms = bench_getElapsedMs(_bench_phaseStart);
+    pRes->phaseTotal[phase] += ms;
+    if (ms > pRes->phaseMax[phase])
+        pRes->phaseMax[phase] = ms;
+    _bench_phaseStart = SDL_GetPerformanceCounter();
+}
+
+/**
+ * Generate a map, load it and update it a few times
+ * 
+ * @param pRes The map's results
+ * @param ppStr Buffer for the generated map (recycled between maps)
+ * @param pBufLen Size of the buffer
+ * @param pParams The map's parameters
+ * @param ticks How many times it should be updated
+ * @param stepMs Duration of each update, in milliseconds
+ * @param lod Whether mobs far from the camera may be simplified
+ * @param dump Prefix of the file where the map is written (or NULL)
+ * @return GFraMe error code
+ */
+static GFraMe_ret bench_run(benchResult *pRes, char **ppStr, int *pBufLen,
+        stressParams *pParams, int ticks, int stepMs, int lod, char *dump) {
+    mapLoadStats stats;
+    GFraMe_ret rv;
+    Uint64 start;
+    int i, len;
+    
+    memset(pRes, 0x0, sizeof(benchResult));
+    pRes->num = pParams->num;
+    
+    start = SDL_GetPerformanceCounter();
+    rv = sm_generate(ppStr, &len, pBufLen, pParams);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to generate map", __ret);
+    pRes->genMs = bench_getElapsedMs(start);
+    pRes->bytes = len;
+    
+    if (dump) {
+        char name[256];
+        FILE *fp;
+        
+        snprintf(name, sizeof(name), "%s%i.gfm", dump, pParams->num);
+        fp = fopen(name, "wb");
+        GFraMe_assertRV(fp, "Failed to dump map", rv = GFraMe_ret_failed,
+            __ret);
+        fwrite(*ppStr, 1, len, fp);
+        fclose(fp);
+    }
+    
+    // Every run starts from the same state
+    gv_init();
+    player_clean(&p1);
+    player_clean(&p2);
+    rv = player_init(&p1, ID_PL1, 224, SM_SPAWN_X, SM_SPAWN_Y);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init player", __ret);
+    rv = player_init(&p2, ID_PL2, 240, SM_SPAWN_X, SM_SPAWN_Y);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init player", __ret);
+    
+    rv = map_loads(m, *ppStr, len);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    rv = sm_spawnBullets(pParams);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to spawn bullets", __ret);
+    map_getDimensions(m, &pRes->w, &pRes->h);
+    pRes->w /= 8;
+    pRes->h /= 8;
+    pRes->mobs = rg_getMobsUsed();
+    pRes->objects = rg_getObjectsUsed();
+    pRes->events = rg_getEventsUsed();
+    
+    cam_setPositionSt(p1, p2);
+    if (lod)
+        mob_setLodMargin(MOB_LOD_MARGIN);
+    else
+        mob_setLodMargin(pRes->w * 8 + pRes->h * 8);
+    
+    i = 0;
+    while (i < ticks) {
+        double ms;
+        
+        start = SDL_GetPerformanceCounter();
+        _bench_phaseStart = start;
+        rv = playstate_updateWorld(stepMs, &bench_onPhase, pRes);
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to update", __ret);
+        ms = bench_getElapsedMs(start);
+        pRes->tickTotal += ms;
+        if (ms > pRes->tickMax)
+            pRes->tickMax = ms;
+        i++;
+    }
+    pRes->ticks = ticks;
+    
+    // Walls are only generated on the first update
+    map_getLoadStats(&stats, m);
+    pRes->parseMs = stats.parseMs;
+    pRes->wallsMs = stats.wallsMs;
+    pRes->walls = stats.walls;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Print every result as JSON
+ * 
+ * @param pRes The results
+ * @param num How many results there are
+ * @param stepMs Duration of each update, in milliseconds
+ * @param lod Whether mobs far from the camera were simplified
+ */
+static void bench_print(benchResult *pRes, int num, int stepMs, int lod) {
+    int i, j;
+    
+    printf("{\n");
+    printf("  \"stepMs\": %i,\n", stepMs);
+    printf("  \"lod\": %i,\n", lod);
+    printf("  \"runs\": [\n");
+    i = 0;
+    while (i < num) {
+        benchResult *pR;
+        
+        pR = &pRes[i];
+        printf("    {\"num\": %i, \"w\": %i, \"h\": %i, \"bytes\": %i, "
+            "\"genMs\": %.4f, \"parseMs\": %.4f, \"genWallsMs\": %.4f, "
+            "\"walls\": %i, \"mobs\": %i, \"objects\": %i, \"events\": %i, "
+            "\"ticks\": %i, \"tickMs\": {\"avg\": %.4f, \"max\": %.4f}, "
+            "\"phases\": {", pR->num, pR->w, pR->h, pR->bytes, pR->genMs,
+            pR->parseMs, pR->wallsMs, pR->walls, pR->mobs, pR->objects,
+            pR->events, pR->ticks, pR->tickTotal / pR->ticks, pR->tickMax);
+        j = 0;
+        while (j < PS_PHASE_MAX) {
+            printf("\"%s\": {\"avg\": %.4f, \"max\": %.4f}%s",
+                _bench_phaseLabels[j], pR->phaseTotal[j] / pR->ticks,
+                pR->phaseMax[j], (j + 1 < PS_PHASE_MAX) ? ", " : "");
+            j++;
+        }
+        printf("}}%s\n", (i + 1 < num) ? "," : "");
+        i++;
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+int main(int argc, char *argv[]) {
+    benchResult *pRes;
+    char *dump, *pStr;
+    GFraMe_ret rv;
+    int bufLen, i, lod, max, min, num, stepMs, ticks;
+    stressParams params;
+    
+    pRes = NULL;
+    pStr = NULL;
+    bufLen = 0;
+    
+    memset(&params, 0x0, sizeof(stressParams));
+    ticks = BENCH_TICKS;
+    min = BENCH_MIN;
+    max = BENCH_MAX;
+    stepMs = 1000 / GAME_UFPS;
+    lod = 0;
+    dump = NULL;
+    i = 1;
+    while (i < argc) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--min") == 0 && i + 1 < argc)
+            min = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            max = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cols") == 0 && i + 1 < argc)
+            params.cols = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            params.seed = (unsigned int)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--lod") == 0)
+            lod = 1;
+        else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc)
+            dump = argv[++i];
+        else
+            break;
+        i++;
+    }
+    GFraMe_assertRV(i == argc && ticks > 0 && min > 0 && max >= min
+        && params.cols >= 0, "Usage: bench_stress [--ticks N] [--min N] "
+        "[--max N] [--cols N] [--seed N] [--lod] [--dump PREFIX]",
+        rv = GFraMe_ret_bad_param, __ret);
+    
+    // Never touch the save files, the audio device nor the renderer
+    setup_volatile_blocks();
+    audio_disable();
+    rv = gl_initHeadless();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "global init failed", __ret);
+    // Nobody is playing
+    ctr_setInjection(1);
+    
+    rv = rg_init();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init registry", __ret);
+    rv = map_init(&m);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init map", __ret);
+    
+    // Count how many maps there are (on a 1-3-10 sequence)
+    num = 0;
+    params.num = min;
+    while (params.num <= max) {
+        num++;
+        params.num = (params.num % 3 == 0) ? params.num * 10 / 3
+                : params.num * 3;
+    }
+    pRes = (benchResult*)calloc(num, sizeof(benchResult));
+    GFraMe_assertRV(pRes, "Failed to alloc results", rv = GFraMe_ret_memory_error,
+        __ret);
+    
+    i = 0;
+    params.num = min;
+    while (i < num) {
+        rv = bench_run(&pRes[i], &pStr, &bufLen, &params, ticks, stepMs, lod,
+            dump);
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to run map", __ret);
+        params.num = (params.num % 3 == 0) ? params.num * 10 / 3
+                : params.num * 3;
+        i++;
+    }
+    
+    bench_print(pRes, num, stepMs, lod);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    if (pRes)
+        free(pRes);
+    if (pStr)
+        free(pStr);
+    map_clean(&m);
+    player_clean(&p1);
+    player_clean(&p2);
+    rg_clean();
+    qt_clean();
+    tg_clean();
+    ctr_setInjection(0);
+    gl_clean();
+    
+    return rv;
+}
+
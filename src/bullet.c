@@ -16,6 +16,8 @@
 #include "bullet.h"
 #include "camera.h"
 #include "global.h"
+#include "interp.h"
+#include "profiler.h"
 #include "registry.h"
 #include "types.h"
 
@@ -29,6 +31,7 @@ typedef enum { PROJ_INIT=0, PROJ_DEF, PROJ_EXPLODE, PROJ_NONE } projState;
 struct stBullet {
     GFraMe_sprite spr;
     projState state;
+    ipPos ip;
     int animLen;
     GFraMe_animation anim[BUL_ANIM_MAX];
 };
@@ -159,6 +162,9 @@ GFraMe_ret bullet_init(bullet *pBul, flag type, int cx, int cy, int dstCX, int d
     pObj->vy = vy * d;
     
     pSpr->id = type;
+    // Start interpolating from the spawn position (instead of from wherever
+    // the slot's previous bullet was)
+    ip_save(&pBul->ip, pObj->x, pObj->y);
     
     // Set all animations
     if (pData) {
@@ -269,12 +275,22 @@ __ret:
 void bullet_draw(bullet *pBul) {
     ASSERT_NR(pBul->state != PROJ_NONE);
     
-    GFraMe_sprite_draw_camera(&pBul->spr, cam_x, cam_y, SCR_W, SCR_H);
+    PROF_SPRITE_DRAW(BULLETS, &pBul->spr, cam_x, cam_y, SCR_W, SCR_H);
     
 __ret:
     return;
 }
 
+/**
+ * Get the bullet's interpolated position (see ip_object)
+ * 
+ * @param ppPos The bullet's interpolated position
+ * @param pBul The bullet
+ */
+void bullet_getIpPos(ipPos **ppPos, bullet *pBul) {
+    *ppPos = &pBul->ip;
+}
+
 /**
  * Updates a bullet
  * 
@@ -365,3 +381,13 @@ __ret:
     return rv;
 }
 
+/**
+ * Save/restore a bullet on a checkpoint
+ * 
+ * @param pBul The bullet
+ * @param pCp The checkpoint
+ */
+void bullet_checkpoint(bullet *pBul, checkpoint *pCp) {
+    cp_field(pCp, pBul, sizeof(bullet));
+}
+
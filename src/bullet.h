@@ -9,6 +9,8 @@
 #include <GFraMe/GFraMe_error.h>
 #include <GFraMe/GFraMe_object.h>
 
+#include "checkpoint.h"
+#include "interp.h"
 #include "types.h"
 
 /** Export the bullet's type */
@@ -88,6 +90,14 @@ void bullet_setAnim(bullet *pBul, int anim);
  */
 void bullet_draw(bullet *pBul);
 
+/**
+ * Get the bullet's interpolated position (see ip_object)
+ * 
+ * @param ppPos The bullet's interpolated position
+ * @param pBul The bullet
+ */
+void bullet_getIpPos(ipPos **ppPos, bullet *pBul);
+
 /**
  * Updates a bullet
  * 
@@ -105,5 +115,13 @@ void bullet_update(bullet *pBul, int ms);
  */
 GFraMe_ret bullet_fireworks(int cx, int cy);
 
+/**
+ * Save/restore a bullet on a checkpoint
+ * 
+ * @param pBul The bullet
+ * @param pCp The checkpoint
+ */
+void bullet_checkpoint(bullet *pBul, checkpoint *pCp);
+
 #endif
 
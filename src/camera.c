@@ -6,6 +6,7 @@
 #include "camera.h"
 #include "global.h"
 #include "globalVar.h"
+#include "interp.h"
 
 #define CAM_DEAD_X 80
 #define CAM_DEAD_Y 32
@@ -22,6 +23,8 @@ static int cam_map_w;
 static int cam_map_h;
 /** Players' last horizontal center position */
 static int last_x = 0;
+/** Camera's position before the last update */
+static ipPos cam_ip;
 
 /**
  * Try to center the camera on both players
@@ -117,3 +120,31 @@ void cam_setMapDimension(int w, int h) {
     cam_map_h = h;
 }
 
+/**
+ * Run a step of interpolating the camera (see ip_object)
+ * 
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+void cam_interpolate(ipStep step, int alpha) {
+    switch (step) {
+        case IP_SAVE: ip_save(&cam_ip, cam_x, cam_y); break;
+        case IP_BEGIN: ip_begin(&cam_ip, &cam_x, &cam_y, alpha); break;
+        case IP_END: ip_end(&cam_ip, &cam_x, &cam_y); break;
+    }
+}
+
+/**
+ * Save/restore the camera on a checkpoint
+ * 
+ * @param pCp The checkpoint
+ */
+void cam_checkpoint(checkpoint *pCp) {
+    cp_field(pCp, &cam_x, sizeof(cam_x));
+    cp_field(pCp, &cam_y, sizeof(cam_y));
+    cp_field(pCp, &cam_map_w, sizeof(cam_map_w));
+    cp_field(pCp, &cam_map_h, sizeof(cam_map_h));
+    cp_field(pCp, &last_x, sizeof(last_x));
+    cp_field(pCp, &cam_ip, sizeof(cam_ip));
+}
+
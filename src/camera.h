@@ -6,6 +6,8 @@
 #ifndef __CAMERA_H_
 #define __CAMERA_H_
 
+#include "checkpoint.h"
+#include "interp.h"
 #include "player.h"
 
 /** Current camera's horizontal position */
@@ -36,5 +38,20 @@ void cam_setPosition();
  */
 void cam_setMapDimension(int w, int h);
 
+/**
+ * Run a step of interpolating the camera (see ip_object)
+ * 
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+void cam_interpolate(ipStep step, int alpha);
+
+/**
+ * Save/restore the camera on a checkpoint
+ * 
+ * @param pCp The checkpoint
+ */
+void cam_checkpoint(checkpoint *pCp);
+
 #endif
 
@@ -0,0 +1,145 @@
+/**
+ * @file src/checkpoint.c
+ * 
+ * Snapshot of the whole simulation, restored on death/retry
+ */
+#include <GFraMe/GFraMe_error.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "camera.h"
+#include "checkpoint.h"
+#include "global.h"
+#include "globalVar.h"
+#include "map.h"
+#include "player.h"
+#include "registry.h"
+#include "signal.h"
+
+/** What's being done to each field */
+typedef enum {
+    CP_MEASURE,
+    CP_SAVE,
+    CP_RESTORE
+} cpMode;
+
+struct stCheckpoint {
+    /** What's being done to each field */
+    cpMode mode;
+    /** Current position on the blob (or how many bytes were measured) */
+    int pos;
+};
+
+/** Every field, one after the other */
+static char *_cp_blob = 0;
+/** Size of the blob's buffer */
+static int _cp_len = 0;
+/** How many bytes were captured (or 0, if there's no valid checkpoint) */
+static int _cp_used = 0;
+
+/**
+ * Describe a piece of a module's state; Depending on what's being done, it's
+ * either measured, copied into the checkpoint or copied back from it
+ * 
+ * @param pCp The checkpoint
+ * @param pData The memory
+ * @param len How many bytes there are
+ */
+void cp_field(checkpoint *pCp, void *pData, int len) {
+    switch (pCp->mode) {
+        case CP_MEASURE: break;
+        case CP_SAVE: memcpy(_cp_blob + pCp->pos, pData, len); break;
+        case CP_RESTORE: memcpy(pData, _cp_blob + pCp->pos, len); break;
+    }
+    pCp->pos += len;
+}
+
+/**
+ * Describe every module's state; Registry buffers store how many objects are
+ * in use before those objects, so they are restored before being iterated
+ * 
+ * @param pCp The checkpoint
+ */
+static void cp_describe(checkpoint *pCp) {
+    gv_checkpoint(pCp);
+    player_checkpoint(p1, pCp);
+    player_checkpoint(p2, pCp);
+    rg_checkpoint(pCp);
+    map_checkpoint(m, pCp);
+    signal_checkpoint(pCp);
+    cam_checkpoint(pCp);
+}
+
+/**
+ * Capture the current state of the simulation; Must only be called when the
+ * map is fully loaded
+ * 
+ * @return GFraMe error code
+ */
+GFraMe_ret cp_save() {
+    checkpoint cp;
+    GFraMe_ret rv;
+    
+    _cp_used = 0;
+    
+    cp.mode = CP_MEASURE;
+    cp.pos = 0;
+    cp_describe(&cp);
+    
+    // Only ever expand the blob here, so restoring it never allocates
+    if (cp.pos > _cp_len) {
+        char *tmp;
+        
+        tmp = (char*)realloc(_cp_blob, cp.pos);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        _cp_blob = tmp;
+        _cp_len = cp.pos;
+    }
+    
+    cp.mode = CP_SAVE;
+    cp.pos = 0;
+    cp_describe(&cp);
+    _cp_used = cp.pos;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Restore the last captured state
+ * 
+ * @return GFraMe error code (GFraMe_ret_failed, if there's none)
+ */
+GFraMe_ret cp_restore() {
+    checkpoint cp;
+    
+    if (_cp_used == 0)
+        return GFraMe_ret_failed;
+    
+    cp.mode = CP_RESTORE;
+    cp.pos = 0;
+    cp_describe(&cp);
+    
+    return GFraMe_ret_ok;
+}
+
+/**
+ * Discard the captured state (e.g., because another map is being loaded)
+ */
+void cp_invalidate() {
+    _cp_used = 0;
+}
+
+/**
+ * Release the checkpoint's memory
+ */
+void cp_clean() {
+    if (_cp_blob)
+        free(_cp_blob);
+    _cp_blob = 0;
+    _cp_len = 0;
+    _cp_used = 0;
+}
+
@@ -0,0 +1,61 @@
+/**
+ * @file src/checkpoint.h
+ * 
+ * Snapshot of the whole simulation (global variables, both players, every
+ * entity on the registry, the map's tiles, the signal and the camera) into a
+ * single contiguous blob. It's taken whenever a map is entered and restored
+ * when a player dies (or both retry), so the map doesn't have to be reloaded.
+ * 
+ * Every module describes its state through a single function (e.g.,
+ * 'cam_checkpoint'), which calls 'cp_field' for each piece of memory; The
+ * same function is used to measure, save and restore the state, so those
+ * can never get out of sync.
+ * 
+ * Since every entity is allocated only once (and never moved) and the map's
+ * buffers are only reallocated when a map is loaded, restoring it is simply a
+ * memcpy per piece, without parsing nor allocating anything.
+ */
+#ifndef __CHECKPOINT_H_
+#define __CHECKPOINT_H_
+
+#include <GFraMe/GFraMe_error.h>
+
+typedef struct stCheckpoint checkpoint;
+
+/**
+ * Describe a piece of a module's state; Depending on what's being done, it's
+ * either measured, copied into the checkpoint or copied back from it
+ * 
+ * @param pCp The checkpoint
+ * @param pData The memory
+ * @param len How many bytes there are
+ */
+void cp_field(checkpoint *pCp, void *pData, int len);
+
+/**
+ * Capture the current state of the simulation; Must only be called when the
+ * map is fully loaded
+ * 
+ * @return GFraMe error code
+ */
+GFraMe_ret cp_save();
+
+/**
+ * Restore the last captured state
+ * 
+ * @return GFraMe error code (GFraMe_ret_failed, if there's none)
+ */
+GFraMe_ret cp_restore();
+
+/**
+ * Discard the captured state (e.g., because another map is being loaded)
+ */
+void cp_invalidate();
+
+/**
+ * Release the checkpoint's memory
+ */
+void cp_clean();
+
+#endif
+
@@ -13,28 +13,20 @@
 #include "global.h"
 #include "globalVar.h"
 #include "object.h"
+#include "perfectHash.h"
 #include "player.h"
 #include "playstate.h"
 #include "registry.h"
 #include "types.h"
 
-static char *_ce_names[CE_MAX+1] = {
-    "ce_open_door",
-    "ce_close_door",
-    "ce_switch_door",
-    "ce_handle_door",
-    "ce_handle_notdoor",
-    "ce_switch_map",
-    "ce_get_item",
-    "ce_hidden_path",
-    "ce_unhide_on_gv", // actualy CE_UNHIDE_HEART
-    "ce_inc_maxhp",
-    "ce_set_gv",
-    "ce_set_anim_off",
-    "ce_spawn_bomb",
-    "ce_none",
-    "ce_max"
+static char *_ce_names[CE_MAX] = {
+#define X(id, name) \
+    name,
+    CE_EVENTS
+#undef X
 };
+/** Table for looking up a common event from its name */
+static perfectHash _ce_hash;
 
 static char _ce_hjboots_textPT[] = 
  "VOCE OBTEVE AS BOTAS DE SALTO!\n"
@@ -94,7 +86,7 @@ static void *_ce_target = NULL;
  * @param j The tiles y position
  * @return The tile
  */
-static unsigned char _ce_setTile(int i, int j);
+static mapTile _ce_setTile(int i, int j);
 
 /**
  * Set a parameter
@@ -116,62 +108,19 @@ __ret:
 }
 
 /**
- * Parse a common event from a file pointer.
- * The event name must be between '"'.
+ * Retrieve a common event from its name
  * 
- * @param fp The file with the event
- * @return The parsed common event or CE_MAX, on error
+ * @param str The event's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The common event or CE_MAX, on error
  */
-commonEvent ce_getEventFromFile(FILE *fp) {
+commonEvent ce_getEventFromString(char *str, int len) {
     int i;
-    commonEvent ce;
-    fpos_t pos;
     
-    GFraMe_assertRV(fp, "Invalid file!", ce = CE_MAX, __ret);
-    
-    // Get the current position, to "backtrack" on error
-    i = fgetpos(fp, &pos);
-    GFraMe_assertRV(i == 0, "Error getting file position!", ce = CE_MAX, __ret);
-    
-    // Check every event (yay, dumb strats!)
-    ce = 0;
-    while (ce < CE_MAX) {
-        int c;
-        
-        
-        // Check that the first character is a '"'
-        c = fgetc(fp);
-        GFraMe_assertRV(c != EOF, "Reached end-of-file!", ce = CE_MAX, __ret);
-        GFraMe_assertRV(c == '"', "Invalid event name!", ce = CE_MAX, __ret);
-        
-        // Try to match every other character to the current event
-        i = 0;
-        while (1) {
-            c = fgetc(fp);
-            GFraMe_assertRV(c != EOF, "Reached end-of-file!", ce = CE_MAX,
-                __ret);
-            
-            // Stop either at the string end or on an unmatch
-            if (c == '"' || c != _ce_names[ce][i])
-                break;
-            
-            i++;
-        }
-        
-        // If the string ended, stop
-        if (c == '"' && _ce_names[ce][i + 1] == '\0')
-            break;
-        
-        // Return to the string's begin
-        i = fsetpos(fp, &pos);
-        GFraMe_assertRV(i == 0, "Error setting file position!", ce = CE_MAX,
-            __ret);
-        
-        ce++;
-    }
-    
-__ret:
-    return ce;
+    i = ph_find(&_ce_hash, _ce_names, CE_MAX, str, len);
+    if (i < 0)
+        return CE_MAX;
+    return (commonEvent)i;
 }
 
 /**
@@ -279,6 +228,8 @@ void ce_callEvent(commonEvent ce) {
                     obj_rmFlag(pO, ID_STATIC);
                     obj_setAnim(pO, OBJ_ANIM_DOOR_HOR_OPEN);
                 }
+                // Nothing else to do until the door's state changes
+                obj_sleep(pO);
             }
             // OPENING
             else if ((!not && val == OPENING) || (not && val == CLOSING)) {
@@ -326,6 +277,7 @@ void ce_callEvent(commonEvent ce) {
                     obj_addFlag(pO, ID_STATIC);
                     obj_setAnim(pO, OBJ_ANIM_DOOR_HOR_CLOSED);
                 }
+                obj_sleep(pO);
             }
         } break;
         case CE_SWITCH_MAP: {
@@ -400,9 +352,7 @@ void ce_callEvent(commonEvent ce) {
         case CE_HIDDEN_PATH: {
             event *pE;
             GFraMe_object *pObj;
-            GFraMe_ret rv;
-            int i, ini, j, len, lx, ly, x, y, w, h;
-            unsigned char *pData;
+            int i, j, lx, ly, x, y, w, h;
             
             map_getDimensions(m, &w, &h);
             w /= 8;
@@ -415,20 +365,16 @@ void ce_callEvent(commonEvent ce) {
             y = pObj->y / 8;
             ly = pObj->hitbox.hh * 2 / 8;
             lx = pObj->hitbox.hw * 2 / 8;
-            ini = x + y * w;
-            // Get the map's data
-            rv = map_getTilemapData(&pData, &len, m);
-            ASSERT_NR(rv == GFraMe_ret_ok);
             // Check that the event is inbounds
-            ASSERT_NR(x + y*w < len);
-            ASSERT_NR(x + lx + y*w < len);
-            ASSERT_NR(x + (y + ly)*w < len);
+            ASSERT_NR(x >= 0 && y >= 0);
+            ASSERT_NR(x + lx <= w);
+            ASSERT_NR(y + ly <= h);
             // Make the hidden path empty
             j = 0;
             while (j < ly) {
                 i = 0;
                 while (i < lx) {
-                    pData[ini + i + j*w] = 64;
+                    map_setTile(m, x + i, y + j, 64);
                     i++;
                 }
                 j++;
@@ -437,7 +383,7 @@ void ce_callEvent(commonEvent ce) {
             j = 0;
             while (j < ly) {
                 if (map_isTileSolid(m, x-1, y + j) == GFraMe_ret_ok) {
-                    pData[ini + j*w] = 106;
+                    map_setTile(m, x, y + j, 106);
                 }
                 j++;
             }
@@ -445,7 +391,7 @@ void ce_callEvent(commonEvent ce) {
             j = 0;
             while (j < ly) {
                 if (map_isTileSolid(m, x+lx, y + j) == GFraMe_ret_ok) {
-                    pData[ini + lx - 1 + j*w] = 104;
+                    map_setTile(m, x + lx - 1, y + j, 104);
                 }
                 j++;
             }
@@ -453,7 +399,7 @@ void ce_callEvent(commonEvent ce) {
             i = 0;
             while (i < lx) {
                 if (map_isTileSolid(m, x + i, y - 1) == GFraMe_ret_ok) {
-                    pData[ini + i] = 137;
+                    map_setTile(m, x + i, y, 137);
                 }
                 i++;
             }
@@ -461,20 +407,19 @@ void ce_callEvent(commonEvent ce) {
             i = 0;
             while (i < lx) {
                 if (map_isTileSolid(m, x + i, y + ly) == GFraMe_ret_ok) {
-                    pData[ini + i + (ly - 1)*w] = 73;
+                    map_setTile(m, x + i, y + ly - 1, 73);
                 }
                 i++;
             }
             // Set the upper-left corner
-            pData[     x + y*w       ] = _ce_setTile(     x, y     );
+            map_setTile(m,      x, y,      _ce_setTile(     x, y     ));
             // Set the upper-right corner
-            pData[x+lx-1 + y*w       ] = _ce_setTile(x+lx-1, y     );
+            map_setTile(m, x+lx-1, y,      _ce_setTile(x+lx-1, y     ));
             // Set the lower-left corner
-            pData[     x + (y+ly-1)*w] = _ce_setTile(     x, y+ly-1);
+            map_setTile(m,      x, y+ly-1, _ce_setTile(     x, y+ly-1));
             // Set the lower-right corner
-            pData[x+lx-1 + (y+ly-1)*w] = _ce_setTile(x+lx-1, y+ly-1);
-            // Reset the tilemap bounds and animations
-            map_setTilemap(m, pData, len, w, h);
+            map_setTile(m, x+lx-1, y+ly-1, _ce_setTile(x+lx-1, y+ly-1));
+            // Only the modified chunks will have their walls regenerated
         } break;
         case CE_UNHIDE_HEART: {
             globalVar gv;
@@ -498,6 +443,8 @@ void ce_callEvent(commonEvent ce) {
             obj_getVar(&gv, pO, 1);
             if (gv_nIsZero(gv))
                 obj_setAnim(pO, OBJ_ANIM_MAXHP_UP_OFF);
+            // Only check again when either variable changes
+            obj_sleep(pO);
         } break;
         case CE_INC_MAXHP: {
             event *pE;
@@ -562,6 +509,7 @@ void ce_callEvent(commonEvent ce) {
                 else if ((ID & ID_TERM) == ID_TERM)
                     obj_setAnim(pO, OBJ_ANIM_TERM_OFF);
             }
+            obj_sleep(pO);
         } break;
         case CE_SPAWN_BOMB: {
             if (gv_getValue(TIMER_BOMB) >= 8500) {
@@ -596,7 +544,7 @@ __ret:
  * @param j The tiles y position
  * @return The tile
  */
-static unsigned char _ce_setTile(int i, int j) {
+static mapTile _ce_setTile(int i, int j) {
     int a, b, c, d, e, f, g, h;
     // a | b | c
     // d |   | e
@@ -6,21 +6,44 @@
 #ifndef __COMMONEVENT_H_
 #define __COMMONEVENT_H_
 
+/**
+ * Every common event and its name (as used on the map files), as
+ * X(enumValue, name)
+ */
+#define CE_EVENTS \
+    /** ev ce: open a door */ \
+    X(CE_OPEN_DOOR, "ce_open_door") \
+    /** ev ce: closes a door */ \
+    X(CE_CLOSE_DOOR, "ce_close_door") \
+    /** ev ce: switch a door's state from open <-> close */ \
+    X(CE_SWITCH_DOOR, "ce_switch_door") \
+    /** obj ce: handles displaying and animating a door */ \
+    X(CE_HANDLE_DOOR, "ce_handle_door") \
+    /** obj ce: handles displaying and animating a ~door */ \
+    X(CE_HANDLE_NOTDOOR, "ce_handle_notdoor") \
+    /** ev ce: loads a new map */ \
+    X(CE_SWITCH_MAP, "ce_switch_map") \
+    /** ev ce: get an item equip it to the current player */ \
+    X(CE_GET_ITEM, "ce_get_item") \
+    /** ev ce: change a part of the map into a corridor */ \
+    X(CE_HIDDEN_PATH, "ce_hidden_path") \
+    /** obj ce: removes the 'hidden' flag if the gv is true */ \
+    X(CE_UNHIDE_HEART, "ce_unhide_on_gv") \
+    /** ev ce: increase the max hp */ \
+    X(CE_INC_MAXHP, "ce_inc_maxhp") \
+    /** ev ce: set a globalVar value */ \
+    X(CE_SET_GV, "ce_set_gv") \
+    /** obj ce: switch to OFF on some variable */ \
+    X(CE_SET_ANIM_OFF, "ce_set_anim_off") \
+    /** ev ce: spawn a bomb after some time */ \
+    X(CE_SPAWN_BOMB, "ce_spawn_bomb") \
+    X(CE_NONE, "ce_none")
+
 typedef enum {
-    CE_OPEN_DOOR,      /**  ev ce: open a door                                */
-    CE_CLOSE_DOOR,     /**  ev ce: closes a door                              */
-    CE_SWITCH_DOOR,    /**  ev ce: switch a door's state from open <-> close  */
-    CE_HANDLE_DOOR,    /** obj ce: handles displaying and animating a door    */
-    CE_HANDLE_NOTDOOR, /** obj ce: handles displaying and animating a ~door   */
-    CE_SWITCH_MAP,     /**  ev ce: loads a new map                            */
-    CE_GET_ITEM,       /**  ev ce: get an item equip it to the current player */
-    CE_HIDDEN_PATH,    /**  ev ce: change a part of the map into a corridor   */
-    CE_UNHIDE_HEART,   /** obj ce: removes the 'hidden' flag if the gv is true*/
-    CE_INC_MAXHP,      /**  ev ce: increase the max hp                        */
-    CE_SET_GV,         /**  ev ce: set a globalVar value                      */
-    CE_SET_ANIM_OFF,   /** obj ce: switch to OFF on some variable             */
-    CE_SPAWN_BOMB,     /**  ev ce: spawn a bomb after some time               */
-    CE_NONE,
+#define X(id, name) \
+    id,
+    CE_EVENTS
+#undef X
     CE_MAX
 } commonEvent;
 
@@ -46,13 +69,13 @@ void ce_callEvent(commonEvent ce);
 void ce_setParam(ce_params p, void *val);
 
 /**
- * Parse a common event from a file pointer.
- * The event name must be between '"'.
+ * Retrieve a common event from its name
  * 
- * @param fp The file with the event
- * @return The parsed common event or CE_MAX, on error
+ * @param str The event's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The common event or CE_MAX, on error
  */
-commonEvent ce_getEventFromFile(FILE *fp);
+commonEvent ce_getEventFromString(char *str, int len);
 
 /**
  * Get a event's name
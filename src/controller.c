@@ -7,6 +7,8 @@
 #include <GFraMe/GFraMe_controller.h>
 #include <GFraMe/GFraMe_keys.h>
 
+#include <string.h>
+
 #include "controller.h"
 #include "global.h"
 #include "types.h"
@@ -19,6 +21,44 @@ int emcc_numenter = 0;
 /** Define which control scheme is currently being used */
 static ctr_mode _ctr_pl1 = CTR_PAD1_C;
 static ctr_mode _ctr_pl2 = CTR_PAD1_D;
+/** Whether the inputs are injected (instead of read from the devices) */
+static int _ctr_isInjected = 0;
+/** Buttons injected for each player */
+static int _ctr_pl1Injected = 0;
+static int _ctr_pl2Injected = 0;
+/** Buttons sampled for each player on the last update */
+static ctrState _ctr_pl1State;
+static ctrState _ctr_pl2State;
+
+/**
+ * Retrieve a player's snapshot
+ * 
+ * @param ID ID of the player
+ * @return The snapshot or NULL, if it isn't a player
+ */
+static ctrState* ctr_getState(int ID) {
+    if (ID == ID_PL1)
+        return &_ctr_pl1State;
+    else if (ID == ID_PL2)
+        return &_ctr_pl2State;
+    return NULL;
+}
+
+/**
+ * Checks if a button was pressed on the last sample
+ * 
+ * @param ID ID of the player checking the button
+ * @param button The button (one of CTR_BT_*)
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+static int ctr_isHeld(int ID, int button) {
+    ctrState *pState;
+    
+    pState = ctr_getState(ID);
+    if (!pState)
+        return 0;
+    return (pState->held & button) != 0;
+}
 
 /**
  * Set default control mode for both players
@@ -102,21 +142,39 @@ __ret:
 }
 
 /**
- * Checks if the left button is pressed
+ * Make both players' input be read from injected buttons, instead of from the
+ * keyboard and controllers (or go back to reading those)
  * 
- * @param ID ID of the player checking the button
- * @return 1 if the button is pressed, 0 otherwise
+ * @param enable Whether inputs should be injected
  */
-int ctr_left(int ID) {
-    int mode;
-    
+void ctr_setInjection(int enable) {
+    _ctr_isInjected = enable;
+    _ctr_pl1Injected = 0;
+    _ctr_pl2Injected = 0;
+    memset(&_ctr_pl1State, 0x0, sizeof(ctrState));
+    memset(&_ctr_pl2State, 0x0, sizeof(ctrState));
+}
+
+/**
+ * Set which buttons a player is pressing, while inputs are injected
+ * 
+ * @param ID ID of the player
+ * @param buttons Bitmask of CTR_BT_* buttons
+ */
+void ctr_inject(int ID, int buttons) {
     if (ID == ID_PL1)
-        mode = _ctr_pl1;
+        _ctr_pl1Injected = buttons;
     else if (ID == ID_PL2)
-        mode = _ctr_pl2;
-    else
-        return 0;
-    
+        _ctr_pl2Injected = buttons;
+}
+
+/**
+ * Read whether the left button is pressed on the devices
+ * 
+ * @param mode The player's control mode
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+static int ctr_readLeft(ctr_mode mode) {
     switch (mode) {
         case CTR_KEYS_A: return GFraMe_keys.a;
         case CTR_KEYS_B: return GFraMe_keys.left;
@@ -135,21 +193,12 @@ int ctr_left(int ID) {
 }
 
 /**
- * Checks if the right button is pressed
+ * Read whether the right button is pressed on the devices
  * 
- * @param ID ID of the player checking the button
+ * @param mode The player's control mode
  * @return 1 if the button is pressed, 0 otherwise
  */
-int ctr_right(int ID) {
-    int mode;
-    
-    if (ID == ID_PL1)
-        mode = _ctr_pl1;
-    else if (ID == ID_PL2)
-        mode = _ctr_pl2;
-    else
-        return 0;
-    
+static int ctr_readRight(ctr_mode mode) {
     switch (mode) {
         case CTR_KEYS_A: return GFraMe_keys.d;
         case CTR_KEYS_B: return GFraMe_keys.right;
@@ -167,23 +216,13 @@ int ctr_right(int ID) {
     }
 }
 
-
 /**
- * Checks if the action button is pressed
+ * Read whether the action button is pressed on the devices
  * 
- * @param ID ID of the player checking the button
+ * @param mode The player's control mode
  * @return 1 if the button is pressed, 0 otherwise
  */
-int ctr_action(int ID) {
-    int mode;
-    
-    if (ID == ID_PL1)
-        mode = _ctr_pl1;
-    else if (ID == ID_PL2)
-        mode = _ctr_pl2;
-    else
-        return 0;
-    
+static int ctr_readAction(ctr_mode mode) {
     switch (mode) {
         case CTR_KEYS_A: return GFraMe_keys.w;
         case CTR_KEYS_B: return GFraMe_keys.up;
@@ -201,23 +240,13 @@ int ctr_action(int ID) {
     }
 }
 
-
 /**
- * Checks if the jump button is pressed
+ * Read whether the jump button is pressed on the devices
  * 
- * @param ID ID of the player checking the button
+ * @param mode The player's control mode
  * @return 1 if the button is pressed, 0 otherwise
  */
-int ctr_jump(int ID) {
-    int mode;
-    
-    if (ID == ID_PL1)
-        mode = _ctr_pl1;
-    else if (ID == ID_PL2)
-        mode = _ctr_pl2;
-    else
-        return 0;
-    
+static int ctr_readJump(ctr_mode mode) {
     switch (mode) {
         case CTR_KEYS_A: return GFraMe_keys.space;
         case CTR_KEYS_B: return GFraMe_keys.x;
@@ -235,23 +264,13 @@ int ctr_jump(int ID) {
     }
 }
 
-
 /**
- * Checks if the item button is pressed
+ * Read whether the item button is pressed on the devices
  * 
- * @param ID ID of the player checking the button
+ * @param mode The player's control mode
  * @return 1 if the button is pressed, 0 otherwise
  */
-int ctr_item(int ID) {
-    int mode;
-    
-    if (ID == ID_PL1)
-        mode = _ctr_pl1;
-    else if (ID == ID_PL2)
-        mode = _ctr_pl2;
-    else
-        return 0;
-    
+static int ctr_readItem(ctr_mode mode) {
     switch (mode) {
         case CTR_KEYS_A: return GFraMe_keys.lshift;
         case CTR_KEYS_B: return GFraMe_keys.c;
@@ -273,23 +292,13 @@ int ctr_item(int ID) {
     }
 }
 
-
 /**
- * Checks if the switchItem button is pressed
+ * Read whether the switchItem button is pressed on the devices
  * 
- * @param ID ID of the player checking the button
+ * @param mode The player's control mode
  * @return 1 if the button is pressed, 0 otherwise
  */
-int ctr_switchItem(int ID) {
-    int mode;
-    
-    if (ID == ID_PL1)
-        mode = _ctr_pl1;
-    else if (ID == ID_PL2)
-        mode = _ctr_pl2;
-    else
-        return 0;
-    
+static int ctr_readSwitchItem(ctr_mode mode) {
     switch (mode) {
         case CTR_KEYS_A: return GFraMe_keys.tab;
         case CTR_KEYS_B: return GFraMe_keys.v;
@@ -307,6 +316,174 @@ int ctr_switchItem(int ID) {
     }
 }
 
+/**
+ * Read every button a player is pressing, either from the devices or injected
+ * 
+ * @param ID ID of the player
+ * @return Bitmask of CTR_BT_* buttons
+ */
+static int ctr_poll(int ID) {
+    int buttons, mode;
+    
+    if (_ctr_isInjected) {
+        if (ID == ID_PL1)
+            return _ctr_pl1Injected;
+        else if (ID == ID_PL2)
+            return _ctr_pl2Injected;
+        return 0;
+    }
+    if (ID == ID_PL1)
+        mode = _ctr_pl1;
+    else if (ID == ID_PL2)
+        mode = _ctr_pl2;
+    else
+        return 0;
+    
+    buttons = 0;
+    if (ctr_readLeft(mode))
+        buttons |= CTR_BT_LEFT;
+    if (ctr_readRight(mode))
+        buttons |= CTR_BT_RIGHT;
+    if (ctr_readAction(mode))
+        buttons |= CTR_BT_ACTION;
+    if (ctr_readJump(mode))
+        buttons |= CTR_BT_JUMP;
+    if (ctr_readItem(mode))
+        buttons |= CTR_BT_ITEM;
+    if (ctr_readSwitchItem(mode))
+        buttons |= CTR_BT_SWITCH;
+    
+    return buttons;
+}
+
+/**
+ * Update a player's snapshot from its newly sampled buttons
+ * 
+ * @param pState The player's snapshot
+ * @param buttons Bitmask of CTR_BT_* buttons
+ */
+static void ctr_updateState(ctrState *pState, int buttons) {
+    pState->pressed = buttons & ~pState->held;
+    pState->released = pState->held & ~buttons;
+    pState->held = buttons;
+}
+
+/**
+ * Sample both players' buttons; Must be called once before every update, so
+ * every query on that update reads the same state
+ */
+void ctr_update() {
+    ctr_updateState(&_ctr_pl1State, ctr_poll(ID_PL1));
+    ctr_updateState(&_ctr_pl2State, ctr_poll(ID_PL2));
+}
+
+/**
+ * Retrieve every button a player was pressing on the last sample
+ * 
+ * @param ID ID of the player
+ * @return Bitmask of CTR_BT_* buttons
+ */
+int ctr_getButtons(int ID) {
+    ctrState *pState;
+    
+    pState = ctr_getState(ID);
+    if (!pState)
+        return 0;
+    return pState->held;
+}
+
+/**
+ * Checks if a button started being pressed on the last sample
+ * 
+ * @param ID ID of the player checking the button
+ * @param button The button (one of CTR_BT_*)
+ * @return 1 if the button was just pressed, 0 otherwise
+ */
+int ctr_pressed(int ID, int button) {
+    ctrState *pState;
+    
+    pState = ctr_getState(ID);
+    if (!pState)
+        return 0;
+    return (pState->pressed & button) != 0;
+}
+
+/**
+ * Checks if a button stopped being pressed on the last sample
+ * 
+ * @param ID ID of the player checking the button
+ * @param button The button (one of CTR_BT_*)
+ * @return 1 if the button was just released, 0 otherwise
+ */
+int ctr_released(int ID, int button) {
+    ctrState *pState;
+    
+    pState = ctr_getState(ID);
+    if (!pState)
+        return 0;
+    return (pState->released & button) != 0;
+}
+
+/**
+ * Checks if the left button is pressed
+ * 
+ * @param ID ID of the player checking the button
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+int ctr_left(int ID) {
+    return ctr_isHeld(ID, CTR_BT_LEFT);
+}
+
+/**
+ * Checks if the right button is pressed
+ * 
+ * @param ID ID of the player checking the button
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+int ctr_right(int ID) {
+    return ctr_isHeld(ID, CTR_BT_RIGHT);
+}
+
+/**
+ * Checks if the action button is pressed
+ * 
+ * @param ID ID of the player checking the button
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+int ctr_action(int ID) {
+    return ctr_isHeld(ID, CTR_BT_ACTION);
+}
+
+/**
+ * Checks if the jump button is pressed
+ * 
+ * @param ID ID of the player checking the button
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+int ctr_jump(int ID) {
+    return ctr_isHeld(ID, CTR_BT_JUMP);
+}
+
+/**
+ * Checks if the item button is pressed
+ * 
+ * @param ID ID of the player checking the button
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+int ctr_item(int ID) {
+    return ctr_isHeld(ID, CTR_BT_ITEM);
+}
+
+/**
+ * Checks if the switchItem button is pressed
+ * 
+ * @param ID ID of the player checking the button
+ * @return 1 if the button is pressed, 0 otherwise
+ */
+int ctr_switchItem(int ID) {
+    return ctr_isHeld(ID, CTR_BT_SWITCH);
+}
+
 /**
  * Checks if the pause button is pressed
  * 
@@ -316,6 +493,8 @@ int ctr_pause() {
     int ret;
     
     ret = 0;
+    if (_ctr_isInjected)
+        return ret;
     ret = ret || GFraMe_keys.esc;
     ret = ret || GFraMe_keys.p;
     ret = ret || GFraMe_keys.enter;
@@ -23,6 +23,25 @@ typedef enum {
     CTR_MAX
 } ctr_mode;
 
+/** Buttons that may be injected (e.g., when running headless) */
+#define CTR_BT_LEFT   0x01
+#define CTR_BT_RIGHT  0x02
+#define CTR_BT_ACTION 0x04
+#define CTR_BT_JUMP   0x08
+#define CTR_BT_ITEM   0x10
+#define CTR_BT_SWITCH 0x20
+
+/** Buttons sampled for a player on an update */
+struct stCtrState {
+    /** Buttons being pressed (bitmask of CTR_BT_*) */
+    int held;
+    /** Buttons that started being pressed on this update */
+    int pressed;
+    /** Buttons that stopped being pressed on this update */
+    int released;
+};
+typedef struct stCtrState ctrState;
+
 /**
  * Set default control mode for both players
  */
@@ -55,6 +74,54 @@ int ctr_setMode(int ID, ctr_mode mode);
  */
 int ctr_setModeForce(int ID, ctr_mode mode);
 
+/**
+ * Make both players' input be read from injected buttons, instead of from the
+ * keyboard and controllers (or go back to reading those)
+ * 
+ * @param enable Whether inputs should be injected
+ */
+void ctr_setInjection(int enable);
+
+/**
+ * Set which buttons a player is pressing, while inputs are injected
+ * 
+ * @param ID ID of the player
+ * @param buttons Bitmask of CTR_BT_* buttons
+ */
+void ctr_inject(int ID, int buttons);
+
+/**
+ * Sample both players' buttons; Must be called once before every update, so
+ * every query on that update reads the same state
+ */
+void ctr_update();
+
+/**
+ * Retrieve every button a player was pressing on the last sample
+ * 
+ * @param ID ID of the player
+ * @return Bitmask of CTR_BT_* buttons
+ */
+int ctr_getButtons(int ID);
+
+/**
+ * Checks if a button started being pressed on the last sample
+ * 
+ * @param ID ID of the player checking the button
+ * @param button The button (one of CTR_BT_*)
+ * @return 1 if the button was just pressed, 0 otherwise
+ */
+int ctr_pressed(int ID, int button);
+
+/**
+ * Checks if a button stopped being pressed on the last sample
+ * 
+ * @param ID ID of the player checking the button
+ * @param button The button (one of CTR_BT_*)
+ * @return 1 if the button was just released, 0 otherwise
+ */
+int ctr_released(int ID, int button);
+
 /**
  * Checks if the left button is pressed
  * 
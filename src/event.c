@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "commonEvent.h"
 #include "controller.h"
@@ -138,6 +139,40 @@ void event_clean(event **ppEv) {
     *ppEv = NULL;
 }
 
+/**
+ * Get how many bytes an event takes
+ * 
+ * @return The size of the event structure
+ */
+int event_getSize() {
+    return sizeof(event);
+}
+
+/**
+ * Copy an event's state into another one
+ * 
+ * @param pDst The event that will receive the state
+ * @param pSrc The event being copied
+ */
+void event_copy(event *pDst, event *pSrc) {
+    memcpy(pDst, pSrc, sizeof(event));
+}
+
+/**
+ * Check whether an actor of the given type could trigger the event (i.e., the
+ * event is active and accepts that actor)
+ * 
+ * @param ev The event
+ * @param id The actor's type (ID_PL, ID_OBJ and/or ID_MOB)
+ * @return Whether it could be triggered
+ */
+int event_canTrigger(event *ev, int id) {
+    return ev->active
+        && (!(ev->t & IS_PLAYER) || (id & ID_PL))
+        && (!(ev->t & IS_OBJ) || (id & ID_OBJ))
+        && (!(ev->t & IS_MOB) || (id & ID_MOB));
+}
+
 /**
  * Check if the event was triggered and call the appropriate callback
  * 
@@ -153,12 +188,9 @@ void event_check(event *ev, GFraMe_sprite *spr) {
     // Sanitize parameters
     ASSERT_NR(ev);
     ASSERT_NR(spr);
-    ASSERT_NR(ev->active);
 
     // Check if the event can even be started
-    ASSERT_NR(!(ev->t & IS_PLAYER) || (spr->id & ID_PL));
-    ASSERT_NR(!(ev->t & IS_OBJ) || (spr->id & ID_OBJ));
-    ASSERT_NR(!(ev->t & IS_MOB) || (spr->id & ID_MOB));
+    ASSERT_NR(event_canTrigger(ev, spr->id));
         
     // Store the previous state (since event doesn't count as regular col.
     obj = GFraMe_sprite_get_object(spr);
@@ -226,7 +258,7 @@ GFraMe_ret event_setVar(event *pEv, int index, globalVar gv) {
     // Sanitize parameters
     ASSERT(pEv, GFraMe_ret_bad_param);
     ASSERT(index < EV_VAR_MAX, GFraMe_ret_bad_param);
-    ASSERT(gv < GV_MAX, GFraMe_ret_bad_param);
+    ASSERT(GV_IS_VALID(gv), GFraMe_ret_bad_param);
     
     // Set the variable
     pEv->local[index] = gv;
@@ -290,3 +322,13 @@ void event_getObject(GFraMe_object **ppObj, event *pEv) {
     *ppObj = &pEv->obj;
 }
 
+/**
+ * Save/restore an event on a checkpoint
+ * 
+ * @param pEv The event
+ * @param pCp The checkpoint
+ */
+void event_checkpoint(event *pEv, checkpoint *pCp) {
+    cp_field(pCp, pEv, sizeof(event));
+}
+
@@ -10,6 +10,7 @@
 #include <GFraMe/GFraMe_error.h>
 #include <GFraMe/GFraMe_sprite.h>
 
+#include "checkpoint.h"
 #include "commonEvent.h"
 #include "globalVar.h"
 #include "types.h"
@@ -54,6 +55,31 @@ GFraMe_ret event_setAll(event *ev, int x, int y, int w, int h, trigger t,
  */
 void event_clean(event **ppEv);
 
+/**
+ * Get how many bytes an event takes
+ * 
+ * @return The size of the event structure
+ */
+int event_getSize();
+
+/**
+ * Copy an event's state into another one
+ * 
+ * @param pDst The event that will receive the state
+ * @param pSrc The event being copied
+ */
+void event_copy(event *pDst, event *pSrc);
+
+/**
+ * Check whether an actor of the given type could trigger the event (i.e., the
+ * event is active and accepts that actor)
+ * 
+ * @param ev The event
+ * @param id The actor's type (ID_PL, ID_OBJ and/or ID_MOB)
+ * @return Whether it could be triggered
+ */
+int event_canTrigger(event *ev, int id);
+
 /**
  * Check if the event was triggered and call the appropriate callback
  * 
@@ -114,5 +140,13 @@ void event_iGetVar(int *pVal, event *pEv, int index);
  */
 void event_getObject(GFraMe_object **ppObj, event *pEv);
 
+/**
+ * Save/restore an event on a checkpoint
+ * 
+ * @param pEv The event
+ * @param pCp The checkpoint
+ */
+void event_checkpoint(event *pEv, checkpoint *pCp);
+
 #endif
 
@@ -9,6 +9,8 @@
 #include <GFraMe/GFraMe_spriteset.h>
 #include <GFraMe/GFraMe_texture.h>
 
+#include <SDL2/SDL.h>
+
 #include <stdlib.h>
 
 #include "global.h"
@@ -20,9 +22,14 @@
   GFraMe_spriteset *gl_sset##W##x##H; \
   static GFraMe_spriteset _glSset##W##x##H
 
-#define DECLARE_AUDIO(AUD) \
-  static GFraMe_audio  _glAud_##AUD; \
-  GFraMe_audio * gl_aud_##AUD
+/** Maximum number of threads loading audios in the background */
+#define GL_MAX_WORKERS 4
+
+/** States of an audio */
+#define GL_AUD_PENDING 0
+#define GL_AUD_LOADING 1
+#define GL_AUD_READY   2
+#define GL_AUD_FAILED  3
 
 static int gl_isInit = 0;
 int gl_lang;
@@ -40,58 +47,132 @@ DECLARE_SSET(64, 8);
 DECLARE_SSET(64, 16);
 DECLARE_SSET(64, 32);
 
-DECLARE_AUDIO(menuMove);
-DECLARE_AUDIO(menuSelect);
-DECLARE_AUDIO(text);
-DECLARE_AUDIO(jump);
-DECLARE_AUDIO(highjump);
-DECLARE_AUDIO(door);
-DECLARE_AUDIO(terminal);
-DECLARE_AUDIO(getItem);
-DECLARE_AUDIO(heartup);
-DECLARE_AUDIO(switchItem);
-DECLARE_AUDIO(shootEn);
-DECLARE_AUDIO(blHit);
-DECLARE_AUDIO(fall);
-DECLARE_AUDIO(pause);
-DECLARE_AUDIO(plHit);
-DECLARE_AUDIO(jumperJump);
-DECLARE_AUDIO(jumperFall);
-DECLARE_AUDIO(charger);
-DECLARE_AUDIO(teleport);
-DECLARE_AUDIO(signaler);
-DECLARE_AUDIO(shootBoss);
-DECLARE_AUDIO(bombExpl);
-DECLARE_AUDIO(bossExpl);
-DECLARE_AUDIO(bossMove);
-DECLARE_AUDIO(plDeath);
-DECLARE_AUDIO(plStep);
-DECLARE_AUDIO(menu);
-DECLARE_AUDIO(intro);
-DECLARE_AUDIO(movingOn);
-DECLARE_AUDIO(victory);
-DECLARE_AUDIO(bossBattle);
-DECLARE_AUDIO(tensionGoesUp);
+/** Every audio (only valid after it's ready) */
+static GFraMe_audio _gl_aud[GL_AUD_MAX];
+/** Whether each audio is pending, loading, ready or failed */
+static SDL_atomic_t _gl_audState[GL_AUD_MAX];
+/** Next audio to be checked by the workers */
+static SDL_atomic_t _gl_nextAud;
+/** Set on gl_clean, so workers stop loading audios */
+static SDL_atomic_t _gl_stopWorkers;
+/** How many workers are still running */
+static SDL_atomic_t _gl_workersLeft;
+/** Threads loading audios in the background */
+static SDL_Thread *_gl_workers[GL_MAX_WORKERS];
+/** How many threads were spawned */
+static int _gl_workersLen = 0;
+/** When gl_init was called, in milliseconds */
+static Uint32 _gl_initTime;
 
+/** Name (and file) of each audio */
+static char *_gl_audName[GL_AUD_MAX] = {
+#define X(name, doLoop, loopPos, isLazy) \
+    #name,
+    GL_AUDIOS
+#undef X
+};
 
-GFraMe_ret gl_init() {
+/** Whether each audio loops */
+static int _gl_audLoop[GL_AUD_MAX] = {
+#define X(name, doLoop, loopPos, isLazy) \
+    doLoop,
+    GL_AUDIOS
+#undef X
+};
+
+/** Where each audio restarts from, after looping */
+static int _gl_audLoopPos[GL_AUD_MAX] = {
+#define X(name, doLoop, loopPos, isLazy) \
+    loopPos,
+    GL_AUDIOS
+#undef X
+};
+
+/** Whether each audio is only loaded on its first use */
+static int _gl_audIsLazy[GL_AUD_MAX] = {
+#define X(name, doLoop, loopPos, isLazy) \
+    isLazy,
+    GL_AUDIOS
+#undef X
+};
+
+/**
+ * Load an audio, if no one else did it (nor is doing it) yet
+ * 
+ * @param aud The audio
+ * @return Whether the audio was loaded by this call
+ */
+static int gl_loadAudio(glAudio aud) {
     GFraMe_ret rv;
-    int atlas_w, atlas_h;
-    unsigned char *data;
     
-    data = 0;
-    atlas_w = 256;
-    atlas_h = 256;
+    // Reserve the audio, so no other thread loads it
+    if (!SDL_AtomicCAS(&_gl_audState[aud], GL_AUD_PENDING, GL_AUD_LOADING))
+        return 0;
     
-    // Initialize and buffer (i.e., load from a file) the texture
-    GFraMe_texture_init(&gl_tex);
-    rv = GFraMe_assets_buffer_image("atlas", atlas_w, atlas_h, (char**)&data);
-    GFraMe_assertRet(rv == GFraMe_ret_ok, "Buffering image failed", __ret);
+    rv = GFraMe_audio_init(&_gl_aud[aud], _gl_audName[aud], _gl_audLoop[aud],
+            _gl_audLoopPos[aud], 1);
+    if (rv != GFraMe_ret_ok) {
+        GFraMe_log("Loading audio %s failed", _gl_audName[aud]);
+        SDL_AtomicSet(&_gl_audState[aud], GL_AUD_FAILED);
+    }
+    else
+        SDL_AtomicSet(&_gl_audState[aud], GL_AUD_READY);
     
-    // Load the texture
-    rv = GFraMe_texture_load(&gl_tex, atlas_w, atlas_h, data);
-    GFraMe_assertRet(rv == GFraMe_ret_ok, "Loading texture failed", __ret);
+    return 1;
+}
+
+/**
+ * Load every audio that isn't lazy, in order, until there are no more audios
+ * 
+ * @param pArg Unused
+ * @return Always 0
+ */
+static int gl_audioWorker(void *pArg) {
+    int i;
+    
+    while (!SDL_AtomicGet(&_gl_stopWorkers)) {
+        i = SDL_AtomicAdd(&_gl_nextAud, 1);
+        if (i >= GL_AUD_MAX)
+            break;
+        if (!_gl_audIsLazy[i])
+            gl_loadAudio((glAudio)i);
+    }
     
+    // The last worker reports how long it took for everything to be loaded
+    if (SDL_AtomicAdd(&_gl_workersLeft, -1) == 1)
+        GFraMe_log("Startup: audios loaded in background after %ims",
+                SDL_GetTicks() - _gl_initTime);
+    
+    return 0;
+}
+
+/**
+ * Retrieve an audio, loading it if it isn't ready yet (i.e., it's lazy or
+ * still waiting for a worker); if it's being loaded by a worker, this blocks
+ * until it's done
+ * 
+ * @param aud The audio
+ * @return The audio or NULL, if it failed to be loaded
+ */
+GFraMe_audio* gl_getAudio(glAudio aud) {
+    int state;
+    
+    if (aud < 0 || aud >= GL_AUD_MAX)
+        return NULL;
+    
+    gl_loadAudio(aud);
+    while ((state = SDL_AtomicGet(&_gl_audState[aud])) == GL_AUD_LOADING)
+        SDL_Delay(1);
+    
+    if (state == GL_AUD_READY)
+        return &_gl_aud[aud];
+    return NULL;
+}
+
+/**
+ * Set up every spriteset on the atlas's texture
+ */
+static void gl_initSpritesets() {
     /**
      * Initialize the spriteset of a given dimensions
      */
@@ -99,23 +180,6 @@ GFraMe_ret gl_init() {
       gl_sset##W##x##H = &_glSset##W##x##H; \
       GFraMe_spriteset_init(gl_sset##W##x##H, &gl_tex, W, H)
     
-    #define INIT_AUDIO(AUD, FILEN) \
-        rv = GFraMe_audio_init(&_glAud_##AUD, FILEN, 0, 0, 1); \
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Loading audio "FILEN" failed", __ret); \
-        gl_aud_##AUD = &_glAud_##AUD
-    #define INIT_SONG(AUD, FILEN) \
-        rv = GFraMe_audio_init(&_glAud_##AUD, FILEN, 1, 0, 1); \
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Loading audio "FILEN" failed", __ret); \
-        gl_aud_##AUD = &_glAud_##AUD
-    #define INIT_SONG_WINTRO(AUD, FILEN, LOOPPOS) \
-        rv = GFraMe_audio_init(&_glAud_##AUD, FILEN, 1, LOOPPOS, 1); \
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Loading audio "FILEN" failed", __ret); \
-        gl_aud_##AUD = &_glAud_##AUD
-    #define INIT_SONG_NOLOOP(AUD, FILEN) \
-        rv = GFraMe_audio_init(&_glAud_##AUD, FILEN, 0, 0, 1); \
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Loading audio "FILEN" failed", __ret); \
-        gl_aud_##AUD = &_glAud_##AUD
-    
     INIT_SSET(4 , 4 );
     INIT_SSET(8 , 8 );
     INIT_SSET(8 , 16);
@@ -126,39 +190,77 @@ GFraMe_ret gl_init() {
     INIT_SSET(64, 8 );
     INIT_SSET(64, 16);
     INIT_SSET(64, 32);
+}
+
+GFraMe_ret gl_init() {
+    GFraMe_ret rv;
+    int atlas_w, atlas_h, i;
+    unsigned char *data;
+    Uint32 atlasTime, songTime;
+    
+    data = 0;
+    atlas_w = 256;
+    atlas_h = 256;
+    _gl_initTime = SDL_GetTicks();
+    
+    // Start loading the audios in the background, while the atlas is loaded
+    i = 0;
+    while (i < GL_AUD_MAX) {
+        SDL_AtomicSet(&_gl_audState[i], GL_AUD_PENDING);
+        i++;
+    }
+    SDL_AtomicSet(&_gl_nextAud, 0);
+    SDL_AtomicSet(&_gl_stopWorkers, 0);
+    _gl_workersLen = 0;
+#if !defined(EMCC)
+    i = SDL_GetCPUCount() - 1;
+    if (i < 1)
+        i = 1;
+    else if (i > GL_MAX_WORKERS)
+        i = GL_MAX_WORKERS;
+    SDL_AtomicSet(&_gl_workersLeft, i);
+    while (_gl_workersLen < i) {
+        _gl_workers[_gl_workersLen] = SDL_CreateThread(gl_audioWorker,
+                "audioWorker", NULL);
+        if (!_gl_workers[_gl_workersLen])
+            break;
+        _gl_workersLen++;
+    }
+    // Fix the counter, in case some thread failed to be spawned
+    SDL_AtomicAdd(&_gl_workersLeft, _gl_workersLen - i);
+#endif
     
-    INIT_AUDIO(menuMove, "menuMove");
-    INIT_AUDIO(menuSelect, "menuSelect");
-    INIT_AUDIO(text, "text");
-    INIT_AUDIO(jump, "jump");
-    INIT_AUDIO(highjump, "highjump");
-    INIT_AUDIO(door, "door");
-    INIT_AUDIO(terminal, "terminal");
-    INIT_AUDIO(getItem, "getItem");
-    INIT_AUDIO(heartup, "heartup");
-    INIT_AUDIO(switchItem, "switchItem");
-    INIT_AUDIO(shootEn, "shootEn");
-    INIT_AUDIO(blHit, "blHit");
-    INIT_AUDIO(fall, "fall");
-    INIT_AUDIO(pause, "pause");
-    INIT_AUDIO(plHit, "plHit");
-    INIT_AUDIO(jumperJump, "jumperJump");
-    INIT_AUDIO(jumperFall, "jumperFall");
-    INIT_AUDIO(charger, "charger");
-    INIT_AUDIO(teleport, "teleport");
-    INIT_AUDIO(signaler, "signaler");
-    INIT_AUDIO(shootBoss, "shootBoss");
-    INIT_AUDIO(bombExpl, "bombExpl");
-    INIT_AUDIO(bossExpl, "bossExpl");
-    INIT_AUDIO(bossMove, "bossMove");
-    INIT_AUDIO(plDeath, "plDeath");
-    INIT_AUDIO(plStep, "plStep");
-    INIT_SONG(menu, "menu");
-    INIT_SONG(intro, "intro");
-    INIT_SONG(movingOn, "movingOn");
-    INIT_SONG_NOLOOP(victory, "victory");
-    INIT_SONG_WINTRO(bossBattle, "bossBattle", 58800*4);
-    INIT_SONG(tensionGoesUp, "tensionGoesUp");
+    // Initialize and buffer (i.e., load from a file) the texture
+    GFraMe_texture_init(&gl_tex);
+    rv = GFraMe_assets_buffer_image("atlas", atlas_w, atlas_h, (char**)&data);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Buffering image failed", __ret);
+    
+    // Load the texture
+    rv = GFraMe_texture_load(&gl_tex, atlas_w, atlas_h, data);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Loading texture failed", __ret);
+    
+    gl_initSpritesets();
+    atlasTime = SDL_GetTicks();
+    
+    // The menu's song must be ready before the menu is shown (if a worker is
+    // already loading it, wait for it)
+    gl_getAudio(GL_AUD_menu);
+    songTime = SDL_GetTicks();
+    
+    // Without workers, load every remaining audio right away
+    if (_gl_workersLen == 0) {
+        i = 0;
+        while (i < GL_AUD_MAX) {
+            if (!_gl_audIsLazy[i])
+                gl_loadAudio((glAudio)i);
+            i++;
+        }
+    }
+    
+    GFraMe_log("Startup: atlas and spritesets in %ims, menu song in %ims, "
+            "total %ims (%i workers loading audios)", atlasTime - _gl_initTime,
+            songTime - atlasTime, SDL_GetTicks() - _gl_initTime,
+            _gl_workersLen);
     
     gl_isInit = 1;
     gl_running = 1;
@@ -170,44 +272,38 @@ __ret:
     return rv;
 }
 
+GFraMe_ret gl_initHeadless() {
+    // The texture is never loaded (nor rendered), but sprites still reference
+    // their spritesets
+    GFraMe_texture_init(&gl_tex);
+    gl_initSpritesets();
+    
+    gl_running = 1;
+    return GFraMe_ret_ok;
+}
+
 void gl_clean() {
+    int i;
+    
     if (gl_isInit) {
         GFraMe_texture_clear(&gl_tex);
-        
-        #define CLEAN_AUDIO(AUD) \
-            if (gl_aud_##AUD) { \
-                GFraMe_audio_clear(&_glAud_##AUD); \
-            }
-        
-        CLEAN_AUDIO(menuMove);
-        CLEAN_AUDIO(menuSelect);
-        CLEAN_AUDIO(text);
-        CLEAN_AUDIO(jump);
-        CLEAN_AUDIO(highjump);
-        CLEAN_AUDIO(door);
-        CLEAN_AUDIO(terminal);
-        CLEAN_AUDIO(getItem);
-        CLEAN_AUDIO(heartup);
-        CLEAN_AUDIO(switchItem);
-        CLEAN_AUDIO(shootEn);
-        CLEAN_AUDIO(blHit);
-        CLEAN_AUDIO(fall);
-        CLEAN_AUDIO(pause);
-        CLEAN_AUDIO(plHit);
-        CLEAN_AUDIO(jumperJump);
-        CLEAN_AUDIO(jumperFall);
-        CLEAN_AUDIO(charger);
-        CLEAN_AUDIO(teleport);
-        CLEAN_AUDIO(signaler);
-        CLEAN_AUDIO(shootBoss);
-        CLEAN_AUDIO(bombExpl);
-        CLEAN_AUDIO(bossExpl);
-        CLEAN_AUDIO(bossMove);
-        CLEAN_AUDIO(plDeath);
-        CLEAN_AUDIO(menu);
-        CLEAN_AUDIO(intro);
-        CLEAN_AUDIO(movingOn);
+    }
+    
+    // Wait for the workers, so no audio is being loaded
+    SDL_AtomicSet(&_gl_stopWorkers, 1);
+    i = 0;
+    while (i < _gl_workersLen) {
+        SDL_WaitThread(_gl_workers[i], NULL);
+        i++;
+    }
+    _gl_workersLen = 0;
+    
+    i = 0;
+    while (i < GL_AUD_MAX) {
+        if (SDL_AtomicGet(&_gl_audState[i]) == GL_AUD_READY)
+            GFraMe_audio_clear(&_gl_aud[i]);
+        SDL_AtomicSet(&_gl_audState[i], GL_AUD_PENDING);
+        i++;
     }
 }
 
-
@@ -20,11 +20,18 @@
 #define FPS 90
 #define GAME_UFPS 60
 #define GAME_DFPS 60
+#define GAME_MIN_UFPS 30
+#define GAME_MAX_UFPS 90
+#define GAME_MIN_DFPS 30
+#define GAME_MAX_DFPS 240
+#define GAME_MAX_SUBSTEPS 4
 #define GRAVITY 500
 #define PL_VX 80
 #define PL_JUMPS 180
 #define PL_HIGHJUMPS 245
 #define SAVEFILE "playstate.save"
+#define SAVEFILE_BIN "playstate.bin"
+#define PAGEFILE "playstate.pages"
 #define CONFFILE "config.save"
 
 #define ASSERT(stmt, err) \
@@ -59,46 +66,69 @@ extern GFraMe_spriteset *gl_sset64x8;  /** 64x8 pixels spriteset    */
 extern GFraMe_spriteset *gl_sset64x16; /** 64x16 pixels spriteset    */
 extern GFraMe_spriteset *gl_sset64x32; /** 64x32 pixels spriteset    */
 
-#define AUD_DECLARE_EXT(AUD) \
-  extern GFraMe_audio *gl_aud_##AUD
+/**
+ * Every audio, as X(name, doLoop, loopPos, isLazy); its file is its name. The
+ * ones that aren't lazy are loaded in the background during gl_init (in this
+ * order), while lazy ones are only loaded when first played
+ */
+#define GL_AUDIOS \
+    X(menu         , 1, 0      , 0) \
+    X(menuMove     , 0, 0      , 0) \
+    X(menuSelect   , 0, 0      , 0) \
+    X(text         , 0, 0      , 0) \
+    X(jump         , 0, 0      , 0) \
+    X(highjump     , 0, 0      , 0) \
+    X(door         , 0, 0      , 0) \
+    X(terminal     , 0, 0      , 0) \
+    X(getItem      , 0, 0      , 0) \
+    X(heartup      , 0, 0      , 0) \
+    X(switchItem   , 0, 0      , 0) \
+    X(shootEn      , 0, 0      , 0) \
+    X(blHit        , 0, 0      , 0) \
+    X(fall         , 0, 0      , 0) \
+    X(pause        , 0, 0      , 0) \
+    X(plHit        , 0, 0      , 0) \
+    X(jumperJump   , 0, 0      , 0) \
+    X(jumperFall   , 0, 0      , 0) \
+    X(charger      , 0, 0      , 0) \
+    X(teleport     , 0, 0      , 0) \
+    X(signaler     , 0, 0      , 0) \
+    X(shootBoss    , 0, 0      , 0) \
+    X(bombExpl     , 0, 0      , 0) \
+    X(bossExpl     , 0, 0      , 0) \
+    X(bossMove     , 0, 0      , 0) \
+    X(plDeath      , 0, 0      , 0) \
+    X(plStep       , 0, 0      , 0) \
+    X(intro        , 1, 0      , 1) \
+    X(movingOn     , 1, 0      , 1) \
+    X(victory      , 0, 0      , 1) \
+    X(bossBattle   , 1, 58800*4, 1) \
+    X(tensionGoesUp, 1, 0      , 1)
 
-AUD_DECLARE_EXT(menuMove);
-AUD_DECLARE_EXT(menuSelect);
-AUD_DECLARE_EXT(text);
-AUD_DECLARE_EXT(jump);
-AUD_DECLARE_EXT(highjump);
-AUD_DECLARE_EXT(door);
-AUD_DECLARE_EXT(terminal);
-AUD_DECLARE_EXT(getItem);
-AUD_DECLARE_EXT(heartup);
-AUD_DECLARE_EXT(switchItem);
-AUD_DECLARE_EXT(shootEn);
-AUD_DECLARE_EXT(blHit);
-AUD_DECLARE_EXT(fall);
-AUD_DECLARE_EXT(pause);
-AUD_DECLARE_EXT(plHit);
-AUD_DECLARE_EXT(jumperJump);
-AUD_DECLARE_EXT(jumperFall);
-AUD_DECLARE_EXT(charger);
-AUD_DECLARE_EXT(teleport);
-AUD_DECLARE_EXT(signaler);
-AUD_DECLARE_EXT(shootBoss);
-AUD_DECLARE_EXT(bombExpl);
-AUD_DECLARE_EXT(bossExpl);
-AUD_DECLARE_EXT(bossMove);
-AUD_DECLARE_EXT(plDeath);
-AUD_DECLARE_EXT(plStep);
-AUD_DECLARE_EXT(menu);
-AUD_DECLARE_EXT(intro);
-AUD_DECLARE_EXT(movingOn);
-AUD_DECLARE_EXT(victory);
-AUD_DECLARE_EXT(bossBattle);
-AUD_DECLARE_EXT(tensionGoesUp);
+typedef enum {
+#define X(name, doLoop, loopPos, isLazy) \
+    GL_AUD_ ## name,
+    GL_AUDIOS
+#undef X
+    GL_AUD_MAX
+} glAudio;
 
 // Functions
 
 GFraMe_ret gl_init();
+/** Initialize only what's needed to run the game without a window nor audio */
+GFraMe_ret gl_initHeadless();
 void gl_clean();
 
+/**
+ * Retrieve an audio, loading it if it isn't ready yet (i.e., it's lazy or
+ * still waiting for a worker); if it's being loaded by a worker, this blocks
+ * until it's done
+ * 
+ * @param aud The audio
+ * @return The audio or NULL, if it failed to be loaded
+ */
+GFraMe_audio* gl_getAudio(glAudio aud);
+
 #endif
 
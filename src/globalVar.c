@@ -6,118 +6,214 @@
 #include <GFraMe/GFraMe_error.h>
 #include <GFraMe/GFraMe_save.h>
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
 #include "globalVar.h"
+#include "perfectHash.h"
 #include "save.h"
 #include "types.h"
 
-static char *_gv_names[GV_MAX+1] = {
-    "pl1_hp",
-    "pl1_maxhp",
-    "pl1_item",
-    "pl1_death",
-    "pl1_x",
-    "pl1_y",
-    "pl2_hp",
-    "pl2_maxhp",
-    "pl2_item",
-    "pl2_death",
-    "pl2_x",
-    "pl2_y",
-    "sigl_x",
-    "sigl_y",
-    "telp_x",
-    "telp_y",
-    "map",
-    "door_x",
-    "door_y",
-    "items",
-    "boss_phase",
-    "boss_x",
-    "boss_y",
-    "boss_dir",
-    "boss_isRunning",
-    "boss_isDead",
-    "heartup01",
-    "heartup02",
-    "heartup03",
-    "heartup04",
-    "heartup05",
-    "heartup06",
-    "heartup07",
-    "heartup01-hidden",
-    "heartup02-hidden",
-    "heartup03-hidden",
-    "heartup05-hidden",
-    "heartup06-hidden",
-    "heartup07-hidden",
-    "switch_map",
-    "map001_door",
-    "map002-1_door",
-    "map002-2_door",
-    "map003_door",
-    "map005_door",
-    "map006-a_door",
-    "map006-b_door",
-    "map006-c_door",
-    "map007_door",
-    "map008-a_door",
-    "map008-b_door",
-    "map008-c_door",
-    "map008-d_door",
-    "map008-e_door",
-    "map010_door",
-    "map011-a_door",
-    "map011-b_door",
-    "map011-c_door",
-    "map012-a_door",
-    "map012-b_door",
-    "map012-c_door",
-    "map015-a_door",
-    "map015-b_door",
-    "map016-a_door",
-    "map016-b_door",
-    "map016-c_door",
-    "map020-a_door",
-    "map020-b_door",
-    "map020-c_door",
-    "terminal001",
-    "terminal002",
-    "terminal003",
-    "terminal004",
-    "terminal005",
-    "terminal006",
-    "terminal007",
-    "terminal008",
-    "terminal009",
-    "terminal010",
-    "terminal011",
-    "terminal012",
-    "terminal013",
-    "terminal014",
-    "terminal015",
-    "terminal016",
-    "terminal017",
-    "terminal018",
-    "terminal019",
-    "terminal020",
-    "terminal021",
-    "terminal022",
-    "terminal023",
-    "terminal024",
-    "terminal025",
-    "terminal026",
-    "terminal027",
-    "hjump-term",
-    "telep-term",
-    "signl-term",
-    "game-ups",
-    "timer-bomb",
-    "game-time",
-    "gv_max"
+static char *_gv_names[GV_MAX] = {
+#define X(id, name) \
+    name,
+    GV_VARS
+#undef X
 };
+/** Table for looking up a global variable from its name */
+static perfectHash _gv_hash;
 
 /** Static array for global variables */
 static int _gv_arr[GV_MAX];
+/** Variables changed since they were last saved or loaded */
+static unsigned int _gv_dirty[GV_DIRTY_LEN];
+
+#define GV_PAGE_INC 8
+/** Some consecutive map variables, only alloc'ed once any is set */
+struct stGvPage {
+    /** Which variables are stored (see GV_PAGE_KEY) */
+    int key;
+    /** Whether it changed since it was last saved or loaded */
+    int isDirty;
+    /** The variables' values */
+    int val[GV_PAGE_LEN];
+};
+typedef struct stGvPage gvPage;
+
+/**
+ * Every page ever used (in the order those were created); Pages are never
+ * removed nor moved, only forgotten by resetting how many are in use, so they
+ * may be reused later (and the first ones restored from a checkpoint)
+ */
+static gvPage **_gv_pages = 0;
+/** How many pages fit on the buffer */
+static int _gv_pagesLen = 0;
+/** How many pages are in use */
+static int _gv_pagesUsed = 0;
+/** Last page found, since most accesses are to the current map's */
+static int _gv_lastPage = 0;
+/** Whether the saved pages must be discarded on the next save */
+static int _gv_resetPages = 0;
+
+/** Current map's index, or -1 if it may not have variables */
+static int _gv_map = -1;
+/** Names of the variables declared by the current map */
+static char _gv_localNames[GV_LOCAL_MAX][GV_NAME_LEN];
+/** Length of each name */
+static int _gv_localLens[GV_LOCAL_MAX];
+/** How many variables the current map declared */
+static int _gv_localUsed = 0;
+
+#define GV_SUB_INC 16
+/** Something that must be notified when a variable changes */
+struct stGvSubscription {
+    /** Function called on every change */
+    gvListener cb;
+    /** Passed to the function */
+    void *pCtx;
+    /** The variable (since every map variable with the same slot shares a
+     *  list) */
+    globalVar gv;
+    /** Next subscription to the same variable (plus 1), or 0 */
+    int next;
+};
+typedef struct stGvSubscription gvSubscription;
+
+/** Every subscription, linked by variable */
+static gvSubscription *_gv_subs = 0;
+/** How many subscriptions fit on the buffer */
+static int _gv_subsLen = 0;
+/** How many subscriptions there are */
+static int _gv_subsUsed = 0;
+/**
+ * First subscription to each variable (plus 1), or 0; Map variables are
+ * indexed by their slot, after the global ones (since only the current map's
+ * objects subscribe to those)
+ */
+static int _gv_subHead[GV_MAX + GV_LOCAL_MAX];
+
+/**
+ * Retrieve the list of subscriptions to a variable
+ * 
+ * @param gv The global variable (must be valid)
+ * @return The list's index on _gv_subHead
+ */
+static int gv_getSubIndex(globalVar gv) {
+    if (gv < GV_MAX)
+        return gv;
+    return GV_MAX + GV_LOCAL_SLOT(gv);
+}
+
+/**
+ * Notify everything that subscribed to a variable that it changed
+ * 
+ * @param gv The global variable
+ */
+static void gv_notify(globalVar gv) {
+    int i;
+    
+    i = _gv_subHead[gv_getSubIndex(gv)];
+    while (i != 0) {
+        gvSubscription *pSub;
+        
+        pSub = _gv_subs + i - 1;
+        if (pSub->gv == gv) {
+            pSub->cb(pSub->pCtx);
+        }
+        i = pSub->next;
+    }
+}
+
+/**
+ * Retrieve a page, optionally creating it
+ * 
+ * @param key The page's key
+ * @param doCreate Whether the page should be created, if not found
+ * @return The page or NULL, if not found (or on error)
+ */
+static gvPage* gv_getPage(int key, int doCreate) {
+    gvPage *pPage;
+    int i;
+    
+    // Check the last one first, since it's the most likely
+    if (_gv_lastPage < _gv_pagesUsed
+            && _gv_pages[_gv_lastPage]->key == key)
+        return _gv_pages[_gv_lastPage];
+    
+    i = 0;
+    while (i < _gv_pagesUsed) {
+        if (_gv_pages[i]->key == key) {
+            _gv_lastPage = i;
+            return _gv_pages[i];
+        }
+        i++;
+    }
+    
+    ASSERT_NR(doCreate);
+    
+    // Expand the buffer as necessary
+    if (_gv_pagesUsed >= _gv_pagesLen) {
+        gvPage **tmp;
+        
+        tmp = (gvPage**)realloc(_gv_pages,
+                sizeof(gvPage*) * (_gv_pagesLen + GV_PAGE_INC));
+        ASSERT_NR(tmp);
+        memset(tmp + _gv_pagesLen, 0x0, sizeof(gvPage*) * GV_PAGE_INC);
+        _gv_pages = tmp;
+        _gv_pagesLen += GV_PAGE_INC;
+    }
+    // Recycle a previously alloc'ed page, if any
+    if (!_gv_pages[_gv_pagesUsed]) {
+        _gv_pages[_gv_pagesUsed] = (gvPage*)malloc(sizeof(gvPage));
+        ASSERT_NR(_gv_pages[_gv_pagesUsed]);
+    }
+    
+    pPage = _gv_pages[_gv_pagesUsed];
+    memset(pPage, 0x0, sizeof(gvPage));
+    pPage->key = key;
+    _gv_lastPage = _gv_pagesUsed;
+    _gv_pagesUsed++;
+    
+    return pPage;
+__ret:
+    return NULL;
+}
+
+/**
+ * Retrieve where a variable is stored
+ * 
+ * @param gv The global variable
+ * @param doCreate Whether a map variable's page should be created, if it
+ *                 wasn't yet
+ * @return The variable or NULL, if invalid (or if its page doesn't exist)
+ */
+static int* gv_getSlot(globalVar gv, int doCreate) {
+    gvPage *pPage;
+    
+    if (gv < GV_MAX)
+        return _gv_arr + gv;
+    if (!GV_IS_VALID(gv))
+        return NULL;
+    
+    pPage = gv_getPage(GV_PAGE_KEY(gv), doCreate);
+    if (!pPage)
+        return NULL;
+    return pPage->val + (GV_LOCAL_SLOT(gv) % GV_PAGE_LEN);
+}
+
+/**
+ * Mark a variable as changed, so it's saved and its subscribers are notified
+ * 
+ * @param gv The global variable
+ */
+static void gv_touch(globalVar gv) {
+    if (gv < GV_MAX)
+        GV_SET_DIRTY(_gv_dirty, gv);
+    else
+        gv_getPage(GV_PAGE_KEY(gv), 0)->isDirty = 1;
+    gv_notify(gv);
+}
 
 /**
  * Initialize the global variables
@@ -142,6 +238,12 @@ void gv_init() {
     _gv_arr[SIGL_Y] = -1;
     // TODO set DOOR_X & DOOR_Y
     
+    // Anything may differ from the save, so write everything on the next one
+    memset(_gv_dirty, 0xff, sizeof(_gv_dirty));
+    // Every map variable starts as zero (i.e., without any page)
+    _gv_pagesUsed = 0;
+    _gv_resetPages = 1;
+    
 //    _gv_arr[ITEMS] = ID_HIGHJUMP | ID_TELEPORT | ID_SIGNALER;
 //    _gv_arr[PL1_ITEM] = ID_TELEPORT;
 //    _gv_arr[PL2_ITEM] = ID_SIGNALER;
@@ -154,8 +256,14 @@ void gv_init() {
  * @param val The new value
  */
 void gv_setValue(globalVar gv, int val) {
-    if (gv < GV_MAX)
-        _gv_arr[gv] = val;
+    int *pSlot;
+    
+    // A missing page is all zeroes, so it's only created on a new value
+    pSlot = gv_getSlot(gv, val != 0);
+    if (pSlot && *pSlot != val) {
+        *pSlot = val;
+        gv_touch(gv);
+    }
 }
 
 /**
@@ -165,8 +273,13 @@ void gv_setValue(globalVar gv, int val) {
  * @param val The new value
  */
 void gv_setBit(globalVar gv, int bit) {
-    if (gv < GV_MAX)
-        _gv_arr[gv] |= bit;
+    int *pSlot;
+    
+    pSlot = gv_getSlot(gv, bit != 0);
+    if (pSlot && (*pSlot & bit) != bit) {
+        *pSlot |= bit;
+        gv_touch(gv);
+    }
 }
 
 /**
@@ -175,8 +288,13 @@ void gv_setBit(globalVar gv, int bit) {
  * @param gv The global variable
  */
 void gv_inc(globalVar gv) {
-    if (gv < GV_MAX)
-        _gv_arr[gv]++;
+    int *pSlot;
+    
+    pSlot = gv_getSlot(gv, 1);
+    if (pSlot) {
+        (*pSlot)++;
+        gv_touch(gv);
+    }
 }
 
 /**
@@ -185,8 +303,13 @@ void gv_inc(globalVar gv) {
  * @param gv The global variable
  */
 void gv_dec(globalVar gv) {
-    if (gv < GV_MAX)
-        _gv_arr[gv]--;
+    int *pSlot;
+    
+    pSlot = gv_getSlot(gv, 1);
+    if (pSlot) {
+        (*pSlot)--;
+        gv_touch(gv);
+    }
 }
 
 /**
@@ -196,8 +319,13 @@ void gv_dec(globalVar gv) {
  * @param val The value to be added
  */
 void gv_add(globalVar gv, int val) {
-    if (gv < GV_MAX)
-        _gv_arr[gv] += val;
+    int *pSlot;
+    
+    pSlot = gv_getSlot(gv, 1);
+    if (pSlot) {
+        *pSlot += val;
+        gv_touch(gv);
+    }
 }
 
 /**
@@ -207,8 +335,13 @@ void gv_add(globalVar gv, int val) {
  * @param val The value to be subtracted
  */
 void gv_sub(globalVar gv, int val) {
-    if (gv < GV_MAX)
-        _gv_arr[gv] -= val;
+    int *pSlot;
+    
+    pSlot = gv_getSlot(gv, 1);
+    if (pSlot) {
+        *pSlot -= val;
+        gv_touch(gv);
+    }
 }
 
 /**
@@ -218,9 +351,16 @@ void gv_sub(globalVar gv, int val) {
  * @return The variable's value
  */
 int gv_getValue(globalVar gv) {
+    int *pSlot;
+    
     if (gv < GV_MAX)
         return _gv_arr[gv];
-    return -1;
+    if (!GV_IS_VALID(gv))
+        return -1;
+    pSlot = gv_getSlot(gv, 0);
+    if (pSlot)
+        return *pSlot;
+    return 0;
 }
 
 /**
@@ -230,8 +370,8 @@ int gv_getValue(globalVar gv) {
  * return 1 on true, 0 on false
  */
 int gv_isZero(globalVar gv) {
-    if (gv < GV_MAX)
-        return _gv_arr[gv] == 0;
+    if (GV_IS_VALID(gv))
+        return gv_getValue(gv) == 0;
     return -1;
 }
 
@@ -242,8 +382,8 @@ int gv_isZero(globalVar gv) {
  * return 1 on true, 0 on false
  */
 int gv_nIsZero(globalVar gv) {
-    if (gv < GV_MAX)
-        return _gv_arr[gv] != 0;
+    if (GV_IS_VALID(gv))
+        return gv_getValue(gv) != 0;
     return -1;
 }
 
@@ -254,18 +394,67 @@ int gv_nIsZero(globalVar gv) {
  * @return The global variable's name or NULL
  */
 char* gv_getName(globalVar gv) {
-    if (gv >= GV_MAX) return 0;
-    return _gv_names[gv];
+    if (gv < GV_MAX)
+        return _gv_names[gv];
+    // Only the current map's variables are named
+    if (GV_IS_VALID(gv) && GV_LOCAL_MAP(gv) == _gv_map
+            && GV_LOCAL_SLOT(gv) < _gv_localUsed)
+        return _gv_localNames[GV_LOCAL_SLOT(gv)];
+    return 0;
 }
 
 /**
- * Save the current state of the global vars to a file
+ * Retrieve a globalVar from its name
+ * 
+ * @param str The variable's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The globalVar or GV_MAX, on error
+ */
+globalVar gv_getVarFromString(char *str, int len) {
+    int i;
+    
+    // The current map's variables take precedence
+    i = 0;
+    while (i < _gv_localUsed) {
+        if (_gv_localLens[i] == len
+                && memcmp(_gv_localNames[i], str, len) == 0)
+            return GV_LOCAL(_gv_map, i);
+        i++;
+    }
+    
+    i = ph_find(&_gv_hash, _gv_names, GV_MAX, str, len);
+    if (i < 0)
+        return GV_MAX;
+    return (globalVar)i;
+}
+
+/**
+ * Save the current state of the global vars to a file; Only the variables
+ * (and pages of map variables) changed since the last save (or load) are
+ * written
  * 
  * @param filename The filename
  * @return GFraMe error code
  */
 GFraMe_ret gv_save(char *filename) {
-    write_block(BLK_GAME, _gv_arr, GV_MAX);
+    int i;
+    
+    write_block_slots(BLK_GAME, _gv_arr, _gv_dirty, GV_MAX);
+    memset(_gv_dirty, 0x0, sizeof(_gv_dirty));
+    
+    if (_gv_resetPages) {
+        reset_pages();
+        _gv_resetPages = 0;
+    }
+    i = 0;
+    while (i < _gv_pagesUsed) {
+        if (_gv_pages[i]->isDirty) {
+            write_page(_gv_pages[i]->key, _gv_pages[i]->val, GV_PAGE_LEN);
+            _gv_pages[i]->isDirty = 0;
+        }
+        i++;
+    }
+    
     return flush_block(BLK_GAME);
 }
 
@@ -276,6 +465,169 @@ GFraMe_ret gv_save(char *filename) {
  * @return GFraMe error code
  */
 GFraMe_ret gv_load(char *filename) {
+    gvPage *pPage;
+    int i, key;
+    
     read_block(BLK_GAME, _gv_arr, GV_MAX);
+    memset(_gv_dirty, 0x0, sizeof(_gv_dirty));
+    
+    // Only the saved pages are alloc'ed
+    _gv_pagesUsed = 0;
+    _gv_resetPages = 0;
+    i = 0;
+    while (read_page(i, &key, 0, 0) == 0) {
+        pPage = gv_getPage(key, 1);
+        GFraMe_assertRet(pPage, "Failed to alloc map variables", __ret);
+        read_page(i, &key, pPage->val, GV_PAGE_LEN);
+        i++;
+    }
+    
+__ret:
     return 0;
 }
+
+/**
+ * Save/restore every global variable (and which were changed since the last
+ * save) on a checkpoint
+ * 
+ * @param pCp The checkpoint
+ */
+void gv_checkpoint(checkpoint *pCp) {
+    int i;
+    
+    cp_field(pCp, _gv_arr, sizeof(_gv_arr));
+    cp_field(pCp, _gv_dirty, sizeof(_gv_dirty));
+    cp_field(pCp, &_gv_resetPages, sizeof(int));
+    // Pages are never moved, so any created afterward is simply dropped
+    cp_field(pCp, &_gv_pagesUsed, sizeof(int));
+    i = 0;
+    while (i < _gv_pagesUsed) {
+        cp_field(pCp, _gv_pages[i], sizeof(gvPage));
+        i++;
+    }
+}
+
+/**
+ * Register a function to be called whenever a variable changes (so whatever
+ * depends on it doesn't have to check it every frame)
+ * 
+ * @param gv The global variable
+ * @param cb The function
+ * @param pCtx Passed to the function
+ * @return GFraMe error code
+ */
+GFraMe_ret gv_subscribe(globalVar gv, gvListener cb, void *pCtx) {
+    GFraMe_ret rv;
+    gvSubscription *pSub;
+    int i;
+    
+    // Sanitize parameters
+    ASSERT(GV_IS_VALID(gv), GFraMe_ret_bad_param);
+    ASSERT(cb, GFraMe_ret_bad_param);
+    
+    // Expand the buffer as necessary
+    if (_gv_subsUsed >= _gv_subsLen) {
+        gvSubscription *tmp;
+        
+        tmp = (gvSubscription*)realloc(_gv_subs,
+                sizeof(gvSubscription) * (_gv_subsLen + GV_SUB_INC));
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        _gv_subs = tmp;
+        _gv_subsLen += GV_SUB_INC;
+    }
+    
+    // Add it to the start of the variable's list
+    i = gv_getSubIndex(gv);
+    pSub = _gv_subs + _gv_subsUsed;
+    pSub->cb = cb;
+    pSub->pCtx = pCtx;
+    pSub->gv = gv;
+    pSub->next = _gv_subHead[i];
+    _gv_subsUsed++;
+    _gv_subHead[i] = _gv_subsUsed;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Remove every subscription (e.g., because the map's objects are being
+ * replaced)
+ */
+void gv_clearSubscriptions() {
+    memset(_gv_subHead, 0x0, sizeof(_gv_subHead));
+    _gv_subsUsed = 0;
+}
+
+/**
+ * Release the memory used by the subscriptions
+ */
+void gv_cleanSubscriptions() {
+    gv_clearSubscriptions();
+    if (_gv_subs)
+        free(_gv_subs);
+    _gv_subs = 0;
+    _gv_subsLen = 0;
+}
+
+/**
+ * Set which map is being loaded, so it may declare its own variables;
+ * Variables declared by the previous map can't be referenced by name anymore
+ * 
+ * @param map The map's index, or -1 if it may not declare variables
+ */
+void gv_setMap(int map) {
+    if (map >= GV_MAP_MAX)
+        map = -1;
+    _gv_map = map;
+    _gv_localUsed = 0;
+}
+
+/**
+ * Declare a variable on the current map; Its slot is the declaration's order,
+ * so new variables must be declared after the previous ones (otherwise, saves
+ * would be mixed up)
+ * 
+ * @param str The variable's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return GFraMe error code
+ */
+GFraMe_ret gv_declare(char *str, int len) {
+    GFraMe_ret rv;
+    
+    // Sanitize parameters
+    ASSERT(_gv_map >= 0, GFraMe_ret_failed);
+    ASSERT(_gv_localUsed < GV_LOCAL_MAX, GFraMe_ret_failed);
+    ASSERT(len > 0 && len < GV_NAME_LEN, GFraMe_ret_bad_param);
+    ASSERT(gv_getVarFromString(str, len) == GV_MAX, GFraMe_ret_failed);
+    
+    memcpy(_gv_localNames[_gv_localUsed], str, len);
+    _gv_localNames[_gv_localUsed][len] = '\0';
+    _gv_localLens[_gv_localUsed] = len;
+    _gv_localUsed++;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Release the memory used by the map variables' pages
+ */
+void gv_clean() {
+    int i;
+    
+    i = 0;
+    while (i < _gv_pagesLen) {
+        if (_gv_pages[i])
+            free(_gv_pages[i]);
+        i++;
+    }
+    if (_gv_pages)
+        free(_gv_pages);
+    _gv_pages = 0;
+    _gv_pagesLen = 0;
+    _gv_pagesUsed = 0;
+    _gv_lastPage = 0;
+}
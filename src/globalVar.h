@@ -8,112 +8,222 @@
 
 #include <GFraMe/GFraMe_error.h>
 
+#include "checkpoint.h"
+
+/**
+ * Every global variable and its name (as used on the map files), as
+ * X(enumValue, name)
+ */
+#define GV_VARS \
+    /** Player 1 current health */ \
+    X(PL1_HP, "pl1_hp") \
+    /** Player 1 maximum health */ \
+    X(PL1_MAXHP, "pl1_maxhp") \
+    /** Player 1 current item */ \
+    X(PL1_ITEM, "pl1_item") \
+    /** How many times player 1 died */ \
+    X(PL1_DEATH, "pl1_death") \
+    /** Player 1 horizontal (world) position */ \
+    X(PL1_CX, "pl1_x") \
+    /** Player 1 vertical (world) position */ \
+    X(PL1_CY, "pl1_y") \
+    /** Player 2 current health */ \
+    X(PL2_HP, "pl2_hp") \
+    /** Player 2 maximum health */ \
+    X(PL2_MAXHP, "pl2_maxhp") \
+    /** Player 2 current item */ \
+    X(PL2_ITEM, "pl2_item") \
+    /** How many times player 2 died */ \
+    X(PL2_DEATH, "pl2_death") \
+    /** Player 1 horizontal (world) position */ \
+    X(PL2_CX, "pl2_x") \
+    /** Player 1 vertical (world) position */ \
+    X(PL2_CY, "pl2_y") \
+    /** Signaler horizontal position */ \
+    X(SIGL_X, "sigl_x") \
+    /** Signaler vertical position */ \
+    X(SIGL_Y, "sigl_y") \
+    /** Target teleporting position */ \
+    X(TELP_X, "telp_x") \
+    /** Target teleporting position */ \
+    X(TELP_Y, "telp_y") \
+    /** Current map */ \
+    X(MAP, "map") \
+    /** Entrance horizontal point on current map */ \
+    X(DOOR_X, "door_x") \
+    /** Entrance vertical point on current map */ \
+    X(DOOR_Y, "door_y") \
+    /** Flags for available items */ \
+    X(ITEMS, "items") \
+    /** Which phase the boss is currently in */ \
+    X(BOSS_PHASE, "boss_phase") \
+    /** Boss top-left origin, according to the wheel */ \
+    X(BOSS_X, "boss_x") \
+    /** Boss top-left origin, according to the wheel */ \
+    X(BOSS_Y, "boss_y") \
+    X(BOSS_DIR, "boss_dir") \
+    X(BOSS_ISRUNNING, "boss_isRunning") \
+    X(BOSS_ISDEAD, "boss_isDead") \
+    X(HEARTUP01, "heartup01") \
+    X(HEARTUP02, "heartup02") \
+    X(HEARTUP03, "heartup03") \
+    X(HEARTUP04, "heartup04") \
+    X(HEARTUP05, "heartup05") \
+    X(HEARTUP06, "heartup06") \
+    X(HEARTUP07, "heartup07") \
+    X(HEARTUP01_HIDDEN, "heartup01-hidden") \
+    X(HEARTUP02_HIDDEN, "heartup02-hidden") \
+    X(HEARTUP03_HIDDEN, "heartup03-hidden") \
+    X(HEARTUP05_HIDDEN, "heartup05-hidden") \
+    X(HEARTUP06_HIDDEN, "heartup06-hidden") \
+    X(HEARTUP07_HIDDEN, "heartup07-hidden") \
+    /** Whether the map should be switched */ \
+    X(SWITCH_MAP, "switch_map") \
+    /** State of the only door on map 001 */ \
+    X(MAP001_DOOR, "map001_door") \
+    /** State of the only door on map 002 */ \
+    X(MAP002_DOOR1, "map002-1_door") \
+    /** State of the only door on map 002 */ \
+    X(MAP002_DOOR2, "map002-2_door") \
+    /** State of the only door on map 003 */ \
+    X(MAP003_DOOR, "map003_door") \
+    /** State of a door on map 005 */ \
+    X(MAP005_DOOR, "map005_door") \
+    /** State of a door on map 005 */ \
+    X(MAP006_DOOR_A, "map006-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP006_DOOR_B, "map006-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP006_DOOR_C, "map006-c_door") \
+    /** State of a door on map 005 */ \
+    X(MAP007_DOOR, "map007_door") \
+    /** State of a door on map 005 */ \
+    X(MAP008_DOOR_A, "map008-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP008_DOOR_B, "map008-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP008_DOOR_C, "map008-c_door") \
+    /** State of a door on map 005 */ \
+    X(MAP008_DOOR_D, "map008-d_door") \
+    /** State of a door on map 005 */ \
+    X(MAP008_DOOR_E, "map008-e_door") \
+    /** State of a door on map 005 */ \
+    X(MAP010_DOOR, "map010_door") \
+    /** State of a door on map 005 */ \
+    X(MAP011_DOOR_A, "map011-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP011_DOOR_B, "map011-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP011_DOOR_C, "map011-c_door") \
+    /** State of a door on map 005 */ \
+    X(MAP012_DOOR_A, "map012-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP012_DOOR_B, "map012-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP012_DOOR_C, "map012-c_door") \
+    /** State of a door on map 005 */ \
+    X(MAP015_DOOR_A, "map015-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP015_DOOR_B, "map015-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP016_DOOR_A, "map016-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP016_DOOR_B, "map016-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP016_DOOR_C, "map016-c_door") \
+    /** State of a door on map 005 */ \
+    X(MAP020_DOOR_A, "map020-a_door") \
+    /** State of a door on map 005 */ \
+    X(MAP020_DOOR_B, "map020-b_door") \
+    /** State of a door on map 005 */ \
+    X(MAP020_DOOR_C, "map020-c_door") \
+    X(TERMINAL_001, "terminal001") \
+    X(TERMINAL_002, "terminal002") \
+    X(TERMINAL_003, "terminal003") \
+    X(TERMINAL_004, "terminal004") \
+    X(TERMINAL_005, "terminal005") \
+    X(TERMINAL_006, "terminal006") \
+    X(TERMINAL_007, "terminal007") \
+    X(TERMINAL_008, "terminal008") \
+    X(TERMINAL_009, "terminal009") \
+    X(TERMINAL_010, "terminal010") \
+    X(TERMINAL_011, "terminal011") \
+    X(TERMINAL_012, "terminal012") \
+    X(TERMINAL_013, "terminal013") \
+    X(TERMINAL_014, "terminal014") \
+    X(TERMINAL_015, "terminal015") \
+    X(TERMINAL_016, "terminal016") \
+    X(TERMINAL_017, "terminal017") \
+    X(TERMINAL_018, "terminal018") \
+    X(TERMINAL_019, "terminal019") \
+    X(TERMINAL_020, "terminal020") \
+    X(TERMINAL_021, "terminal021") \
+    X(TERMINAL_022, "terminal022") \
+    X(TERMINAL_023, "terminal023") \
+    X(TERMINAL_024, "terminal024") \
+    X(TERMINAL_025, "terminal025") \
+    X(TERMINAL_026, "terminal026") \
+    X(TERMINAL_027, "terminal027") \
+    X(HJUMP_TERM, "hjump-term") \
+    X(TELEP_TERM, "telep-term") \
+    X(SIGNL_TERM, "signl-term") \
+    X(GAME_UPS, "game-ups") \
+    X(TIMER_BOMB, "timer-bomb") \
+    X(GAME_TIME, "game-time")
+
 typedef enum {
-    PL1_HP,       /** Player 1 current health                      */
-    PL1_MAXHP,    /** Player 1 maximum health                      */
-    PL1_ITEM,     /** Player 1 current item                        */
-    PL1_DEATH,    /** How many times player 1 died                 */
-    PL1_CX,       /** Player 1 horizontal (world) position         */
-    PL1_CY,       /** Player 1 vertical (world) position           */
-    PL2_HP,       /** Player 2 current health                      */
-    PL2_MAXHP,    /** Player 2 maximum health                      */
-    PL2_ITEM,     /** Player 2 current item                        */
-    PL2_DEATH,    /** How many times player 2 died                 */
-    PL2_CX,       /** Player 1 horizontal (world) position         */
-    PL2_CY,       /** Player 1 vertical (world) position           */
-    SIGL_X,       /** Signaler horizontal position                 */
-    SIGL_Y,       /** Signaler vertical position                   */
-    TELP_X,       /** Target teleporting position                  */
-    TELP_Y,       /** Target teleporting position                  */
-    MAP,          /** Current map                                  */
-    DOOR_X,       /** Entrance horizontal point on current map     */
-    DOOR_Y,       /** Entrance vertical point on current map       */
-    ITEMS,        /** Flags for available items                    */
-    BOSS_PHASE,   /** Which phase the boss is currently in         */
-    BOSS_X,       /** Boss top-left origin, according to the wheel */
-    BOSS_Y,       /** Boss top-left origin, according to the wheel */
-    BOSS_DIR,
-    BOSS_ISRUNNING,
-    BOSS_ISDEAD,
-    HEARTUP01,
-    HEARTUP02,
-    HEARTUP03,
-    HEARTUP04,
-    HEARTUP05,
-    HEARTUP06,
-    HEARTUP07,
-    HEARTUP01_HIDDEN,
-    HEARTUP02_HIDDEN,
-    HEARTUP03_HIDDEN,
-    HEARTUP05_HIDDEN,
-    HEARTUP06_HIDDEN,
-    HEARTUP07_HIDDEN,
-    SWITCH_MAP,   /** Whether the map should be switched       */
-    MAP001_DOOR,  /** State of the only door on map 001        */
-    MAP002_DOOR1, /** State of the only door on map 002        */
-    MAP002_DOOR2, /** State of the only door on map 002        */
-    MAP003_DOOR,  /** State of the only door on map 003        */
-    MAP005_DOOR,  /** State of a door on map 005              */
-    MAP006_DOOR_A,/** State of a door on map 005              */
-    MAP006_DOOR_B,/** State of a door on map 005              */
-    MAP006_DOOR_C,/** State of a door on map 005              */
-    MAP007_DOOR,  /** State of a door on map 005              */
-    MAP008_DOOR_A,/** State of a door on map 005              */
-    MAP008_DOOR_B,/** State of a door on map 005              */
-    MAP008_DOOR_C,/** State of a door on map 005              */
-    MAP008_DOOR_D,/** State of a door on map 005              */
-    MAP008_DOOR_E,/** State of a door on map 005              */
-    MAP010_DOOR,  /** State of a door on map 005              */
-    MAP011_DOOR_A,/** State of a door on map 005              */
-    MAP011_DOOR_B,/** State of a door on map 005              */
-    MAP011_DOOR_C,/** State of a door on map 005              */
-    MAP012_DOOR_A,  /** State of a door on map 005              */
-    MAP012_DOOR_B,  /** State of a door on map 005              */
-    MAP012_DOOR_C,  /** State of a door on map 005              */
-    MAP015_DOOR_A,  /** State of a door on map 005              */
-    MAP015_DOOR_B,  /** State of a door on map 005              */
-    MAP016_DOOR_A,  /** State of a door on map 005              */
-    MAP016_DOOR_B,  /** State of a door on map 005              */
-    MAP016_DOOR_C,  /** State of a door on map 005              */
-    MAP020_DOOR_A,  /** State of a door on map 005              */
-    MAP020_DOOR_B,  /** State of a door on map 005              */
-    MAP020_DOOR_C,  /** State of a door on map 005              */
-    TERMINAL_001,
-    TERMINAL_002,
-    TERMINAL_003,
-    TERMINAL_004,
-    TERMINAL_005,
-    TERMINAL_006,
-    TERMINAL_007,
-    TERMINAL_008,
-    TERMINAL_009,
-    TERMINAL_010,
-    TERMINAL_011,
-    TERMINAL_012,
-    TERMINAL_013,
-    TERMINAL_014,
-    TERMINAL_015,
-    TERMINAL_016,
-    TERMINAL_017,
-    TERMINAL_018,
-    TERMINAL_019,
-    TERMINAL_020,
-    TERMINAL_021,
-    TERMINAL_022,
-    TERMINAL_023,
-    TERMINAL_024,
-    TERMINAL_025,
-    TERMINAL_026,
-    TERMINAL_027,
-    HJUMP_TERM,
-    TELEP_TERM,
-    SIGNL_TERM,
-    GAME_UPS,
-    TIMER_BOMB,
-    GAME_TIME,
+#define X(id, name) \
+    id,
+    GV_VARS
+#undef X
     GV_MAX        /** Global var count                         */
 } globalVar;
 
+/** Number of words in a bitmap with a bit for every global variable */
+#define GV_DIRTY_LEN ((GV_MAX + 31) / 32)
+/** Mark a variable on a bitmap of changed variables */
+#define GV_SET_DIRTY(pDirty, gv) \
+    ((pDirty)[(gv) / 32] |= 1u << ((gv) % 32))
+/** Check whether a variable is set on a bitmap of changed variables */
+#define GV_IS_DIRTY(pDirty, gv) \
+    (((pDirty)[(gv) / 32] >> ((gv) % 32)) & 1)
+
+/**
+ * Besides the variables above, each map may declare its own (on its .gfm
+ * file, as 'var:"name"'). Those are identified by the map's index and the
+ * variable's slot (i.e., the order it was declared), encoded after GV_MAX:
+ * 
+ *   GV_MAX + 1 + map * GV_LOCAL_MAX + slot
+ * 
+ * Map variables are stored on pages of GV_PAGE_LEN values, which are only
+ * alloc'ed (and saved) once any of its variables is set, so a map that was
+ * never visited (or that didn't set anything) doesn't cost anything.
+ */
+/** How many variables each map may declare */
+#define GV_LOCAL_MAX 64
+/** How many map variables are stored (and saved) together */
+#define GV_PAGE_LEN 32
+/** How many maps may declare variables */
+#define GV_MAP_MAX 4096
+/** Longest name of a map variable (including the '\0') */
+#define GV_NAME_LEN 32
+/** Retrieve a map's variable */
+#define GV_LOCAL(map, slot) \
+    ((globalVar)(GV_MAX + 1 + (map) * GV_LOCAL_MAX + (slot)))
+/** Retrieve the map of a map variable */
+#define GV_LOCAL_MAP(gv) (((int)(gv) - GV_MAX - 1) / GV_LOCAL_MAX)
+/** Retrieve the slot of a map variable */
+#define GV_LOCAL_SLOT(gv) (((int)(gv) - GV_MAX - 1) % GV_LOCAL_MAX)
+/** Retrieve the page where a map variable is stored */
+#define GV_PAGE_KEY(gv) (((int)(gv) - GV_MAX - 1) / GV_PAGE_LEN)
+/** Check whether a variable is either a global or a map one */
+#define GV_IS_VALID(gv) \
+    ((int)(gv) < GV_MAX || ((int)(gv) > GV_MAX \
+    && (int)(gv) < (int)GV_LOCAL(GV_MAP_MAX, 0)))
+
+/** Function called whenever a subscribed variable changes */
+typedef void (*gvListener)(void *pCtx);
+
 /**
  * Initialize the global variables
  * 
@@ -200,7 +310,18 @@ int gv_nIsZero(globalVar gv);
 char* gv_getName(globalVar gv);
 
 /**
- * Save the current state of the global vars to a file
+ * Retrieve a globalVar from its name
+ * 
+ * @param str The variable's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The globalVar or GV_MAX, on error
+ */
+globalVar gv_getVarFromString(char *str, int len);
+
+/**
+ * Save the current state of the global vars to a file; Only the variables
+ * (and pages of map variables) changed since the last save (or load) are
+ * written
  * 
  * @param filename The filename
  * @return GFraMe error code
@@ -215,5 +336,59 @@ GFraMe_ret gv_save(char *filename);
  */
 GFraMe_ret gv_load(char *filename);
 
+/**
+ * Save/restore every global variable (and which were changed since the last
+ * save) on a checkpoint
+ * 
+ * @param pCp The checkpoint
+ */
+void gv_checkpoint(checkpoint *pCp);
+
+/**
+ * Register a function to be called whenever a variable changes (so whatever
+ * depends on it doesn't have to check it every frame)
+ * 
+ * @param gv The global variable
+ * @param cb The function
+ * @param pCtx Passed to the function
+ * @return GFraMe error code
+ */
+GFraMe_ret gv_subscribe(globalVar gv, gvListener cb, void *pCtx);
+
+/**
+ * Remove every subscription (e.g., because the map's objects are being
+ * replaced)
+ */
+void gv_clearSubscriptions();
+
+/**
+ * Release the memory used by the subscriptions
+ */
+void gv_cleanSubscriptions();
+
+/**
+ * Set which map is being loaded, so it may declare its own variables;
+ * Variables declared by the previous map can't be referenced by name anymore
+ * 
+ * @param map The map's index, or -1 if it may not declare variables
+ */
+void gv_setMap(int map);
+
+/**
+ * Declare a variable on the current map; Its slot is the declaration's order,
+ * so new variables must be declared after the previous ones (otherwise, saves
+ * would be mixed up)
+ * 
+ * @param str The variable's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return GFraMe error code
+ */
+GFraMe_ret gv_declare(char *str, int len);
+
+/**
+ * Release the memory used by the map variables' pages
+ */
+void gv_clean();
+
 #endif
 
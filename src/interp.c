@@ -0,0 +1,82 @@
+/**
+ * @file src/interp.c
+ * 
+ * Interpolate positions between the last two updates. Every position is
+ * stored before an update and, while drawing, temporarily moved back between
+ * the stored and the current positions; This way, nothing needs to know
+ * whether it's being drawn interpolated.
+ */
+#include <GFraMe/GFraMe_object.h>
+
+#include "interp.h"
+
+/** Anything that moved more than this (in pixels) is drawn as is */
+#define IP_SNAP_DIST 32
+
+/**
+ * Store the position before an update
+ * 
+ * @param pPos The interpolated position
+ * @param x The current horizontal position
+ * @param y The current vertical position
+ */
+void ip_save(ipPos *pPos, int x, int y) {
+    pPos->lastX = x;
+    pPos->lastY = y;
+}
+
+/**
+ * Move a position between the last and the current update; Anything that
+ * moved too far (e.g., teleported) is kept on its current position
+ * 
+ * @param pPos The interpolated position
+ * @param pX The horizontal position (modified until ip_end is called)
+ * @param pY The vertical position (modified until ip_end is called)
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+void ip_begin(ipPos *pPos, int *pX, int *pY, int alpha) {
+    int dx, dy;
+    
+    pPos->x = *pX;
+    pPos->y = *pY;
+    
+    dx = *pX - pPos->lastX;
+    dy = *pY - pPos->lastY;
+    if (dx > IP_SNAP_DIST || dx < -IP_SNAP_DIST || dy > IP_SNAP_DIST
+            || dy < -IP_SNAP_DIST)
+        return;
+    
+    *pX = pPos->lastX + dx * alpha / IP_ONE;
+    *pY = pPos->lastY + dy * alpha / IP_ONE;
+}
+
+/**
+ * Restore a position modified by ip_begin
+ * 
+ * @param pPos The interpolated position
+ * @param pX The horizontal position
+ * @param pY The vertical position
+ */
+void ip_end(ipPos *pPos, int *pX, int *pY) {
+    *pX = pPos->x;
+    *pY = pPos->y;
+}
+
+/**
+ * Run a step of interpolating an object (e.g., a mob's or a player's); The
+ * position is retrieved with the entity's getObject, so every entity is
+ * interpolated by this same function
+ * 
+ * @param pPos The object's interpolated position
+ * @param pObj The object
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE] (only used by
+ *              IP_BEGIN)
+ */
+void ip_object(ipPos *pPos, GFraMe_object *pObj, ipStep step, int alpha) {
+    switch (step) {
+        case IP_SAVE: ip_save(pPos, pObj->x, pObj->y); break;
+        case IP_BEGIN: ip_begin(pPos, &pObj->x, &pObj->y, alpha); break;
+        case IP_END: ip_end(pPos, &pObj->x, &pObj->y); break;
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ * @file src/interp.h
+ * 
+ * Interpolate positions between the last two updates, so the game may be
+ * drawn more often than it's updated (e.g., updating at 60 FPS while drawing
+ * at 144 FPS) without stuttering
+ */
+#ifndef __INTERP_H_
+#define __INTERP_H_
+
+#include <GFraMe/GFraMe_object.h>
+
+/** Fixed-point value of a whole update (i.e., the current position) */
+#define IP_ONE 256
+
+/** Position of something between the last two updates */
+struct stIpPos {
+    /** Horizontal position before the last update */
+    int lastX;
+    /** Vertical position before the last update */
+    int lastY;
+    /** Actual horizontal position (only valid while interpolating) */
+    int x;
+    /** Actual vertical position (only valid while interpolating) */
+    int y;
+};
+typedef struct stIpPos ipPos;
+
+/** Steps of interpolating something, on every frame */
+typedef enum {
+    /** Store the position before an update (see ip_save) */
+    IP_SAVE,
+    /** Move it between the last two updates, for drawing (see ip_begin) */
+    IP_BEGIN,
+    /** Restore its current position, after drawing (see ip_end) */
+    IP_END
+} ipStep;
+
+/**
+ * Store the position before an update
+ * 
+ * @param pPos The interpolated position
+ * @param x The current horizontal position
+ * @param y The current vertical position
+ */
+void ip_save(ipPos *pPos, int x, int y);
+
+/**
+ * Move a position between the last and the current update; Anything that
+ * moved too far (e.g., teleported) is kept on its current position
+ * 
+ * @param pPos The interpolated position
+ * @param pX The horizontal position (modified until ip_end is called)
+ * @param pY The vertical position (modified until ip_end is called)
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+void ip_begin(ipPos *pPos, int *pX, int *pY, int alpha);
+
+/**
+ * Restore a position modified by ip_begin
+ * 
+ * @param pPos The interpolated position
+ * @param pX The horizontal position
+ * @param pY The vertical position
+ */
+void ip_end(ipPos *pPos, int *pX, int *pY);
+
+/**
+ * Run a step of interpolating an object (e.g., a mob's or a player's); The
+ * position is retrieved with the entity's getObject, so every entity is
+ * interpolated by this same function
+ * 
+ * @param pPos The object's interpolated position
+ * @param pObj The object
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE] (only used by
+ *              IP_BEGIN)
+ */
+void ip_object(ipPos *pPos, GFraMe_object *pObj, ipStep step, int alpha);
+
+#endif
+
@@ -10,14 +10,24 @@
 #include <GFraMe/GFraMe_screen.h>
 //#include <GFraMe/GFraMe_sprite.h>
 
+#include <SDL2/SDL_timer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio.h"
 #include "credits.h"
 #include "controller.h"
 #include "demo.h"
 #include "errorstate.h"
 #include "global.h"
+#include "globalVar.h"
 #include "menustate.h"
 #include "options.h"
 #include "playstate.h"
+#include "profiler.h"
+#include "replay.h"
 #include "save.h"
 #include "state.h"
 #include "types.h"
@@ -25,11 +35,109 @@
 void setIcon();
 
 #if defined(EMCC)
-#  include <stdio.h>
-#  include <stdlib.h>
 #  include <emscripten.h>
 #endif
 
+/** Default number of updates simulated when running headless */
+#define HEADLESS_TICKS 3600
+
+/**
+ * Run the playstate without a window nor audio (so it works without a display
+ * server), simulating a fixed number of updates with injected inputs (either
+ * generated or from a recording), and print its results to stdout
+ * 
+ * usage: game --headless [--ticks N] [--step MS] [--seed N] [--mt]
+ *                        [--replay FILE] [--trace FILE]
+ * 
+ * (--trace is only available when built with PROFILER)
+ * 
+ * @param argc Number of arguments
+ * @param argv The arguments
+ * @return GFraMe error code
+ */
+static int runHeadless(int argc, char *argv[]) {
+    psHeadlessResult res;
+    playstateCmd cmd;
+    GFraMe_ret rv;
+    char *replay;
+#if defined(PROFILER)
+    char *trace;
+#endif /* PROFILER */
+    int i, stepMs, ticks;
+    unsigned int seed;
+    
+    cmd = NEWGAME;
+    replay = NULL;
+#if defined(PROFILER)
+    trace = NULL;
+#endif /* PROFILER */
+    ticks = HEADLESS_TICKS;
+    stepMs = 1000 / GAME_UFPS;
+    seed = 0;
+    i = 2;
+    while (i < argc) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc)
+            stepMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = (unsigned int)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--mt") == 0)
+            cmd = MT_VERSION;
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay = argv[++i];
+            // Unless requested, run the replay until its end
+            if (ticks == HEADLESS_TICKS)
+                ticks = 0;
+        }
+#if defined(PROFILER)
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            trace = argv[++i];
+#endif /* PROFILER */
+        else {
+            fprintf(stderr, "usage: %s --headless [--ticks N] [--step MS] "
+                "[--seed N] [--mt] [--replay FILE] [--trace FILE]\n",
+                argv[0]);
+            return GFraMe_ret_bad_param;
+        }
+        i++;
+    }
+    
+    // Never touch the save files, the audio device nor the renderer
+    setup_volatile_blocks();
+    audio_disable();
+    rv = gl_initHeadless();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "global init failed", __ret);
+    
+    if (replay) {
+        rv = playstate_runReplay(&res, replay, ticks);
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Replay failed", __ret);
+        printf("{\"ticks\": %i, \"replay\": \"%s\", ", res.ticks, replay);
+    }
+    else {
+        rv = playstate_runHeadless(&res, cmd, ticks, stepMs, seed);
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Headless simulation failed",
+            __ret);
+        printf("{\"ticks\": %i, \"stepMs\": %i, \"seed\": %u, ", res.ticks,
+            stepMs, seed);
+    }
+    printf("\"map\": %i, \"elapsedMs\": %.3f, \"ticksPerSecond\": %.1f, "
+        "\"checksum\": \"%08x\"}\n", res.map, res.elapsedMs,
+        (res.elapsedMs > 0.0) ? res.ticks * 1000.0 / res.elapsedMs : 0.0,
+        res.checksum);
+#if defined(PROFILER)
+    prof_log();
+    if (trace)
+        prof_exportTrace(trace);
+#endif /* PROFILER */
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    gl_clean();
+    
+    return rv;
+}
+
 void mainloop(void **ctx) {
     struct stateHandler **pHandle = (struct stateHandler**)ctx;
     struct stateHandler *curState = *pHandle;
@@ -120,6 +228,12 @@ int main(int argc, char *argv[]) {
     GFraMe_wndext ext;
     int zoom, lang;
     
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+        return runHeadless(argc, argv);
+    // Record the inputs of the first game played
+    if (argc > 2 && strcmp(argv[1], "--record") == 0)
+        rp_setRecording(argv[2]);
+    
     ext.atlas = "atlas";
     ext.atlasWidth = 256;
     ext.atlasHeight = 256;
@@ -184,6 +298,7 @@ int main(int argc, char *argv[]) {
     
     curState = (struct stateHandler*)menustate_getHnd();
     curState->setup(curState);
+    GFraMe_log("Startup: menu ready after %ims", SDL_GetTicks());
 #if defined(EMCC)
     do {
         struct stateHandler **ctx;
@@ -208,6 +323,11 @@ int main(int argc, char *argv[]) {
 __ret:
     GFraMe_audio_player_pause();
     GFraMe_audio_player_clear();
+#if defined(PROFILER)
+    prof_clean();
+#endif /* PROFILER */
+    clean_blocks();
+    gv_clean();
     gl_clean();
     GFraMe_controller_close();
     GFraMe_quit();
@@ -7,18 +7,25 @@
 #include <GFraMe/GFraMe_sprite.h>
 #include <GFraMe/GFraMe_spriteset.h>
 
+#include <SDL2/SDL_timer.h>
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "camera.h"
 #include "commonEvent.h"
 #include "event.h"
 #include "global.h"
+#include "globalVar.h"
 #include "map.h"
+#include "mapCache.h"
 #include "mob.h"
 #include "object.h"
 #include "parser.h"
+#include "profiler.h"
 #include "registry.h"
+#include "triggerGrid.h"
 
 #include "quadtree/quadtree.h"
 
@@ -78,6 +85,9 @@ char *_map_tms[TM_MAX] = {
     "mt-maps/map019.gfm",
     "mt-maps/map020.gfm"
 };
+
+/** Statistics about the last map loaded */
+static mapLoadStats _map_loadStats;
 //============================================================================//
 //                                                                            //
 // Tiles definitions                                                          //
@@ -138,6 +148,39 @@ char *_map_tms[TM_MAX] = {
 #define TILE_TP4_1 83
 #define TILE_TP4_2 85
 
+//============================================================================//
+//                                                                            //
+// Chunks definitions                                                         //
+//                                                                            //
+//============================================================================//
+
+/** log2 of a chunk's width (and height), in tiles */
+#define CHUNK_BITS 5
+/** A chunk's width (and height), in tiles */
+#define CHUNK_DIM (1 << CHUNK_BITS)
+/** Mask to get a tile's position inside its chunk */
+#define CHUNK_MASK (CHUNK_DIM - 1)
+/** Number of tiles in a chunk */
+#define CHUNK_LEN (CHUNK_DIM * CHUNK_DIM)
+/** Offset of a tile (in tiles) inside its chunk */
+#define CHUNK_OFFSET(i, j) ((((j) & CHUNK_MASK) << CHUNK_BITS) \
+        + ((i) & CHUNK_MASK))
+
+/** log2 of the number of bits in each word of the solidity bitmap */
+#define SOLID_BITS 5
+/** Mask to get a tile's bit inside its word */
+#define SOLID_MASK ((1 << SOLID_BITS) - 1)
+/** Word of the solidity bitmap that contains a tile */
+#define SOLID_WORD(pM, i, j) \
+        ((pM)->solid[(j) * (pM)->solidStride + ((i) >> SOLID_BITS)])
+/** A tile's bit inside its word */
+#define SOLID_BIT(i) (1u << ((i) & SOLID_MASK))
+
+/** The chunk has a modified tile, so its walls must be regenerated */
+#define CHUNK_DIRTY 0x1
+/** A wall on the chunk was removed, so its tiles must be checked again */
+#define CHUNK_RESCAN 0x2
+
 //============================================================================//
 //                                                                            //
 // Structs                                                                    //
@@ -149,16 +192,35 @@ typedef struct {
     int elapsed;          /** How long has this tile being displayed */
 } animTile;
 
+typedef struct {
+    mapTile tiles[CHUNK_LEN];        /** The chunk's tiles, row by row        */
+    unsigned char inWall[CHUNK_LEN]; /** Whether a tile is in a wall object   */
+    int solidTiles;          /** How many wall tiles there are in the chunk   */
+    int animTiles;           /** How many animated tiles there are            */
+    int visibleTiles;        /** How many tiles must be rendered              */
+    int flags;               /** Whether its walls must be regenerated        */
+} mapChunk;
+
 struct stMap {
-    unsigned char *data;     /** Tilemap's data                               */
-    int dataLen;             /** Size of the tilemap's buffer                 */
+    mapTile *data;           /** Tilemap's data, as it was last set           */
+    int dataLen;             /** Size of the tilemap's buffer, in tiles       */
     int w;                   /** Width of the tilemap, in tiles               */
     int h;                   /** Height of the tilemap, int tiles             */
     int doReset;             /** Whether the walls should be reset            */
+    int doUpdate;            /** Whether some chunk's walls must be updated   */
+    
+    mapChunk *chunks;        /** Every chunk, row by row                      */
+    int chunksLen;           /** Size of the chunks' buffer                   */
+    int chunksW;             /** Width of the tilemap, in chunks              */
+    int chunksH;             /** Height of the tilemap, in chunks             */
     
     animTile *animTiles;     /** List of animated tiles in the tilemap's data */
     int animTilesLen;        /** Size of the list of animated tiles           */
     int animTilesUsed;       /** Number of animated tiles on the current      */
+    
+    unsigned int *solid;     /** Whether each tile is a wall (a bit per tile) */
+    int solidLen;            /** Size of the solidity bitmap, in words        */
+    int solidStride;         /** Words on each of the solidity bitmap's rows  */
 };
 
 //============================================================================//
@@ -192,14 +254,56 @@ static void map_animateTile(map *pM, animTile *pT, int ms);
  */
 static GFraMe_ret map_genAnimatedTiles(map *pM);
 
+/**
+ * Get the chunk that contains a tile; the tile must be inbounds
+ * 
+ * @param pM The map
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
+ * @return The chunk
+ */
+static mapChunk* map_getChunk(map *pM, int i, int j);
+
 /**
  * Check whether a tile is already in a wall object
  * 
  * @param pM The map
- * @param pos Position of the tile to be tested
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
  * @return GFraMe_ret_ok if it is, GFraMe_ret_failed otherwise
  */
-static GFraMe_ret map_isTileInWall(map *pM, int pos);
+static GFraMe_ret map_isTileInWall(map *pM, int i, int j);
+
+/**
+ * Mark (or unmark) every tile in an area as belonging to a wall object
+ * 
+ * @param pM The map
+ * @param x The area's horizontal position (in tiles)
+ * @param y The area's vertical position (in tiles)
+ * @param w The area's width (in tiles)
+ * @param h The area's height (in tiles)
+ * @param inWall Whether the tiles are in a wall
+ */
+static void map_setInWall(map *pM, int x, int y, int w, int h, int inWall);
+
+/**
+ * Get a wall's area, in tiles
+ * 
+ * @param pX Return the horizontal position
+ * @param pY Return the vertical position
+ * @param pW Return the width
+ * @param pH Return the height
+ * @param pObj The wall
+ */
+static void map_getWallArea(int *pX, int *pY, int *pW, int *pH,
+    GFraMe_object *pObj);
+
+/**
+ * Mark every tile covered by the walls on the registry
+ * 
+ * @param pM The map
+ */
+static void map_coverWalls(map *pM);
 
 /**
  * Get the bounds of a wall
@@ -209,10 +313,22 @@ static GFraMe_ret map_isTileInWall(map *pM, int pos);
  * @param pW Return the width
  * @param pH Return the height
  * @param pM The map
- * @param pos First tile in the wall
+ * @param i First tile's horizontal position in the wall
+ * @param j First tile's vertical position in the wall
  */
 static void map_getWallBounds(int *pX, int *pY, int *pW, int *pH, map *pM,
-    int pos);
+    int i, int j);
+
+/**
+ * Calculate where the walls should be placed, on a single chunk; Tiles that
+ * already belong to a wall are skipped
+ * 
+ * @param pM The map
+ * @param ci The chunk's horizontal position (in chunks)
+ * @param cj The chunk's vertical position (in chunks)
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_genChunkWalls(map *pM, int ci, int cj);
 
 /**
  * Calculate where the walls should be placed
@@ -222,6 +338,40 @@ static void map_getWallBounds(int *pX, int *pY, int *pW, int *pH, map *pM,
  */
 static GFraMe_ret map_genWalls(map *pM);
 
+/**
+ * Remove every wall and generate the map's ones from scratch, accounting how
+ * long it took
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_resetWalls(map *pM);
+
+/**
+ * Get how many milliseconds elapsed since a given performance counter
+ * 
+ * @param start The initial counter
+ * @return The elapsed time, in milliseconds
+ */
+static double map_getElapsedMs(Uint64 start);
+
+/**
+ * Regenerate only the walls on modified chunks (removing any wall that
+ * touches those)
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_updateWalls(map *pM);
+
+/**
+ * Copy the tilemap's data into its chunks and calculate their summaries
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_genChunks(map *pM);
+
 /**
  * Realloc the animTiles buffer as to have at least 'len' members
  * 
@@ -237,7 +387,7 @@ static GFraMe_ret map_setAnimTilesMinLength(map *pM, int len);
  * @param tile The tile
  * @return GFraMe_ret_ok on sucess, GFraMe_ret_failed otherwise
  */
-static GFraMe_ret map_isWall(unsigned char tile);
+static GFraMe_ret map_isWall(mapTile tile);
 
 //============================================================================//
 //                                                                            //
@@ -275,15 +425,23 @@ GFraMe_ret map_init(map **ppM) {
     pM->w = 0;
     pM->h = 0;
     pM->doReset = 0;
+    pM->doUpdate = 0;
+    pM->chunks = NULL;
+    pM->chunksLen = 0;
+    pM->chunksW = 0;
+    pM->chunksH = 0;
     pM->animTiles = NULL;
     pM->animTilesLen = 0;
     pM->animTilesUsed = 0;
+    pM->solid = NULL;
+    pM->solidLen = 0;
+    pM->solidStride = 0;
     
     // Initialize every struture it might use
     pM->w = 40;
     pM->h = 30;
     pM->dataLen = pM->w * pM->h;
-    pM->data = (unsigned char*)malloc(pM->dataLen);
+    pM->data = (mapTile*)malloc(sizeof(mapTile) * pM->dataLen);
     GFraMe_assertRV(pM->data, "Failed to alloc!", rv = GFraMe_ret_memory_error,
         __ret);
     
@@ -312,8 +470,12 @@ void map_clean(map **ppM) {
     
     if ((*ppM)->data)
         free((*ppM)->data);
+    if ((*ppM)->chunks)
+        free((*ppM)->chunks);
     if ((*ppM)->animTiles)
         free((*ppM)->animTiles);
+    if ((*ppM)->solid)
+        free((*ppM)->solid);
     
     free(*ppM);
     *ppM = NULL;
@@ -331,6 +493,8 @@ void map_reset(map *pM) {
     
     pM->w = 0;
     pM->h = 0;
+    pM->chunksW = 0;
+    pM->chunksH = 0;
     pM->animTilesUsed = 0;
     
 __ret:
@@ -338,14 +502,15 @@ __ret:
 }
 
 /**
- * Get the current tilemap, if any
+ * Get the buffer the tilemap was last set from, if any. Note that tiles
+ * modified through map_setTile aren't reflected on this buffer
  * 
  * @param ppData Data retrieved or NULL
- * @param pLen How many bytes there are in the buffer
+ * @param pLen How many tiles there are in the buffer
  * @param pM The map
  * @return GFraMe error code
  */
-GFraMe_ret map_getTilemapData(unsigned char **ppData, int *pLen, map *pM) {
+GFraMe_ret map_getTilemapData(mapTile **ppData, int *pLen, map *pM) {
     GFraMe_ret rv;
     
     // Sanitize parameters
@@ -362,23 +527,24 @@ __ret:
 }
 
 /**
- * Set the current tilemap
+ * Set the current tilemap; its tiles are copied into the map's chunks
  * 
  * @param pM The map
  * @param pData The tilemap
- * @param len How many bytes there are in the buffer (needn't all be in use)
+ * @param len How many tiles there are in the buffer (needn't all be in use)
  * @param w How many tiles there are horizontally
  * @param h How many tiles there are vertically
+ * @return GFraMe error code
  */
-void map_setTilemap(map *pM, unsigned char *pData, int len, int w, int h) {
+GFraMe_ret map_setTilemap(map *pM, mapTile *pData, int len, int w, int h) {
     GFraMe_ret rv;
     
     // Sanitize parameters
-    ASSERT_NR(pM);
-    ASSERT_NR(pData);
-    ASSERT_NR(len > 0);
-    ASSERT_NR(w > 0);
-    ASSERT_NR(h > 0);
+    ASSERT(pM, GFraMe_ret_bad_param);
+    ASSERT(pData, GFraMe_ret_bad_param);
+    ASSERT(len > 0, GFraMe_ret_bad_param);
+    ASSERT(w > 0, GFraMe_ret_bad_param);
+    ASSERT(h > 0, GFraMe_ret_bad_param);
     
     // Set the data
     pM->data = pData;
@@ -386,13 +552,104 @@ void map_setTilemap(map *pM, unsigned char *pData, int len, int w, int h) {
     pM->w = w;
     pM->h = h;
     
+    // Split the tilemap into chunks
+    rv = map_genChunks(pM);
+    ASSERT(rv == GFraMe_ret_ok, rv);
+    
     // Animate the tilemap
     pM->animTilesUsed = 0;
     rv = map_genAnimatedTiles(pM);
-    ASSERT_NR(rv == GFraMe_ret_ok);
-    // TODO return the error
+    ASSERT(rv == GFraMe_ret_ok, rv);
     
     pM->doReset = 1;
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Get a tile from the map
+ * 
+ * @param pM The map
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
+ * @return The tile (0, if out of bounds)
+ */
+mapTile map_getTile(map *pM, int i, int j) {
+    if (i < 0 || j < 0 || i >= pM->w || j >= pM->h)
+        return 0;
+    
+    return map_getChunk(pM, i, j)->tiles[CHUNK_OFFSET(i, j)];
+}
+
+/**
+ * Modify a single tile; only the walls on the modified chunk (and the ones
+ * touching it) are regenerated, on the next update
+ * 
+ * @param pM The map
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
+ * @param tile The new tile
+ */
+void map_setTile(map *pM, int i, int j, mapTile tile) {
+    mapChunk *pC;
+    mapTile old;
+    int isAnim, wasAnim;
+    
+    // Check that it's inbound
+    ASSERT_NR(i >= 0 && i < pM->w);
+    ASSERT_NR(j >= 0 && j < pM->h);
+    
+    pC = map_getChunk(pM, i, j);
+    old = pC->tiles[CHUNK_OFFSET(i, j)];
+    ASSERT_NR(old != tile);
+    pC->tiles[CHUNK_OFFSET(i, j)] = tile;
+    
+    // Update the chunk's summary
+    if (map_isWall(old) == GFraMe_ret_ok) {
+        pC->solidTiles--;
+        pC->flags |= CHUNK_DIRTY;
+        SOLID_WORD(pM, i, j) &= ~SOLID_BIT(i);
+    }
+    if (map_isWall(tile) == GFraMe_ret_ok) {
+        pC->solidTiles++;
+        pC->flags |= CHUNK_DIRTY;
+        SOLID_WORD(pM, i, j) |= SOLID_BIT(i);
+    }
+    if (old != 0 && old != 64)
+        pC->visibleTiles--;
+    if (tile != 0 && tile != 64)
+        pC->visibleTiles++;
+    
+    wasAnim = (map_tileIsAnimated(old) == GFraMe_ret_ok);
+    isAnim = (map_tileIsAnimated(tile) == GFraMe_ret_ok);
+    pC->animTiles += isAnim - wasAnim;
+    // Tiles that stop being animated are simply skipped by map_animateTile
+    // (so, if it's animated again, its previous entry is reused)
+    if (isAnim && !wasAnim) {
+        animTile *pT;
+        GFraMe_ret rv;
+        int k, pos;
+        
+        pos = i + j * pM->w;
+        k = 0;
+        while (k < pM->animTilesUsed && pM->animTiles[k].pos != pos)
+            k++;
+        if (k == pM->animTilesUsed) {
+            if (pM->animTilesUsed >= pM->animTilesLen) {
+                rv = map_setAnimTilesMinLength(pM, pM->animTilesLen*2);
+                ASSERT_NR(rv == GFraMe_ret_ok);
+            }
+            pM->animTilesUsed++;
+        }
+        pT = &pM->animTiles[k];
+        
+        pT->pos = pos;
+        pT->elapsed = 0;
+    }
+    
+    if (pC->flags & CHUNK_DIRTY)
+        pM->doUpdate = 1;
 __ret:
     return;
 }
@@ -406,8 +663,26 @@ __ret:
  * @return GFraMe error code
  */
 GFraMe_ret map_loads(map *m, char *str, int len) {
-    // Wrong return... >__<
-    return GFraMe_ret_failed;
+    GFraMe_ret rv;
+    Uint64 start;
+    
+    // Only indexed maps may declare their own variables
+    gv_setMap(-1);
+    
+    // Parse the map from the string
+    memset(&_map_loadStats, 0x0, sizeof(_map_loadStats));
+    start = SDL_GetPerformanceCounter();
+    rv = parses_map(&m, str, len);
+    _map_loadStats.parseMs = map_getElapsedMs(start);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    
+    // Events never move, so they are only indexed once
+    rv = tg_build(m);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
 }
 
 /**
@@ -419,9 +694,14 @@ GFraMe_ret map_loads(map *m, char *str, int len) {
  */
 static GFraMe_ret _map_loadf(map *pM, char *fn) {
     GFraMe_ret rv;
+    Uint64 start;
+    
+    memset(&_map_loadStats, 0x0, sizeof(_map_loadStats));
     
     // Parse the map from a file
+    start = SDL_GetPerformanceCounter();
     rv = parsef_map(&pM, fn);
+    _map_loadStats.parseMs = map_getElapsedMs(start);
     
     return rv;
 }
@@ -444,10 +724,17 @@ GFraMe_ret map_loadf(map *pM, char *fn) {
 	rv = GFraMe_assets_clean_filename(name, fn, &len);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
     
+    // Only indexed maps may declare their own variables
+    gv_setMap(-1);
+    
     // Load the map
     rv = _map_loadf(pM, name);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
     
+    // Events never move, so they are only indexed once
+    rv = tg_build(pM);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    
     rv = GFraMe_ret_ok;
 __ret:
     return rv;
@@ -470,20 +757,74 @@ GFraMe_ret map_loadi(map *m, int i) {
     GFraMe_assertRV(i >=0 && i < TM_MAX, "Invalid map index", rv = GFraMe_ret_failed,
         __ret);
     
+    // Restore the map's pristine state, if it was already loaded
+    rv = mc_restore(m, i);
+    if (rv == GFraMe_ret_ok) {
+        // The walls were restored as well
+        map_coverWalls(m);
+        m->doReset = 0;
+        memset(&_map_loadStats, 0x0, sizeof(_map_loadStats));
+        _map_loadStats.cached = 1;
+        
+        rv = tg_build(m);
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+        goto __ret;
+    }
+    
     // Retrive a valid asset filename
     len = MAX_NAME_LEN;
 	rv = GFraMe_assets_clean_filename(name, _map_tms[i], &len);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
     
+    // Any variable declared by the map is stored by its index
+    gv_setMap(i);
+    
     // Load the map
     rv = _map_loadf(m, name);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
     
+    // Generate the walls right away, so they are cached with the map
+    rv = map_resetWalls(m);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    
+    // Caching is optional, so ignore any error
+    mc_store(m, i);
+    
+    // Events never move, so they are only indexed once
+    rv = tg_build(m);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to load map", __ret);
+    
     rv = GFraMe_ret_ok;
 __ret:
     return rv;
 }
 
+/**
+ * Get the file of a indexed map
+ * 
+ * @param i The map's index
+ * @return The map's filename (relative to the assets) or NULL, if the index is
+ *         invalid
+ */
+char* map_getFilename(int i) {
+    if (i < 0 || i >= TM_MAX)
+        return NULL;
+    return _map_tms[i];
+}
+
+/**
+ * Retrieve statistics about the last map loaded; its walls are only accounted
+ * for after they are generated (i.e., right away by map_loadi, but only on the
+ * first map_update after map_loadf)
+ * 
+ * @param pStats Returns the statistics
+ * @param pM The map
+ */
+void map_getLoadStats(mapLoadStats *pStats, map *pM) {
+    memcpy(pStats, &_map_loadStats, sizeof(mapLoadStats));
+    pStats->walls = rg_getWallsUsed();
+    pStats->animTiles = pM->animTilesUsed;
+}
 
 /**
  * Animate the map tiles
@@ -497,12 +838,16 @@ void map_update(map *pM, int ms) {
     if (pM->doReset) {
         GFraMe_ret rv;
         
-        rg_resetWall();
-        rv = map_genWalls(pM);
+        rv = map_resetWalls(pM);
         ASSERT_NR(rv == GFraMe_ret_ok);
         // TODO return the error
+    }
+    else if (pM->doUpdate) {
+        GFraMe_ret rv;
         
-        pM->doReset = 0;
+        rv = map_updateWalls(pM);
+        ASSERT_NR(rv == GFraMe_ret_ok);
+        // TODO return the error
     }
     // Update every animated tile
     i = 0;
@@ -525,53 +870,79 @@ __ret:
  * @param pM The map
  */
 void map_draw(map *pM) {
-    int firstTile, dX, i, iniX, offX, x, y;
-    
-    // Get the first tile position on screen
-    iniX = -(cam_x % 8);
-    y = -(cam_y % 8);
-    // Get the first tile position
-    firstTile = cam_x / 8 + cam_y / 8 * pM->w;
-    // Get how many tiles are skipped each row
-    dX = pM->w - SCR_W / 8;
-    // If the camera's pos doesn't match a tile, it will render 1 extra tile
-    if (iniX != 0)
-        dX--;
-    
-    // Loop through every tile
-    i = 0;
-    x = iniX;
-    offX = 0;
-    while (1) {
-        int tile;
-        
-        // Check that the tile is still valid
-        if (i >= pM->w * pM->h)
-            break;
-        
-        // Render the tile to the screen
-        tile = pM->data[firstTile + offX + i];
-        if (tile > 0 && tile != 64) {
-            GFraMe_spriteset_draw
-                (
-                 gl_sset8x8,
-                 tile,
-                 x,
-                 y,
-                 0 // flipped
-                );
-        }
-        
-        // Updates the tile position
-        x += 8;
-        if (x >= SCR_W) {
-            x = iniX;
-            y += 8;
-            offX += dX;
+    int ci, cj, endCi, endCj, endI, endJ, iniI, iniJ;
+    
+    // Get the visible tiles (there may be one extra row/column, when the
+    // camera isn't aligned to the tiles)
+    iniI = cam_x / 8;
+    iniJ = cam_y / 8;
+    endI = (cam_x + SCR_W - 1) / 8;
+    endJ = (cam_y + SCR_H) / 8;
+    if (iniI < 0)
+        iniI = 0;
+    if (iniJ < 0)
+        iniJ = 0;
+    if (endI >= pM->w)
+        endI = pM->w - 1;
+    if (endJ >= pM->h)
+        endJ = pM->h - 1;
+    
+    // Loop through every visible chunk
+    endCi = endI >> CHUNK_BITS;
+    endCj = endJ >> CHUNK_BITS;
+    cj = iniJ >> CHUNK_BITS;
+    while (cj <= endCj) {
+        ci = iniI >> CHUNK_BITS;
+        while (ci <= endCi) {
+            mapChunk *pC;
+            int i, j, lastI, lastJ;
+            
+            pC = &pM->chunks[ci + cj * pM->chunksW];
+            // Skip chunks without anything to be rendered
+            if (pC->visibleTiles == 0) {
+                ci++;
+                continue;
+            }
+            
+            // Get the visible area of the chunk
+            j = cj << CHUNK_BITS;
+            if (j < iniJ)
+                j = iniJ;
+            lastJ = (cj << CHUNK_BITS) + CHUNK_MASK;
+            if (lastJ > endJ)
+                lastJ = endJ;
+            lastI = (ci << CHUNK_BITS) + CHUNK_MASK;
+            if (lastI > endI)
+                lastI = endI;
+            
+            while (j <= lastJ) {
+                i = ci << CHUNK_BITS;
+                if (i < iniI)
+                    i = iniI;
+                
+                while (i <= lastI) {
+                    int tile;
+                    
+                    // Render the tile to the screen
+                    tile = pC->tiles[CHUNK_OFFSET(i, j)];
+                    if (tile > 0 && tile != 64) {
+                        PROF_SPRITESET_DRAW
+                            (
+                             MAP,
+                             gl_sset8x8,
+                             tile,
+                             i * 8 - cam_x,
+                             j * 8 - cam_y,
+                             0 // flipped
+                            );
+                    }
+                    i++;
+                }
+                j++;
+            }
+            ci++;
         }
-        if (y > SCR_H)
-            break;
-        i++;
+        cj++;
     }
 }
 
@@ -596,24 +967,11 @@ void map_getDimensions(map *pM, int *pW, int *pH) {
  * @return GFraMe_ret_ok on success
  */
 GFraMe_ret map_isPixelSolid(map *pM, int x, int y) {
-    GFraMe_ret rv;
-    int tx, ty;
-    unsigned char tile;
-    
-    // Get the current tile
-    tx = x / 8;
-    ty = y / 8;
-    ASSERT(tx < pM->w, GFraMe_ret_failed);
-    ASSERT(ty < pM->h, GFraMe_ret_failed);
     // Use the pixel position to account for [-7, -1] values
-    ASSERT(x >= 0, GFraMe_ret_failed);
-    ASSERT(y >= 0, GFraMe_ret_failed);
+    if (x < 0 || y < 0)
+        return GFraMe_ret_failed;
     
-    // Get the tile and check it
-    tile = pM->data[tx + ty*pM->w];
-    rv = map_isWall(tile);
-__ret:
-    return rv;
+    return map_isTileSolid(pM, x >> 3, y >> 3);
 }
 
 /**
@@ -625,18 +983,143 @@ __ret:
  * @return GFraMe_ret_ok on success
  */
 GFraMe_ret map_isTileSolid(map *pM, int i, int j) {
-    GFraMe_ret rv;
-    unsigned char tile;
+    // Check that it's inbound (casting to unsigned also catches negatives)
+    if ((unsigned)i >= (unsigned)pM->w || (unsigned)j >= (unsigned)pM->h)
+        return GFraMe_ret_failed;
     
-    // Check that it's inbound
-    ASSERT(i < pM->w, GFraMe_ret_failed);
-    ASSERT(j < pM->h, GFraMe_ret_failed);
+    if (SOLID_WORD(pM, i, j) & SOLID_BIT(i))
+        return GFraMe_ret_ok;
+    return GFraMe_ret_failed;
+}
+
+/**
+ * Check if any tile in an area (in pixels) is solid
+ * 
+ * @param pM The map
+ * @param x The area's horizontal position
+ * @param y The area's vertical position
+ * @param w The area's width
+ * @param h The area's height
+ * @return GFraMe_ret_ok if any is solid, GFraMe_ret_failed otherwise
+ */
+GFraMe_ret map_isAreaSolid(map *pM, int x, int y, int w, int h) {
+    int i0, i1, j, j0, j1, k0, k1;
     
-    // Get the tile and check it
-    tile = pM->data[i + j*pM->w];
-    rv = map_isWall(tile);
-__ret:
-    return rv;
+    if (w <= 0 || h <= 0)
+        return GFraMe_ret_failed;
+    
+    // Get the tiles touched by the area, clamped to the map
+    i0 = x >> 3;
+    j0 = y >> 3;
+    i1 = (x + w - 1) >> 3;
+    j1 = (y + h - 1) >> 3;
+    if (i0 < 0)
+        i0 = 0;
+    if (j0 < 0)
+        j0 = 0;
+    if (i1 >= pM->w)
+        i1 = pM->w - 1;
+    if (j1 >= pM->h)
+        j1 = pM->h - 1;
+    if (i0 > i1 || j0 > j1)
+        return GFraMe_ret_failed;
+    
+    // Check whole words at a time, masking the first and last ones
+    k0 = i0 >> SOLID_BITS;
+    k1 = i1 >> SOLID_BITS;
+    j = j0;
+    while (j <= j1) {
+        unsigned int *pRow;
+        unsigned int first, last;
+        int k;
+        
+        pRow = pM->solid + j * pM->solidStride;
+        first = ~0u << (i0 & SOLID_MASK);
+        last = ~0u >> (SOLID_MASK - (i1 & SOLID_MASK));
+        if (k0 == k1) {
+            if (pRow[k0] & first & last)
+                return GFraMe_ret_ok;
+        }
+        else {
+            if ((pRow[k0] & first) || (pRow[k1] & last))
+                return GFraMe_ret_ok;
+            k = k0 + 1;
+            while (k < k1) {
+                if (pRow[k])
+                    return GFraMe_ret_ok;
+                k++;
+            }
+        }
+        j++;
+    }
+    
+    return GFraMe_ret_failed;
+}
+
+/**
+ * Walk through every tile touched by a line (in pixels), in order, until a
+ * solid one is found; Tiles outside the map are never solid
+ * 
+ * @param pI Returns the horizontal position of the solid tile (may be NULL)
+ * @param pJ Returns the vertical position of the solid tile (may be NULL)
+ * @param pM The map
+ * @param x0 The line's initial horizontal position
+ * @param y0 The line's initial vertical position
+ * @param x1 The line's final horizontal position
+ * @param y1 The line's final vertical position
+ * @return GFraMe_ret_ok if a solid tile was hit, GFraMe_ret_failed otherwise
+ */
+GFraMe_ret map_raycast(int *pI, int *pJ, map *pM, int x0, int y0, int x1,
+    int y1) {
+    int adx, ady, i, i1, j, j1, nextX, nextY, si, sj;
+    
+    i = x0 >> 3;
+    j = y0 >> 3;
+    i1 = x1 >> 3;
+    j1 = y1 >> 3;
+    si = (x1 > x0)? 1 : -1;
+    sj = (y1 > y0)? 1 : -1;
+    adx = (x1 > x0)? x1 - x0 : x0 - x1;
+    ady = (y1 > y0)? y1 - y0 : y0 - y1;
+    
+    // Distance (along each axis, from the center of the initial pixel, and
+    // doubled so it's kept integer) to the next tile's border; Each distance
+    // is scaled by the other axis' length, so they may be compared without
+    // dividing anything
+    if (si > 0)
+        nextX = (((i + 1) << 3) - x0) * 2 - 1;
+    else
+        nextX = (x0 - (i << 3)) * 2 + 1;
+    if (sj > 0)
+        nextY = (((j + 1) << 3) - y0) * 2 - 1;
+    else
+        nextY = (y0 - (j << 3)) * 2 + 1;
+    
+    while (1) {
+        if ((unsigned)i < (unsigned)pM->w && (unsigned)j < (unsigned)pM->h
+                && (SOLID_WORD(pM, i, j) & SOLID_BIT(i))) {
+            if (pI)
+                *pI = i;
+            if (pJ)
+                *pJ = j;
+            return GFraMe_ret_ok;
+        }
+        
+        // Step into whichever tile the line enters first (horizontally, on
+        // a corner, so the line can't slip between two diagonal walls)
+        if (i == i1 && j == j1)
+            break;
+        else if (j == j1 || (i != i1 && nextX * ady <= nextY * adx)) {
+            i += si;
+            nextX += 16;
+        }
+        else {
+            j += sj;
+            nextY += 16;
+        }
+    }
+    
+    return GFraMe_ret_failed;
 }
 
 
@@ -712,13 +1195,17 @@ static GFraMe_ret map_tileIsAnimated(int tile) {
  * @param ms Time elapsed from the previous frame
  */
 static void map_animateTile(map *pM, animTile *pT, int ms) {
-    unsigned char tile;
+    mapTile *pTile, tile;
+    int i, j;
     
     // Update the tile's running time
     pT->elapsed += ms;
     
     // Check which tile it is
-    tile = pM->data[pT->pos];
+    i = pT->pos % pM->w;
+    j = pT->pos / pM->w;
+    pTile = &map_getChunk(pM, i, j)->tiles[CHUNK_OFFSET(i, j)];
+    tile = *pTile;
     
     // Update the tile, if necessary
     switch (tile) {
@@ -820,7 +1307,7 @@ static void map_animateTile(map *pM, animTile *pT, int ms) {
         default: {}
     }
     
-    pM->data[pT->pos] = tile;
+    *pTile = tile;
 }
 
 /**
@@ -831,31 +1318,61 @@ static void map_animateTile(map *pM, animTile *pT, int ms) {
  */
 static GFraMe_ret map_genAnimatedTiles(map *pM) {
     GFraMe_ret rv;
-    int i;
+    int ci, cj;
     
-    i = 0;
-    while (i < pM->w*pM->h) {
-        unsigned char t;
-        
-        t = pM->data[i];
-        if (map_tileIsAnimated(t) == GFraMe_ret_ok) {
-            animTile *tile;
+    cj = 0;
+    while (cj < pM->chunksH) {
+        ci = 0;
+        while (ci < pM->chunksW) {
+            mapChunk *pC;
+            int i, j, lastI, lastJ;
             
-            // Expand the buffer as necessary
-            if (pM->animTilesUsed >= pM->animTilesLen) {
-                rv = map_setAnimTilesMinLength(pM, pM->animTilesLen*2);
-                ASSERT(rv == GFraMe_ret_ok, rv);
+            // Only check chunks with animated tiles
+            pC = &pM->chunks[ci + cj * pM->chunksW];
+            if (pC->animTiles == 0) {
+                ci++;
+                continue;
             }
             
-            // Get the animated tile
-            tile = &pM->animTiles[pM->animTilesUsed];
-            pM->animTilesUsed++;
+            lastI = (ci + 1) << CHUNK_BITS;
+            if (lastI > pM->w)
+                lastI = pM->w;
+            lastJ = (cj + 1) << CHUNK_BITS;
+            if (lastJ > pM->h)
+                lastJ = pM->h;
             
-            // Initialize the animated tile
-            tile->pos = i;
-            tile->elapsed = 0;
+            j = cj << CHUNK_BITS;
+            while (j < lastJ) {
+                i = ci << CHUNK_BITS;
+                while (i < lastI) {
+                    mapTile t;
+                    
+                    t = pC->tiles[CHUNK_OFFSET(i, j)];
+                    if (map_tileIsAnimated(t) == GFraMe_ret_ok) {
+                        animTile *tile;
+                        
+                        // Expand the buffer as necessary
+                        if (pM->animTilesUsed >= pM->animTilesLen) {
+                            rv = map_setAnimTilesMinLength(pM,
+                                pM->animTilesLen*2);
+                            ASSERT(rv == GFraMe_ret_ok, rv);
+                        }
+                        
+                        // Get the animated tile
+                        tile = &pM->animTiles[pM->animTilesUsed];
+                        pM->animTilesUsed++;
+                        
+                        // Initialize the animated tile
+                        tile->pos = i + j * pM->w;
+                        tile->elapsed = 0;
+                    }
+                    i++;
+                }
+                j++;
+            }
+            ci++;
         }
-        i++;
+        cj++;
     }
     
     rv = GFraMe_ret_ok;
@@ -863,44 +1380,118 @@ __ret:
     return rv;
 }
 
+/**
+ * Get the chunk that contains a tile; the tile must be inbounds
+ * 
+ * @param pM The map
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
+ * @return The chunk
+ */
+static mapChunk* map_getChunk(map *pM, int i, int j) {
+    return &pM->chunks[(i >> CHUNK_BITS) + (j >> CHUNK_BITS) * pM->chunksW];
+}
+
 /**
  * Check whether a tile is already in a wall object
  * 
  * @param pM The map
- * @param pos Position of the tile to be tested
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
  * @return GFraMe_ret_ok if it is, GFraMe_ret_failed otherwise
  */
-static GFraMe_ret map_isTileInWall(map *pM, int pos) {
-    int i, x, y;
+static GFraMe_ret map_isTileInWall(map *pM, int i, int j) {
+    if (map_getChunk(pM, i, j)->inWall[CHUNK_OFFSET(i, j)])
+        return GFraMe_ret_ok;
+    return GFraMe_ret_failed;
+}
+
+/**
+ * Mark (or unmark) every tile in an area as belonging to a wall object
+ * 
+ * @param pM The map
+ * @param x The area's horizontal position (in tiles)
+ * @param y The area's vertical position (in tiles)
+ * @param w The area's width (in tiles)
+ * @param h The area's height (in tiles)
+ * @param inWall Whether the tiles are in a wall
+ */
+static void map_setInWall(map *pM, int x, int y, int w, int h, int inWall) {
+    int i, j;
     
-    // Retrieve horizontal and vertical position of the tile
-    x = pos % pM->w;
-    y = pos / pM->w;
+    // Clamp the area to the map
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > pM->w)
+        w = pM->w - x;
+    if (y + h > pM->h)
+        h = pM->h - y;
     
-    // Check against every object
+    j = y;
+    while (j < y + h) {
+        i = x;
+        while (i < x + w) {
+            map_getChunk(pM, i, j)->inWall[CHUNK_OFFSET(i, j)] = inWall;
+            i++;
+        }
+        j++;
+    }
+}
+
+/**
+ * Get a wall's area, in tiles
+ * 
+ * @param pX Return the horizontal position
+ * @param pY Return the vertical position
+ * @param pW Return the width
+ * @param pH Return the height
+ * @param pObj The wall
+ */
+static void map_getWallArea(int *pX, int *pY, int *pW, int *pH,
+    GFraMe_object *pObj) {
+    GFraMe_hitbox *hb;
+    
+    hb = GFraMe_object_get_hitbox(pObj);
+    
+    *pX = pObj->x / 8;
+    *pY = pObj->y / 8;
+    *pW = (pObj->x + hb->cx + hb->hw) / 8 - *pX;
+    *pH = (pObj->y + hb->cy + hb->hh) / 8 - *pY;
+}
+
+/**
+ * Mark every tile covered by the walls on the registry
+ * 
+ * @param pM The map
+ */
+static void map_coverWalls(map *pM) {
+    int i;
+    
+    // Clear every chunk
+    i = 0;
+    while (i < pM->chunksW * pM->chunksH) {
+        memset(pM->chunks[i].inWall, 0x0, sizeof(pM->chunks[i].inWall));
+        pM->chunks[i].flags = 0;
+        i++;
+    }
+    pM->doUpdate = 0;
+    
+    // Mark the area of every wall
     i = 0;
     while (i < rg_getWallsUsed()) {
-        GFraMe_object *obj;
-        GFraMe_hitbox *hb;
-        int iniX, iniY, endX, endY;
-        
-        // Get both the object and the boundings
-        obj = rg_getWall(i);
-        hb = GFraMe_object_get_hitbox(obj);
-        
-        iniX = obj->x / 8;
-        endX = (obj->x + hb->cx + hb->hw) / 8 - 1;
-        iniY = obj->y / 8;
-        endY = (obj->y + hb->cy + hb->hh) / 8 - 1;
+        int h, w, x, y;
         
-        // Check if the tile is inside this object
-        if (x >= iniX && x <= endX && y >= iniY && y <= endY)
-            return GFraMe_ret_ok;
+        map_getWallArea(&x, &y, &w, &h, rg_getWall(i));
+        map_setInWall(pM, x, y, w, h, 1);
         
         i++;
     }
-    
-    return GFraMe_ret_failed;
 }
 
 /**
@@ -909,7 +1500,7 @@ static GFraMe_ret map_isTileInWall(map *pM, int pos) {
  * @param tile The tile
  * @return GFraMe_ret_ok on sucess, GFraMe_ret_failed otherwise
  */
-static GFraMe_ret map_isWall(unsigned char tile) {
+static GFraMe_ret map_isWall(mapTile tile) {
     switch (tile) {
         case 72:
         case 73:
@@ -953,24 +1544,20 @@ static GFraMe_ret map_isWall(unsigned char tile) {
  * @param pW Return the width
  * @param pH Return the height
  * @param pM The map
- * @param pos First tile in the wall
+ * @param x First tile's horizontal position in the wall
+ * @param y First tile's vertical position in the wall
  */
 static void map_getWallBounds(int *pX, int *pY, int *pW, int *pH, map *pM,
-    int pos) {
-    int i, h, w, x, y;
+    int x, int y) {
+    int i, h, w;
     
-    // Get the (x, y) tile position
-    x = pos % pM->w;
-    y = pos / pM->w;
-    
-    // Search for the first 'non-wall' on the horizontal
+    // Search for the first 'non-wall' on the horizontal (tiles already on
+    // another wall are skipped, so walls never overlap)
     i = 0;
     while (x + i < pM->w) {
-        unsigned char tile;
-        
-        tile = pM->data[pos + i];
-        
-        if (map_isWall(tile) != GFraMe_ret_ok)
+        if (map_isTileSolid(pM, x + i, y) != GFraMe_ret_ok)
+            break;
+        if (map_isTileInWall(pM, x + i, y) == GFraMe_ret_ok)
             break;
         
         i++;
@@ -982,13 +1569,13 @@ static void map_getWallBounds(int *pX, int *pY, int *pW, int *pH, map *pM,
     h = 0x7fffffff;
     while (i < w) {
         int j;
-        unsigned char tile;
         
         // Check which tile isn't a wall, anymore
         j = 0;
-        while (j + y < pM->h) {
-            tile = pM->data[pos + i + j * pM->w];
-            if (map_isWall(tile) != GFraMe_ret_ok)
+        while (j + y < pM->h && j < h) {
+            if (map_isTileSolid(pM, x + i, y + j) != GFraMe_ret_ok)
+                break;
+            if (map_isTileInWall(pM, x + i, y + j) == GFraMe_ret_ok)
                 break;
             j++;
         }
@@ -1000,12 +1587,116 @@ static void map_getWallBounds(int *pX, int *pY, int *pW, int *pH, map *pM,
     }
     
     // Set the return variables
-    *pX = (pos % pM->w) * 8;
-    *pY = (pos / pM->w) * 8;
+    *pX = x * 8;
+    *pY = y * 8;
     *pW = w * 8;
     *pH = h * 8;
 }
 
+/**
+ * Calculate where the walls should be placed, on a single chunk; Tiles that
+ * already belong to a wall are skipped
+ * 
+ * @param pM The map
+ * @param ci The chunk's horizontal position (in chunks)
+ * @param cj The chunk's vertical position (in chunks)
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_genChunkWalls(map *pM, int ci, int cj) {
+    GFraMe_ret rv;
+    mapChunk *pC;
+    int i, j, lastI, lastJ;
+    
+    pC = &pM->chunks[ci + cj * pM->chunksW];
+    // Do nothing if there are no walls in this chunk
+    ASSERT(pC->solidTiles > 0, GFraMe_ret_ok);
+    
+    lastI = (ci + 1) << CHUNK_BITS;
+    if (lastI > pM->w)
+        lastI = pM->w;
+    lastJ = (cj + 1) << CHUNK_BITS;
+    if (lastJ > pM->h)
+        lastJ = pM->h;
+    
+    // Traverse every tile
+    j = cj << CHUNK_BITS;
+    while (j < lastJ) {
+        i = ci << CHUNK_BITS;
+        while (i < lastI) {
+            GFraMe_object *obj;
+            GFraMe_hitbox *hb;
+            int h, w, x, y, off;
+            
+            off = CHUNK_OFFSET(i, j);
+            // Only check if the tile is a wall and if it doesn't already
+            // belong to a wall object
+            if (map_isWall(pC->tiles[off]) != GFraMe_ret_ok
+                    || pC->inWall[off]) {
+                i++;
+                continue;
+            }
+            
+            // Otherwise, find the wall bounds...
+            map_getWallBounds(&x, &y, &w, &h, pM, i, j);
+            // ... and add it
+            rv = rg_getNextWall(&obj);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            
+            hb = GFraMe_object_get_hitbox(obj);
+            
+            GFraMe_object_clear(obj);
+            GFraMe_object_set_x(obj, x);
+            GFraMe_object_set_y(obj, y);
+            GFraMe_hitbox_set(hb, GFraMe_hitbox_upper_left, 0/*x*/, 0/*y*/, w,
+                h);
+            
+            // Increase the objects count
+            rg_pushWall();
+            map_setInWall(pM, x / 8, y / 8, w / 8, h / 8, 1);
+            
+            i++;
+        }
+        j++;
+    }
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Remove every wall and generate the map's ones from scratch, accounting how
+ * long it took
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_resetWalls(map *pM) {
+    GFraMe_ret rv;
+    Uint64 start;
+    
+    start = SDL_GetPerformanceCounter();
+    rg_resetWall();
+    rv = map_genWalls(pM);
+    _map_loadStats.wallsMs = map_getElapsedMs(start);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    
+    pM->doReset = 0;
+__ret:
+    return rv;
+}
+
+/**
+ * Get how many milliseconds elapsed since a given performance counter
+ * 
+ * @param start The initial counter
+ * @return The elapsed time, in milliseconds
+ */
+static double map_getElapsedMs(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+}
+
 /**
  * Calculate where the walls should be placed
  * 
@@ -1014,40 +1705,168 @@ static void map_getWallBounds(int *pX, int *pY, int *pW, int *pH, map *pM,
  */
 static GFraMe_ret map_genWalls(map *pM) {
     GFraMe_ret rv;
-    int i;
+    int ci, cj;
     
-    // Traverse every tile
-    i = -1;
-    while (++i < pM->w*pM->h) {
-        GFraMe_object *obj;
-        GFraMe_hitbox *hb;
-        int h, w, x, y;
-        
-        // Only check if the tile is a wall
-        if (map_isWall(pM->data[i]) != GFraMe_ret_ok)
-            continue;
+    // Mark every tile as not being in a wall
+    map_coverWalls(pM);
     
-        // Check if it already belongs to a wall object
-        if (map_isTileInWall(pM, i) == GFraMe_ret_ok)
-            // If it does, go to the next one
-            continue;
+    // Traverse every chunk
+    cj = 0;
+    while (cj < pM->chunksH) {
+        ci = 0;
+        while (ci < pM->chunksW) {
+            rv = map_genChunkWalls(pM, ci, cj);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            ci++;
+        }
+        cj++;
+    }
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Regenerate only the walls on modified chunks (removing any wall that
+ * touches those)
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_updateWalls(map *pM) {
+    GFraMe_ret rv;
+    int ci, cj, i;
+    
+    // Remove every wall that touches a modified chunk
+    i = 0;
+    while (i < rg_getWallsUsed()) {
+        int endCi, endCj, h, iniCi, iniCj, isDirty, w, x, y;
+        
+        map_getWallArea(&x, &y, &w, &h, rg_getWall(i));
+        iniCi = x >> CHUNK_BITS;
+        iniCj = y >> CHUNK_BITS;
+        endCi = (x + w - 1) >> CHUNK_BITS;
+        endCj = (y + h - 1) >> CHUNK_BITS;
+        
+        isDirty = 0;
+        cj = iniCj;
+        while (cj <= endCj && !isDirty) {
+            ci = iniCi;
+            while (ci <= endCi && !isDirty) {
+                isDirty = pM->chunks[ci + cj * pM->chunksW].flags
+                    & CHUNK_DIRTY;
+                ci++;
+            }
+            cj++;
+        }
         
-        // Otherwise, find the wall bounds...
-        map_getWallBounds(&x, &y, &w, &h, pM, i);
-        // ... and add it
-        rv = rg_getNextWall(&obj);
-        ASSERT(rv == GFraMe_ret_ok, rv);
+        if (!isDirty) {
+            i++;
+            continue;
+        }
         
-        hb = GFraMe_object_get_hitbox(obj);
+        // Release its tiles and check every chunk it touched again
+        map_setInWall(pM, x, y, w, h, 0);
+        cj = iniCj;
+        while (cj <= endCj) {
+            ci = iniCi;
+            while (ci <= endCi) {
+                pM->chunks[ci + cj * pM->chunksW].flags |= CHUNK_RESCAN;
+                ci++;
+            }
+            cj++;
+        }
+        rg_removeWall(i);
+    }
+    
+    // Generate the walls on every modified chunk
+    cj = 0;
+    while (cj < pM->chunksH) {
+        ci = 0;
+        while (ci < pM->chunksW) {
+            mapChunk *pC;
+            
+            pC = &pM->chunks[ci + cj * pM->chunksW];
+            if (pC->flags) {
+                rv = map_genChunkWalls(pM, ci, cj);
+                ASSERT(rv == GFraMe_ret_ok, rv);
+                pC->flags = 0;
+            }
+            ci++;
+        }
+        cj++;
+    }
+    
+    pM->doUpdate = 0;
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Copy the tilemap's data into its chunks and calculate their summaries
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+static GFraMe_ret map_genChunks(map *pM) {
+    GFraMe_ret rv;
+    int i, j, len;
+    
+    // Expand the buffer as necessary
+    pM->chunksW = (pM->w + CHUNK_MASK) >> CHUNK_BITS;
+    pM->chunksH = (pM->h + CHUNK_MASK) >> CHUNK_BITS;
+    len = pM->chunksW * pM->chunksH;
+    if (pM->chunksLen < len) {
+        mapChunk *tmp;
         
-        GFraMe_object_clear(obj);
-        GFraMe_object_set_x(obj, x);
-        GFraMe_object_set_y(obj, y);
-        GFraMe_hitbox_set(hb, GFraMe_hitbox_upper_left, 0/*x*/, 0/*y*/, w, h);
+        tmp = (mapChunk*)realloc(pM->chunks, sizeof(mapChunk) * len);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        pM->chunks = tmp;
+        pM->chunksLen = len;
+    }
+    memset(pM->chunks, 0x0, sizeof(mapChunk) * len);
+    
+    // Expand the solidity bitmap as well
+    pM->solidStride = (pM->w + SOLID_MASK) >> SOLID_BITS;
+    len = pM->solidStride * pM->h;
+    if (pM->solidLen < len) {
+        unsigned int *tmp;
         
-        // Increase the objects count
-        rg_pushWall();
+        tmp = (unsigned int*)realloc(pM->solid, sizeof(unsigned int) * len);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        pM->solid = tmp;
+        pM->solidLen = len;
     }
+    memset(pM->solid, 0x0, sizeof(unsigned int) * len);
+    
+    // Copy every tile (out of bounds tiles are left as 0)
+    j = 0;
+    while (j < pM->h) {
+        i = 0;
+        while (i < pM->w) {
+            mapChunk *pC;
+            mapTile tile;
+            
+            tile = pM->data[i + j * pM->w];
+            pC = map_getChunk(pM, i, j);
+            pC->tiles[CHUNK_OFFSET(i, j)] = tile;
+            
+            if (map_isWall(tile) == GFraMe_ret_ok) {
+                pC->solidTiles++;
+                SOLID_WORD(pM, i, j) |= SOLID_BIT(i);
+            }
+            if (map_tileIsAnimated(tile) == GFraMe_ret_ok)
+                pC->animTiles++;
+            if (tile != 0 && tile != 64)
+                pC->visibleTiles++;
+            
+            i++;
+        }
+        j++;
+    }
+    pM->doUpdate = 0;
     
     rv = GFraMe_ret_ok;
 __ret:
@@ -1077,3 +1896,20 @@ __ret:
     return rv;
 }
 
+/**
+ * Save/restore the map's (possibly modified) tiles on a checkpoint; It must
+ * be restored into the same map it was saved from
+ * 
+ * @param pM The map
+ * @param pCp The checkpoint
+ */
+void map_checkpoint(map *pM, checkpoint *pCp) {
+    cp_field(pCp, &pM->doReset, sizeof(int));
+    cp_field(pCp, &pM->doUpdate, sizeof(int));
+    cp_field(pCp, pM->chunks, sizeof(mapChunk) * pM->chunksW * pM->chunksH);
+    cp_field(pCp, pM->solid, sizeof(unsigned int) * pM->solidStride * pM->h);
+    // The buffer is never shrunk, so it always fits what was saved
+    cp_field(pCp, &pM->animTilesUsed, sizeof(int));
+    cp_field(pCp, pM->animTiles, sizeof(animTile) * pM->animTilesUsed);
+}
+
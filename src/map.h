@@ -11,11 +11,30 @@
 #include <GFraMe/GFraMe_object.h>
 #include <GFraMe/GFraMe_sprite.h>
 
+#include "checkpoint.h"
 #include "event.h"
 #include "object.h"
 
 typedef struct stMap map;
 
+/** A single tile from the tilemap (wide enough for more than 256 tiles) */
+typedef unsigned short mapTile;
+
+/** Statistics about the last time a map was loaded (e.g., for benchmarking) */
+struct stMapLoadStats {
+    /** Whether the map was restored from the cache (and thus wasn't parsed) */
+    int cached;
+    /** Time spent parsing the map's file, in milliseconds */
+    double parseMs;
+    /** Time spent generating the map's walls, in milliseconds */
+    double wallsMs;
+    /** Number of walls on the map */
+    int walls;
+    /** Number of animated tiles on the map */
+    int animTiles;
+};
+typedef struct stMapLoadStats mapLoadStats;
+
 /**
  * Initialize the map module
  * 
@@ -39,25 +58,48 @@ void map_clean(map **ppM);
 void map_reset(map *pM);
 
 /**
- * Get the current tilemap, if any
+ * Get the buffer the tilemap was last set from, if any. Note that tiles
+ * modified through map_setTile aren't reflected on this buffer
  * 
  * @param ppData Data retrieved or NULL
- * @param pLen How many bytes there are in the buffer
+ * @param pLen How many tiles there are in the buffer
  * @param pM The map
  * @return GFraMe error code
  */
-GFraMe_ret map_getTilemapData(unsigned char **ppData, int *pLen, map *pM);
+GFraMe_ret map_getTilemapData(mapTile **ppData, int *pLen, map *pM);
 
 /**
- * Set the current tilemap
+ * Set the current tilemap; its tiles are copied into the map's chunks
  * 
  * @param pM The map
  * @param pData The tilemap
- * @param len How many bytes there are in the buffer (needn't all be in use)
+ * @param len How many tiles there are in the buffer (needn't all be in use)
  * @param w How many tiles there are horizontally
  * @param h How many tiles there are vertically
+ * @return GFraMe error code
+ */
+GFraMe_ret map_setTilemap(map *pM, mapTile *pData, int len, int w, int h);
+
+/**
+ * Get a tile from the map
+ * 
+ * @param pM The map
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
+ * @return The tile (0, if out of bounds)
  */
-void map_setTilemap(map *pM, unsigned char *pData, int len, int w, int h);
+mapTile map_getTile(map *pM, int i, int j);
+
+/**
+ * Modify a single tile; only the walls on the modified chunk (and the ones
+ * touching it) are regenerated, on the next update
+ * 
+ * @param pM The map
+ * @param i The horizontal position (in tiles)
+ * @param j The vertical position (in tiles)
+ * @param tile The new tile
+ */
+void map_setTile(map *pM, int i, int j, mapTile tile);
 
 /**
  * Load a map from a string
@@ -87,6 +129,25 @@ GFraMe_ret map_loadf(map *m, char *fn);
  */
 GFraMe_ret map_loadi(map *m, int i);
 
+/**
+ * Get the file of a indexed map
+ * 
+ * @param i The map's index
+ * @return The map's filename (relative to the assets) or NULL, if the index is
+ *         invalid
+ */
+char* map_getFilename(int i);
+
+/**
+ * Retrieve statistics about the last map loaded; its walls are only accounted
+ * for after they are generated (i.e., right away by map_loadi, but only on the
+ * first map_update after map_loadf)
+ * 
+ * @param pStats Returns the statistics
+ * @param pM The map
+ */
+void map_getLoadStats(mapLoadStats *pStats, map *pM);
+
 /**
  * Animate the map tiles
  * 
@@ -141,5 +202,42 @@ GFraMe_ret map_isPixelSolid(map *pM, int x, int y);
  */
 GFraMe_ret map_isTileSolid(map *pM, int i, int j);
 
+/**
+ * Check if any tile in an area (in pixels) is solid
+ * 
+ * @param pM The map
+ * @param x The area's horizontal position
+ * @param y The area's vertical position
+ * @param w The area's width
+ * @param h The area's height
+ * @return GFraMe_ret_ok if any is solid, GFraMe_ret_failed otherwise
+ */
+GFraMe_ret map_isAreaSolid(map *pM, int x, int y, int w, int h);
+
+/**
+ * Walk through every tile touched by a line (in pixels), in order, until a
+ * solid one is found; Tiles outside the map are never solid
+ * 
+ * @param pI Returns the horizontal position of the solid tile (may be NULL)
+ * @param pJ Returns the vertical position of the solid tile (may be NULL)
+ * @param pM The map
+ * @param x0 The line's initial horizontal position
+ * @param y0 The line's initial vertical position
+ * @param x1 The line's final horizontal position
+ * @param y1 The line's final vertical position
+ * @return GFraMe_ret_ok if a solid tile was hit, GFraMe_ret_failed otherwise
+ */
+GFraMe_ret map_raycast(int *pI, int *pJ, map *pM, int x0, int y0, int x1,
+    int y1);
+
+/**
+ * Save/restore the map's (possibly modified) tiles on a checkpoint; It must
+ * be restored into the same map it was saved from
+ * 
+ * @param pM The map
+ * @param pCp The checkpoint
+ */
+void map_checkpoint(map *pM, checkpoint *pCp);
+
 #endif
 
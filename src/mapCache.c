@@ -0,0 +1,417 @@
+/**
+ * @file src/mapCache.c
+ * 
+ * Keep the pristine state of every visited map in memory. Each entry is a
+ * plain copy of the tilemap and of every event, object, mob and wall on the
+ * registry, right after the map was parsed. When the memory limit is reached,
+ * the least recently used map is evicted.
+ */
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_object.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "camera.h"
+#include "event.h"
+#include "global.h"
+#include "map.h"
+#include "mapCache.h"
+#include "mob.h"
+#include "object.h"
+#include "registry.h"
+
+typedef struct {
+    int index;               /** Map's index (-1, if the entry is unused)     */
+    int lastUse;             /** When the entry was last stored or restored   */
+    int size;                /** How many bytes this entry is using           */
+    
+    mapTile *data;           /** Tilemap's data (exactly w * h tiles)         */
+    int w;                   /** Width of the tilemap, in tiles               */
+    int h;                   /** Height of the tilemap, in tiles              */
+    
+    char *events;            /** Copy of every event                          */
+    int eventsLen;           /** Number of events                             */
+    char *objects;           /** Copy of every object                         */
+    int objectsLen;          /** Number of objects                            */
+    char *mobs;              /** Copy of every mob                            */
+    int mobsLen;             /** Number of mobs                               */
+    GFraMe_object *walls;    /** Copy of every wall                           */
+    int wallsLen;            /** Number of walls                              */
+} mcEntry;
+
+/** Every cached map */
+static mcEntry *_mc_entries = NULL;
+/** Size of the entries buffer */
+static int _mc_entriesLen = 0;
+/** Maximum number of bytes that may be cached */
+static int _mc_maxMem = MC_MAX_MEM;
+/** Number of bytes currently cached */
+static int _mc_usedMem = 0;
+/** Counter used to find the least recently used entry */
+static int _mc_time = 0;
+/** How many times a map was restored */
+static int _mc_hits = 0;
+/** How many times a map wasn't found */
+static int _mc_misses = 0;
+
+/**
+ * Release an entry's memory and mark it as unused
+ * 
+ * @param pE The entry
+ */
+static void mc_freeEntry(mcEntry *pE);
+
+/**
+ * Search for a map's entry
+ * 
+ * @param i The map's index
+ * @return The entry or NULL, if the map isn't cached
+ */
+static mcEntry* mc_getEntry(int i);
+
+/**
+ * Evict the least recently used maps until there's enough space
+ * 
+ * @param size How many bytes are required
+ */
+static void mc_evict(int size);
+
+/**
+ * Set the maximum number of bytes kept by the cache, evicting the least
+ * recently used maps as necessary
+ * 
+ * @param bytes The new limit (0 disables the cache)
+ */
+void mc_setMaxMemory(int bytes) {
+    if (bytes < 0)
+        bytes = 0;
+    
+    _mc_maxMem = bytes;
+    mc_evict(0);
+}
+
+/**
+ * Store the currently loaded map (and everything on the registry) as the
+ * pristine state of a map. The map's walls must already have been generated
+ * 
+ * @param pM The map
+ * @param i The map's index
+ * @return GFraMe error code
+ */
+GFraMe_ret mc_store(map *pM, int i) {
+    GFraMe_ret rv;
+    mcEntry *pE;
+    mapTile *pData;
+    int evSize, j, len, mobSize, objSize, size, w, h;
+    
+    // Sanitize parameters
+    ASSERT(pM, GFraMe_ret_bad_param);
+    ASSERT(i >= 0, GFraMe_ret_bad_param);
+    
+    // Retrieve the map's dimensions (in tiles)
+    rv = map_getTilemapData(&pData, &len, pM);
+    ASSERT(rv == GFraMe_ret_ok, rv);
+    map_getDimensions(pM, &w, &h);
+    w /= 8;
+    h /= 8;
+    ASSERT(pData && w > 0 && h > 0, GFraMe_ret_failed);
+    
+    // Calculate how much memory is required and make some room for it
+    evSize = event_getSize();
+    objSize = obj_getSize();
+    mobSize = mob_getSize();
+    size = w * h * (int)sizeof(mapTile) + rg_getEventsUsed() * evSize
+        + rg_getObjectsUsed() * objSize + rg_getMobsUsed() * mobSize
+        + rg_getWallsUsed() * (int)sizeof(GFraMe_object);
+    ASSERT(size <= _mc_maxMem, GFraMe_ret_failed);
+    
+    // Overwrite the map's previous state, if any
+    pE = mc_getEntry(i);
+    if (pE)
+        mc_freeEntry(pE);
+    mc_evict(size);
+    
+    // Get an unused entry, expanding the buffer as necessary
+    pE = mc_getEntry(-1);
+    if (!pE) {
+        mcEntry *tmp;
+        int newLen;
+        
+        newLen = _mc_entriesLen * 2;
+        if (newLen == 0)
+            newLen = 8;
+        
+        tmp = (mcEntry*)realloc(_mc_entries, sizeof(mcEntry) * newLen);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        
+        j = _mc_entriesLen;
+        while (j < newLen) {
+            memset(&tmp[j], 0x0, sizeof(mcEntry));
+            tmp[j].index = -1;
+            j++;
+        }
+        
+        pE = &tmp[_mc_entriesLen];
+        _mc_entries = tmp;
+        _mc_entriesLen = newLen;
+    }
+    
+    // Alloc every buffer
+    pE->eventsLen = rg_getEventsUsed();
+    pE->objectsLen = rg_getObjectsUsed();
+    pE->mobsLen = rg_getMobsUsed();
+    pE->wallsLen = rg_getWallsUsed();
+    
+    pE->data = (mapTile*)malloc(sizeof(mapTile) * w * h);
+    pE->events = (char*)malloc(pE->eventsLen * evSize + 1);
+    pE->objects = (char*)malloc(pE->objectsLen * objSize + 1);
+    pE->mobs = (char*)malloc(pE->mobsLen * mobSize + 1);
+    pE->walls = (GFraMe_object*)malloc(sizeof(GFraMe_object) * pE->wallsLen
+        + 1);
+    if (!pE->data || !pE->events || !pE->objects || !pE->mobs || !pE->walls) {
+        mc_freeEntry(pE);
+        ASSERT(0, GFraMe_ret_memory_error);
+    }
+    
+    // Copy the map's current state
+    memcpy(pE->data, pData, sizeof(mapTile) * w * h);
+    pE->w = w;
+    pE->h = h;
+    
+    j = 0;
+    while (j < pE->eventsLen) {
+        event_copy((event*)(pE->events + j * evSize), rg_getEvent(j));
+        j++;
+    }
+    j = 0;
+    while (j < pE->objectsLen) {
+        obj_copy((object*)(pE->objects + j * objSize), rg_getObject(j));
+        j++;
+    }
+    j = 0;
+    while (j < pE->mobsLen) {
+        mob_copy((mob*)(pE->mobs + j * mobSize), rg_getMob(j));
+        j++;
+    }
+    j = 0;
+    while (j < pE->wallsLen) {
+        memcpy(&pE->walls[j], rg_getWall(j), sizeof(GFraMe_object));
+        j++;
+    }
+    
+    pE->index = i;
+    pE->size = size;
+    pE->lastUse = ++_mc_time;
+    _mc_usedMem += size;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Restore a map's pristine state, if it's cached
+ * 
+ * @param pM The map
+ * @param i The map's index
+ * @return GFraMe_ret_ok on hit, GFraMe_ret_failed on miss or other error code
+ */
+GFraMe_ret mc_restore(map *pM, int i) {
+    GFraMe_ret rv;
+    mcEntry *pE;
+    mapTile *pData;
+    int evSize, j, len, mobSize, objSize;
+    
+    // Sanitize parameters
+    ASSERT(pM, GFraMe_ret_bad_param);
+    ASSERT(i >= 0, GFraMe_ret_bad_param);
+    
+    // Check that the map is cached
+    pE = mc_getEntry(i);
+    if (!pE) {
+        _mc_misses++;
+        ASSERT(0, GFraMe_ret_failed);
+    }
+    
+    map_reset(pM);
+    rg_reset();
+    
+    // Recycle the map's buffer, expanding it as necessary
+    rv = map_getTilemapData(&pData, &len, pM);
+    ASSERT(rv == GFraMe_ret_ok, rv);
+    if (len < pE->w * pE->h) {
+        mapTile *tmp;
+        
+        tmp = (mapTile*)realloc(pData, sizeof(mapTile) * pE->w * pE->h);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        pData = tmp;
+        len = pE->w * pE->h;
+    }
+    memcpy(pData, pE->data, sizeof(mapTile) * pE->w * pE->h);
+    rv = map_setTilemap(pM, pData, len, pE->w, pE->h);
+    ASSERT(rv == GFraMe_ret_ok, rv);
+    cam_setMapDimension(pE->w * 8, pE->h * 8);
+    
+    // Restore every entity and wall
+    evSize = event_getSize();
+    objSize = obj_getSize();
+    mobSize = mob_getSize();
+    
+    j = 0;
+    while (j < pE->eventsLen) {
+        event *pEv;
+        
+        rv = rg_getNextEvent(&pEv);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        event_copy(pEv, (event*)(pE->events + j * evSize));
+        rg_pushEvent();
+        j++;
+    }
+    j = 0;
+    while (j < pE->objectsLen) {
+        object *pObj;
+        
+        rv = rg_getNextObject(&pObj);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        obj_copy(pObj, (object*)(pE->objects + j * objSize));
+        rv = rg_pushObject();
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        j++;
+    }
+    j = 0;
+    while (j < pE->mobsLen) {
+        mob *pMob;
+        
+        rv = rg_getNextMob(&pMob);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        mob_copy(pMob, (mob*)(pE->mobs + j * mobSize));
+        rg_pushMob();
+        j++;
+    }
+    j = 0;
+    while (j < pE->wallsLen) {
+        GFraMe_object *pWall;
+        
+        rv = rg_getNextWall(&pWall);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        memcpy(pWall, &pE->walls[j], sizeof(GFraMe_object));
+        rg_pushWall();
+        j++;
+    }
+    
+    pE->lastUse = ++_mc_time;
+    _mc_hits++;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Retrieve the cache's statistics; any of the pointers may be NULL
+ * 
+ * @param pHits How many times a map was restored from the cache
+ * @param pMisses How many times a map wasn't found in the cache
+ * @param pUsed How many bytes are currently in use
+ */
+void mc_getStats(int *pHits, int *pMisses, int *pUsed) {
+    if (pHits)
+        *pHits = _mc_hits;
+    if (pMisses)
+        *pMisses = _mc_misses;
+    if (pUsed)
+        *pUsed = _mc_usedMem;
+}
+
+/**
+ * Release every cached map
+ */
+void mc_clean() {
+    int i;
+    
+    i = 0;
+    while (i < _mc_entriesLen) {
+        mc_freeEntry(&_mc_entries[i]);
+        i++;
+    }
+    
+    if (_mc_entries)
+        free(_mc_entries);
+    _mc_entries = NULL;
+    _mc_entriesLen = 0;
+    _mc_usedMem = 0;
+    _mc_time = 0;
+}
+
+/**
+ * Release an entry's memory and mark it as unused
+ * 
+ * @param pE The entry
+ */
+static void mc_freeEntry(mcEntry *pE) {
+    if (pE->data)
+        free(pE->data);
+    if (pE->events)
+        free(pE->events);
+    if (pE->objects)
+        free(pE->objects);
+    if (pE->mobs)
+        free(pE->mobs);
+    if (pE->walls)
+        free(pE->walls);
+    
+    if (pE->index != -1)
+        _mc_usedMem -= pE->size;
+    
+    memset(pE, 0x0, sizeof(mcEntry));
+    pE->index = -1;
+}
+
+/**
+ * Search for a map's entry
+ * 
+ * @param i The map's index
+ * @return The entry or NULL, if the map isn't cached
+ */
+static mcEntry* mc_getEntry(int i) {
+    int j;
+    
+    j = 0;
+    while (j < _mc_entriesLen) {
+        if (_mc_entries[j].index == i)
+            return &_mc_entries[j];
+        j++;
+    }
+    
+    return NULL;
+}
+
+/**
+ * Evict the least recently used maps until there's enough space
+ * 
+ * @param size How many bytes are required
+ */
+static void mc_evict(int size) {
+    while (_mc_usedMem > 0 && _mc_usedMem + size > _mc_maxMem) {
+        mcEntry *pLru;
+        int j;
+        
+        // Find the least recently used entry
+        pLru = NULL;
+        j = 0;
+        while (j < _mc_entriesLen) {
+            mcEntry *pE;
+            
+            pE = &_mc_entries[j];
+            if (pE->index != -1 && (!pLru || pE->lastUse < pLru->lastUse))
+                pLru = pE;
+            j++;
+        }
+        
+        if (!pLru)
+            break;
+        mc_freeEntry(pLru);
+    }
+}
+
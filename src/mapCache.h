@@ -0,0 +1,62 @@
+/**
+ * @file src/mapCache.h
+ * 
+ * Keep the pristine state of every visited map (its tilemap, events, objects,
+ * mobs and walls) in memory, so reloading a map (e.g., after dying or on
+ * retry) doesn't have to parse its file again.
+ */
+#ifndef __MAPCACHE_H_
+#define __MAPCACHE_H_
+
+#include <GFraMe/GFraMe_error.h>
+
+#include "map.h"
+
+/** Default maximum number of bytes kept by the cache */
+#ifndef MC_MAX_MEM
+#  define MC_MAX_MEM (1024 * 1024)
+#endif
+
+/**
+ * Set the maximum number of bytes kept by the cache, evicting the least
+ * recently used maps as necessary
+ * 
+ * @param bytes The new limit (0 disables the cache)
+ */
+void mc_setMaxMemory(int bytes);
+
+/**
+ * Store the currently loaded map (and everything on the registry) as the
+ * pristine state of a map. The map's walls must already have been generated
+ * 
+ * @param pM The map
+ * @param i The map's index
+ * @return GFraMe error code
+ */
+GFraMe_ret mc_store(map *pM, int i);
+
+/**
+ * Restore a map's pristine state, if it's cached
+ * 
+ * @param pM The map
+ * @param i The map's index
+ * @return GFraMe_ret_ok on hit, GFraMe_ret_failed on miss or other error code
+ */
+GFraMe_ret mc_restore(map *pM, int i);
+
+/**
+ * Retrieve the cache's statistics; any of the pointers may be NULL
+ * 
+ * @param pHits How many times a map was restored from the cache
+ * @param pMisses How many times a map wasn't found in the cache
+ * @param pUsed How many bytes are currently in use
+ */
+void mc_getStats(int *pHits, int *pMisses, int *pUsed);
+
+/**
+ * Release every cached map
+ */
+void mc_clean();
+
+#endif
+
@@ -12,13 +12,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "audio.h"
 #include "bullet.h"
 #include "camera.h"
 #include "global.h"
+#include "interp.h"
 #include "map.h"
 #include "mob.h"
+#include "profiler.h"
 #include "registry.h"
 #include "types.h"
 
@@ -52,8 +55,17 @@ enum {EYE_CLOSED = 0, EYE_OPENING, EYE_OPEN, EYE_FOCUSED, EYE_CLOSING, EYE_BLINK
 #define EYE_MINDIST 64
 #define EYE_MAXDIST 96
 
+/** Level of detail of a mob's update, depending on where the camera is */
+enum {MOB_LOD_FULL = 0, MOB_LOD_REDUCED, MOB_LOD_ASLEEP};
+/** How long, in milliseconds, between each update of a simplified mob */
+#define MOB_LOD_INTERVAL 96
+
+/** Distance from the camera, in pixels, until mobs are simplified */
+static int _mob_lodMargin = MOB_LOD_MARGIN;
+
 struct stMob {
     GFraMe_sprite spr;       /** Mob's sprite (for rendering and collision)   */
+    ipPos ip;                /** Position before the last update              */
     int health;              /** How many hitpoints this mob has              */
     int damage;              /** How much damage this mob does on the player  */
     flag weakness;           /** IDs that can do damage to this mob           */
@@ -61,6 +73,8 @@ struct stMob {
     int anim;                /** The mob's current animation                  */
     int animLen;             /** How many animations this mob has             */
     int hurtCountdown;       /** How long until the mob can be hurt again     */
+    int lodElapsed;          /** Time not yet simulated (while simplified)    */
+    int didUpdate;           /** Whether the mob was updated on this frame    */
     /** Every possible animation, so it won't overlap another mob's */
     GFraMe_animation mob_anim[MOB_ANIM_MAX];
 };
@@ -169,6 +183,30 @@ __ret:
     return;
 }
 
+/**
+ * Get how many bytes a mob takes
+ * 
+ * @return The size of the mob structure
+ */
+int mob_getSize() {
+    return sizeof(mob);
+}
+
+/**
+ * Copy a mob's state into another one; its current animation is made to point
+ * to the destination's own animations
+ * 
+ * @param pDst The mob that will receive the state
+ * @param pSrc The mob being copied
+ */
+void mob_copy(mob *pDst, mob *pSrc) {
+    memcpy(pDst, pSrc, sizeof(mob));
+    
+    // The sprite points to an animation inside the mob itself
+    if (pSrc->spr.anim)
+        pDst->spr.anim = pDst->mob_anim + (pSrc->spr.anim - pSrc->mob_anim);
+}
+
 /**
  * Initialize a mob of a given type
  * 
@@ -287,6 +325,12 @@ GFraMe_ret mob_init(mob *pMob, int x, int y, flag type) {
     #undef SET_ANIMDATA
     pMob->spr.id = type;
     pMob->hurtCountdown = 0;
+    pMob->lodElapsed = 0;
+    // Collide it right away, even if it was spawned after mobs were updated
+    pMob->didUpdate = 1;
+    // Start interpolating from the spawn position (instead of from wherever
+    // the slot's previous mob was)
+    ip_save(&pMob->ip, pMob->spr.obj.x, pMob->spr.obj.y);
     
     // Set all animations
     if (animData) {
@@ -342,23 +386,25 @@ void mob_draw(mob *pMob) {
                 int pX, pY;
                 // Render the eye ball
                 if (pMob->spr.flipped)
-                    GFraMe_spriteset_draw(gl_sset4x4, 2951/*tile*/, x  , y+3, 1);
+                    PROF_SPRITESET_DRAW(MOBS, gl_sset4x4, 2951/*tile*/, x  ,
+                        y+3, 1);
                 else
-                    GFraMe_spriteset_draw(gl_sset4x4, 2951/*tile*/, x+4, y+3, 0);
+                    PROF_SPRITESET_DRAW(MOBS, gl_sset4x4, 2951/*tile*/, x+4,
+                        y+3, 0);
                 // Get the closest player's position
                 mob_getClosestPlDist(&pX, &pY, pMob);
                 pX = pX / (float)(EYE_MAXDIST) * 2.0f + 1;
                 pY = pY / (float)(EYE_MAXDIST) * 3.0f + 1;
                 // Render the pupil
                 if (pMob->spr.flipped)
-                    GFraMe_spriteset_draw(gl_sset4x4, 2950/*tile*/, x - 2 + pX,
-                        y + 3 + pY, 1);
+                    PROF_SPRITESET_DRAW(MOBS, gl_sset4x4, 2950/*tile*/,
+                        x - 2 + pX, y + 3 + pY, 1);
                 else
-                    GFraMe_spriteset_draw(gl_sset4x4, 2950/*tile*/, x + 4 + pX,
-                        y + 3 + pY, 0);
+                    PROF_SPRITESET_DRAW(MOBS, gl_sset4x4, 2950/*tile*/,
+                        x + 4 + pX, y + 3 + pY, 0);
             }
             // Render the eyelid
-            GFraMe_sprite_draw_camera(&pMob->spr, cam_x, cam_y, SCR_W, SCR_H);
+            PROF_SPRITE_DRAW(MOBS, &pMob->spr, cam_x, cam_y, SCR_W, SCR_H);
         } break;
         case ID_CHARGER: {
             if (pMob->anim != CHARGER_STAND) {
@@ -368,13 +414,13 @@ void mob_draw(mob *pMob) {
                 x = pMob->spr.obj.x - cam_x + pMob->spr.offset_x;
                 x -= pMob->spr.obj.vx / 20;
                 y = pMob->spr.obj.y - cam_y + pMob->spr.offset_x;
-                GFraMe_spriteset_draw(gl_sset16x16, pMob->spr.cur_tile + 1, x,
-                    y, pMob->spr.flipped); 
+                PROF_SPRITESET_DRAW(MOBS, gl_sset16x16,
+                    pMob->spr.cur_tile + 1, x, y, pMob->spr.flipped); 
             }
-            GFraMe_sprite_draw_camera(&pMob->spr, cam_x, cam_y, SCR_W, SCR_H);
+            PROF_SPRITE_DRAW(MOBS, &pMob->spr, cam_x, cam_y, SCR_W, SCR_H);
         } break;
         default: {
-            GFraMe_sprite_draw_camera(&pMob->spr, cam_x, cam_y, SCR_W, SCR_H);
+            PROF_SPRITE_DRAW(MOBS, &pMob->spr, cam_x, cam_y, SCR_W, SCR_H);
         }
     }
     
@@ -382,6 +428,16 @@ __ret:
     return;
 }
 
+/**
+ * Get the mob's interpolated position (see ip_object)
+ * 
+ * @param ppPos The mob's interpolated position
+ * @param pMob The mob
+ */
+void mob_getIpPos(ipPos **ppPos, mob *pMob) {
+    *ppPos = &pMob->ip;
+}
+
 /**
  * Change the currently playing animation
  * 
@@ -559,18 +615,142 @@ int mob_getID(mob *pMob) {
     return pMob->spr.id;
 }
 
+/**
+ * Set how far from the camera (in pixels) mobs are updated normally; Farther
+ * than that, mobs are either put to sleep or updated less frequently
+ * 
+ * @param margin The distance, in pixels
+ */
+void mob_setLodMargin(int margin) {
+    _mob_lodMargin = margin;
+}
+
+/**
+ * Check whether the mob was updated on the current frame (i.e., it's alive
+ * and isn't simplified, or it was its turn to be updated); Mobs that weren't
+ * couldn't have moved, so they don't have to be collided
+ * 
+ * @param pMob The mob
+ * @return 1 if true, 0 if false
+ */
+int mob_didUpdate(mob *pMob) {
+    return pMob->didUpdate;
+}
+
+/**
+ * Get how detailed a mob's update should be, from how far it's from the
+ * camera; It only depends on the mob's and the camera's positions, so mobs are
+ * woken deterministically
+ * 
+ * @param pMob The mob
+ * @return The level of detail (MOB_LOD_FULL, MOB_LOD_REDUCED or MOB_LOD_ASLEEP)
+ */
+static int mob_getLod(mob *pMob) {
+    GFraMe_object *pObj;
+    int cx, cy;
+    
+    // Boss parts (and the bombs it drops) must always be updated in sync
+    switch (pMob->spr.id) {
+        case ID_BOSS_HEAD:
+        case ID_BOSS_TANK:
+        case ID_BOSS_PLAT:
+        case ID_BOSS_WHEEL:
+        case ID_BOMB: return MOB_LOD_FULL;
+        default: {}
+    }
+    
+    pObj = &pMob->spr.obj;
+    cx = pObj->x + pObj->hitbox.cx;
+    cy = pObj->y + pObj->hitbox.cy;
+    if (cx + pObj->hitbox.hw >= cam_x - _mob_lodMargin
+            && cx - pObj->hitbox.hw < cam_x + SCR_W + _mob_lodMargin
+            && cy + pObj->hitbox.hh >= cam_y - _mob_lodMargin
+            && cy - pObj->hitbox.hh < cam_y + SCR_H + _mob_lodMargin)
+        return MOB_LOD_FULL;
+    
+    // Mobs that only react to the players are frozen, while the others keep
+    // moving (at a lower rate); Chargers are also frozen, since they must check
+    // for ledges and walls on every step (otherwise, they would walk off their
+    // platforms)
+    switch (pMob->spr.id) {
+        case ID_JUMPER:
+        case ID_CHARGER:
+        case ID_EYE:
+        case ID_EYE_LEFT: return MOB_LOD_ASLEEP;
+        default: return MOB_LOD_REDUCED;
+    }
+}
+
+/**
+ * Compute what every mob knows about the players (i.e., where the closest one
+ * is); Must be called once per update, before the mobs are updated
+ * 
+ * @param pPer The perception of every mob (the i-th entry is the i-th mob's)
+ * @param ppMobs Every mob
+ * @param num How many mobs there are
+ */
+void mob_perceive(mobPerception *pPer, mob **ppMobs, int num) {
+    int i, p1X, p1Y, p2X, p2Y;
+    
+    // Both players are only read once, for every mob
+    p1X = gv_getValue(PL1_CX);
+    p1Y = gv_getValue(PL1_CY);
+    p2X = gv_getValue(PL2_CX);
+    p2Y = gv_getValue(PL2_CY);
+    
+    // Dead mobs are also computed, so this pass doesn't check which are alive
+    i = 0;
+    while (i < num) {
+        GFraMe_object *pObj;
+        int cx, cy, d1, d2;
+        
+        pObj = &ppMobs[i]->spr.obj;
+        cx = pObj->x + pObj->hitbox.cx;
+        cy = pObj->y + pObj->hitbox.cy;
+        
+        // Get both player positions (relative to the mob)
+        d1 = (p1X - cx) * (p1X - cx) + (p1Y - cy) * (p1Y - cy);
+        d2 = (p2X - cx) * (p2X - cx) + (p2Y - cy) * (p2Y - cy);
+        
+        // Store the closest one (on a tie, player 2)
+        if (d1 < d2) {
+            pPer[i].dx = p1X - cx;
+            pPer[i].dy = p1Y - cy;
+            pPer[i].distSq = d1;
+        }
+        else {
+            pPer[i].dx = p2X - cx;
+            pPer[i].dy = p2Y - cy;
+            pPer[i].distSq = d2;
+        }
+        i++;
+    }
+}
+
 /**
  * Updates the mob
  * 
  * @param pMob The mob
+ * @param pPer What the mob knows about the players (from mob_perceive)
  * @param ms Time elapsed, in milliseconds, from the previous frame
  */
-void mob_update(mob *pMob, int ms) {
-    int isDown;
+void mob_update(mob *pMob, mobPerception *pPer, int ms) {
+    int isDown, lod;
     
+    pMob->didUpdate = 0;
     // Check that the mob is alive
     ASSERT_NR(mob_isAlive(pMob));
     
+    // Mobs far from the camera are either frozen or only updated every
+    // MOB_LOD_INTERVAL, for however long was accumulated
+    lod = mob_getLod(pMob);
+    ASSERT_NR(lod != MOB_LOD_ASLEEP);
+    pMob->lodElapsed += ms;
+    ASSERT_NR(lod == MOB_LOD_FULL || pMob->lodElapsed >= MOB_LOD_INTERVAL);
+    ms = pMob->lodElapsed;
+    pMob->lodElapsed = 0;
+    pMob->didUpdate = 1;
+    
     isDown = pMob->spr.obj.hit & GFraMe_direction_down;
     if (pMob->countdown > 0)
         pMob->countdown -= ms;
@@ -641,11 +821,8 @@ void mob_update(mob *pMob, int ms) {
         } break; /* ID_JUMPER */
         case ID_EYE: {
             if (pMob->anim == EYE_CLOSED && pMob->countdown <= 0) {
-                int x, y;
-                // Get the closest player's position
-                mob_getClosestPlDist(&x, &y, pMob);
                 // Check if any player is at least 8 tiles close
-                if (x*x + y*y <= EYE_MINDIST*EYE_MINDIST) {
+                if (pPer->distSq <= EYE_MINDIST*EYE_MINDIST) {
                     // Set the new animation
                     mob_setAnim(pMob, EYE_OPENING, 0);
                 }
@@ -655,11 +832,8 @@ void mob_update(mob *pMob, int ms) {
                 pMob->countdown += EYE_COUNTDOWN;
             }
             else if (pMob->anim == EYE_OPEN && pMob->countdown <= 0) {
-                int x, y;
-                // Get the closest player's position
-                mob_getClosestPlDist(&x, &y, pMob);
                 // If the player got 11 tiles away, stop following
-                if (x*x + y*y > EYE_MAXDIST*EYE_MAXDIST) {
+                if (pPer->distSq > EYE_MAXDIST*EYE_MAXDIST) {
                     // Set the new animation
                     mob_setAnim(pMob, EYE_CLOSING, 0);
                 }
@@ -677,7 +851,8 @@ void mob_update(mob *pMob, int ms) {
                 int cx, cy, dx, dy;
                 
                 // Get the closest player's position
-                mob_getClosestPlDist(&dx, &dy, pMob);
+                dx = pPer->dx;
+                dy = pPer->dy;
                 if (pMob->spr.flipped) {
                     cx = pMob->spr.obj.x - 2;
                     dx += 4;
@@ -747,12 +922,7 @@ void mob_update(mob *pMob, int ms) {
                 sfx_charger();
             }
             else if (pMob->anim == CHARGER_FLOAT && pMob->countdown > 0) {
-                int x, y;
-                
-                // Get the closest player's position
-                mob_getClosestPlDist(&x, &y, pMob);
-                
-                if (x*x + y*y <= CHARGER_DIST*CHARGER_DIST) {
+                if (pPer->distSq <= CHARGER_DIST*CHARGER_DIST) {
                     mob_setAnim(pMob, CHARGER_CHARGE, 0);
                     pMob->countdown += CHARGER_COUNTDOWN;
                     pObj->vx *= 2.5;
@@ -766,15 +936,13 @@ void mob_update(mob *pMob, int ms) {
         } break; /* ID_CHARGER */
         case ID_PHANTOM: {
             GFraMe_object *pObj;
-            int x, y;
             
             // Get the mob's object
             mob_getObject(&pObj, pMob);
-            // Get the closest player's position
-            mob_getClosestPlDist(&x, &y, pMob);
             
-            pObj->ax = (x / 8) * 50;
-            pObj->ay = (y / 8) * 50;
+            // Accelerate toward the closest player
+            pObj->ax = (pPer->dx / 8) * 50;
+            pObj->ay = (pPer->dy / 8) * 50;
             
             if (pObj->vx > PHANTOM_MAXSPEED)
                 pObj->vx = PHANTOM_MAXSPEED;
@@ -932,7 +1100,7 @@ void mob_update(mob *pMob, int ms) {
         } break;
         case ID_BOSS_WHEEL: {
             GFraMe_object *pObj;
-            int pX, pY, x, y;
+            int x, y;
            
             // Check that the boss is still alive
             if (gv_nIsZero(BOSS_ISDEAD) && pMob->hurtCountdown <= 0) {
@@ -955,13 +1123,12 @@ void mob_update(mob *pMob, int ms) {
                 pObj->vx = BOSS_WHEEL_SPEED;
                 mob_setAnim(pMob, BOSS_WHEEL_RIGHT, 0);
             }
-            // Check the player position
-            mob_getClosestPlDist(&pX, &pY, pMob);
-            // Check if the boss should ram into him
+            // Check if the boss should ram into the closest player
             y = 8;
             x = 38;
             // Make the boss run if it (the wheel) just hit the player
-            gv_setValue(BOSS_ISRUNNING, (pY > -y && pY < y && pX > -x && pX < x));
+            gv_setValue(BOSS_ISRUNNING, (pPer->dy > -y && pPer->dy < y
+                && pPer->dx > -x && pPer->dx < x));
             
             if (pMob->countdown <= 0) {
                 sfx_bossMove();
@@ -1023,3 +1190,13 @@ __ret:
     return;
 }
 
+/**
+ * Save/restore a mob on a checkpoint
+ * 
+ * @param pMob The mob
+ * @param pCp The checkpoint
+ */
+void mob_checkpoint(mob *pMob, checkpoint *pCp) {
+    cp_field(pCp, pMob, sizeof(mob));
+}
+
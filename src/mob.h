@@ -9,11 +9,23 @@
 #include <GFraMe/GFraMe_error.h>
 #include <GFraMe/GFraMe_object.h>
 
+#include "checkpoint.h"
+#include "interp.h"
 #include "types.h"
 
 typedef struct stMob mob;
 
+/** What a mob knows about the players, computed once per update */
+struct stMobPerception {
+    int dx;                  /** Horizontal distance to the closest player    */
+    int dy;                  /** Vertical distance to the closest player      */
+    int distSq;              /** Squared distance to the closest player       */
+};
+typedef struct stMobPerception mobPerception;
+
 #define BOSS_SPEED 90
+/** Default distance from the camera, in pixels, until mobs are simplified */
+#define MOB_LOD_MARGIN 64
 
 /**
  * Instantiate a new mob
@@ -29,6 +41,22 @@ GFraMe_ret mob_getNew(mob **ppMob);
  */
 void mob_clean(mob **ppMob);
 
+/**
+ * Get how many bytes a mob takes
+ * 
+ * @return The size of the mob structure
+ */
+int mob_getSize();
+
+/**
+ * Copy a mob's state into another one; its current animation is made to point
+ * to the destination's own animations
+ * 
+ * @param pDst The mob that will receive the state
+ * @param pSrc The mob being copied
+ */
+void mob_copy(mob *pDst, mob *pSrc);
+
 /**
  * Initialize a mob of a given type
  * 
@@ -39,13 +67,42 @@ void mob_clean(mob **ppMob);
  */
 GFraMe_ret mob_init(mob *pMob, int x, int y, flag type);
 
+/**
+ * Set how far from the camera (in pixels) mobs are updated normally; Farther
+ * than that, mobs are either put to sleep or updated less frequently
+ * 
+ * @param margin The distance, in pixels
+ */
+void mob_setLodMargin(int margin);
+
+/**
+ * Check whether the mob was updated on the current frame (i.e., it's alive
+ * and isn't simplified, or it was its turn to be updated); Mobs that weren't
+ * couldn't have moved, so they don't have to be collided
+ * 
+ * @param pMob The mob
+ * @return 1 if true, 0 if false
+ */
+int mob_didUpdate(mob *pMob);
+
+/**
+ * Compute what every mob knows about the players (i.e., where the closest one
+ * is); Must be called once per update, before the mobs are updated
+ * 
+ * @param pPer The perception of every mob (the i-th entry is the i-th mob's)
+ * @param ppMobs Every mob
+ * @param num How many mobs there are
+ */
+void mob_perceive(mobPerception *pPer, mob **ppMobs, int num);
+
 /**
  * Updates the mob
  * 
  * @param pMob The mob
+ * @param pPer What the mob knows about the players (from mob_perceive)
  * @param ms Time elapsed, in milliseconds, from the previous frame
  */
-void mob_update(mob *pMob, int ms);
+void mob_update(mob *pMob, mobPerception *pPer, int ms);
 
 /**
  * Draw the mob
@@ -54,6 +111,14 @@ void mob_update(mob *pMob, int ms);
  */
 void mob_draw(mob *pMob);
 
+/**
+ * Get the mob's interpolated position (see ip_object)
+ * 
+ * @param ppPos The mob's interpolated position
+ * @param pMob The mob
+ */
+void mob_getIpPos(ipPos **ppPos, mob *pMob);
+
 /**
  * Change the currently playing animation
  * 
@@ -166,5 +231,13 @@ int mob_didAnimFinish(mob *pMob);
  */
 int mob_getID(mob *pMob);
 
+/**
+ * Save/restore a mob on a checkpoint
+ * 
+ * @param pMob The mob
+ * @param pCp The checkpoint
+ */
+void mob_checkpoint(mob *pMob, checkpoint *pCp);
+
 #endif
 
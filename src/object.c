@@ -15,14 +15,18 @@
 #include "commonEvent.h"
 #include "global.h"
 #include "globalVar.h"
+#include "interp.h"
 #include "object.h"
+#include "profiler.h"
 #include "types.h"
 
 struct stObject {
     GFraMe_sprite spr;            /** Event's sprite (for rendering and collision  */
+    ipPos ip;                     /** Position before the last update              */
     commonEvent ce;               /** Common event to be called every sprite frame */
     globalVar local[OBJ_VAR_MAX]; /** Each event has 4 local global variables      */
     objAnim anim;                 /** The object's current animation               */
+    int isAwake;                  /** Whether the common event should be called    */
     /** Every possible animation, so it won't overlap another object's */
     GFraMe_animation obj_anim[OBJ_ANIM_MAX];
 };
@@ -116,6 +120,30 @@ __ret:
     return;
 }
 
+/**
+ * Get how many bytes an object takes
+ * 
+ * @return The size of the object structure
+ */
+int obj_getSize() {
+    return sizeof(object);
+}
+
+/**
+ * Copy an object's state into another one; its current animation is made to
+ * point to the destination's own animations
+ * 
+ * @param pDst The object that will receive the state
+ * @param pSrc The object being copied
+ */
+void obj_copy(object *pDst, object *pSrc) {
+    memcpy(pDst, pSrc, sizeof(object));
+    
+    // The sprite points to an animation inside the object itself
+    if (pSrc->spr.anim)
+        pDst->spr.anim = pDst->obj_anim + (pSrc->spr.anim - pSrc->obj_anim);
+}
+
 /**
  * Make this a "empty" object
  * 
@@ -135,6 +163,7 @@ GFraMe_ret obj_setZero(object *pObj) {
     pObj->local[2] = GV_MAX;
     pObj->local[3] = GV_MAX;
     pObj->anim = OBJ_ANIM_MAX;
+    pObj->isAwake = 1;
     
     rv = GFraMe_ret_ok;
 __ret:
@@ -168,6 +197,9 @@ void obj_setBounds(object *pObj, int x, int y, int w, int h) {
         pSset = NULL;
     
     GFraMe_sprite_init(&pObj->spr, x, y, w, h, pSset, 0, 0);
+    // Start interpolating from the spawn position (instead of from wherever
+    // the slot's previous object was)
+    ip_save(&pObj->ip, x, y);
 }
 
 /**
@@ -266,7 +298,7 @@ GFraMe_ret obj_setVar(object *pObj, int index, globalVar gv) {
     // Sanitize parameters
     ASSERT(pObj, GFraMe_ret_bad_param);
     ASSERT(index < OBJ_VAR_MAX, GFraMe_ret_bad_param);
-    ASSERT(gv < GV_MAX, GFraMe_ret_bad_param);
+    ASSERT(GV_IS_VALID(gv), GFraMe_ret_bad_param);
     
     // Set the variable
     pObj->local[index] = gv;
@@ -296,13 +328,58 @@ void obj_getVar(globalVar *pGv, object *pObj, int index) {
 void obj_update(object *pObj, int ms) {
     GFraMe_sprite_update(&pObj->spr, ms);
     
-    // Call the object's event, if any
-    if (pObj->ce) {
+    // Call the object's event, if any (and if anything it depends on changed)
+    if (pObj->ce && pObj->isAwake) {
         ce_setParam(CE_CALLER, pObj);
         ce_callEvent(pObj->ce);
     }
 }
 
+/**
+ * Wake an object, so its common event is called on the next update
+ * 
+ * @param pCtx The object
+ */
+static void obj_wake(void *pCtx) {
+    ((object*)pCtx)->isAwake = 1;
+}
+
+/**
+ * Wake the object whenever any of its variables changes; Also wakes it now,
+ * since they may have changed while it wasn't subscribed
+ * 
+ * @param pObj The object
+ * @return GFraMe error code
+ */
+GFraMe_ret obj_subscribe(object *pObj) {
+    GFraMe_ret rv;
+    int i;
+    
+    i = 0;
+    while (i < OBJ_VAR_MAX) {
+        if (GV_IS_VALID(pObj->local[i])) {
+            rv = gv_subscribe(pObj->local[i], obj_wake, pObj);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+        }
+        i++;
+    }
+    pObj->isAwake = 1;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Stop calling the object's common event until any of its variables changes;
+ * Should be called by the common event itself, once it reaches a stable state
+ * 
+ * @param pObj The object
+ */
+void obj_sleep(object *pObj) {
+    pObj->isAwake = 0;
+}
+
 /**
  * Draw every object
  * 
@@ -311,7 +388,17 @@ void obj_update(object *pObj, int ms) {
 void obj_draw(object *pObj) {
     //GFraMe_sprite_draw(&pObj->spr);
     if (!(pObj->spr.id & ID_HIDDEN))
-        GFraMe_sprite_draw_camera(&pObj->spr, cam_x, cam_y, SCR_W, SCR_H);
+        PROF_SPRITE_DRAW(OBJECTS, &pObj->spr, cam_x, cam_y, SCR_W, SCR_H);
+}
+
+/**
+ * Get the object's interpolated position (see ip_object)
+ * 
+ * @param ppPos The object's interpolated position
+ * @param pObj The object
+ */
+void obj_getIpPos(ipPos **ppPos, object *pObj) {
+    *ppPos = &pObj->ip;
 }
 
 /**
@@ -379,3 +466,13 @@ void obj_getObject(GFraMe_object **ppObj, object *pObj) {
     *ppObj = GFraMe_sprite_get_object(&pObj->spr);
 }
 
+/**
+ * Save/restore an object on a checkpoint
+ * 
+ * @param pObj The object
+ * @param pCp The checkpoint
+ */
+void obj_checkpoint(object *pObj, checkpoint *pCp) {
+    cp_field(pCp, pObj, sizeof(object));
+}
+
@@ -8,8 +8,10 @@
 
 #include <GFraMe/GFraMe_object.h>
 
+#include "checkpoint.h"
 #include "commonEvent.h"
 #include "globalVar.h"
+#include "interp.h"
 #include "types.h"
 
 enum {
@@ -59,6 +61,22 @@ GFraMe_ret obj_getNew(object **ppObj);
  */
 void obj_clean(object **ppObj);
 
+/**
+ * Get how many bytes an object takes
+ * 
+ * @return The size of the object structure
+ */
+int obj_getSize();
+
+/**
+ * Copy an object's state into another one; its current animation is made to
+ * point to the destination's own animations
+ * 
+ * @param pDst The object that will receive the state
+ * @param pSrc The object being copied
+ */
+void obj_copy(object *pDst, object *pSrc);
+
 /**
  * Make this a "empty" object
  * 
@@ -152,6 +170,23 @@ void obj_getVar(globalVar *pGv, object *pObj, int index);
  */
 void obj_update(object *pObj, int ms);
 
+/**
+ * Wake the object whenever any of its variables changes; Also wakes it now,
+ * since they may have changed while it wasn't subscribed
+ * 
+ * @param pObj The object
+ * @return GFraMe error code
+ */
+GFraMe_ret obj_subscribe(object *pObj);
+
+/**
+ * Stop calling the object's common event until any of its variables changes;
+ * Should be called by the common event itself, once it reaches a stable state
+ * 
+ * @param pObj The object
+ */
+void obj_sleep(object *pObj);
+
 /**
  * Draw every object
  * 
@@ -159,6 +194,14 @@ void obj_update(object *pObj, int ms);
  */
 void obj_draw(object *pObj);
 
+/**
+ * Get the object's interpolated position (see ip_object)
+ * 
+ * @param ppPos The object's interpolated position
+ * @param pObj The object
+ */
+void obj_getIpPos(ipPos **ppPos, object *pObj);
+
 /**
  * Collide a object against this
  * 
@@ -199,5 +242,13 @@ int obj_animFinished(object *pObj);
  */
 void obj_getObject(GFraMe_object **ppObj, object *pObj);
 
+/**
+ * Save/restore an object on a checkpoint
+ * 
+ * @param pObj The object
+ * @param pCp The checkpoint
+ */
+void obj_checkpoint(object *pObj, checkpoint *pCp);
+
 #endif
 
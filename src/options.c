@@ -9,6 +9,8 @@
 #include <GFraMe/GFraMe_screen.h>
 #include <GFraMe/GFraMe_spriteset.h>
 
+#include <stdio.h>
+
 #include "audio.h"
 #include "controller.h"
 #include "global.h"
@@ -124,6 +126,33 @@ static void _op_renderText(char *text, int X, int Y, int l);
 #define _op_renderValueStatic(text, X, Y) \
         _op_renderText(text, X + tab, Y, sizeof(text) - 1)
 
+/** Update rates selectable on the menu (any rate within [GAME_MIN_UFPS,
+ *  GAME_MAX_UFPS] may be set on the config file) */
+static const int _op_ufpsList[] = {30, 45, 60, 90};
+/** Draw rates selectable on the menu (any rate within [GAME_MIN_DFPS,
+ *  GAME_MAX_DFPS] may be set on the config file) */
+static const int _op_dfpsList[] = {30, 60, 90, 120, 144, 240};
+
+/**
+ * Select the next rate on a list, wrapping around its ends
+ * 
+ * @param list The selectable rates (in ascending order)
+ * @param len How many rates there are on the list
+ * @param cur The current rate (which may not be on the list)
+ * @param dir Whether the next (1) or previous (-1) rate should be selected
+ * @return The selected rate
+ */
+static int _op_nextRate(const int *list, int len, int cur, int dir);
+
+/**
+ * Render a rate (in FPS) as an option's value
+ * 
+ * @param rate The rate
+ * @param X Horizontal position
+ * @param Y Vertical position
+ */
+static void _op_renderRate(int rate, int X, int Y);
+
 /**
  * Render a input mode, on the desired position
  * 
@@ -309,20 +338,11 @@ static void op_draw(struct stOptions *op) {
             switch (i) {
                 case OPT_UFPS: {
                     _op_renderLang(op, TXT_UPS, x, y);
-                    switch (op->ufps) {
-                        case 60: _op_renderValueStatic("60", x, y); break;
-                        case 90: _op_renderValueStatic("90", x, y); break;
-                    }
-                    _op_renderTextStatic("FPS", x + tab + 3, y);
+                    _op_renderRate(op->ufps, x + tab, y);
                 } break;
                 case OPT_DFPS: {
                     _op_renderLang(op, TXT_DPS, x, y);
-                    switch (op->dfps) {
-                        case 30: _op_renderValueStatic("30", x, y); break;
-                        case 60: _op_renderValueStatic("60", x, y); break;
-                        case 90: _op_renderValueStatic("90", x, y); break;
-                    }
-                    _op_renderTextStatic("FPS", x + tab + 3, y);
+                    _op_renderRate(op->dfps, x + tab, y);
                 } break;
                 case OPT_RES: {
                     _op_renderLang(op, TXT_ZOOM, x, y);
@@ -703,22 +723,18 @@ static void op_update(struct stOptions *op) {
                 op->firstPress = 1;
             }
             else if (op->curOpt == OPT_UFPS && (isLeft || isRight)) {
-                if (isLeft) op->ufps -= 30;
-                else if (isRight) op->ufps += 30;
-                // Clamp the value
-                if (op->ufps < 60) op->ufps = 90;
-                else if (op->ufps > 90) op->ufps = 60;
+                op->ufps = _op_nextRate(_op_ufpsList,
+                    sizeof(_op_ufpsList) / sizeof(int), op->ufps,
+                    isLeft ? -1 : 1);
                 // Avoid multi presses
                 if (!op->firstPress) op->lastPressedTime += 300;
                 else op->lastPressedTime += 100;
                 op->firstPress = 1;
             }
             else if (op->curOpt == OPT_DFPS && (isLeft || isRight)) {
-                if (isLeft) op->dfps -= 30;
-                else if (isRight) op->dfps += 30;
-                // Clamp the value
-                if (op->dfps < 30) op->dfps = 90;
-                else if (op->dfps > 90) op->dfps = 30;
+                op->dfps = _op_nextRate(_op_dfpsList,
+                    sizeof(_op_dfpsList) / sizeof(int), op->dfps,
+                    isLeft ? -1 : 1);
                 // Avoid multi presses
                 if (!op->firstPress) op->lastPressedTime += 300;
                 else op->lastPressedTime += 100;
@@ -834,6 +850,51 @@ static void _op_renderLang(struct stOptions *op, int text, int X, int Y) {
     _op_renderText(pText, X, Y, len);
 }
 
+/**
+ * Select the next rate on a list, wrapping around its ends
+ * 
+ * @param list The selectable rates (in ascending order)
+ * @param len How many rates there are on the list
+ * @param cur The current rate (which may not be on the list)
+ * @param dir Whether the next (1) or previous (-1) rate should be selected
+ * @return The selected rate
+ */
+static int _op_nextRate(const int *list, int len, int cur, int dir) {
+    int i;
+    
+    if (dir > 0) {
+        i = 0;
+        while (i < len && list[i] <= cur)
+            i++;
+        if (i == len)
+            i = 0;
+    }
+    else {
+        i = len - 1;
+        while (i >= 0 && list[i] >= cur)
+            i--;
+        if (i < 0)
+            i = len - 1;
+    }
+    
+    return list[i];
+}
+
+/**
+ * Render a rate (in FPS) as an option's value
+ * 
+ * @param rate The rate
+ * @param X Horizontal position
+ * @param Y Vertical position
+ */
+static void _op_renderRate(int rate, int X, int Y) {
+    char text[16];
+    int len;
+    
+    len = snprintf(text, sizeof(text), "%i FPS", rate);
+    _op_renderText(text, X, Y, len);
+}
+
 /**
  * Render some text into the screen
  * 
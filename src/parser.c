@@ -9,10 +9,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 #include "camera.h"
 #include "commonEvent.h"
 #include "event.h"
 #include "global.h"
+#include "globalVar.h"
 #include "map.h"
 #include "mob.h"
 #include "object.h"
@@ -20,132 +25,219 @@
 #include "registry.h"
 #include "types.h"
 
+/**
+ * How many bytes, after the end of a loaded file, are guaranteed to be valid
+ * (and zeroed); this lets the tilemap decoder read whole blocks at a time
+ */
+#define PARSER_PADDING 16
+
+/**
+ * Same as ASSERT, but also store the error (and where it happened) on the
+ * context
+ */
+#define PASSERT(stmt, err, pos, msg) \
+  do { \
+    if (!(stmt)) { \
+      parsef_setError(pCtx, pos, msg); \
+      rv = err; \
+      goto __ret; \
+    } \
+  } while (0)
+
+/**
+ * Store the first error found while parsing, along with its line and column.
+ * Since errors are propagated upward, only the innermost (i.e., first) one is
+ * kept
+ * 
+ * @param pCtx The file being parsed
+ * @param pPos Position on the buffer where the error happened
+ * @param msg The error's description
+ */
+static void parsef_setError(parserCtx *pCtx, char *pPos, char *msg) {
+    char *pCur, *pLine;
+    int line;
+    
+    if (pCtx->pErrMsg)
+        return;
+    
+    // Since this only happens once, simply count the lines up to the error
+    pCur = pCtx->pBuf;
+    pLine = pCur;
+    line = 1;
+    while (pCur < pPos) {
+        if (*pCur == '\n') {
+            line++;
+            pLine = pCur + 1;
+        }
+        pCur++;
+    }
+    
+    pCtx->pErrMsg = msg;
+    pCtx->errLine = line;
+    pCtx->errCol = (int)(pPos - pLine) + 1;
+}
+
 /**
  * Simply ignore every whitespace. Since this is only called internally, no
  * verification is needed
  * 
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @param ignoreNewline Whether newline ('\n') can be ignored or not
  */
-static void parsef_ignoreWhitespace(FILE *fp, int ignoreNewline) {
-    int c;
+static void parsef_ignoreWhitespace(parserCtx *pCtx, int ignoreNewline) {
+    char *pCur;
     
-    while (1) {
-        c = fgetc(fp);
-        
-        if (c == EOF || (c != ' ' && c != '\t' && c != '\r' &&
-            (!ignoreNewline || c != '\n')))
-            break;
-    }
+    pCur = pCtx->pCur;
+    while (*pCur == ' ' || *pCur == '\t' || *pCur == '\r' ||
+        (ignoreNewline && *pCur == '\n'))
+        pCur++;
+    
+    pCtx->pCur = pCur;
+}
+
+/**
+ * Check whether the next character is the expected one and, if so, skip it
+ * (and every whitespace after it)
+ * 
+ * @param pCtx The file being parsed
+ * @param c The expected character
+ * @return GFraMe error code
+ */
+static GFraMe_ret parsef_char(parserCtx *pCtx, char c) {
+    GFraMe_ret rv;
+    
+    ASSERT(pCtx->pCur < pCtx->pEnd, GFraMe_ret_failed);
+    ASSERT(*pCtx->pCur == c, GFraMe_ret_failed);
     
-    ungetc(c, fp);
+    pCtx->pCur++;
+    parsef_ignoreWhitespace(pCtx, 1);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
 }
 
 /**
  * Parse a integer from a file
  * 
  * @param pI Returns the parsed integer
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-static GFraMe_ret parsef_int(int *pI, FILE *fp) {
-    fpos_t pos;
+static GFraMe_ret parsef_int(int *pI, parserCtx *pCtx) {
+    char *pCur;
     GFraMe_ret rv;
-    int c, i, irv, signal;
+    int i, signal;
     
     // Sanitize parameters
     ASSERT(pI, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
-    
-    // Check that the first character is a digit
-    c = fgetc(fp);
-    ASSERT(c != EOF, GFraMe_ret_failed);
-    ASSERT((c >= '0' && c <= '9') || c == '-', GFraMe_ret_failed);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
     // Set the varibles signal
-    if (c == '-') {
+    pCur = pCtx->pCur;
+    if (*pCur == '-') {
         signal = -1;
-        c = fgetc(fp);
-        ASSERT(c != EOF, GFraMe_ret_failed);
-        ASSERT(c >= '0' && c <= '9', GFraMe_ret_failed);
+        pCur++;
     }
     else
         signal = 1;
     
+    // Check that the first character is a digit (the buffer is
+    // NULL-terminated, so there's no need to check its end)
+    PASSERT(*pCur >= '0' && *pCur <= '9', GFraMe_ret_failed, pCtx->pCur,
+        "Expected a number");
+    
     // Parse the integer
     i = 0;
-    while (1) {
-        i = i * 10 + (c - '0');
-        
-        // Read the next character and stop if it isn't a digit
-        c = fgetc(fp);
-        if (c == EOF || c < '0' || c > '9')
-            break;
+    while (*pCur >= '0' && *pCur <= '9') {
+        i = i * 10 + (*pCur - '0');
+        pCur++;
     }
-    ungetc(c, fp);
+    pCtx->pCur = pCur;
     
     // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
+    parsef_ignoreWhitespace(pCtx, 1);
     
     *pI = i*signal;
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param)
-        fsetpos(fp, &pos);
-    
     return rv;
 }
 
 /**
- * Check that a given (expected) string is read from the stream.
+ * Parse a key (i.e., a lowercase identifier followed by ':'), returning its
+ * range on the buffer (without the ':'). Nothing is consumed on error
  * 
- * @param fp File pointer
- * @param str String to be matched
- * @param len String's length
+ * @param ppKey Returns the key's first character
+ * @param pLen Returns the key's length
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-static GFraMe_ret parsef_string(FILE *fp, char *str, int len) {
-    fpos_t pos;
+static GFraMe_ret parsef_key(char **ppKey, int *pLen, parserCtx *pCtx) {
+    char *pCur;
     GFraMe_ret rv;
-    int i, irv;
     
-    // Sanitize parameters
-    ASSERT(fp, GFraMe_ret_bad_param);
-    ASSERT(str, GFraMe_ret_bad_param);
-    ASSERT(len > 0, GFraMe_ret_bad_param);
+    pCur = pCtx->pCur;
+    while (*pCur >= 'a' && *pCur <= 'z')
+        pCur++;
+    ASSERT(pCur != pCtx->pCur, GFraMe_ret_failed);
+    ASSERT(*pCur == ':', GFraMe_ret_failed);
     
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
+    *ppKey = pCtx->pCur;
+    *pLen = (int)(pCur - pCtx->pCur);
     
-    // Match each character on the string
-    i = 0;
-    while (i < len) {
-        int c;
-        
-        c = fgetc(fp);
-        if (c != str[i])
-            break;
-        i++;
-    }
+    // Skip the ':' and get to the next valid character
+    pCtx->pCur = pCur + 1;
+    parsef_ignoreWhitespace(pCtx, 1);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Check whether a parsed key is the expected one
+ * 
+ * @param pKey The key's first character
+ * @param len The key's length
+ * @param str The expected key (without the ':')
+ * @return 1 on match, 0 otherwise
+ */
+static int parsef_isKey(char *pKey, int len, char *str) {
+    return strncmp(pKey, str, len) == 0 && str[len] == '\0';
+}
+
+/**
+ * Parse a name (i.e., a string between '"'), returning its range on the buffer
+ * (without the '"')
+ * 
+ * @param ppStr Returns the name's first character
+ * @param pLen Returns the name's length
+ * @param pCtx The file being parsed
+ * @return GFraMe error code
+ */
+static GFraMe_ret parsef_name(char **ppStr, int *pLen, parserCtx *pCtx) {
+    char *pCur;
+    GFraMe_ret rv;
     
-    // Check that the string was completely read (and matched)
-    ASSERT(i == len, GFraMe_ret_failed);
+    PASSERT(*pCtx->pCur == '"', GFraMe_ret_failed, pCtx->pCur,
+        "Expected a string");
     
-    // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
+    pCur = pCtx->pCur + 1;
+    while (*pCur != '"' && *pCur != '\n' && *pCur != '\0')
+        pCur++;
+    PASSERT(*pCur == '"', GFraMe_ret_failed, pCtx->pCur,
+        "Unterminated string");
+    
+    *ppStr = pCtx->pCur + 1;
+    *pLen = (int)(pCur - *ppStr);
+    
+    // Skip the closing '"' and get to the next valid character
+    pCtx->pCur = pCur + 1;
+    parsef_ignoreWhitespace(pCtx, 1);
     
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param)
-        fsetpos(fp, &pos);
-    
     return rv;
 }
 
@@ -154,37 +246,34 @@ __ret:
  * flags - flagName ('|' flagName)*
  * 
  * @param pF Returns the parsed flags
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_flags(flag *pF, FILE *fp) {
+GFraMe_ret parsef_flags(flag *pF, parserCtx *pCtx) {
     flag f;
-    fpos_t pos;
     GFraMe_ret rv;
-    int irv;
     
     // Sanitize parameters
     ASSERT(pF, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
     f = 0;
     while (1) {
+        char *pStr;
         flag tmp;
+        int len;
         
         // Get the current flag
-        tmp = t_getFlagFromFile(fp);
-        ASSERT(tmp != 0, GFraMe_ret_failed);
-        parsef_ignoreWhitespace(fp, 1);
+        rv = parsef_name(&pStr, &len, pCtx);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        tmp = t_getFlagFromString(pStr, len);
+        PASSERT(tmp != 0, GFraMe_ret_failed, pStr - 1, "Unknown flag");
         
         // Add it to the current found ones
         f |= tmp;
         
         // Check if another flag is expected
-        rv = parsef_string(fp, "|", 1);
+        rv = parsef_char(pCtx, '|');
         if (rv != GFraMe_ret_ok)
             break;
     }
@@ -193,10 +282,6 @@ GFraMe_ret parsef_flags(flag *pF, FILE *fp) {
     *pF = f;
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param)
-        fsetpos(fp, &pos);
-    
     return rv;
 }
 
@@ -205,37 +290,34 @@ __ret:
  * triggerss - triggerName ('|' triggerName)*
  * 
  * @param pT Returns the parsed triggers
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_triggers(trigger *pT, FILE *fp) {
-    fpos_t pos;
+GFraMe_ret parsef_triggers(trigger *pT, parserCtx *pCtx) {
     GFraMe_ret rv;
-    int irv;
     trigger t;
     
     // Sanitize parameters
     ASSERT(pT, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
     t = 0;
     while (1) {
+        char *pStr;
+        int len;
         trigger tmp;
         
-        // Get the current flag
-        tmp = t_getTriggerFromFile(fp);
-        ASSERT(tmp != 0, GFraMe_ret_failed);
-        parsef_ignoreWhitespace(fp, 1);
+        // Get the current trigger
+        rv = parsef_name(&pStr, &len, pCtx);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        tmp = t_getTriggerFromString(pStr, len);
+        PASSERT(tmp != 0, GFraMe_ret_failed, pStr - 1, "Unknown trigger");
         
         // Add it to the current found ones
         t |= tmp;
         
-        // Check if another flag is expected
-        rv = parsef_string(fp, "|", 1);
+        // Check if another trigger is expected
+        rv = parsef_char(pCtx, '|');
         if (rv != GFraMe_ret_ok)
             break;
     }
@@ -244,10 +326,6 @@ GFraMe_ret parsef_triggers(trigger *pT, FILE *fp) {
     *pT = t;
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param)
-        fsetpos(fp, &pos);
-    
     return rv;
 }
 
@@ -255,59 +333,30 @@ __ret:
  * Parse a global variable from a file
  * 
  * @param pGv Returns the parsed common event
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_globalVar(globalVar *pGv, FILE *fp) {
-    fpos_t pos;
+GFraMe_ret parsef_globalVar(globalVar *pGv, parserCtx *pCtx) {
+    char *pStr;
     GFraMe_ret rv;
     globalVar gv;
-    int irv;
+    int len;
     
     // Sanitize parameters
     ASSERT(pGv, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
-    // Check every globalVar (yay, dumb strats!)
-    gv = 0;
-    while (gv < GV_MAX) {
-        char *gvName;
-        
-        // Get the current globalVar's name
-        gvName = gv_getName(gv);
-        
-        rv = parsef_string(fp, "\"", 1);
-        ASSERT(rv == GFraMe_ret_ok, GFraMe_ret_failed);
-        
-        // Try to match every other character to the current globalVar
-        rv = parsef_string(fp, gvName, strlen(gvName));
-        if (rv == GFraMe_ret_ok) {
-            rv = parsef_string(fp, "\"", 1);
-            if (rv == GFraMe_ret_ok)
-                break;
-        }
-        
-        // Return to the string's begin
-        irv = fsetpos(fp, &pos);
-        ASSERT(irv == 0, GFraMe_ret_failed);
-        
-        gv++;
-    }
+    rv = parsef_name(&pStr, &len, pCtx);
+    ASSERT(rv == GFraMe_ret_ok, rv);
     
-    // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
+    // Look up the variable, pointing at it on error
+    gv = gv_getVarFromString(pStr, len);
+    PASSERT(gv != GV_MAX, GFraMe_ret_failed, pStr - 1,
+        "Unknown global variable");
     
     *pGv = gv;
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param)
-        fsetpos(fp, &pos);
-    
     return rv;
 }
 
@@ -315,99 +364,60 @@ __ret:
  * Parse a common event from a file.
  * 
  * @param pCe Returns the parsed common event
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_commonEvent(commonEvent *pCe, FILE *fp) {
+GFraMe_ret parsef_commonEvent(commonEvent *pCe, parserCtx *pCtx) {
+    char *pStr;
     commonEvent ce;
-    fpos_t pos;
     GFraMe_ret rv;
-    int irv;
+    int len;
     
     // Sanitize parameters
     ASSERT(pCe, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
-    
-    // Check every event (yay, dumb strats!)
-    ce = 0;
-    while (ce < CE_MAX) {
-        char *ceName;
-        
-        rv = parsef_string(fp, "\"", 1);
-        ASSERT(rv == GFraMe_ret_ok, GFraMe_ret_failed);
-        
-        // Get the current event's name
-        ceName = ce_getName(ce);
-        
-        // Try to match every other character to the current event
-        rv = parsef_string(fp, ceName, strlen(ceName));
-        if (rv == GFraMe_ret_ok) {
-            rv = parsef_string(fp, "\"", 1);
-            if (rv == GFraMe_ret_ok)
-                break;
-        }
-        
-        // Return to the string's begin
-        irv = fsetpos(fp, &pos);
-        ASSERT(irv == 0, GFraMe_ret_failed);
-        
-        ce++;
-    }
+    rv = parsef_name(&pStr, &len, pCtx);
+    ASSERT(rv == GFraMe_ret_ok, rv);
     
-    // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
+    // Look up the event, pointing at it on error
+    ce = ce_getEventFromString(pStr, len);
+    PASSERT(ce < CE_MAX, GFraMe_ret_failed, pStr - 1, "Unknown common event");
     
     // Set the function's return
     *pCe = ce;
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param)
-        fsetpos(fp, &pos);
-    
     return rv;
 }
 
 /**
- * Parse a event from a file
+ * Parse a event from a file, right after its "ev:" keyword
  * A event is described by following rule:
- * "ev:" '{' "x:"int "y:"int "w:"int "h:"int "ce:"commonEventName "t:"int 
+ * "ev:" '{' "x:"int "y:"int "w:"int "h:"int "ce:"commonEventName "t:"int
  *          "var:"globalVarName "int:":int '}'
  * All the numbers are read as tiles (i.e., multiplied by 8)
  * 
  * @param pE Returns the parsed event
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_event(event *pE, FILE *fp) {
+GFraMe_ret parsef_event(event *pE, parserCtx *pCtx) {
+    char *pStart;
     commonEvent ce;
-    fpos_t pos;
     GFraMe_ret rv;
     globalVar gvs[EV_VAR_MAX];
-    int c, irv, ivs[EV_VAR_MAX], ivsUsed, gvsUsed, h, w, x, y;
+    int ivs[EV_VAR_MAX], ivsUsed, gvsUsed, h, w, x, y;
     trigger t;
     
     // Sanitize parameters
     ASSERT(pE, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
-    
-    // Check that the next "token" must be an event
-    rv = parsef_string(fp, "ev:", 3);
-    ASSERT(rv == GFraMe_ret_ok, rv);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
     // Open a bracket =D
-    c = fgetc(fp);
-    ASSERT(c != EOF, GFraMe_ret_failed);
-    ASSERT(c == '{', GFraMe_ret_failed);
-    parsef_ignoreWhitespace(fp, 1);
+    pStart = pCtx->pCur;
+    rv = parsef_char(pCtx, '{');
+    PASSERT(rv == GFraMe_ret_ok, rv, pStart, "Expected '{'");
     
     // Get every parameter needed for the event, one at a time
     x = -1;
@@ -419,62 +429,52 @@ GFraMe_ret parsef_event(event *pE, FILE *fp) {
     ivsUsed = 0;
     ce = CE_MAX;
     while (1) {
-        if (parsef_string(fp, "x:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&x, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "y:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&y, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "w:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&w, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "h:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&h, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "t:", 2) == GFraMe_ret_ok) {
-            rv = parsef_triggers(&t, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "ce:", 3) == GFraMe_ret_ok) {
-            rv = parsef_commonEvent(&ce, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            ASSERT(ce < CE_MAX, GFraMe_ret_failed);
+        char *pKey;
+        int len;
+        
+        // If no key was found, expect a closing bracket and stop
+        rv = parsef_key(&pKey, &len, pCtx);
+        if (rv != GFraMe_ret_ok) {
+            rv = parsef_char(pCtx, '}');
+            PASSERT(rv == GFraMe_ret_ok, rv, pCtx->pCur,
+                "Expected a field or '}'");
+            break;
         }
-        else if (parsef_string(fp, "var:", 4) == GFraMe_ret_ok) {
-            globalVar gv;
-            
-            ASSERT(gvsUsed < EV_VAR_MAX, GFraMe_ret_failed);
-            rv = parsef_globalVar(&gv, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            ASSERT(gv < GV_MAX, GFraMe_ret_failed);
-            gvs[gvsUsed] = gv;
+        
+        if (parsef_isKey(pKey, len, "x"))
+            rv = parsef_int(&x, pCtx);
+        else if (parsef_isKey(pKey, len, "y"))
+            rv = parsef_int(&y, pCtx);
+        else if (parsef_isKey(pKey, len, "w"))
+            rv = parsef_int(&w, pCtx);
+        else if (parsef_isKey(pKey, len, "h"))
+            rv = parsef_int(&h, pCtx);
+        else if (parsef_isKey(pKey, len, "t"))
+            rv = parsef_triggers(&t, pCtx);
+        else if (parsef_isKey(pKey, len, "ce"))
+            rv = parsef_commonEvent(&ce, pCtx);
+        else if (parsef_isKey(pKey, len, "var")) {
+            PASSERT(gvsUsed < EV_VAR_MAX, GFraMe_ret_failed, pKey,
+                "Too many variables");
+            rv = parsef_globalVar(&gvs[gvsUsed], pCtx);
             gvsUsed++;
         }
-        else if (parsef_string(fp, "int:", 4) == GFraMe_ret_ok) {
-            int i;
-            
-            ASSERT(ivsUsed < EV_VAR_MAX, GFraMe_ret_failed);
-            rv = parsef_int(&i, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            ivs[ivsUsed] = i;
+        else if (parsef_isKey(pKey, len, "int")) {
+            PASSERT(ivsUsed < EV_VAR_MAX, GFraMe_ret_failed, pKey,
+                "Too many integers");
+            rv = parsef_int(&ivs[ivsUsed], pCtx);
             ivsUsed++;
         }
         else {
-            // If nothing was found, expect a closing bracket and stop
-            c = fgetc(fp);
-            ASSERT(c != EOF, GFraMe_ret_failed);
-            ASSERT(c == '}', GFraMe_ret_failed);
-            break;
+            PASSERT(0, GFraMe_ret_failed, pKey, "Unknown event field");
         }
+        ASSERT(rv == GFraMe_ret_ok, rv);
     }
-    ASSERT(w > 0, GFraMe_ret_failed);
-    ASSERT(h > 0, GFraMe_ret_failed);
-    ASSERT(t > 0, GFraMe_ret_failed);
-    ASSERT(ce != CE_MAX, GFraMe_ret_failed);
+    PASSERT(w > 0, GFraMe_ret_failed, pStart, "Event without a valid width");
+    PASSERT(h > 0, GFraMe_ret_failed, pStart, "Event without a valid height");
+    PASSERT(t > 0, GFraMe_ret_failed, pStart, "Event without triggers");
+    PASSERT(ce != CE_MAX, GFraMe_ret_failed, pStart,
+        "Event without a common event");
     
     // Create the event
     rv = event_setAll(pE, x*8, y*8, w*8, h*8, t, ce);
@@ -490,9 +490,6 @@ GFraMe_ret parsef_event(event *pE, FILE *fp) {
         rv = event_iSetVar(pE, ivsUsed, ivs[ivsUsed]);
     }
     
-    // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
-    
     rv = GFraMe_ret_ok;
 __ret:
     return rv;
@@ -500,40 +497,31 @@ __ret:
 
 
 /**
- * Parse an object from a file
+ * Parse an object from a file, right after its "obj:" keyword
  * A object is described by following rule:
  * "obj:" '{' "x:"int "y:"int "w:"int "h:"int "ce:"commonEventName "var":globalVarName '}'
  * All the numbers are read as tiles (i.e., multiplied by 8)
  * 
  * @param pO Returns the parsed object
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_object(object *pO, FILE *fp) {
+GFraMe_ret parsef_object(object *pO, parserCtx *pCtx) {
+    char *pStart;
     commonEvent ce;
     flag f;
-    fpos_t pos;
     GFraMe_ret rv;
-    int c, irv, h, w, x, y, gvsUsed;
+    int h, w, x, y, gvsUsed;
     globalVar gvs[OBJ_VAR_MAX];
     
     // Sanitize parameters
     ASSERT(pO, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
-    
-    // Check that the next "token" must be an event
-    rv = parsef_string(fp, "obj:", 4);
-    ASSERT(rv == GFraMe_ret_ok, rv);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
     // Open a bracket =D
-    c = fgetc(fp);
-    ASSERT(c != EOF, GFraMe_ret_failed);
-    ASSERT(c == '{', GFraMe_ret_failed);
-    parsef_ignoreWhitespace(fp, 1);
+    pStart = pCtx->pCur;
+    rv = parsef_char(pCtx, '{');
+    PASSERT(rv == GFraMe_ret_ok, rv, pStart, "Expected '{'");
     
     // Get every parameter needed for the object, one at a time
     x = -1;
@@ -544,53 +532,48 @@ GFraMe_ret parsef_object(object *pO, FILE *fp) {
     gvsUsed = 0;
     ce = CE_MAX;
     while (1) {
-        if (parsef_string(fp, "x:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&x, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "y:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&y, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "w:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&w, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "h:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&h, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "ce:", 3) == GFraMe_ret_ok) {
-            rv = parsef_commonEvent(&ce, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            ASSERT(ce < CE_MAX, GFraMe_ret_failed);
+        char *pKey;
+        int len;
+        
+        // If no key was found, expect a closing bracket and stop
+        rv = parsef_key(&pKey, &len, pCtx);
+        if (rv != GFraMe_ret_ok) {
+            rv = parsef_char(pCtx, '}');
+            PASSERT(rv == GFraMe_ret_ok, rv, pCtx->pCur,
+                "Expected a field or '}'");
+            break;
         }
-        else if (parsef_string(fp, "var:", 4) == GFraMe_ret_ok) {
-            ASSERT(gvsUsed < OBJ_VAR_MAX, GFraMe_ret_failed);
-            
-            rv = parsef_globalVar(&gvs[gvsUsed], fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            
+        
+        if (parsef_isKey(pKey, len, "x"))
+            rv = parsef_int(&x, pCtx);
+        else if (parsef_isKey(pKey, len, "y"))
+            rv = parsef_int(&y, pCtx);
+        else if (parsef_isKey(pKey, len, "w"))
+            rv = parsef_int(&w, pCtx);
+        else if (parsef_isKey(pKey, len, "h"))
+            rv = parsef_int(&h, pCtx);
+        else if (parsef_isKey(pKey, len, "ce"))
+            rv = parsef_commonEvent(&ce, pCtx);
+        else if (parsef_isKey(pKey, len, "var")) {
+            PASSERT(gvsUsed < OBJ_VAR_MAX, GFraMe_ret_failed, pKey,
+                "Too many variables");
+            rv = parsef_globalVar(&gvs[gvsUsed], pCtx);
             gvsUsed++;
         }
-        else if (parsef_string(fp, "f:", 2) == GFraMe_ret_ok) {
-            rv = parsef_flags(&f, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            ASSERT(f != 0, GFraMe_ret_failed);
-        }
+        else if (parsef_isKey(pKey, len, "f"))
+            rv = parsef_flags(&f, pCtx);
         else {
-            // If nothing was found, expect a closing bracket and stop
-            c = fgetc(fp);
-            ASSERT(c != EOF, GFraMe_ret_failed);
-            ASSERT(c == '}', GFraMe_ret_failed);
-            break;
+            PASSERT(0, GFraMe_ret_failed, pKey, "Unknown object field");
         }
+        ASSERT(rv == GFraMe_ret_ok, rv);
     }
-    ASSERT(x >= 0, GFraMe_ret_failed);
-    ASSERT(y >= 0, GFraMe_ret_failed);
-    ASSERT(w > 0, GFraMe_ret_failed);
-    ASSERT(h > 0, GFraMe_ret_failed);
-    ASSERT(f != 0, GFraMe_ret_failed);
+    PASSERT(x >= 0, GFraMe_ret_failed, pStart,
+        "Object without a valid position");
+    PASSERT(y >= 0, GFraMe_ret_failed, pStart,
+        "Object without a valid position");
+    PASSERT(w > 0, GFraMe_ret_failed, pStart, "Object without a valid width");
+    PASSERT(h > 0, GFraMe_ret_failed, pStart, "Object without a valid height");
+    PASSERT(f != 0, GFraMe_ret_failed, pStart, "Object without flags");
     
     // Create the object
     obj_setZero(pO);
@@ -602,65 +585,171 @@ GFraMe_ret parsef_object(object *pO, FILE *fp) {
         obj_setVar(pO, gvsUsed, gvs[gvsUsed]);
     }
     
-    // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
-    
     rv = GFraMe_ret_ok;
 __ret:
     return rv;
 }
 
 /**
- * Set a tile into the buffer, expanding it if necessary
+ * Count how many tiles there are in a tilemap, so its buffer may be alloc'ed
+ * only once. Since every tile is followed by a comma, simply count those
  * 
- * @param ppData Buffer that will contain the tilemap
- * @param pDataLen Size of the buffer
- * @param i Horizontal position in the buffer
- * @param h Vertical position in the buffer
- * @param w Width of the buffer
- * @param val Value to be set into the buffer
- * @param GFraMe error code
+ * @param pCtx The file being parsed (positioned after the opening '[')
+ * @return How many tiles there are (or more, if the tilemap is malformed)
  */
-static GFraMe_ret parse_setTile(unsigned char **pData, int *pDataLen, int i,
-    int h, int w, int val) {
-    GFraMe_ret rv;
+static int parsef_countTiles(parserCtx *pCtx) {
+    char *pCur;
+    int n;
+    
+    n = 0;
+    pCur = pCtx->pCur;
+#if defined(__SSE2__)
+    // Count 16 bytes at a time, until the block with the tilemap's end
+    while (1) {
+        __m128i block;
+        int commas;
+        
+        block = _mm_loadu_si128((__m128i*)pCur);
+        if (_mm_movemask_epi8(_mm_or_si128(
+                _mm_cmpeq_epi8(block, _mm_set1_epi8(']')),
+                _mm_cmpeq_epi8(block, _mm_setzero_si128()))))
+            break;
+        
+        commas = _mm_movemask_epi8(_mm_cmpeq_epi8(block,
+                _mm_set1_epi8(',')));
+        n += __builtin_popcount(commas);
+        pCur += 16;
+    }
+#endif
+    while (*pCur != ']' && *pCur != '\0') {
+        if (*pCur == ',')
+            n++;
+        pCur++;
+    }
     
-    // If the buffer is too small, double its size
-    if (i + h*w >= *pDataLen) {
-        *pDataLen *= 2;
+    return n;
+}
+
+/**
+ * Decode, in bulk, as many tiles of 1 to 3 digits (each followed by a comma)
+ * as possible. It stops right before the first field that doesn't follow that
+ * (e.g., whitespace, the line's end or a malformed tile), which must then be
+ * handled by the caller.
+ * 
+ * If available, SSE2 is used to find the commas (and validate the digits) 16
+ * bytes at a time; otherwise (or near the buffer's end), it's done one
+ * character at a time.
+ * 
+ * @param pDst Buffer where the tiles are stored
+ * @param maxTiles How many tiles fit on the buffer
+ * @param ppCur Position on the file; returns the position after the last
+ *              decoded tile's comma
+ * @return How many tiles were decoded
+ */
+static int parsef_decodeTiles(mapTile *pDst, int maxTiles, char **ppCur) {
+    char *pCur;
+    int num;
+    
+    pCur = *ppCur;
+    num = 0;
+#if defined(__SSE2__)
+    // Each tile takes at least 2 bytes, so at most 8 are decoded per block
+    while (num + 8 <= maxTiles) {
+        /* Weight of each of the 3 digits before a comma, by the tile's length
+         * (so there's no need to branch on the length) */
+        static const unsigned char weights[4][3] = {
+            {0, 0, 0}, {0, 0, 1}, {0, 10, 1}, {100, 10, 1}
+        };
+        unsigned char digits[3 + 16];
+        __m128i block, values;
+        int commas, start, valid;
+        
+        // Find every comma and every digit on the block (the file is padded,
+        // so it's safe to read past its end)
+        block = _mm_loadu_si128((__m128i*)pCur);
+        values = _mm_sub_epi8(block, _mm_set1_epi8('0'));
+        commas = _mm_movemask_epi8(_mm_cmpeq_epi8(block,
+                _mm_set1_epi8(',')));
+        valid = commas | _mm_movemask_epi8(_mm_cmpeq_epi8(values,
+                _mm_min_epu8(values, _mm_set1_epi8(9))));
+        digits[0] = 0;
+        digits[1] = 0;
+        digits[2] = 0;
+        _mm_storeu_si128((__m128i*)(digits + 3), values);
+        
+        // Ignore everything after the first unexpected character
+        valid = ~valid & 0xffff;
+        if (valid)
+            commas &= (valid & -valid) - 1;
+        
+        // Convert every complete tile on the block
+        start = 0;
+        while (commas) {
+            int end, len;
+            
+            end = __builtin_ctz(commas);
+            len = end - start;
+            if (len < 1 || len > 3)
+                break;
+            // Since 'digits' is offset by 3, this reads the 3 bytes before
+            // the comma (any byte before the tile has a weight of 0)
+            pDst[num] = weights[len][0] * digits[end]
+                + weights[len][1] * digits[end + 1]
+                + weights[len][2] * digits[end + 2];
+            num++;
+            start = end + 1;
+            commas &= commas - 1;
+        }
+        pCur += start;
         
-        *pData = (unsigned char*)realloc(*pData, *pDataLen);
-        ASSERT(*pData, GFraMe_ret_memory_error);
+        // Stop if the block didn't end on a complete tile
+        if (commas || start == 0)
+            break;
     }
+#endif
     
-    // Set the tile
-    (*pData)[i + h * w] = val;
+    // Decode whatever is left, one character at a time
+    while (num < maxTiles) {
+        int len, tile;
+        
+        tile = 0;
+        len = 0;
+        while (len < 3 && pCur[len] >= '0' && pCur[len] <= '9') {
+            tile = tile * 10 + (pCur[len] - '0');
+            len++;
+        }
+        if (len == 0 || pCur[len] != ',')
+            break;
+        
+        pDst[num] = (mapTile)tile;
+        num++;
+        pCur += len + 1;
+    }
     
-    rv = GFraMe_ret_ok;
-__ret:
-    return rv;
+    *ppCur = pCur;
+    return num;
 }
 
 /**
- * Parse a tilemap from a file, alloc'ing it's buffer (it's actually recycled!)
- * and returning the width and height in tiles.
- * A tilemap must follow the rule:
+ * Parse a tilemap from a file, right after its "tm:" keyword, alloc'ing it's
+ * buffer (it's actually recycled!) and returning the width and height in tiles.
+ * A tilemap must follow the rule (and every line must have the same width):
  * "tm:" '[' ((int',')+ '\n')+ ']'
  * 
  * @param ppData Buffer that will contain the tilemap; if it's being recycled,
- *               pDataLen must have the buffer current size!
+ *               pDataLen must have the buffer current size! If it's too small,
+ *               it's released (on success) and a new one is returned
  * @param pDataLen Buffer final len (and initial, if ppData isn't NULL)
  * @param pW Tilemap's width in tiles
  * @param pH Tilemap's height in tiles
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_tilemap(unsigned char **ppData, int *pDataLen, int *pW,
-    int *pH, FILE *fp) {
-    unsigned char *data;
-    fpos_t pos;
+GFraMe_ret parsef_tilemap(mapTile **ppData, int *pDataLen, int *pW,
+    int *pH, parserCtx *pCtx) {
+    mapTile *data;
     GFraMe_ret rv;
-    int c, dataLen, h, i, irv, w;
+    int dataLen, h, i, n, w;
     
     // Intialize this, so it can be cleaned
     data = NULL;
@@ -671,24 +760,18 @@ GFraMe_ret parsef_tilemap(unsigned char **ppData, int *pDataLen, int *pW,
     ASSERT(!*ppData || *pDataLen > 0, GFraMe_ret_bad_param);
     ASSERT(pW, GFraMe_ret_bad_param);
     ASSERT(pH, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
-    
-    // Check that the next "token" must be a tilemap
-    rv = parsef_string(fp, "tm:", 3);
-    ASSERT(rv == GFraMe_ret_ok, rv);
-    
-    c = fgetc(fp);
-    ASSERT(c != EOF, GFraMe_ret_failed);
-    ASSERT(c == '[', GFraMe_ret_failed);
-    
-    // Set the working buffer
-    if (!*ppData) {
-        dataLen = 2;
-        data = (unsigned char*)malloc(sizeof(char)*dataLen);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
+    
+    PASSERT(*pCtx->pCur == '[', GFraMe_ret_failed, pCtx->pCur,
+        "Expected '['");
+    pCtx->pCur++;
+    
+    // Set the working buffer; if the recycled one is too small, a new one is
+    // alloc'ed (and the old one is only released on success)
+    dataLen = parsef_countTiles(pCtx);
+    PASSERT(dataLen > 0, GFraMe_ret_failed, pCtx->pCur, "Empty tilemap");
+    if (!*ppData || *pDataLen < dataLen) {
+        data = (mapTile*)malloc(sizeof(mapTile)*dataLen);
         ASSERT(data, GFraMe_ret_memory_error);
     }
     else {
@@ -697,105 +780,186 @@ GFraMe_ret parsef_tilemap(unsigned char **ppData, int *pDataLen, int *pW,
     }
     
     // Parse the tilemap
+    n = 0;
     w = 0;
     h = 0;
     while (1) {
-        parsef_ignoreWhitespace(fp, 1);
+        char *pCur;
+        
+        parsef_ignoreWhitespace(pCtx, 1);
         
         // Check if the end of the array was reached
-        c = fgetc(fp);
-        ASSERT(c != EOF, GFraMe_ret_failed);
-        if (c == ']')
+        if (*pCtx->pCur == ']')
             break;
-        ungetc(c, fp);
         
-        // Get every tile in a line
+        // Get every tile in a line; since the whole file is in memory (and
+        // NULL-terminated), simply walk through it
+        pCur = pCtx->pCur;
         i = 0;
-        while (1) {
-            int n;
-            
-            // Read the current tile (or stop)
-            rv = parsef_int(&n, fp);
-            if (rv != GFraMe_ret_ok)
-                break;
-            
-            // After a digit, a comma MUST follow
-            c = fgetc(fp);
-            ASSERT(c != EOF, GFraMe_ret_failed);
-            ASSERT(c == ',', GFraMe_ret_failed);
+        while (*pCur >= '0' && *pCur <= '9') {
+            int num;
             
-            // Set the last read tile
-            parse_setTile(&data, &dataLen, i, h, w, n);
+            // Decode as many tiles as possible in bulk (there's always enough
+            // room, since the commas were counted)
+            num = parsef_decodeTiles(data + n, dataLen - n, &pCur);
+            if (num == 0) {
+                int tile;
+                
+                // Otherwise, read a single (longer or malformed) tile
+                tile = 0;
+                while (*pCur >= '0' && *pCur <= '9' && tile <= 0xffff) {
+                    tile = tile * 10 + (*pCur - '0');
+                    pCur++;
+                }
+                PASSERT(tile <= 0xffff, GFraMe_ret_failed, pCtx->pCur,
+                    "Invalid tile");
+                
+                // After a digit, a comma MUST follow
+                PASSERT(*pCur == ',', GFraMe_ret_failed, pCur,
+                    "Expected ','");
+                pCur++;
+                
+                data[n] = (mapTile)tile;
+                num = 1;
+            }
+            n += num;
+            i += num;
             
             // Ignore everything but '\n'
-            parsef_ignoreWhitespace(fp, 0);
-            
-            // Go to the next column
-            i++;
-            
-            // Check if the line ended
-            c = fgetc(fp);
-            ASSERT(c != EOF, GFraMe_ret_failed);
-            if (c == '\n') {
-                parsef_ignoreWhitespace(fp, 1);
-                break;
-            }
-            ungetc(c, fp);
+            while (*pCur == ' ' || *pCur == '\t' || *pCur == '\r')
+                pCur++;
+            pCtx->pCur = pCur;
         }
-        if (i > w)
+        PASSERT(i > 0, GFraMe_ret_failed, pCur, "Expected a tile or ']'");
+        PASSERT(*pCur == '\n' || *pCur == ']', GFraMe_ret_failed, pCur,
+            "Expected a tile or a new line");
+        
+        // Every line must have the same width
+        if (h == 0)
             w = i;
+        PASSERT(i == w, GFraMe_ret_failed, pCur,
+            "Tilemap's lines must have the same width");
         
         // Go to the next line
         h++;
     }
-    
-    // Check that the tilemap indeed ended
-    ASSERT(c == ']', GFraMe_ret_failed);
-    parsef_ignoreWhitespace(fp, 1);
+    // Skip the tilemap's closing bracket
+    pCtx->pCur++;
+    parsef_ignoreWhitespace(pCtx, 1);
     
     // Set the camera's dimension
     cam_setMapDimension(w * 8, h * 8);
     
     // Set the function's return
+    if (*ppData && *ppData != data)
+        free(*ppData);
     *ppData = data;
     *pDataLen = dataLen;
     *pW = w;
     *pH = h;
     rv = GFraMe_ret_ok;
 __ret:
-    // Backtrack on error
-    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param) {
-        fsetpos(fp, &pos);
-        // If 'data' was allocated here
-        if (!*ppData && data)
-            free(data);
-    }
+    // If 'data' was allocated here
+    if (rv != GFraMe_ret_ok && rv != GFraMe_ret_bad_param && data &&
+        data != *ppData)
+        free(data);
     
     return rv;
 }
 
 /**
- * Parse a map from a file
+ * Load a whole file into memory, NULL-terminating it (and padding it with
+ * PARSER_PADDING zeroed bytes)
  * 
- * @param ppM Returns the map
+ * @param pCtx Returns the loaded file
  * @param fn The file's name
  * @return GFraMe error code
  */
-GFraMe_ret parsef_map(map **ppM, char *fn) {
+static GFraMe_ret parsef_loadFile(parserCtx *pCtx, char *fn) {
     FILE *fp;
     GFraMe_ret rv;
-    map *pM;
+    long len;
     
     // Intialize this, so it can be cleaned
-    pM = NULL;
-    
-    // Sanitize parameters
-    ASSERT(ppM, GFraMe_ret_bad_param);
-    ASSERT(fn, GFraMe_ret_bad_param);
+    fp = NULL;
+    memset(pCtx, 0x0, sizeof(parserCtx));
+    pCtx->fn = fn;
     
     fp = fopen(fn, "rb");
     ASSERT(fp, GFraMe_ret_file_not_found);
     
+    // Get the file's size
+    ASSERT(fseek(fp, 0, SEEK_END) == 0, GFraMe_ret_failed);
+    len = ftell(fp);
+    ASSERT(len >= 0, GFraMe_ret_failed);
+    ASSERT(fseek(fp, 0, SEEK_SET) == 0, GFraMe_ret_failed);
+    
+    // Read it in a single go
+    pCtx->pBuf = (char*)malloc(len + PARSER_PADDING);
+    ASSERT(pCtx->pBuf, GFraMe_ret_memory_error);
+    ASSERT(fread(pCtx->pBuf, 1, len, fp) == (size_t)len, GFraMe_ret_failed);
+    memset(pCtx->pBuf + len, 0x0, PARSER_PADDING);
+    
+    pCtx->pCur = pCtx->pBuf;
+    pCtx->pEnd = pCtx->pBuf + len;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    if (fp)
+        fclose(fp);
+    if (rv != GFraMe_ret_ok && pCtx->pBuf) {
+        free(pCtx->pBuf);
+        pCtx->pBuf = NULL;
+    }
+    
+    return rv;
+}
+
+/**
+ * Copy a string into memory, NULL-terminating it (and padding it with
+ * PARSER_PADDING zeroed bytes)
+ * 
+ * @param pCtx Returns the loaded string
+ * @param str The string
+ * @param len The string's length
+ * @return GFraMe error code
+ */
+static GFraMe_ret parses_loadString(parserCtx *pCtx, char *str, int len) {
+    GFraMe_ret rv;
+    
+    memset(pCtx, 0x0, sizeof(parserCtx));
+    pCtx->fn = "<string>";
+    
+    pCtx->pBuf = (char*)malloc(len + PARSER_PADDING);
+    ASSERT(pCtx->pBuf, GFraMe_ret_memory_error);
+    memcpy(pCtx->pBuf, str, len);
+    memset(pCtx->pBuf + len, 0x0, PARSER_PADDING);
+    
+    pCtx->pCur = pCtx->pBuf;
+    pCtx->pEnd = pCtx->pBuf + len;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Parse a map already loaded into memory, releasing its buffer
+ * Each structure is parsed according to its leading keyword ("ev:", "tm:",
+ * "obj:", "mob:" or "var:", which declares a variable of this map). On error,
+ * the offending line and column are logged.
+ * 
+ * @param ppM Returns the map
+ * @param pCtx The loaded map
+ * @return GFraMe error code
+ */
+static GFraMe_ret parsef_mapCtx(map **ppM, parserCtx *pCtx) {
+    GFraMe_ret rv;
+    map *pM;
+    
+    // Intialize this, so it can be cleaned
+    pM = NULL;
+    
     // Get the working map
     if (*ppM)
         pM = *ppM;
@@ -806,60 +970,79 @@ GFraMe_ret parsef_map(map **ppM, char *fn) {
     map_reset(pM);
     rg_reset();
     
-    while (1) {
-        unsigned char *pData;
-        event *e;
-        int c, h, len, w;
-        object *o;
-        mob *m;
-        
-        // Retrieve a event from map, in case it's parsed
-        rv = rg_getNextEvent(&e);
-        ASSERT(rv == GFraMe_ret_ok, rv);
-        // Retrieve the current map's data, to recycle it
-        rv = map_getTilemapData(&pData, &len, pM);
-        ASSERT(rv == GFraMe_ret_ok, rv);
-        rv = rg_getNextObject(&o);
-        ASSERT(rv == GFraMe_ret_ok, rv);
-        rv = rg_getNextMob(&m);
-        ASSERT(rv == GFraMe_ret_ok, rv);
+    parsef_ignoreWhitespace(pCtx, 1);
+    while (pCtx->pCur < pCtx->pEnd) {
+        char *pKey;
+        int len;
         
-        // Try to parse a event
+        // Every structure starts with a keyword
+        rv = parsef_key(&pKey, &len, pCtx);
+        PASSERT(rv == GFraMe_ret_ok, rv, pCtx->pCur, "Expected a keyword");
         
-        // Try to parse a event
-        rv = parsef_event(e, fp);
-        if (rv == GFraMe_ret_ok) {
+        if (parsef_isKey(pKey, len, "ev")) {
+            event *e;
+            
+            rv = rg_getNextEvent(&e);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = parsef_event(e, pCtx);
+            ASSERT(rv == GFraMe_ret_ok, rv);
             rg_pushEvent();
-            continue;
         }
-        // Try to parse a tilemap
-        rv = parsef_tilemap(&pData, &len, &w, &h, fp);
-        if (rv == GFraMe_ret_ok) {
-            map_setTilemap(pM, pData, len, w, h);
-            continue;
+        else if (parsef_isKey(pKey, len, "tm")) {
+            mapTile *pData;
+            int dataLen, h, w;
+            
+            // Retrieve the current map's data, to recycle it
+            rv = map_getTilemapData(&pData, &dataLen, pM);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = parsef_tilemap(&pData, &dataLen, &w, &h, pCtx);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = map_setTilemap(pM, pData, dataLen, w, h);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+        }
+        else if (parsef_isKey(pKey, len, "obj")) {
+            object *o;
+            
+            rv = rg_getNextObject(&o);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = parsef_object(o, pCtx);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = rg_pushObject();
+            ASSERT(rv == GFraMe_ret_ok, rv);
         }
-        rv = parsef_object(o, fp);
-        if (rv == GFraMe_ret_ok) {
-            rg_pushObject();
-            continue;
+        else if (parsef_isKey(pKey, len, "var")) {
+            char *pStr;
+            int strLen;
+            
+            // Declare a variable of this map
+            rv = parsef_name(&pStr, &strLen, pCtx);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = gv_declare(pStr, strLen);
+            PASSERT(rv == GFraMe_ret_ok, rv, pStr - 1,
+                "Invalid (or repeated) map variable");
         }
-        rv = parsef_mob(m, fp);
-        if (rv == GFraMe_ret_ok) {
+        else if (parsef_isKey(pKey, len, "mob")) {
+            mob *m;
+            
+            rv = rg_getNextMob(&m);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rv = parsef_mob(m, pCtx);
+            ASSERT(rv == GFraMe_ret_ok, rv);
             rg_pushMob();
-            continue;
         }
-        // TODO parse other structures
-        
-        // Ignore whitespace and check that the file ended
-        parsef_ignoreWhitespace(fp, 1);
-        c = fgetc(fp);
-        ASSERT(c == EOF, GFraMe_ret_failed);
-        break;
+        else {
+            PASSERT(0, GFraMe_ret_failed, pKey, "Unknown keyword");
+        }
     }
     
     *ppM = pM;
     rv = GFraMe_ret_ok;
 __ret:
+    if (rv != GFraMe_ret_ok && pCtx->pErrMsg)
+        GFraMe_log("%s:%i:%i: %s", pCtx->fn, pCtx->errLine, pCtx->errCol,
+            pCtx->pErrMsg);
+    if (pCtx->pBuf)
+        free(pCtx->pBuf);
     // Backtrack on error
     if (rv != GFraMe_ret_ok && !*ppM && pM)
             free(pM);
@@ -868,73 +1051,113 @@ __ret:
 }
 
 /**
- * Parse a mob from a file
+ * Parse a map from a file
+ * The whole file is loaded into memory and each structure is parsed according
+ * to its leading keyword ("ev:", "tm:", "obj:", "mob:" or "var:", which
+ * declares a variable of this map). On error, the offending line and column
+ * are logged.
  * 
- * @param pM Returns the parsed mob
- * @param fp File pointer
+ * @param ppM Returns the map
+ * @param fn The file's name
  * @return GFraMe error code
  */
-GFraMe_ret parsef_mob(mob *pM, FILE *fp) {
-    flag f;
-    fpos_t pos;
+GFraMe_ret parsef_map(map **ppM, char *fn) {
+    parserCtx ctx;
     GFraMe_ret rv;
-    int c, irv, x, y;
     
     // Sanitize parameters
-    ASSERT(pM, GFraMe_ret_bad_param);
-    ASSERT(fp, GFraMe_ret_bad_param);
+    ASSERT(ppM, GFraMe_ret_bad_param);
+    ASSERT(fn, GFraMe_ret_bad_param);
     
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    ASSERT(irv == 0, GFraMe_ret_failed);
+    rv = parsef_loadFile(&ctx, fn);
+    ASSERT(rv == GFraMe_ret_ok, rv);
+    rv = parsef_mapCtx(ppM, &ctx);
+__ret:
+    return rv;
+}
+
+/**
+ * Parse a map from a string (in the same format as a map's file)
+ * 
+ * @param ppM Returns the map
+ * @param str The string
+ * @param len The string's length
+ * @return GFraMe error code
+ */
+GFraMe_ret parses_map(map **ppM, char *str, int len) {
+    parserCtx ctx;
+    GFraMe_ret rv;
+    
+    // Sanitize parameters
+    ASSERT(ppM, GFraMe_ret_bad_param);
+    ASSERT(str, GFraMe_ret_bad_param);
+    ASSERT(len >= 0, GFraMe_ret_bad_param);
     
-    // Check that the next "token" must be an event
-    rv = parsef_string(fp, "mob:", 4);
+    rv = parses_loadString(&ctx, str, len);
     ASSERT(rv == GFraMe_ret_ok, rv);
+    rv = parsef_mapCtx(ppM, &ctx);
+__ret:
+    return rv;
+}
+
+/**
+ * Parse a mob from a file, right after its "mob:" keyword
+ * 
+ * @param pM Returns the parsed mob
+ * @param pCtx The file being parsed
+ * @return GFraMe error code
+ */
+GFraMe_ret parsef_mob(mob *pM, parserCtx *pCtx) {
+    char *pStart;
+    flag f;
+    GFraMe_ret rv;
+    int x, y;
+    
+    // Sanitize parameters
+    ASSERT(pM, GFraMe_ret_bad_param);
+    ASSERT(pCtx, GFraMe_ret_bad_param);
     
     // Open a bracket =D
-    c = fgetc(fp);
-    ASSERT(c != EOF, GFraMe_ret_failed);
-    ASSERT(c == '{', GFraMe_ret_failed);
-    parsef_ignoreWhitespace(fp, 1);
+    pStart = pCtx->pCur;
+    rv = parsef_char(pCtx, '{');
+    PASSERT(rv == GFraMe_ret_ok, rv, pStart, "Expected '{'");
     
     // Get every parameter needed for the object, one at a time
     x = -1;
     y = -1;
     f = 0;
     while (1) {
-        if (parsef_string(fp, "x:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&x, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "y:", 2) == GFraMe_ret_ok) {
-            rv = parsef_int(&y, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-        }
-        else if (parsef_string(fp, "f:", 2) == GFraMe_ret_ok) {
-            rv = parsef_flags(&f, fp);
-            ASSERT(rv == GFraMe_ret_ok, rv);
-            ASSERT(f != 0, GFraMe_ret_failed);
+        char *pKey;
+        int len;
+        
+        // If no key was found, expect a closing bracket and stop
+        rv = parsef_key(&pKey, &len, pCtx);
+        if (rv != GFraMe_ret_ok) {
+            rv = parsef_char(pCtx, '}');
+            PASSERT(rv == GFraMe_ret_ok, rv, pCtx->pCur,
+                "Expected a field or '}'");
+            break;
         }
+        
+        if (parsef_isKey(pKey, len, "x"))
+            rv = parsef_int(&x, pCtx);
+        else if (parsef_isKey(pKey, len, "y"))
+            rv = parsef_int(&y, pCtx);
+        else if (parsef_isKey(pKey, len, "f"))
+            rv = parsef_flags(&f, pCtx);
         else {
-            // If nothing was found, expect a closing bracket and stop
-            c = fgetc(fp);
-            ASSERT(c != EOF, GFraMe_ret_failed);
-            ASSERT(c == '}', GFraMe_ret_failed);
-            break;
+            PASSERT(0, GFraMe_ret_failed, pKey, "Unknown mob field");
         }
+        ASSERT(rv == GFraMe_ret_ok, rv);
     }
-    ASSERT(x >= 0, GFraMe_ret_failed);
-    ASSERT(y >= 0, GFraMe_ret_failed);
-    ASSERT(f != 0, GFraMe_ret_failed);
+    PASSERT(x >= 0, GFraMe_ret_failed, pStart, "Mob without a valid position");
+    PASSERT(y >= 0, GFraMe_ret_failed, pStart, "Mob without a valid position");
+    PASSERT(f != 0, GFraMe_ret_failed, pStart, "Mob without flags");
     
     // Create the mob
     rv = mob_init(pM, x, y, f);
     ASSERT_NR(rv == GFraMe_ret_ok);
     
-    // Get to the next valid character
-    parsef_ignoreWhitespace(fp, 1);
-    
     rv = GFraMe_ret_ok;
 __ret:
     return rv;
@@ -8,83 +8,105 @@
 
 #include <GFraMe/GFraMe_error.h>
 
-#include <stdio.h>
-
 #include "commonEvent.h"
 #include "event.h"
 #include "globalVar.h"
+#include "map.h"
 #include "mob.h"
 #include "types.h"
 
+/** A file loaded into memory, as it's being parsed */
+struct stParserCtx {
+    /** The file's name (used when reporting errors) */
+    char *fn;
+    /** The file's content, NULL-terminated */
+    char *pBuf;
+    /** Current position on the buffer */
+    char *pCur;
+    /** Position right after the last character on the buffer */
+    char *pEnd;
+    /** The first error found (or NULL) */
+    char *pErrMsg;
+    /** Line where the first error was found */
+    int errLine;
+    /** Column where the first error was found */
+    int errCol;
+};
+typedef struct stParserCtx parserCtx;
+
 /**
  * Parse a global variable from a file
  * 
  * @param pGv Returns the parsed common event
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_globalVar(globalVar *pGv, FILE *fp);
+GFraMe_ret parsef_globalVar(globalVar *pGv, parserCtx *pCtx);
 
 /**
  * Parse flags from a file
  * flags - flagName ('|' flagName)*
  * 
  * @param pF Returns the parsed flags
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_flags(flag *pF, FILE *fp);
+GFraMe_ret parsef_flags(flag *pF, parserCtx *pCtx);
 
 /**
  * Parse triggers from a file
  * triggerss - triggerName ('|' triggerName)*
  * 
  * @param pT Returns the parsed triggers
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_triggers(trigger *pT, FILE *fp);
+GFraMe_ret parsef_triggers(trigger *pT, parserCtx *pCtx);
 
 /**
  * Parse a common event from a file
  * 
  * @param pCe Returns the parsed common event
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_commonEvent(commonEvent *pCe, FILE *fp);
+GFraMe_ret parsef_commonEvent(commonEvent *pCe, parserCtx *pCtx);
 
 /**
- * Parse a event from a file
+ * Parse a event from a file, right after its "ev:" keyword
  * A event is described by following rule:
  * "ev:" '{' "x:"int "y:"int "w:"int "h:"int "ce:"commonEventName "t:"int 
  *          "var:"globalVarName "int:":int '}'
  * 
  * @param pE Returns the parsed event
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_event(event *pE, FILE *fp);
+GFraMe_ret parsef_event(event *pE, parserCtx *pCtx);
 
 /**
- * Parse a tilemap from a file, alloc'ing it's buffer (it's actually recycled!)
- * and returning the width and height in tiles.
- * A tilemap must follow the rule:
+ * Parse a tilemap from a file, right after its "tm:" keyword, alloc'ing it's
+ * buffer (it's actually recycled!) and returning the width and height in tiles.
+ * A tilemap must follow the rule (and every line must have the same width):
  * "tm:" '[' ((int',')+ '\n')+ ']'
  * 
  * @param ppData Buffer that will contain the tilemap; if it's being recycled,
- *               pDataLen must have the buffer current size!
+ *               pDataLen must have the buffer current size! If it's too small,
+ *               it's released (on success) and a new one is returned
  * @param pDataLen Buffer final len (and initial, if ppData isn't NULL)
  * @param pW Tilemap's width in tiles
  * @param pH Tilemap's height in tiles
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_tilemap(unsigned char **ppData, int *pDataLen, int *pW,
-    int *pH, FILE *fp);
+GFraMe_ret parsef_tilemap(mapTile **ppData, int *pDataLen, int *pW,
+    int *pH, parserCtx *pCtx);
 
 /**
  * Parse a map from a file
+ * The whole file is loaded into memory and each structure is parsed according
+ * to its leading keyword ("ev:", "tm:", "obj:" or "mob:"). On error, the
+ * offending line and column are logged.
  * 
  * @param ppM Returns the map
  * @param fn The file's name
@@ -93,22 +115,32 @@ GFraMe_ret parsef_tilemap(unsigned char **ppData, int *pDataLen, int *pW,
 GFraMe_ret parsef_map(map **ppM, char *fn);
 
 /**
- * Parse a mob from a file
+ * Parse a map from a string (in the same format as a map's file)
+ * 
+ * @param ppM Returns the map
+ * @param str The string
+ * @param len The string's length
+ * @return GFraMe error code
+ */
+GFraMe_ret parses_map(map **ppM, char *str, int len);
+
+/**
+ * Parse a mob from a file, right after its "mob:" keyword
  * 
  * @param pM Returns the parsed mob
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-GFraMe_ret parsef_mob(mob *pM, FILE *fp);
+GFraMe_ret parsef_mob(mob *pM, parserCtx *pCtx);
 
 /**
  * Parse a object from a file
  * 
  * @param pO Returns the parsed object
- * @param fp File pointer
+ * @param pCtx The file being parsed
  * @return GFraMe error code
  */
-// GFraMe_ret parsef_obj(obj *pO, FILE *fp);
+// GFraMe_ret parsef_obj(obj *pO, parserCtx *pCtx);
 
 #endif
 
@@ -0,0 +1,172 @@
+/**
+ * @file src/perfectHash.c
+ * 
+ * Perfect hash tables, generated through "hash and displace": every name is
+ * first hashed into a bucket, then each bucket (from the fullest to the
+ * emptiest) gets the first displacement that puts all of its names on unused
+ * slots. Looking a name up is simply hashing it to its bucket and, with that
+ * bucket's displacement, to its slot.
+ */
+#include <GFraMe/GFraMe_error.h>
+
+#include <string.h>
+
+#include "global.h"
+#include "perfectHash.h"
+
+/** Highest displacement tried before giving up */
+#define PH_MAX_DISP 0xffff
+
+/**
+ * Hash a string (FNV-1a, with a final mix so lower bits are usable)
+ * 
+ * @param seed Seed for the hash (i.e., a bucket's displacement)
+ * @param str The string
+ * @param len The string's length
+ * @return The hash
+ */
+static unsigned int ph_hash(unsigned int seed, char *str, int len) {
+    unsigned int h;
+    
+    h = 2166136261u ^ (seed * 0x9e3779b9u);
+    while (len > 0) {
+        h ^= (unsigned char)*str;
+        h *= 16777619u;
+        str++;
+        len--;
+    }
+    
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    
+    return h;
+}
+
+/**
+ * Generate a table for the given names; since it's deterministic, it yields
+ * the same table for the same list
+ * 
+ * @param pH The table
+ * @param names The names, indexed by their value (they must be unique)
+ * @param num How many names there are
+ * @return GFraMe error code
+ */
+GFraMe_ret ph_init(perfectHash *pH, char **names, int num) {
+    GFraMe_ret rv;
+    int bucket, buckets, count[PH_MAX_NAMES], i, max;
+    unsigned char nameBucket[PH_MAX_NAMES];
+    
+    // Sanitize parameters
+    ASSERT(pH, GFraMe_ret_bad_param);
+    ASSERT(names, GFraMe_ret_bad_param);
+    ASSERT(num > 0 && num <= PH_MAX_NAMES, GFraMe_ret_bad_param);
+    
+    // Use as many buckets as there are names (rounded to a power of two)
+    buckets = 1;
+    while (buckets < num)
+        buckets *= 2;
+    
+    // Split every name into its bucket
+    memset(count, 0x0, sizeof(count));
+    i = 0;
+    while (i < num) {
+        bucket = ph_hash(0, names[i], strlen(names[i])) & (buckets - 1);
+        nameBucket[i] = (unsigned char)bucket;
+        count[bucket]++;
+        i++;
+    }
+    
+    memset(pH->disp, 0x0, sizeof(pH->disp));
+    memset(pH->slots, 0xff, sizeof(pH->slots));
+    
+    // Place the fullest buckets first, since they are the hardest to fit
+    max = num;
+    while (max > 0) {
+        bucket = 0;
+        while (bucket < buckets) {
+            unsigned int d;
+            
+            if (count[bucket] != max) {
+                bucket++;
+                continue;
+            }
+            
+            // Find a displacement that fits every name on the bucket
+            d = 1;
+            while (d <= PH_MAX_DISP) {
+                int j;
+                
+                i = 0;
+                while (i < num) {
+                    int slot;
+                    
+                    if (nameBucket[i] == bucket) {
+                        slot = ph_hash(d, names[i], strlen(names[i]))
+                            & (PH_SLOTS - 1);
+                        if (pH->slots[slot] != -1)
+                            break;
+                        // Temporarily take the slot
+                        pH->slots[slot] = (short)i;
+                    }
+                    i++;
+                }
+                if (i == num)
+                    break;
+                
+                // Release every slot taken with this displacement
+                j = 0;
+                while (j < i) {
+                    if (nameBucket[j] == bucket)
+                        pH->slots[ph_hash(d, names[j], strlen(names[j]))
+                            & (PH_SLOTS - 1)] = -1;
+                    j++;
+                }
+                d++;
+            }
+            GFraMe_assertRV(d <= PH_MAX_DISP, "Failed to generate hash table",
+                rv = GFraMe_ret_failed, __ret);
+            
+            pH->disp[bucket] = (unsigned short)d;
+            bucket++;
+        }
+        max--;
+    }
+    
+    pH->names = names;
+    pH->num = num;
+    pH->bucketMask = buckets - 1;
+    pH->isInit = 1;
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Look up a name on a table, generating it on the first call
+ * 
+ * @param pH The table
+ * @param names The names, indexed by their value
+ * @param num How many names there are
+ * @param str The name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The name's index or -1, if it isn't on the table
+ */
+int ph_find(perfectHash *pH, char **names, int num, char *str, int len) {
+    int bucket, i;
+    
+    if (!pH || !str || len <= 0)
+        return -1;
+    if (!pH->isInit && ph_init(pH, names, num) != GFraMe_ret_ok)
+        return -1;
+    
+    bucket = ph_hash(0, str, len) & pH->bucketMask;
+    i = pH->slots[ph_hash(pH->disp[bucket], str, len) & (PH_SLOTS - 1)];
+    
+    // Check that it's indeed the requested name
+    if (i < 0 || strncmp(pH->names[i], str, len) != 0 ||
+        pH->names[i][len] != '\0')
+        return -1;
+    return i;
+}
+
@@ -0,0 +1,59 @@
+/**
+ * @file src/perfectHash.h
+ * 
+ * Perfect hash tables for looking up a value from its name (e.g., when parsing
+ * a map). Each table is generated (only once) from a fixed list of names, so
+ * every lookup costs two hashes and a single string comparison.
+ */
+#ifndef __PERFECTHASH_H_
+#define __PERFECTHASH_H_
+
+#include <GFraMe/GFraMe_error.h>
+
+/** Maximum number of names on a table */
+#define PH_MAX_NAMES 128
+/** Number of slots on a table (must be a power of two, at least twice
+ *  PH_MAX_NAMES) */
+#define PH_SLOTS 256
+
+struct stPerfectHash {
+    /** The names, indexed by their value */
+    char **names;
+    /** How many names there are */
+    int num;
+    /** Mask for a name's bucket (i.e., buckets - 1) */
+    int bucketMask;
+    /** Displacement used by the names on each bucket */
+    unsigned short disp[PH_MAX_NAMES];
+    /** Index of the name hashed to each slot (or -1) */
+    short slots[PH_SLOTS];
+    /** Whether the table was already generated */
+    int isInit;
+};
+typedef struct stPerfectHash perfectHash;
+
+/**
+ * Generate a table for the given names; since it's deterministic, it yields
+ * the same table for the same list
+ * 
+ * @param pH The table
+ * @param names The names, indexed by their value (they must be unique)
+ * @param num How many names there are
+ * @return GFraMe error code
+ */
+GFraMe_ret ph_init(perfectHash *pH, char **names, int num);
+
+/**
+ * Look up a name on a table, generating it on the first call
+ * 
+ * @param pH The table
+ * @param names The names, indexed by their value
+ * @param num How many names there are
+ * @param str The name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The name's index or -1, if it isn't on the table
+ */
+int ph_find(perfectHash *pH, char **names, int num, char *str, int len);
+
+#endif
+
@@ -19,8 +19,10 @@
 #include "controller.h"
 #include "global.h"
 #include "globalVar.h"
+#include "interp.h"
 #include "mob.h"
 #include "player.h"
+#include "profiler.h"
 #include "registry.h"
 #include "signal.h"
 #include "types.h"
@@ -39,6 +41,7 @@ enum {
 
 struct stPlayer {
     GFraMe_sprite spr;
+    ipPos ip;
     
     GFraMe_animation standAnim;
     int standData[8];
@@ -398,7 +401,7 @@ void player_draw(player *pPl) {
     x = pPl->spr.obj.x - cam_x;
     y = pPl->spr.obj.y - cam_y;
     if (x >= 0 && x <= SCR_W && y >= 0 && y <= SCR_H)
-        GFraMe_sprite_draw_camera(&pPl->spr, cam_x, cam_y, SCR_W, SCR_H);
+        PROF_SPRITE_DRAW(PLAYERS, &pPl->spr, cam_x, cam_y, SCR_W, SCR_H);
     else {
         if (x < 0)
             x = 0;
@@ -409,14 +412,26 @@ void player_draw(player *pPl) {
         else if (y + 8 > SCR_H)
             y = SCR_H - 8;
         if (pPl->spr.id == ID_PL1) {
-            GFraMe_spriteset_draw(gl_sset8x8, PL1_ICON, x, y, pPl->spr.flipped);
+            PROF_SPRITESET_DRAW(PLAYERS, gl_sset8x8, PL1_ICON, x, y,
+                pPl->spr.flipped);
         }
         else if (pPl->spr.id == ID_PL2) {
-            GFraMe_spriteset_draw(gl_sset8x8, PL2_ICON, x, y, pPl->spr.flipped);
+            PROF_SPRITESET_DRAW(PLAYERS, gl_sset8x8, PL2_ICON, x, y,
+                pPl->spr.flipped);
         }
     }
 }
 
+/**
+ * Get the player's interpolated position (see ip_object)
+ * 
+ * @param ppPos The player's interpolated position
+ * @param pPl The player
+ */
+void player_getIpPos(ipPos **ppPos, player *pPl) {
+    *ppPos = &pPl->ip;
+}
+
 /**
  * Get the player's object, for collision
  * 
@@ -885,3 +900,13 @@ void player_resetTeleport(player *pPl) {
     pPl->pressedTeleport = 0;
     pPl->isTeleporting = 0;
 }
+
+/**
+ * Save/restore a player on a checkpoint
+ * 
+ * @param pPl The player
+ * @param pCp The checkpoint
+ */
+void player_checkpoint(player *pPl, checkpoint *pCp) {
+    cp_field(pCp, pPl, sizeof(player));
+}
@@ -7,6 +7,8 @@
 #ifndef __PLAYER_H_
 #define __PLAYER_H_
 
+#include "checkpoint.h"
+#include "interp.h"
 #include "types.h"
 
 #include <GFraMe/GFraMe_error.h>
@@ -49,6 +51,14 @@ void player_update(player *pPl, int ms);
  */
 void player_draw(player *pPl);
 
+/**
+ * Get the player's interpolated position (see ip_object)
+ * 
+ * @param ppPos The player's interpolated position
+ * @param pPl The player
+ */
+void player_getIpPos(ipPos **ppPos, player *pPl);
+
 /**
  * Get the player's object, for collision
  * 
@@ -207,5 +217,13 @@ void player_resetVerticalSpeed(player *pPl);
  */
 void player_resetTeleport(player *pPl);
 
+/**
+ * Save/restore a player on a checkpoint
+ * 
+ * @param pPl The player
+ * @param pCp The checkpoint
+ */
+void player_checkpoint(player *pPl, checkpoint *pCp);
+
 #endif
 
@@ -13,27 +13,35 @@
 #endif
 #include <GFraMe/GFraMe_util.h>
 
-#ifdef DEBUG
-#  include <SDL2/SDL_timer.h>
-#endif
+#include <SDL2/SDL_cpuinfo.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
 
 #include "audio.h"
 #include "bullet.h"
 #include "camera.h"
+#include "checkpoint.h"
 #include "collision.h"
 #include "controller.h"
 #include "global.h"
+#include "interp.h"
 #include "map.h"
+#include "mapCache.h"
 #include "options.h"
 #include "player.h"
 #include "playstate.h"
+#include "profiler.h"
 #include "registry.h"
+#include "replay.h"
 #include "save.h"
 #include "signal.h"
+#include "snapshot.h"
 #include "state.h"
 #include "textwindow.h"
 #include "timer.h"
 #include "transition.h"
+#include "triggerGrid.h"
 #include "types.h"
 #include "ui.h"
 
@@ -73,6 +81,10 @@ static int _ps_text;
 static int _maxUfps;
 static int _maxDfps;
 static int _ps_isSpeedrun;
+/** When the last update happened, to interpolate positions while drawing */
+static unsigned int _ps_lastStep;
+/** How many updates may be caught up on a single frame */
+static int _ps_maxSubsteps;
 
 struct stGame {
     struct stateHandler hnd;
@@ -113,14 +125,37 @@ static GFraMe_ret ps_init(playstateCmd cmd);
  * Clean up the playstate
  */
 static void ps_clean();
+/**
+ * Update the current frame (or the pause menu/map transition)
+ */
+static GFraMe_ret ps_frame();
+/**
+ * Record the current frame into the back snapshot
+ */
+static void ps_record();
 /**
  * Draw the current frame
  */
-static void ps_draw();
+static void ps_draw(int doRecord);
 /**
  * Update the current frame, as many times as it's accumulated
  */
 static void ps_update();
+/**
+ * Update the game a single time
+ */
+static int ps_step();
+/**
+ * Run a step of interpolating everything (camera, entities and players)
+ * 
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+static void ps_interpolate(ipStep step, int alpha);
+/**
+ * Calculate how far into the current update the frame is being drawn
+ */
+static int ps_getAlpha();
 /**
  * Handle every event
  */
@@ -129,6 +164,10 @@ static void ps_event();
  * Handle pause menu
  */
 static void ps_doPause();
+/**
+ * Kill both players, so the game restarts from the last save
+ */
+static void ps_retry();
 /**
  * Draw pause menu
  */
@@ -137,9 +176,51 @@ static void ps_drawPause();
  * Switch the current map
  */
 static GFraMe_ret ps_switchMap();
+/**
+ * Advance the map transition a single time
+ */
+static GFraMe_ret ps_switchMapStep();
+
+/** How long (in milliseconds) updates may take on a single frame, before the
+ *  remaining ones are dropped */
+#define PS_UPDATE_BUDGET (1000 / GAME_MIN_DFPS)
+
+/** Whether the next frame may be updated on a worker thread while the current
+ *  one is drawn (neither the profiler nor the quadtree's debug drawing are
+ *  thread-safe, so it's disabled with those) */
+#if !defined(EMCC) && !defined(PROFILER) && !defined(QT_DEBUG_DRAW)
+#  define PS_PIPELINED
+#endif
+
+#if defined(PS_PIPELINED)
+/** Thread that updates and records the next frame (NULL if running serially) */
+static SDL_Thread *_ps_worker = NULL;
+/** Signaled when the worker should update the next frame */
+static SDL_sem *_ps_workStart = NULL;
+/** Signaled when the worker finished updating the next frame */
+static SDL_sem *_ps_workDone = NULL;
+/** Whether the worker should exit */
+static SDL_atomic_t _ps_stopWorker;
+/** Result of the worker's last update */
+static GFraMe_ret _ps_workRv;
+
+/**
+ * Update and record frames whenever signaled, until stopped
+ */
+static int ps_work(void *data);
+/**
+ * Start the worker thread (if there are multiple cores)
+ */
+static void ps_startWorker();
+/**
+ * Stop the worker thread (if it was running)
+ */
+static void ps_stopWorker();
+#endif /* PS_PIPELINED */
 
 #ifdef DEBUG
 static int _updCalls;
+static int _drpCalls;
 static int _drwCalls;
 static unsigned int _time;
 static unsigned int _ltime;
@@ -156,6 +237,12 @@ int playstate_setup(void *self) {
         _ps_pause = 0;
         _ps_justRetry = 0;
         _psRunning = 1;
+        
+        // Recording is optional, so ignore any error
+        rp_beginRecording(ps->cmd, gv_getValue(MAP));
+#if defined(PS_PIPELINED)
+        ps_startWorker();
+#endif
     }
 
     return rv;
@@ -169,33 +256,47 @@ int playstate_isRunning(void *self) {
 
 void playstate_update(void *self) {
     struct stGame *ps = (struct stGame*)self;
+    GFraMe_ret rv;
 #ifdef DEBUG
     unsigned int t;
 #endif
 
+    PROF_BEGIN(FRAME);
+    PROF_BEGIN(EVENTS);
     ps_event();
+    PROF_END(EVENTS);
     timer_update();
-    if (_ps_pause)
-        ps_doPause();
-    else {
-        if (gv_isZero(SWITCH_MAP))
-            ps_update();
-        else {
-            ps->lastRv = ps_switchMap();
-            if (ps->lastRv != GFraMe_ret_ok) {
-                ps->err = JERR_LOAD_MAP;
-                return;
-            }
-        }
+#if defined(PS_PIPELINED)
+    if (_ps_worker) {
+        // Update and record the next frame while the last one is drawn
+        SDL_SemPost(_ps_workStart);
+        ps_draw(0/*doRecord*/);
+        SDL_SemWait(_ps_workDone);
+        sn_swap();
+        rv = _ps_workRv;
     }
-    ps_draw();
+    else
+#endif /* PS_PIPELINED */
+    {
+        rv = ps_frame();
+        if (rv == GFraMe_ret_ok)
+            ps_draw(1/*doRecord*/);
+    }
+    if (rv != GFraMe_ret_ok) {
+        ps->lastRv = rv;
+        ps->err = JERR_LOAD_MAP;
+        return;
+    }
+    PROF_END(FRAME);
+    PROF_END_FRAME();
 
 #ifdef DEBUG
     t = SDL_GetTicks();
     if (t >= _time) {
-        GFraMe_log("t=%04i, U=%03i/%03i D=%03i/%03i", _time - _ltime,
-            _updCalls, _maxUfps, _drwCalls, _maxDfps);
+        GFraMe_log("t=%04i, U=%03i/%03i (-%03i) D=%03i/%03i", _time - _ltime,
+            _updCalls, _maxUfps, _drpCalls, _drwCalls, _maxDfps);
         _updCalls = 0;
+        _drpCalls = 0;
         _drwCalls = 0;
         _ltime = _time;
         _time = SDL_GetTicks() + 1000;
@@ -220,6 +321,10 @@ int playstate_nextState(void *self) {
 }
 
 void playstate_release(void *self) {
+#if defined(PS_PIPELINED)
+    ps_stopWorker();
+#endif
+    rp_endRecording();
     ps_clean();
 }
 
@@ -249,6 +354,235 @@ int isPlaystate(void *hnd) {
     return hnd == &global_ps;
 }
 
+/**
+ * Generate the next pseudo-random number for the headless inputs
+ * 
+ * @param pSeed The generator's state
+ * @return A number in the range [0, 0x7fff]
+ */
+static unsigned int ps_rand(unsigned int *pSeed) {
+    *pSeed = *pSeed * 1103515245u + 12345u;
+    return (*pSeed >> 16) & 0x7fff;
+}
+
+/**
+ * Pick a random set of buttons for a player
+ * 
+ * @param pSeed The generator's state
+ * @return Bitmask of CTR_BT_* buttons
+ */
+static int ps_randButtons(unsigned int *pSeed) {
+    unsigned int r;
+    int buttons;
+    
+    buttons = 0;
+    r = ps_rand(pSeed);
+    if (r % 3 == 0)
+        buttons |= CTR_BT_LEFT;
+    else if (r % 3 == 1)
+        buttons |= CTR_BT_RIGHT;
+    r = ps_rand(pSeed);
+    if (r % 3 == 0)
+        buttons |= CTR_BT_JUMP;
+    if (r % 8 == 1)
+        buttons |= CTR_BT_ACTION;
+    if (r % 16 == 2)
+        buttons |= CTR_BT_ITEM;
+    if (r % 32 == 3)
+        buttons |= CTR_BT_SWITCH;
+    
+    return buttons;
+}
+
+/**
+ * Hash every global variable and both players' positions
+ * 
+ * @return The hash
+ */
+static unsigned int ps_getChecksum() {
+    unsigned int hash;
+    int i, val[4];
+    
+    // FNV-1a, fed by each value
+    #define PS_HASH(v) \
+        hash ^= (unsigned int)(v); \
+        hash *= 16777619u
+    
+    hash = 2166136261u;
+    i = 0;
+    while (i < GV_MAX) {
+        PS_HASH(gv_getValue((globalVar)i));
+        i++;
+    }
+    player_getCenter(&val[0], &val[1], p1);
+    player_getCenter(&val[2], &val[3], p2);
+    i = 0;
+    while (i < 4) {
+        PS_HASH(val[i]);
+        i++;
+    }
+    
+    #undef PS_HASH
+    return hash;
+}
+
+/**
+ * Simulate the playstate without rendering nor playing audio, as fast as
+ * possible, either from a replay or from inputs generated from 'seed'
+ * 
+ * @param pRes Returns the simulation's results
+ * @param cmd In which mode the playstate should start
+ * @param ticks How many updates should be simulated (if replaying, 0 runs
+ *              until its end)
+ * @param stepMs Duration of each update, in milliseconds (ignored if
+ *               replaying)
+ * @param seed Seed for the injected inputs (ignored if replaying)
+ * @param replayMap Map where the replay started (or -1, if not replaying)
+ * @return GFraMe error code
+ */
+static GFraMe_ret ps_simulate(psHeadlessResult *pRes, playstateCmd cmd,
+    int ticks, int stepMs, unsigned int seed, int replayMap) {
+    GFraMe_ret rv;
+    Uint64 start;
+    int hold1, hold2, i, isInit;
+    
+    isInit = 0;
+    memset(pRes, 0x0, sizeof(psHeadlessResult));
+    
+    ctr_setInjection(1);
+    rv = ps_init(cmd);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init playstate", __ret);
+    isInit = 1;
+    _ps_pause = 0;
+    _ps_justRetry = 0;
+    _psRunning = 1;
+    GFraMe_assertRV(replayMap < 0 || gv_getValue(MAP) == replayMap,
+        "Replay started on a different map", rv = GFraMe_ret_failed, __ret);
+    
+    hold1 = 0;
+    hold2 = 0;
+    start = SDL_GetPerformanceCounter();
+    i = 0;
+    while ((i < ticks || ticks <= 0) && gl_running && _psRunning) {
+        if (replayMap >= 0) {
+            int events, pl1, pl2;
+            
+            if (!rp_nextTick(&pl1, &pl2, &events, &stepMs))
+                break;
+            ctr_inject(ID_PL1, pl1);
+            ctr_inject(ID_PL2, pl2);
+            if (events & RP_EV_DISMISS_TEXT)
+                _ps_text = 0;
+            if (events & RP_EV_RETRY)
+                ps_retry();
+        }
+        else {
+            // Hold each player's buttons for a random number of updates
+            if (hold1 <= 0) {
+                ctr_inject(ID_PL1, ps_randButtons(&seed));
+                hold1 = 8 + ps_rand(&seed) % 56;
+            }
+            if (hold2 <= 0) {
+                ctr_inject(ID_PL2, ps_randButtons(&seed));
+                hold2 = 8 + ps_rand(&seed) % 56;
+            }
+            hold1--;
+            hold2--;
+            
+            // There's no one to dismiss text windows
+            if (_ps_text && textWnd_didFinish())
+                _ps_text = 0;
+        }
+        
+        ctr_update();
+        GFraMe_event_elapsed = stepMs;
+        timer_step(stepMs);
+        if (gv_isZero(SWITCH_MAP)) {
+            PROF_BEGIN(UPDATE);
+            ps_step();
+            PROF_END(UPDATE);
+        }
+        else {
+            rv = ps_switchMapStep();
+            GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to switch maps",
+                __ret);
+        }
+        PROF_END_FRAME();
+        i++;
+    }
+    GFraMe_assertRV(gl_running, "Simulation failed", rv = GFraMe_ret_failed,
+        __ret);
+    
+    pRes->elapsedMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+    pRes->ticks = i;
+    pRes->map = gv_getValue(MAP);
+    pRes->checksum = ps_getChecksum();
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    if (isInit)
+        ps_clean();
+    ctr_setInjection(0);
+    
+    return rv;
+}
+
+/**
+ * Run the playstate without rendering nor playing audio, as fast as possible.
+ * Every update is exactly 'stepMs' long and the players' inputs are generated
+ * from 'seed', so runs with the same parameters are reproducible.
+ * 
+ * @param pRes Returns the simulation's results
+ * @param cmd In which mode the playstate should start
+ * @param ticks How many updates should be simulated
+ * @param stepMs Duration of each update, in milliseconds
+ * @param seed Seed for the injected inputs
+ * @return GFraMe error code
+ */
+GFraMe_ret playstate_runHeadless(psHeadlessResult *pRes, playstateCmd cmd,
+    int ticks, int stepMs, unsigned int seed) {
+    GFraMe_ret rv;
+    
+    // Sanitize parameters
+    ASSERT(pRes, GFraMe_ret_bad_param);
+    ASSERT(ticks > 0, GFraMe_ret_bad_param);
+    ASSERT(stepMs > 0, GFraMe_ret_bad_param);
+    
+    rv = ps_simulate(pRes, cmd, ticks, stepMs, seed, -1);
+__ret:
+    return rv;
+}
+
+/**
+ * Run a recorded playstate without rendering nor playing audio, as fast as
+ * possible. The save state where the recording started is restored, so it
+ * must be called after 'setup_volatile_blocks'.
+ * 
+ * @param pRes Returns the simulation's results
+ * @param filename The recorded file
+ * @param ticks How many updates should be simulated (0 runs until the end)
+ * @return GFraMe error code
+ */
+GFraMe_ret playstate_runReplay(psHeadlessResult *pRes, char *filename,
+    int ticks) {
+    playstateCmd cmd;
+    GFraMe_ret rv;
+    int map;
+    
+    // Sanitize parameters
+    ASSERT(pRes, GFraMe_ret_bad_param);
+    ASSERT(filename, GFraMe_ret_bad_param);
+    
+    rv = rp_openReplay(&cmd, &map, filename);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to open replay", __ret);
+    rv = ps_simulate(pRes, cmd, ticks, 0, 0, map);
+__ret:
+    rp_closeReplay();
+    
+    return rv;
+}
+
 /**
  * Initialize the playstate
  * 
@@ -265,6 +599,20 @@ static GFraMe_ret ps_init(playstateCmd cmd) {
     _maxDfps = read_slot(BLK_CONFIG, sv_dfps);
     if (_maxDfps == -1)
         _maxDfps = GAME_DFPS;
+    // Any rate may be configured, as long as it's within the supported range
+    if (_maxUfps < GAME_MIN_UFPS)
+        _maxUfps = GAME_MIN_UFPS;
+    else if (_maxUfps > GAME_MAX_UFPS)
+        _maxUfps = GAME_MAX_UFPS;
+    if (_maxDfps < GAME_MIN_DFPS)
+        _maxDfps = GAME_MIN_DFPS;
+    else if (_maxDfps > GAME_MAX_DFPS)
+        _maxDfps = GAME_MAX_DFPS;
+    _ps_maxSubsteps = read_slot(BLK_CONFIG, sv_maxSubsteps);
+    if (_ps_maxSubsteps == -1)
+        _ps_maxSubsteps = GAME_MAX_SUBSTEPS;
+    else if (_ps_maxSubsteps < 1)
+        _ps_maxSubsteps = 1;
     _ps_isSpeedrun = read_slot(BLK_CONFIG, sv_speedrun);
     if (_ps_isSpeedrun == -1)
         _ps_isSpeedrun = 0;
@@ -314,6 +662,9 @@ static GFraMe_ret ps_init(playstateCmd cmd) {
     rv = rg_init();
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to registry ui", __ret);
     
+    rv = sn_init();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init snapshots", __ret);
+    
     rv = map_init(&m);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to init map", __ret);
     
@@ -328,6 +679,10 @@ static GFraMe_ret ps_init(playstateCmd cmd) {
 
     signal_init();
     
+    // Dying before leaving the first map goes back to how it started
+    rv = cp_save();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to save checkpoint", __ret);
+    
     _timerTilCredits = 0;
     _ps_onOptions = 0;
     _ps_text = 0;
@@ -352,171 +707,335 @@ __ret:
 static void ps_clean() {
     ui_clean();
     map_clean(&m);
+    mc_clean();
     player_clean(&p1);
     player_clean(&p2);
     rg_clean();
     qt_clean();
+    sn_clean();
+    cp_clean();
+    tg_clean();
+}
+
+/**
+ * Update the current frame (or the pause menu/map transition)
+ * 
+ * @return GFraMe error code
+ */
+static GFraMe_ret ps_frame() {
+    GFraMe_ret rv;
+    
+    rv = GFraMe_ret_ok;
+    if (_ps_pause)
+        ps_doPause();
+    else if (gv_isZero(SWITCH_MAP))
+        ps_update();
+    else
+        rv = ps_switchMap();
+    
+    return rv;
+}
+
+/**
+ * Record the current frame into the back snapshot
+ */
+static void ps_record() {
+    int alpha;
+    
+    sn_beginRecording();
+    PROF_BEGIN(DRAW);
+    // Draw everything between the last two updates
+    alpha = ps_getAlpha();
+    if (alpha < IP_ONE) {
+        ps_interpolate(IP_BEGIN, alpha);
+    }
+    PROF_BEGIN(DRW_MAP);
+    map_draw(m);
+    PROF_END(DRW_MAP);
+    PROF_BEGIN(DRW_BULLETS);
+    rg_drawBullets();
+    PROF_END(DRW_BULLETS);
+    PROF_BEGIN(DRW_OBJECTS);
+    rg_drawObjects();
+    PROF_END(DRW_OBJECTS);
+    PROF_BEGIN(DRW_MOBS);
+    rg_drawMobs();
+    PROF_END(DRW_MOBS);
+    PROF_BEGIN(DRW_UI);
+    if (gv_nIsZero(SWITCH_MAP))
+        transition_draw();
+    ui_draw();
+    PROF_END(DRW_UI);
+    PROF_BEGIN(DRW_PLAYERS);
+    player_draw(p2);
+    player_draw(p1);
+    PROF_END(DRW_PLAYERS);
+    PROF_BEGIN(DRW_HUD);
+    if (gv_isZero(SWITCH_MAP))
+        signal_draw();
+    if (_ps_pause) {
+        ps_drawPause();
+    }
+    if (_ps_isSpeedrun)
+        timer_draw();
+    if (_ps_text) {
+        textWnd_draw();
+    }
+    PROF_END(DRW_HUD);
+    if (alpha < IP_ONE) {
+        ps_interpolate(IP_END, alpha);
+    }
+    PROF_END(DRAW);
+    sn_endRecording();
 }
 
 /**
  * Draw the current frame
+ * 
+ * @param doRecord Whether the frame should be recorded (and swapped) before
+ *                 being drawn (otherwise, the last swapped one is drawn)
  */
-static void ps_draw() {
+static void ps_draw(int doRecord) {
     GFraMe_event_draw_begin();
 #ifdef DEBUG
         _drwCalls++;
 #endif
-        map_draw(m);
-        rg_drawBullets();
-        rg_drawObjects();
-        rg_drawMobs();
-        if (gv_nIsZero(SWITCH_MAP))
-            transition_draw();
-        ui_draw();
-        player_draw(p2);
-        player_draw(p1);
-        if (gv_isZero(SWITCH_MAP))
-            signal_draw();
+        if (doRecord) {
+            ps_record();
+            sn_swap();
+        }
+        PROF_BEGIN(SUBMIT);
+        sn_draw();
+        PROF_END(SUBMIT);
         #ifdef QT_DEBUG_DRAW
             if (GFraMe_keys.f1 ||
                 (GFraMe_controller_max > 0 && GFraMe_controllers[0].l2))
                 qt_drawRootDebug();
         #endif 
-        if (_ps_pause) {
-            ps_drawPause();
-        }
-        if (_ps_isSpeedrun)
-            timer_draw();
-        if (_ps_text) {
-            textWnd_draw();
-        }
+#if defined(PROFILER)
+        prof_draw();
+#endif /* PROFILER */
     GFraMe_event_draw_end();
 }
 
+#if defined(PS_PIPELINED)
+/**
+ * Update and record frames whenever signaled, until stopped
+ * 
+ * @param data Unused
+ * @return Always 0
+ */
+static int ps_work(void *data) {
+    while (1) {
+        SDL_SemWait(_ps_workStart);
+        if (SDL_AtomicGet(&_ps_stopWorker))
+            break;
+        
+        _ps_workRv = ps_frame();
+        if (_ps_workRv == GFraMe_ret_ok)
+            ps_record();
+        SDL_SemPost(_ps_workDone);
+    }
+    
+    return 0;
+}
+
+/**
+ * Start the worker thread (if there are multiple cores); On any error, the
+ * playstate simply runs serially
+ */
+static void ps_startWorker() {
+    if (_ps_worker || SDL_GetCPUCount() < 2)
+        return;
+    
+    _ps_workStart = SDL_CreateSemaphore(0);
+    _ps_workDone = SDL_CreateSemaphore(0);
+    if (!_ps_workStart || !_ps_workDone) {
+        ps_stopWorker();
+        return;
+    }
+    
+    SDL_AtomicSet(&_ps_stopWorker, 0);
+    _ps_worker = SDL_CreateThread(ps_work, "playstate", NULL);
+    if (!_ps_worker) {
+        GFraMe_log("Failed to start the update thread, running serially");
+        ps_stopWorker();
+    }
+}
+
+/**
+ * Stop the worker thread (if it was running)
+ */
+static void ps_stopWorker() {
+    if (_ps_worker) {
+        SDL_AtomicSet(&_ps_stopWorker, 1);
+        SDL_SemPost(_ps_workStart);
+        SDL_WaitThread(_ps_worker, NULL);
+        _ps_worker = NULL;
+    }
+    if (_ps_workStart)
+        SDL_DestroySemaphore(_ps_workStart);
+    if (_ps_workDone)
+        SDL_DestroySemaphore(_ps_workDone);
+    _ps_workStart = NULL;
+    _ps_workDone = NULL;
+}
+#endif /* PS_PIPELINED */
+
 /**
  * Switch the current map
  */
 static GFraMe_ret ps_switchMap() {
     GFraMe_ret rv;
+    
+    rv = GFraMe_ret_ok;
 #if !defined(DEBUG) || !defined(FAST_TRANSITION)
     GFraMe_event_update_begin();
-        int tmp;
+        ctr_update();
+        rp_recordTick(ctr_getButtons(ID_PL1), ctr_getButtons(ID_PL2),
+            GFraMe_event_elapsed);
+        rv = ps_switchMapStep();
+        ASSERT_NR(rv == GFraMe_ret_ok);
+    GFraMe_event_update_end();
+__ret:
+#else /* FAST_TRANSITION */
+    ctr_update();
+    rp_recordTick(ctr_getButtons(ID_PL1), ctr_getButtons(ID_PL2),
+        GFraMe_event_elapsed);
+    rv = ps_switchMapStep();
+#endif /* FAST_TRANSITION */
+    return rv;
+}
        
-        // Store whether the game was running
-        tmp = gl_running;
-        // Make it stop on any error
-        gl_running = 0;
+/**
+ * Advance the map transition a single time, by GFraMe_event_elapsed
+ * milliseconds
+ * 
+ * @return GFraMe error code
+ */
+static GFraMe_ret ps_switchMapStep() {
+    GFraMe_ret rv;
+#if !defined(DEBUG) || !defined(FAST_TRANSITION)
+    int tmp;
         
-        switch (switchState) {
-            /** Simply start the transition */
-            case 0: transition_initFadeOut(); switchState++; break;
-            /** Fade out */
-            case 1: {
-                if (transition_fadeOut(GFraMe_event_elapsed) == TR_COMPLETE)
-                    switchState++;
-            } break;
-            /** Load the map */
-            case 2: {
-                int map;
-                map = gv_getValue(MAP);
+    // Store whether the game was running
+    tmp = gl_running;
+    // Make it stop on any error
+    gl_running = 0;
                 
-                rv = map_loadi(m, map);
-                ASSERT(rv == GFraMe_ret_ok, rv);
-                rg_updateObjects(0);
+    switch (switchState) {
+        /** Simply start the transition */
+        case 0: transition_initFadeOut(); switchState++; break;
+        /** Fade out */
+        case 1: {
+            if (transition_fadeOut(GFraMe_event_elapsed) == TR_COMPLETE)
+                switchState++;
+        } break;
+        /** Load the map */
+        case 2: {
+            int map;
+            map = gv_getValue(MAP);
                 
-                if ((map % 21) >= 20) {
-                    audio_playBoss();
-                }
-                else if ((map % 21) >= 15) {
-                    audio_playTensionGoesUp();
-                }
-                else if ((map % 21) >= 4) {
-                    audio_playMovingOn();
+            cp_invalidate();
+            rv = map_loadi(m, map);
+            ASSERT(rv == GFraMe_ret_ok, rv);
+            rg_updateObjects(0);
+            
+            if ((map % 21) >= 20) {
+                audio_playBoss();
+            }
+            else if ((map % 21) >= 15) {
+                audio_playTensionGoesUp();
+            }
+            else if ((map % 21) >= 4) {
+                audio_playMovingOn();
+            }
+            else {
+                audio_playIntro();
+            }
+            
+            switchState++;
+        } break;
+        /** Tween players to their new position */
+        case 3: {
+            int x, y;
+            
+            // Get their destiny position
+            x = gv_getValue(DOOR_X) * 8;
+            y = gv_getValue(DOOR_Y) * 8;
+            // Tween the players
+            rv = player_tweenTo(p1, x, y, GFraMe_event_elapsed, PL_TWEEN_DELAY);
+            rv = player_tweenTo(p2, x, y, GFraMe_event_elapsed, PL_TWEEN_DELAY);
+            // Update camera
+            cam_setPositionSt(p1, p2);
+            
+            if (rv == GFraMe_ret_ok)
+                switchState++;
+        } break;
+        /** Init fade in animation */
+        case 4: transition_initFadeIn(); switchState++; break;
+        /** Fade in */
+        case 5: {
+            if (transition_fadeIn(GFraMe_event_elapsed) == TR_COMPLETE)
+                switchState++;
+        } break;
+        /** Finish the transition */
+        default: {
+            int map;
+            map = gv_getValue(MAP);
+            
+            if (map == 1) {
+                if (gl_lang == EN_US) {
+                    ps_showText(_ps_map001_textEN, sizeof(_ps_map001_textEN), 0, 0, 40, 6);
                 }
-                else {
-                    audio_playIntro();
+                else if (gl_lang == PT_BR) {
+                    ps_showText(_ps_map001_textPT, sizeof(_ps_map001_textPT), 0, 0, 40, 6);
                 }
-                
-                switchState++;
-            } break;
-            /** Tween players to their new position */
-            case 3: {
-                int x, y;
-                
-                // Get their destiny position
-                x = gv_getValue(DOOR_X) * 8;
-                y = gv_getValue(DOOR_Y) * 8;
-                // Tween the players
-                rv = player_tweenTo(p1, x, y, GFraMe_event_elapsed, PL_TWEEN_DELAY);
-                rv = player_tweenTo(p2, x, y, GFraMe_event_elapsed, PL_TWEEN_DELAY);
-                // Update camera
-                cam_setPositionSt(p1, p2);
-                
-                if (rv == GFraMe_ret_ok)
-                    switchState++;
-            } break;
-            /** Init fade in animation */
-            case 4: transition_initFadeIn(); switchState++; break;
-            /** Fade in */
-            case 5: {
-                if (transition_fadeIn(GFraMe_event_elapsed) == TR_COMPLETE)
-                    switchState++;
-            } break;
-            /** Finish the transition */
-            default: {
-                int map;
-                map = gv_getValue(MAP);
-                
-                if (map == 1) {
-                    if (gl_lang == EN_US) {
-                        ps_showText(_ps_map001_textEN, sizeof(_ps_map001_textEN), 0, 0, 40, 6);
-                    }
-                    else if (gl_lang == PT_BR) {
-                        ps_showText(_ps_map001_textPT, sizeof(_ps_map001_textPT), 0, 0, 40, 6);
-                    }
+            }
+            else if (map == 8 || map == 13) {
+                if (gl_lang == EN_US) {
+                    ps_showText(_ps_map_afterItemEN, sizeof(_ps_map_afterItemEN), 0, 0, 40, 6);
                 }
-                else if (map == 8 || map == 13) {
-                    if (gl_lang == EN_US) {
-                        ps_showText(_ps_map_afterItemEN, sizeof(_ps_map_afterItemEN), 0, 0, 40, 6);
-                    }
-                    else if (gl_lang == PT_BR) {
-                        ps_showText(_ps_map_afterItemPT, sizeof(_ps_map_afterItemPT), 0, 0, 40, 6);
-                    }
+                else if (gl_lang == PT_BR) {
+                    ps_showText(_ps_map_afterItemPT, sizeof(_ps_map_afterItemPT), 0, 0, 40, 6);
                 }
+            }
                 
-                gv_setValue(SWITCH_MAP, 0);
-                switchState = 0;
-                signal_release();
+            gv_setValue(SWITCH_MAP, 0);
+            switchState = 0;
+            signal_release();
                 
-                if (_ps_justRetry) {
-                   player_resetVerticalSpeed(p1);
-                   player_resetVerticalSpeed(p2);
-                   _ps_justRetry = 0;
-                }
-                if (!_ps_isSpeedrun) {
-                    // If speedrun mode is enabled, this is skipped. By doing that, the
-                    // teleport target is loaded from the previous saved state (i.e.,
-                    // it become the last position teleported to).
-                    // This only works on the first frame after loading a level, though.
-                    player_resetTeleport(p1);
-                    player_resetTeleport(p2);
-                }
+            if (_ps_justRetry) {
+               player_resetVerticalSpeed(p1);
+               player_resetVerticalSpeed(p2);
+               _ps_justRetry = 0;
+            }
+            if (!_ps_isSpeedrun) {
+                // If speedrun mode is enabled, this is skipped. By doing that, the
+                // teleport target is loaded from the previous saved state (i.e.,
+                // it become the last position teleported to).
+                // This only works on the first frame after loading a level, though.
+                player_resetTeleport(p1);
+                player_resetTeleport(p2);
+            }
                 
-                // Set the update time (for using on events)
-                gv_setValue(GAME_UPS, GFraMe_event_elapsed);
-                // Save the current state
-                if (player_isAlive(p1) && player_isAlive(p2)) {
-                    gv_setValue(GAME_TIME, timer_getTime());
-                    rv = gv_save(SAVEFILE);
-                    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving file!", __ret);
-                }
+            // Set the update time (for using on events)
+            gv_setValue(GAME_UPS, GFraMe_event_elapsed);
+            // Save the current state
+            if (player_isAlive(p1) && player_isAlive(p2)) {
+                gv_setValue(GAME_TIME, timer_getTime());
+                rv = gv_save(SAVEFILE);
+                GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving file!", __ret);
+                // Also keep everything in memory, to respawn from it
+                rv = cp_save();
+                GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving checkpoint!", __ret);
+            }
 #  if defined(DEBUG) && defined(RESET_GV)
-                gv_init();
+            gv_init();
 #  endif /* RESET_GV */
-            }
         }
-        gl_running = tmp;
-    GFraMe_event_update_end();
+    }
+    gl_running = tmp;
 #else /* FAST_TRANSITION */
     int tmp, x, y;
     int map;
@@ -528,6 +1047,7 @@ static GFraMe_ret ps_switchMap() {
     
     map = gv_getValue(MAP);
     
+    cp_invalidate();
     rv = map_loadi(m, map);
     ASSERT(rv == GFraMe_ret_ok, rv);
     
@@ -553,6 +1073,8 @@ static GFraMe_ret ps_switchMap() {
         gv_setValue(GAME_TIME, timer_getTime());
         rv = gv_save(SAVEFILE);
         GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving file!", __ret);
+        rv = cp_save();
+        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving checkpoint!", __ret);
     }
 #endif /* FAST_TRANSITION */
     
@@ -563,175 +1085,355 @@ __ret:
 }
 
 /**
- * Update the current frame, as many times as it's accumulated
+ * Update the current frame, as many times as it's accumulated (but no more
+ * than _ps_maxSubsteps times, nor for longer than PS_UPDATE_BUDGET)
  */
 static void ps_update() {
+    unsigned int start;
+    int dropped, isRunning, steps;
+    
+    start = SDL_GetTicks();
+    dropped = 0;
+    steps = 0;
     GFraMe_event_update_begin();
-        GFraMe_object *pObj;
-        GFraMe_ret rv;
-        int  h, w;
-        
-        if (gv_getValue(BOSS_ISDEAD) >= 4) {
-            if (_timerTilCredits == 0) {
-                timer_stop();
-                audio_playVictory();
-            }
-            else if (_timerTilCredits > 5000) {
-                _psRunning = 0;
-            }
-            _timerTilCredits += GFraMe_event_elapsed;
-            if (_timerTilCredits >= 2000)
+        // Bound how much may be caught up on a single frame; Any update over
+        // the limit is dropped (i.e., the game slows down), instead of making
+        // the next frame even slower
+        if (steps >= _ps_maxSubsteps
+                || (steps > 0 && SDL_GetTicks() - start >= PS_UPDATE_BUDGET)) {
+            if (dropped == 0 && steps >= _ps_maxSubsteps)
+                PROF_COUNT(CAPPED, 1);
+            else if (dropped == 0)
+                PROF_COUNT(DILATED, 1);
+            PROF_COUNT(DROPPED, 1);
+            dropped++;
+#ifdef DEBUG
+            _drpCalls++;
+#endif
+        }
+        else {
+            ctr_update();
+            rp_recordTick(ctr_getButtons(ID_PL1), ctr_getButtons(ID_PL2),
+                GFraMe_event_elapsed);
+            ps_interpolate(IP_SAVE, 0);
+            PROF_BEGIN(UPDATE);
+            isRunning = ps_step();
+            PROF_END(UPDATE);
+            PROF_COUNT(STEPS, 1);
+            _ps_lastStep = SDL_GetTicks();
+            steps++;
+            if (!isRunning)
                 return;
         }
-        else if (gv_nIsZero(SWITCH_MAP)) {
-            return;
+    GFraMe_event_update_end();
+}
+
+/**
+ * Run a step of interpolating everything (camera, entities and players)
+ * 
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+static void ps_interpolate(ipStep step, int alpha) {
+    GFraMe_object *pObj;
+    ipPos *pPos;
+    
+    cam_interpolate(step, alpha);
+    rg_interpolate(step, alpha);
+    player_getObject(&pObj, p1);
+    player_getIpPos(&pPos, p1);
+    ip_object(pPos, pObj, step, alpha);
+    player_getObject(&pObj, p2);
+    player_getIpPos(&pPos, p2);
+    ip_object(pPos, pObj, step, alpha);
+}
+
+/**
+ * Calculate how far into the current update the frame is being drawn
+ * 
+ * @return The interpolation factor, in [0, IP_ONE] (IP_ONE if positions
+ *         shouldn't be interpolated)
+ */
+static int ps_getAlpha() {
+    unsigned int dt;
+    
+    // Only interpolate if it's drawn more often than updated, and only while
+    // updating normally (transitions move the players on their own)
+    if (_maxDfps <= _maxUfps || _ps_pause || gv_nIsZero(SWITCH_MAP))
+        return IP_ONE;
+    
+    dt = SDL_GetTicks() - _ps_lastStep;
+    if (dt * _maxUfps >= 1000)
+        return IP_ONE;
+    return (int)(dt * _maxUfps * IP_ONE / 1000);
+}
+
+/**
+ * Update the game a single time, by GFraMe_event_elapsed milliseconds
+ * 
+ * @return Whether the frame may keep being updated (i.e., whether nothing
+ *         interrupted it, like a map transition or a text window)
+ */
+static int ps_step() {
+    GFraMe_ret rv;
+    
+    if (gv_getValue(BOSS_ISDEAD) >= 4) {
+        if (_timerTilCredits == 0) {
+            timer_stop();
+            audio_playVictory();
         }
-        else if (_ps_text) {
-            textWnd_update(GFraMe_event_elapsed);
-            return;
+        else if (_timerTilCredits > 5000) {
+            _psRunning = 0;
         }
-        
+        _timerTilCredits += GFraMe_event_elapsed;
+        if (_timerTilCredits >= 2000)
+            return 0;
+    }
+    else if (gv_nIsZero(SWITCH_MAP)) {
+        return 0;
+    }
+    else if (_ps_text) {
+        textWnd_update(GFraMe_event_elapsed);
+        return 0;
+    }
+    
 #ifdef DEBUG
-        _updCalls++;
+    _updCalls++;
 #endif
-        pObj = 0;
-        
-        // Check if any player should teleport
-        player_checkTeleport(p1);
-        player_checkTeleport(p2);
-        
-        // Update everything
-        map_update(m, GFraMe_event_elapsed);
-        rg_updateMobs(GFraMe_event_elapsed);
-        rg_updateObjects(GFraMe_event_elapsed);
-        rg_updateBullets(GFraMe_event_elapsed);
-        player_update(p1, GFraMe_event_elapsed);
-        player_update(p2, GFraMe_event_elapsed);
-        ui_update(GFraMe_event_elapsed);
-        signal_update(GFraMe_event_elapsed);
-        
-        // Collide everythin against everything else
-        map_getDimensions(m, &w, &h);
-        
-        rv = qt_initCol(-8, -8, w + 16, h + 16);
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error initializing collision",
-            __err_ret);
-        
-        rv = rg_qtAddWalls();
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding map to collision",
-            __err_ret);
-        
-        rv = rg_qtAddObjects();
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding object to quadtree",
-            __err_ret);
-        
-        rv = rg_qtAddMob();
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding mob to quadtree",
-            __err_ret);
-        
-        rv = rg_qtAddEvents();
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding events to quadtree",
-            __err_ret);
-        
-        rv = rg_qtAddBullets();
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding bullets to quadtree",
-            __err_ret);
-        
-        rv = qt_addPl(p1);
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding player to quadtree",
-            __err_ret);
-        
-        rv = qt_addPl(p2);
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding player to quadtree",
-            __err_ret);
+    rv = playstate_updateWorld(GFraMe_event_elapsed, NULL, NULL);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error updating the game",
+        __err_ret);
+    
+    // If the player is trying to switch maps, do it
+    if (player_cmpDestMap(p1, p2) == GFraMe_ret_ok) {
+        gv_setValue(SWITCH_MAP, 1);
+        return 0;
+    }
+    
+    do {
+        int didDie = 0;
         
-        // Collide both players, manually
-        col_onPlayer(p1, p2);
-        col_onPlayer(p2, p1);
+        // Check if any of the players died/is OOB
+        if (!player_isAlive(p1) && !player_isInsideMap(p1)) {
+            didDie = 1;
+        }
+        else if (!player_isInsideMap(p1)) {
+           // P1 is OOB... Heck yeah, great strat!
+           player_resetVerticalSpeed(p1);
+        }
+        if (!player_isAlive(p2) && !player_isInsideMap(p2)) {
+            didDie |= 2;
+        }
+        else if (!player_isInsideMap(p2)) {
+           // P2 is OOB... Heck yeah, great strat!
+           player_resetVerticalSpeed(p2);
+        }
         
-        // Collide the carried player (if any) against the map
-        if (player_isBeingCarried(p1))
-            player_getObject(&pObj, p1);
-        else if (player_isBeingCarried(p2))
-            player_getObject(&pObj, p2);
-        // Fix a bug that would let players clip into ceilings
-        if (pObj)
-            rg_collideObjWall(pObj);
+        if (didDie != 0) {
+            GFraMe_ret rv;
+            int death1, death2;
         
-        // Update camera
-        cam_setPosition();
+            // Go back to how everything was when the map was entered,
+            // keeping only the death counters
+            death1 = gv_getValue(PL1_DEATH);
+            death2 = gv_getValue(PL2_DEATH);
+            rv = cp_restore();
+            if (rv == GFraMe_ret_ok) {
+                if (didDie & 1) {
+                    death1++;
+                }
+                if (didDie & 2) {
+                    death2++;
+                }
+                gv_setValue(PL1_DEATH, death1);
+                gv_setValue(PL2_DEATH, death2);
         
-        // If the player is trying to switch maps, do it
-        if (player_cmpDestMap(p1, p2) == GFraMe_ret_ok) {
-            gv_setValue(SWITCH_MAP, 1);
-            return;
-        }
+                // Save death counter and timer
+                gv_setValue(GAME_TIME, timer_getTime());
+                rv = gv_save(SAVEFILE);
+                GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving map", __err_ret);
         
-        do {
-            int didDie = 0;
-
-            // Check if any of the players died/is OOB
-            if (!player_isAlive(p1) && !player_isInsideMap(p1)) {
-                didDie = 1;
-            }
-            else if (!player_isInsideMap(p1)) {
-               // P1 is OOB... Heck yeah, great strat!
-               player_resetVerticalSpeed(p1);
-            }
-            if (!player_isAlive(p2) && !player_isInsideMap(p2)) {
-                didDie |= 2;
-            }
-            else if (!player_isInsideMap(p2)) {
-               // P2 is OOB... Heck yeah, great strat!
-               player_resetVerticalSpeed(p2);
+                _ps_justRetry = 0;
+                return 0;
             }
 
-            if (didDie != 0) {
-                GFraMe_ret rv;
+            // Otherwise, reload the map from the last save. Ignore errors if
+            // on the first map.
+            rv = gv_load(SAVEFILE);
 
-                // Recover previous state. Ignore errors if on the first map.
-                rv = gv_load(SAVEFILE);
+            // Increase death counter
+            if (didDie & 1) {
+                gv_inc(PL1_DEATH);
+            }
+            if (didDie & 2) {
+                gv_inc(PL2_DEATH);
+            }
 
-                // Increase death counter
-                if (didDie & 1) {
-                    gv_inc(PL1_DEATH);
-                }
-                if (didDie & 2) {
-                    gv_inc(PL2_DEATH);
-                }
+            if (rv != GFraMe_ret_ok && gv_getValue(MAP) == 0) {
+                int death1, death2;
 
-                if (rv != GFraMe_ret_ok && gv_getValue(MAP) == 0) {
-                    int death1, death2;
+                death1 = gv_getValue(PL1_DEATH);
+                death2 = gv_getValue(PL2_DEATH);
 
-                    death1 = gv_getValue(PL1_DEATH);
-                    death2 = gv_getValue(PL2_DEATH);
+                // Reset the variables (since it's most likely a buggy situation)
+                gv_init();
+                gv_setValue(DOOR_X, 16 / 8);
+                gv_setValue(DOOR_Y, 184 / 8);
+                gv_setValue(MAP, 0);
+                gv_setValue(PL1_DEATH, death1);
+                gv_setValue(PL2_DEATH, death2);
+            }
+            else {
+                // Save death counter and timer
+                GFraMe_assertRet(rv == GFraMe_ret_ok, "Error loading map", __err_ret);
+                gv_setValue(GAME_TIME, timer_getTime());
+                rv = gv_save(SAVEFILE);
+                GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving map", __err_ret);
+            }
 
-                    // Reset the variables (since it's most likely a buggy situation)
-                    gv_init();
-                    gv_setValue(DOOR_X, 16 / 8);
-                    gv_setValue(DOOR_Y, 184 / 8);
-                    gv_setValue(MAP, 0);
-                    gv_setValue(PL1_DEATH, death1);
-                    gv_setValue(PL2_DEATH, death2);
-                }
-                else {
-                    // Save death counter and timer
-                    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error loading map", __err_ret);
-                    gv_setValue(GAME_TIME, timer_getTime());
-                    rv = gv_save(SAVEFILE);
-                    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error saving map", __err_ret);
-                }
+            // Force reload
+            gv_setValue(SWITCH_MAP, 1);
+        }
+    } while (0);
 
-                // Force reload
-                gv_setValue(SWITCH_MAP, 1);
-            }
-        } while (0);
-    GFraMe_event_update_end();
-    
-    return;
+    return 1;
 __err_ret:
     gl_running = 0;
-    return;
+    return 0;
+}
+
+/**
+ * Update every entity on the current map once and collide them, without
+ * handling map transitions, deaths nor text windows (which are left to the
+ * caller)
+ * 
+ * @param ms Duration of the update, in milliseconds
+ * @param cb Called after each phase (may be NULL)
+ * @param pCtx Context passed to the callback
+ * @return GFraMe error code
+ */
+GFraMe_ret playstate_updateWorld(int ms, psPhaseCb cb, void *pCtx) {
+    GFraMe_object *pObj;
+    GFraMe_ret rv;
+    GFraMe_sprite *pSpr;
+    int  h, w;
+    
+/** Close a phase on the profiler and report it to the callback */
+#define PS_PHASE_END(phase) \
+    do { \
+        PROF_END(UPD_ ## phase); \
+        if (cb) \
+            cb(PS_PHASE_ ## phase, pCtx); \
+    } while (0)
+    
+    pObj = 0;
+    
+    // Check if any player should teleport
+    PROF_BEGIN(UPD_TELEPORT);
+    player_checkTeleport(p1);
+    player_checkTeleport(p2);
+    PS_PHASE_END(TELEPORT);
+    
+    // Update everything
+    PROF_BEGIN(UPD_MAP);
+    map_update(m, ms);
+    PS_PHASE_END(MAP);
+    PROF_BEGIN(UPD_MOBS);
+    rv = rg_updateMobs(ms);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error updating mobs", __ret);
+    PS_PHASE_END(MOBS);
+    PROF_BEGIN(UPD_OBJECTS);
+    rg_updateObjects(ms);
+    PS_PHASE_END(OBJECTS);
+    PROF_BEGIN(UPD_BULLETS);
+    rg_updateBullets(ms);
+    PS_PHASE_END(BULLETS);
+    PROF_BEGIN(UPD_PLAYERS);
+    player_update(p1, ms);
+    player_update(p2, ms);
+    PS_PHASE_END(PLAYERS);
+    PROF_BEGIN(UPD_UI);
+    ui_update(ms);
+    signal_update(ms);
+    PS_PHASE_END(UI);
+    
+    // Collide everythin against everything else
+    map_getDimensions(m, &w, &h);
+    
+    PROF_BEGIN(UPD_QTINIT);
+    rv = qt_initCol(-8, -8, w + 16, h + 16);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error initializing collision",
+        __ret);
+    PS_PHASE_END(QTINIT);
+    
+    PROF_BEGIN(UPD_QTWALLS);
+    rv = rg_qtAddWalls();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding map to collision",
+        __ret);
+    PS_PHASE_END(QTWALLS);
+    
+    PROF_BEGIN(UPD_QTOBJS);
+    rv = rg_qtAddObjects();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding object to quadtree",
+        __ret);
+    PS_PHASE_END(QTOBJS);
+    
+    PROF_BEGIN(UPD_QTMOBS);
+    rv = rg_qtAddMob();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding mob to quadtree",
+        __ret);
+    PS_PHASE_END(QTMOBS);
+    
+    PROF_BEGIN(UPD_QTBULLETS);
+    rv = rg_qtAddBullets();
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding bullets to quadtree",
+        __ret);
+    PS_PHASE_END(QTBULLETS);
+    
+    PROF_BEGIN(UPD_QTPLAYERS);
+    rv = qt_addPl(p1);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding player to quadtree",
+        __ret);
+    
+    rv = qt_addPl(p2);
+    GFraMe_assertRet(rv == GFraMe_ret_ok, "Error adding player to quadtree",
+        __ret);
+    PS_PHASE_END(QTPLAYERS);
+    
+    // Only players may trigger events (objects and mobs never do), so only
+    // those query the trigger grid
+    PROF_BEGIN(UPD_TRIGGERS);
+    player_getSprite(&pSpr, p1);
+    tg_check(pSpr);
+    player_getSprite(&pSpr, p2);
+    tg_check(pSpr);
+    PS_PHASE_END(TRIGGERS);
+    
+    // Collide both players, manually
+    PROF_BEGIN(UPD_PLCOL);
+    col_onPlayer(p1, p2);
+    col_onPlayer(p2, p1);
+    
+    // Collide the carried player (if any) against the map
+    if (player_isBeingCarried(p1))
+        player_getObject(&pObj, p1);
+    else if (player_isBeingCarried(p2))
+        player_getObject(&pObj, p2);
+    // Fix a bug that would let players clip into ceilings
+    if (pObj)
+        rg_collideObjWall(pObj);
+    PS_PHASE_END(PLCOL);
+    
+    // Update camera
+    PROF_BEGIN(UPD_CAMERA);
+    cam_setPosition();
+    PS_PHASE_END(CAMERA);
+    
+#undef PS_PHASE_END
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
 }
 
 /**
@@ -750,6 +1452,14 @@ static void ps_event() {
             if (event.key.keysym.scancode == SDL_SCANCODE_F24)
                 emcc_numenter = 1;
 #endif /* defined(EMCC) */
+#if defined(PROFILER)
+            if (event.key.keysym.scancode == SDL_SCANCODE_F9)
+                prof_toggleOverlay();
+            else if (event.key.keysym.scancode == SDL_SCANCODE_F10)
+                prof_exportTrace("trace.json");
+            else if (event.key.keysym.scancode == SDL_SCANCODE_F11)
+                prof_exportOverdraw("overdraw.csv");
+#endif /* PROFILER */
             if (ctr_pause() && (!_ps_pause || !GFraMe_keys.enter)) {
                 _ps_pause = !_ps_pause;
                 _ps_firstPress = 0;
@@ -760,6 +1470,7 @@ static void ps_event() {
             }
             else if (_ps_text && textWnd_didFinish()) {
                 _ps_text = 0;
+                rp_recordEvent(RP_EV_DISMISS_TEXT);
             }
         GFraMe_event_on_key_up();
 #if defined(EMCC)
@@ -791,6 +1502,7 @@ static void ps_event() {
                 }
                 else if (_ps_text && textWnd_didFinish()) {
                     _ps_text = 0;
+                    rp_recordEvent(RP_EV_DISMISS_TEXT);
                 }
             }
         GFraMe_event_on_quit();
@@ -878,10 +1590,8 @@ static void ps_doPause() {
                 switch (_ps_opt) {
                     case OPT_CONT: _ps_pause = 0; break;
                     case OPT_RETRY: {
-                        gv_setValue(PL1_HP, 0);
-                        gv_setValue(PL2_HP, 0);
-                        _ps_pause = 0;
-                        _ps_justRetry = 1;
+                        ps_retry();
+                        rp_recordEvent(RP_EV_RETRY);
                     } break;
                     case OPT_OPTIONS: {
                         _ps_onOptions = 1;
@@ -897,6 +1607,16 @@ static void ps_doPause() {
     GFraMe_event_update_end();
 }
 
+/**
+ * Kill both players, so the game restarts from the last save
+ */
+static void ps_retry() {
+    gv_setValue(PL1_HP, 0);
+    gv_setValue(PL2_HP, 0);
+    _ps_pause = 0;
+    _ps_justRetry = 1;
+}
+
 /**
  * Draw pause menu
  */
@@ -961,7 +1681,7 @@ static void _op_renderText(char *text, int X, int Y, int l) {
             y += 8;
         }
         else if (c != ' ')
-            GFraMe_spriteset_draw(gl_sset8x8, c-'!', x, y, 0/*flipped*/);
+            PROF_SPRITESET_DRAW(HUD, gl_sset8x8, c-'!', x, y, 0/*flipped*/);
         
         x += 8;
         i++;
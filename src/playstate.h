@@ -6,6 +6,8 @@
 #ifndef __PLAYSTATE_H_
 #define __PLAYSTATE_H_
 
+#include <GFraMe/GFraMe_error.h>
+
 #include "types.h"
 
 enum enPlaystateCmd {
@@ -15,6 +17,55 @@ enum enPlaystateCmd {
 };
 typedef enum enPlaystateCmd playstateCmd;
 
+/** Results of running the playstate headless */
+struct stPsHeadlessResult {
+    /** How many updates were actually simulated */
+    int ticks;
+    /** Real time spent simulating, in milliseconds */
+    double elapsedMs;
+    /** Map where the simulation stopped */
+    int map;
+    /** Hash of the game's state after the last update */
+    unsigned int checksum;
+};
+typedef struct stPsHeadlessResult psHeadlessResult;
+
+/** Every phase of a single update, in order, as X(phase, label) */
+#define PS_PHASES \
+    X(TELEPORT,   "teleport") \
+    X(MAP,        "map") \
+    X(MOBS,       "mobs") \
+    X(OBJECTS,    "objects") \
+    X(BULLETS,    "bullets") \
+    X(PLAYERS,    "players") \
+    X(UI,         "ui") \
+    X(QTINIT,     "qtInit") \
+    X(QTWALLS,    "qtWalls") \
+    X(QTOBJS,     "qtObjs") \
+    X(QTMOBS,     "qtMobs") \
+    X(QTBULLETS,  "qtBullets") \
+    X(QTPLAYERS,  "qtPlayers") \
+    X(TRIGGERS,   "triggers") \
+    X(PLCOL,      "plCol") \
+    X(CAMERA,     "camera")
+
+enum enPsPhase {
+#define X(phase, label) \
+    PS_PHASE_ ## phase,
+    PS_PHASES
+#undef X
+    PS_PHASE_MAX
+};
+typedef enum enPsPhase psPhase;
+
+/**
+ * Called as soon as each phase of an update finishes
+ * 
+ * @param phase The phase that just finished
+ * @param pCtx Context passed to playstate_updateWorld
+ */
+typedef void (*psPhaseCb)(psPhase phase, void *pCtx);
+
 /**
  * Playstate implementation. Must initialize it, run the loop and clean it up
  */
@@ -22,7 +73,7 @@ state playstate(playstateCmd cmd);
 
 /**
  * Retrieve a new 'stateHandler' for the playstate 'state'.
- *
+ * 
  * @param [in]cmd In which mode the playstate should start.
  */
 void *playstate_getHnd(playstateCmd cmd);
@@ -45,5 +96,45 @@ void ps_showText(char *text, int textLen, int x, int y, int w, int h);
 /** Retrieve the last gfm error that caused a state transition. */
 int playstate_getGfmError(void *self);
 
+/**
+ * Run the playstate without rendering nor playing audio, as fast as possible.
+ * Every update is exactly 'stepMs' long and the players' inputs are generated
+ * from 'seed', so runs with the same parameters are reproducible.
+ * 
+ * @param pRes Returns the simulation's results
+ * @param cmd In which mode the playstate should start
+ * @param ticks How many updates should be simulated
+ * @param stepMs Duration of each update, in milliseconds
+ * @param seed Seed for the injected inputs
+ * @return GFraMe error code
+ */
+GFraMe_ret playstate_runHeadless(psHeadlessResult *pRes, playstateCmd cmd,
+    int ticks, int stepMs, unsigned int seed);
+
+/**
+ * Run a recorded playstate without rendering nor playing audio, as fast as
+ * possible. The save state where the recording started is restored, so it
+ * must be called after 'setup_volatile_blocks'.
+ * 
+ * @param pRes Returns the simulation's results
+ * @param filename The recorded file
+ * @param ticks How many updates should be simulated (0 runs until the end)
+ * @return GFraMe error code
+ */
+GFraMe_ret playstate_runReplay(psHeadlessResult *pRes, char *filename,
+    int ticks);
+
+/**
+ * Update every entity on the current map once and collide them, without
+ * handling map transitions, deaths nor text windows (which are left to the
+ * caller)
+ * 
+ * @param ms Duration of the update, in milliseconds
+ * @param cb Called after each phase (may be NULL)
+ * @param pCtx Context passed to the callback
+ * @return GFraMe error code
+ */
+GFraMe_ret playstate_updateWorld(int ms, psPhaseCb cb, void *pCtx);
+
 #endif
 
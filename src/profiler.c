@@ -0,0 +1,724 @@
+/**
+ * @file src/profiler.c
+ * 
+ * Hierarchical frame profiler. Every zone accumulates how long it took on the
+ * current frame (e.g., the update may run a few times per frame) and, at its
+ * end, the frame is pushed into a ring buffer of the last PROF_FRAMES frames.
+ * Every begin/end pair is also stored (on a much bigger ring buffer) so it may
+ * be exported as a Chrome trace.
+ * 
+ * Draws are accounted per subsystem: every call is clipped to the screen and
+ * its pixels are marked on a depth buffer, so any pixel drawn more than once
+ * on a frame counts as overdraw. Frames that drew anything go into another
+ * ring buffer, into a per-run CSV and into the overdraw heatmap.
+ * 
+ * Counters simply accumulate since the game started.
+ */
+#if defined(PROFILER)
+
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_spriteset.h>
+
+#include <SDL2/SDL_timer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "profiler.h"
+#include "snapshot.h"
+
+/** How many frames are kept for the overlay */
+#define PROF_FRAMES 256
+/** How many zones are kept for the trace */
+#define PROF_EVENTS 65536
+/** How many frames between refreshing the overlay's statistics */
+#define PROF_REFRESH 30
+/** Longest line on the overlay */
+#define PROF_LINE_LEN 40
+/** How many lines there may be on the overlay */
+#define PROF_LINES (PROF_MAX + 1)
+/** File where every frame's draws are written */
+#define PROF_DRAWS_CSV "draws.csv"
+/** Dimensions of each cell on the overdraw heatmap */
+#define PROF_CELL 8
+#define PROF_CELLS_W (SCR_W / PROF_CELL)
+#define PROF_CELLS_H (SCR_H / PROF_CELL)
+
+/** What the overlay is showing */
+enum enProfOverlay {
+    PROF_OVERLAY_HIDDEN = 0,
+    PROF_OVERLAY_ZONES,
+    PROF_OVERLAY_DRAWS,
+    PROF_OVERLAY_COUNTERS,
+    PROF_OVERLAY_MAX
+};
+
+/** A single timed zone, for the trace */
+struct stProfEvent {
+    profZone zone;
+    Uint64 start;
+    Uint64 end;
+};
+typedef struct stProfEvent profEvent;
+
+/** A subsystem's draws on a frame */
+struct stProfDraws {
+    /** How many tiles/sprites were drawn */
+    int calls;
+    /** How many pixels (on the screen) were covered */
+    int pixels;
+    /** How many of those pixels had already been drawn on this frame */
+    int overdraw;
+};
+typedef struct stProfDraws profDraws;
+
+/** Every zone's parent */
+static const profZone _prof_parent[PROF_MAX] = {
+#define X(zone, parent, label) \
+    PROF_ ## parent,
+    PROF_ZONES
+#undef X
+};
+/** Every zone's label */
+static const char *_prof_label[PROF_MAX] = {
+#define X(zone, parent, label) \
+    label,
+    PROF_ZONES
+#undef X
+};
+/** Every drawer's label */
+static const char *_prof_drawerLabel[PROF_DRAWER_MAX] = {
+#define X(drawer, label) \
+    label,
+    PROF_DRAWERS
+#undef X
+};
+/** Every counter's label */
+static const char *_prof_counterLabel[PROF_CNT_MAX] = {
+#define X(counter, label) \
+    label,
+    PROF_COUNTERS
+#undef X
+};
+
+/** When each zone was started */
+static Uint64 _prof_start[PROF_MAX];
+/** Time spent on each zone on the current frame (in counter ticks) */
+static Uint64 _prof_cur[PROF_MAX];
+/** Time spent on each zone on the last frames, in milliseconds */
+static float _prof_ring[PROF_FRAMES][PROF_MAX];
+/** How many frames were pushed into the ring */
+static int _prof_frames = 0;
+/** Every timed zone, for the trace */
+static profEvent _prof_events[PROF_EVENTS];
+/** Where the next zone goes on the trace ring */
+static int _prof_nextEvent = 0;
+/** How many zones are on the trace ring (at most PROF_EVENTS) */
+static int _prof_numEvents = 0;
+/** What the overlay is showing */
+static int _prof_overlay = PROF_OVERLAY_HIDDEN;
+/** The overlay's text */
+static char _prof_lines[PROF_LINES][PROF_LINE_LEN + 1];
+/** How many lines there are on the overlay */
+static int _prof_numLines = 0;
+/** Each subsystem's draws on the current frame */
+static profDraws _prof_draws[PROF_DRAWER_MAX];
+/** Each subsystem's draws on the last frames that drew anything */
+static profDraws _prof_drawRing[PROF_FRAMES][PROF_DRAWER_MAX];
+/** Texture switches on the current frame */
+static int _prof_texSwitches = 0;
+/** Texture switches on the last frames that drew anything */
+static int _prof_texRing[PROF_FRAMES];
+/** Last texture drawn */
+static GFraMe_texture *_prof_lastTex = NULL;
+/** How many frames drew anything */
+static int _prof_drawnFrames = 0;
+/** How many times each pixel was drawn on the current frame */
+static unsigned char _prof_depth[SCR_H][SCR_W];
+/** How many times each cell's pixels were drawn, over every frame */
+static double _prof_heat[PROF_CELLS_H][PROF_CELLS_W];
+/** The draws' CSV (opened on the first frame that draws anything) */
+static FILE *_prof_csv = NULL;
+/** Every counter's value */
+static int _prof_counters[PROF_CNT_MAX];
+
+/**
+ * Start timing a zone
+ * 
+ * @param zone The zone
+ */
+void prof_begin(profZone zone) {
+    _prof_start[zone] = SDL_GetPerformanceCounter();
+}
+
+/**
+ * Stop timing a zone and accumulate it into the current frame
+ * 
+ * @param zone The zone
+ */
+void prof_end(profZone zone) {
+    profEvent *pEv;
+    Uint64 end;
+    
+    end = SDL_GetPerformanceCounter();
+    _prof_cur[zone] += end - _prof_start[zone];
+    
+    pEv = &_prof_events[_prof_nextEvent];
+    pEv->zone = zone;
+    pEv->start = _prof_start[zone];
+    pEv->end = end;
+    // Wrap around, so long sessions never overflow the counter
+    _prof_nextEvent = (_prof_nextEvent + 1) % PROF_EVENTS;
+    if (_prof_numEvents < PROF_EVENTS)
+        _prof_numEvents++;
+}
+
+/**
+ * Increase a counter
+ * 
+ * @param counter The counter
+ * @param num How much it should be increased by
+ */
+void prof_count(profCounter counter, int num) {
+    _prof_counters[counter] += num;
+}
+
+/**
+ * Account for a rectangle drawn by a subsystem
+ * 
+ * @param drawer The subsystem
+ * @param pTex The texture it was drawn from
+ * @param x Horizontal position on the screen
+ * @param y Vertical position on the screen
+ * @param w The rectangle's width
+ * @param h The rectangle's height
+ */
+static void prof_accountDraw(profDrawer drawer, GFraMe_texture *pTex, int x,
+    int y, int w, int h) {
+    profDraws *pD;
+    int i, j, x1, y1;
+    
+    pD = &_prof_draws[drawer];
+    pD->calls++;
+    if (pTex != _prof_lastTex) {
+        if (_prof_lastTex)
+            _prof_texSwitches++;
+        _prof_lastTex = pTex;
+    }
+    
+    // Clip it to the screen
+    x1 = x + w;
+    y1 = y + h;
+    if (x < 0)
+        x = 0;
+    if (y < 0)
+        y = 0;
+    if (x1 > SCR_W)
+        x1 = SCR_W;
+    if (y1 > SCR_H)
+        y1 = SCR_H;
+    
+    j = y;
+    while (j < y1) {
+        i = x;
+        while (i < x1) {
+            if (_prof_depth[j][i] > 0)
+                pD->overdraw++;
+            if (_prof_depth[j][i] < 0xff)
+                _prof_depth[j][i]++;
+            i++;
+        }
+        j++;
+    }
+    if (x1 > x && y1 > y)
+        pD->pixels += (x1 - x) * (y1 - y);
+}
+
+/**
+ * Draw a tile from a spriteset, accounting for it
+ * 
+ * @param drawer The subsystem drawing it
+ * @param pSset The spriteset
+ * @param tile The tile
+ * @param x Horizontal position on the screen
+ * @param y Vertical position on the screen
+ * @param flip Whether the tile is flipped
+ * @return GFraMe error code
+ */
+GFraMe_ret prof_spritesetDraw(profDrawer drawer, GFraMe_spriteset *pSset,
+    int tile, int x, int y, int flip) {
+    prof_accountDraw(drawer, pSset->tex, x, y, pSset->tw, pSset->th);
+    return sn_spritesetDraw(pSset, tile, x, y, flip);
+}
+
+/**
+ * Draw a sprite relative to the camera, accounting for it
+ * 
+ * @param drawer The subsystem drawing it
+ * @param pSpr The sprite
+ * @param camX Camera's horizontal position
+ * @param camY Camera's vertical position
+ * @param w Camera's width
+ * @param h Camera's height
+ */
+void prof_spriteDraw(profDrawer drawer, GFraMe_sprite *pSpr, int camX,
+    int camY, int w, int h) {
+    int x, y;
+    
+    // Only account for sprites that are on the camera (same test as the one
+    // used when recording)
+    x = pSpr->obj.x + pSpr->offset_x - camX;
+    y = pSpr->obj.y + pSpr->offset_y - camY;
+    if (x + pSpr->sset->tw >= 0 && x <= w && y + pSpr->sset->th >= 0 && y <= h)
+        prof_accountDraw(drawer, pSpr->sset->tex, x, y, pSpr->sset->tw,
+            pSpr->sset->th);
+    sn_spriteDraw(pSpr, camX, camY, w, h);
+}
+
+/**
+ * Compare two floats, for qsort
+ */
+static int prof_cmp(const void *a, const void *b) {
+    float fa, fb;
+    
+    fa = *(const float*)a;
+    fb = *(const float*)b;
+    if (fa < fb)
+        return -1;
+    else if (fa > fb)
+        return 1;
+    return 0;
+}
+
+/**
+ * Calculate a zone's statistics over the ring buffer
+ * 
+ * @param pMin Returns the fastest frame, in milliseconds
+ * @param pAvg Returns the average, in milliseconds
+ * @param pP99 Returns the 99th percentile, in milliseconds
+ * @param zone The zone
+ */
+static void prof_getStats(float *pMin, float *pAvg, float *pP99,
+    profZone zone) {
+    float samples[PROF_FRAMES], total;
+    int i, num;
+    
+    num = _prof_frames;
+    if (num > PROF_FRAMES)
+        num = PROF_FRAMES;
+    if (num == 0) {
+        *pMin = 0.0f;
+        *pAvg = 0.0f;
+        *pP99 = 0.0f;
+        return;
+    }
+    
+    total = 0.0f;
+    i = 0;
+    while (i < num) {
+        samples[i] = _prof_ring[i][zone];
+        total += samples[i];
+        i++;
+    }
+    qsort(samples, num, sizeof(float), prof_cmp);
+    
+    *pMin = samples[0];
+    *pAvg = total / num;
+    *pP99 = samples[num * 99 / 100];
+}
+
+/**
+ * Retrieve how deep a zone is on the hierarchy
+ * 
+ * @param zone The zone
+ * @return The zone's depth (0 for root zones)
+ */
+static int prof_getDepth(profZone zone) {
+    int depth;
+    
+    depth = 0;
+    while (_prof_parent[zone] != zone) {
+        zone = _prof_parent[zone];
+        depth++;
+    }
+    
+    return depth;
+}
+
+/**
+ * Regenerate the overlay's text with every zone's timings
+ */
+static void prof_refreshZones() {
+    int i;
+    
+    snprintf(_prof_lines[0], PROF_LINE_LEN + 1, "%-14s %7s %7s %7s",
+        "ZONE (MS)", "MIN", "AVG", "P99");
+    i = 0;
+    while (i < PROF_MAX) {
+        char name[15];
+        float avg, min, p99;
+        int depth;
+        
+        depth = prof_getDepth((profZone)i);
+        snprintf(name, sizeof(name), "%*s%s", depth, "", _prof_label[i]);
+        prof_getStats(&min, &avg, &p99, (profZone)i);
+        snprintf(_prof_lines[i + 1], PROF_LINE_LEN + 1,
+            "%-14s %7.3f %7.3f %7.3f", name, min, avg, p99);
+        i++;
+    }
+    _prof_numLines = PROF_MAX + 1;
+}
+
+/**
+ * Regenerate the overlay's text with every subsystem's average draws
+ */
+static void prof_refreshDraws() {
+    double calls, over, pixels, switches, totalCalls, totalOver, totalPixels;
+    int i, j, num;
+    
+    num = _prof_drawnFrames;
+    if (num > PROF_FRAMES)
+        num = PROF_FRAMES;
+    
+    snprintf(_prof_lines[0], PROF_LINE_LEN + 1, "%-12s %7s %7s %7s",
+        "DRAWS (AVG)", "CALLS", "KPIXELS", "OVER%");
+    totalCalls = 0.0;
+    totalPixels = 0.0;
+    totalOver = 0.0;
+    i = 0;
+    while (i < PROF_DRAWER_MAX) {
+        calls = 0.0;
+        pixels = 0.0;
+        over = 0.0;
+        j = 0;
+        while (j < num) {
+            calls += _prof_drawRing[j][i].calls;
+            pixels += _prof_drawRing[j][i].pixels;
+            over += _prof_drawRing[j][i].overdraw;
+            j++;
+        }
+        totalCalls += calls;
+        totalPixels += pixels;
+        totalOver += over;
+        if (num > 0) {
+            calls /= num;
+            pixels /= num;
+            over /= num;
+        }
+        snprintf(_prof_lines[i + 1], PROF_LINE_LEN + 1,
+            "%-12s %7.1f %7.2f %7.1f", _prof_drawerLabel[i], calls,
+            pixels / 1000.0, (pixels > 0.0) ? over * 100.0 / pixels : 0.0);
+        i++;
+    }
+    
+    switches = 0.0;
+    j = 0;
+    while (j < num) {
+        switches += _prof_texRing[j];
+        j++;
+    }
+    if (num > 0) {
+        totalCalls /= num;
+        totalPixels /= num;
+        totalOver /= num;
+        switches /= num;
+    }
+    snprintf(_prof_lines[i + 1], PROF_LINE_LEN + 1, "%-12s %7.1f %7.2f %7.1f",
+        "TOTAL", totalCalls, totalPixels / 1000.0, (totalPixels > 0.0) ?
+        totalOver * 100.0 / totalPixels : 0.0);
+    snprintf(_prof_lines[i + 2], PROF_LINE_LEN + 1, "%-12s %7.1f",
+        "TEX SWITCHES", switches);
+    _prof_numLines = i + 3;
+}
+
+/**
+ * Regenerate the overlay's text with every counter
+ */
+static void prof_refreshCounters() {
+    int i;
+    
+    snprintf(_prof_lines[0], PROF_LINE_LEN + 1, "%-14s %7s", "COUNTER",
+        "TOTAL");
+    i = 0;
+    while (i < PROF_CNT_MAX) {
+        snprintf(_prof_lines[i + 1], PROF_LINE_LEN + 1, "%-14s %7i",
+            _prof_counterLabel[i], _prof_counters[i]);
+        i++;
+    }
+    _prof_numLines = PROF_CNT_MAX + 1;
+}
+
+/**
+ * Regenerate the overlay's text
+ */
+static void prof_refresh() {
+    if (_prof_overlay == PROF_OVERLAY_DRAWS)
+        prof_refreshDraws();
+    else if (_prof_overlay == PROF_OVERLAY_COUNTERS)
+        prof_refreshCounters();
+    else
+        prof_refreshZones();
+}
+
+/**
+ * Push the current frame's draws into the ring buffer, the CSV and the
+ * heatmap
+ */
+static void prof_pushDraws() {
+    int i, j;
+    
+    memcpy(_prof_drawRing[_prof_drawnFrames % PROF_FRAMES], _prof_draws,
+        sizeof(_prof_draws));
+    _prof_texRing[_prof_drawnFrames % PROF_FRAMES] = _prof_texSwitches;
+    
+    j = 0;
+    while (j < SCR_H) {
+        i = 0;
+        while (i < SCR_W) {
+            _prof_heat[j / PROF_CELL][i / PROF_CELL] += _prof_depth[j][i];
+            i++;
+        }
+        j++;
+    }
+    
+    if (!_prof_csv) {
+        _prof_csv = fopen(PROF_DRAWS_CSV, "wt");
+        if (_prof_csv) {
+            fprintf(_prof_csv, "frame,tex_switches");
+            i = 0;
+            while (i < PROF_DRAWER_MAX) {
+                fprintf(_prof_csv, ",%s_calls,%s_pixels,%s_overdraw",
+                    _prof_drawerLabel[i], _prof_drawerLabel[i],
+                    _prof_drawerLabel[i]);
+                i++;
+            }
+            fprintf(_prof_csv, "\n");
+        }
+    }
+    if (_prof_csv) {
+        fprintf(_prof_csv, "%i,%i", _prof_drawnFrames, _prof_texSwitches);
+        i = 0;
+        while (i < PROF_DRAWER_MAX) {
+            fprintf(_prof_csv, ",%i,%i,%i", _prof_draws[i].calls,
+                _prof_draws[i].pixels, _prof_draws[i].overdraw);
+            i++;
+        }
+        fprintf(_prof_csv, "\n");
+    }
+    
+    _prof_drawnFrames++;
+    memset(_prof_draws, 0x0, sizeof(_prof_draws));
+    memset(_prof_depth, 0x0, sizeof(_prof_depth));
+    _prof_texSwitches = 0;
+    _prof_lastTex = NULL;
+}
+
+/**
+ * Push the current frame into the ring buffer and start a new one
+ */
+void prof_endFrame() {
+    double freq;
+    int i;
+    
+    freq = (double)SDL_GetPerformanceFrequency();
+    i = 0;
+    while (i < PROF_MAX) {
+        _prof_ring[_prof_frames % PROF_FRAMES][i] =
+            (float)(_prof_cur[i] * 1000.0 / freq);
+        i++;
+    }
+    memset(_prof_cur, 0x0, sizeof(_prof_cur));
+    _prof_frames++;
+    
+    i = 0;
+    while (i < PROF_DRAWER_MAX && _prof_draws[i].calls == 0)
+        i++;
+    if (i < PROF_DRAWER_MAX)
+        prof_pushDraws();
+    
+    if (_prof_overlay != PROF_OVERLAY_HIDDEN
+            && _prof_frames % PROF_REFRESH == 0)
+        prof_refresh();
+}
+
+/**
+ * Cycle the overlay between the zones' timings, the draws' statistics, the
+ * counters and hidden
+ */
+void prof_toggleOverlay() {
+    _prof_overlay = (_prof_overlay + 1) % PROF_OVERLAY_MAX;
+    if (_prof_overlay != PROF_OVERLAY_HIDDEN)
+        prof_refresh();
+}
+
+/**
+ * Draw the overlay (if it's visible)
+ */
+void prof_draw() {
+    int i, x, y;
+    
+    if (_prof_overlay == PROF_OVERLAY_HIDDEN)
+        return;
+    
+    y = 0;
+    i = 0;
+    while (i < _prof_numLines && y + 8 <= SCR_H) {
+        char *c;
+        
+        x = 0;
+        c = _prof_lines[i];
+        while (*c && x + 8 <= SCR_W) {
+            if (*c != ' ')
+                GFraMe_spriteset_draw(gl_sset8x8, *c - '!', x, y, 0/*flip*/);
+            x += 8;
+            c++;
+        }
+        y += 8;
+        i++;
+    }
+}
+
+/**
+ * Log every line on the overlay's text
+ */
+static void prof_logLines() {
+    int i;
+    
+    i = 0;
+    while (i < _prof_numLines) {
+        GFraMe_log("%s", _prof_lines[i]);
+        i++;
+    }
+}
+
+/**
+ * Log every zone's min/avg/p99 (in milliseconds), the draws' statistics and
+ * the counters
+ */
+void prof_log() {
+    prof_refreshZones();
+    prof_logLines();
+    if (_prof_drawnFrames > 0) {
+        prof_refreshDraws();
+        prof_logLines();
+    }
+    prof_refreshCounters();
+    prof_logLines();
+    // Restore whatever the overlay was showing
+    prof_refresh();
+}
+
+/**
+ * Export every recorded zone as a Chrome trace
+ * 
+ * @param filename The trace file
+ * @return GFraMe error code
+ */
+GFraMe_ret prof_exportTrace(char *filename) {
+    double freq;
+    FILE *fp;
+    GFraMe_ret rv;
+    int first, i, num;
+    Uint64 base;
+    
+    fp = NULL;
+    // Only the last PROF_EVENTS zones are available
+    num = _prof_numEvents;
+    first = (_prof_nextEvent - num + PROF_EVENTS) % PROF_EVENTS;
+    ASSERT(num > 0, GFraMe_ret_failed);
+    
+    fp = fopen(filename, "wt");
+    GFraMe_assertRV(fp, "Failed to open trace file",
+        rv = GFraMe_ret_file_not_found, __ret);
+    
+    freq = (double)SDL_GetPerformanceFrequency();
+    base = _prof_events[first % PROF_EVENTS].start;
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    i = 0;
+    while (i < num) {
+        profEvent *pEv;
+        
+        pEv = &_prof_events[(first + i) % PROF_EVENTS];
+        // Events are ordered by their end, so an enclosing zone may start
+        // before the first one
+        if (pEv->start < base)
+            base = pEv->start;
+        i++;
+    }
+    i = 0;
+    while (i < num) {
+        profEvent *pEv;
+        
+        pEv = &_prof_events[(first + i) % PROF_EVENTS];
+        fprintf(fp, "  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+            "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1}%s\n",
+            _prof_label[pEv->zone], _prof_label[_prof_parent[pEv->zone]],
+            (pEv->start - base) * 1000000.0 / freq,
+            (pEv->end - pEv->start) * 1000000.0 / freq,
+            (i + 1 < num) ? "," : "");
+        i++;
+    }
+    fprintf(fp, "]}\n");
+    
+    GFraMe_log("Exported %i zones to %s", num, filename);
+    rv = GFraMe_ret_ok;
+__ret:
+    if (fp)
+        fclose(fp);
+    
+    return rv;
+}
+
+/**
+ * Export the overdraw heatmap, as the average number of times each 8x8 cell
+ * was drawn per frame (one CSV row per row of cells)
+ * 
+ * @param filename The heatmap file
+ * @return GFraMe error code
+ */
+GFraMe_ret prof_exportOverdraw(char *filename) {
+    FILE *fp;
+    GFraMe_ret rv;
+    int i, j;
+    
+    fp = NULL;
+    ASSERT(_prof_drawnFrames > 0, GFraMe_ret_failed);
+    
+    fp = fopen(filename, "wt");
+    GFraMe_assertRV(fp, "Failed to open heatmap file",
+        rv = GFraMe_ret_file_not_found, __ret);
+    
+    j = 0;
+    while (j < PROF_CELLS_H) {
+        i = 0;
+        while (i < PROF_CELLS_W) {
+            fprintf(fp, "%s%.2f", (i > 0) ? "," : "", _prof_heat[j][i]
+                / (PROF_CELL * PROF_CELL * (double)_prof_drawnFrames));
+            i++;
+        }
+        fprintf(fp, "\n");
+        j++;
+    }
+    
+    GFraMe_log("Exported the overdraw heatmap to %s", filename);
+    rv = GFraMe_ret_ok;
+__ret:
+    if (fp)
+        fclose(fp);
+    
+    return rv;
+}
+
+/**
+ * Close the draws' CSV
+ */
+void prof_clean() {
+    if (_prof_csv)
+        fclose(_prof_csv);
+    _prof_csv = NULL;
+}
+
+#endif /* PROFILER */
+
@@ -0,0 +1,230 @@
+/**
+ * @file src/profiler.h
+ * 
+ * Hierarchical frame profiler. Each zone is timed with the performance
+ * counter and accumulated per frame into a ring buffer, which may be shown as
+ * an overlay (min/avg/p99 per zone) or exported as a Chrome trace (to be
+ * opened on chrome://tracing).
+ * 
+ * Every sprite/tile drawn by the playstate goes through PROF_SPRITESET_DRAW or
+ * PROF_SPRITE_DRAW, which account for the draw calls, pixels covered, overdraw
+ * and texture switches of each subsystem.
+ * 
+ * Some events (e.g., how often the update loop had to drop steps) are counted
+ * with PROF_COUNT.
+ * 
+ * It's only compiled when PROFILER is defined (e.g., 'make linux64
+ * PROFILER=1'); Otherwise, every macro expands to nothing (or straight into
+ * the snapshot, which either draws or records it).
+ */
+#ifndef __PROFILER_H_
+#define __PROFILER_H_
+
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_sprite.h>
+#include <GFraMe/GFraMe_spriteset.h>
+
+#include "snapshot.h"
+
+/** Every zone, as X(zone, parent zone, label); Root zones are their own
+ *  parent and every zone must come after its parent */
+#define PROF_ZONES \
+    X(FRAME,        FRAME,  "FRAME") \
+    X(EVENTS,       FRAME,  "EVENTS") \
+    X(UPDATE,       FRAME,  "UPDATE") \
+    X(UPD_TELEPORT, UPDATE, "TELEPORT") \
+    X(UPD_MAP,      UPDATE, "MAP") \
+    X(UPD_MOBS,     UPDATE, "MOBS") \
+    X(UPD_OBJECTS,  UPDATE, "OBJECTS") \
+    X(UPD_BULLETS,  UPDATE, "BULLETS") \
+    X(UPD_PLAYERS,  UPDATE, "PLAYERS") \
+    X(UPD_UI,       UPDATE, "UI") \
+    X(UPD_QTINIT,   UPDATE, "QT INIT") \
+    X(UPD_QTWALLS,  UPDATE, "QT WALLS") \
+    X(UPD_QTOBJS,   UPDATE, "QT OBJS") \
+    X(UPD_QTMOBS,   UPDATE, "QT MOBS") \
+    X(UPD_QTBULLETS,UPDATE, "QT BULLETS") \
+    X(UPD_QTPLAYERS,UPDATE, "QT PLAYERS") \
+    X(UPD_TRIGGERS, UPDATE, "TRIGGERS") \
+    X(UPD_PLCOL,    UPDATE, "PL X PL") \
+    X(UPD_CAMERA,   UPDATE, "CAMERA") \
+    X(DRAW,         FRAME,  "DRAW") \
+    X(DRW_MAP,      DRAW,   "MAP") \
+    X(DRW_BULLETS,  DRAW,   "BULLETS") \
+    X(DRW_OBJECTS,  DRAW,   "OBJECTS") \
+    X(DRW_MOBS,     DRAW,   "MOBS") \
+    X(DRW_UI,       DRAW,   "UI") \
+    X(DRW_PLAYERS,  DRAW,   "PLAYERS") \
+    X(DRW_HUD,      DRAW,   "HUD") \
+    X(SUBMIT,       FRAME,  "SUBMIT")
+
+enum enProfZone {
+#define X(zone, parent, label) \
+    PROF_ ## zone,
+    PROF_ZONES
+#undef X
+    PROF_MAX
+};
+typedef enum enProfZone profZone;
+
+/** Every subsystem that draws, as X(drawer, label) */
+#define PROF_DRAWERS \
+    X(MAP,        "MAP") \
+    X(TRANSITION, "TRANSITION") \
+    X(UI,         "UI") \
+    X(TEXT,       "TEXT") \
+    X(PLAYERS,    "PLAYERS") \
+    X(MOBS,       "MOBS") \
+    X(OBJECTS,    "OBJECTS") \
+    X(BULLETS,    "BULLETS") \
+    X(HUD,        "HUD")
+
+enum enProfDrawer {
+#define X(drawer, label) \
+    PROF_DRAWER_ ## drawer,
+    PROF_DRAWERS
+#undef X
+    PROF_DRAWER_MAX
+};
+typedef enum enProfDrawer profDrawer;
+
+/** Every counter, as X(counter, label) */
+#define PROF_COUNTERS \
+    X(STEPS,   "STEPS") \
+    X(CAPPED,  "CAPPED FRAMES") \
+    X(DILATED, "DILATED FRAMES") \
+    X(DROPPED, "DROPPED STEPS")
+
+enum enProfCounter {
+#define X(counter, label) \
+    PROF_CNT_ ## counter,
+    PROF_COUNTERS
+#undef X
+    PROF_CNT_MAX
+};
+typedef enum enProfCounter profCounter;
+
+#if defined(PROFILER)
+#  define PROF_SPRITESET_DRAW(drawer, pSset, tile, x, y, flip) \
+    prof_spritesetDraw(PROF_DRAWER_ ## drawer, pSset, tile, x, y, flip)
+#  define PROF_SPRITE_DRAW(drawer, pSpr, camX, camY, w, h) \
+    prof_spriteDraw(PROF_DRAWER_ ## drawer, pSpr, camX, camY, w, h)
+#else
+#  define PROF_SPRITESET_DRAW(drawer, pSset, tile, x, y, flip) \
+    sn_spritesetDraw(pSset, tile, x, y, flip)
+#  define PROF_SPRITE_DRAW(drawer, pSpr, camX, camY, w, h) \
+    sn_spriteDraw(pSpr, camX, camY, w, h)
+#endif /* PROFILER */
+
+#if defined(PROFILER)
+#  define PROF_BEGIN(zone) prof_begin(PROF_ ## zone)
+#  define PROF_END(zone) prof_end(PROF_ ## zone)
+#  define PROF_END_FRAME() prof_endFrame()
+#  define PROF_COUNT(counter, num) prof_count(PROF_CNT_ ## counter, num)
+#else
+#  define PROF_BEGIN(zone) do {} while (0)
+#  define PROF_END(zone) do {} while (0)
+#  define PROF_END_FRAME() do {} while (0)
+#  define PROF_COUNT(counter, num) do {} while (0)
+#endif /* PROFILER */
+
+#if defined(PROFILER)
+
+/**
+ * Start timing a zone
+ * 
+ * @param zone The zone
+ */
+void prof_begin(profZone zone);
+
+/**
+ * Stop timing a zone and accumulate it into the current frame
+ * 
+ * @param zone The zone
+ */
+void prof_end(profZone zone);
+
+/**
+ * Increase a counter
+ * 
+ * @param counter The counter
+ * @param num How much it should be increased by
+ */
+void prof_count(profCounter counter, int num);
+
+/**
+ * Draw a tile from a spriteset, accounting for it
+ * 
+ * @param drawer The subsystem drawing it
+ * @param pSset The spriteset
+ * @param tile The tile
+ * @param x Horizontal position on the screen
+ * @param y Vertical position on the screen
+ * @param flip Whether the tile is flipped
+ * @return GFraMe error code
+ */
+GFraMe_ret prof_spritesetDraw(profDrawer drawer, GFraMe_spriteset *pSset,
+    int tile, int x, int y, int flip);
+
+/**
+ * Draw a sprite relative to the camera, accounting for it
+ * 
+ * @param drawer The subsystem drawing it
+ * @param pSpr The sprite
+ * @param camX Camera's horizontal position
+ * @param camY Camera's vertical position
+ * @param w Camera's width
+ * @param h Camera's height
+ */
+void prof_spriteDraw(profDrawer drawer, GFraMe_sprite *pSpr, int camX,
+    int camY, int w, int h);
+
+/**
+ * Push the current frame into the ring buffers (and the draws' CSV, if
+ * anything was drawn) and start a new one
+ */
+void prof_endFrame();
+
+/**
+ * Cycle the overlay between the zones' timings, the draws' statistics, the
+ * counters and hidden
+ */
+void prof_toggleOverlay();
+
+/**
+ * Draw the overlay (if it's visible)
+ */
+void prof_draw();
+
+/**
+ * Log every zone's min/avg/p99 (in milliseconds), the draws' statistics and
+ * the counters
+ */
+void prof_log();
+
+/**
+ * Export every recorded zone as a Chrome trace
+ * 
+ * @param filename The trace file
+ * @return GFraMe error code
+ */
+GFraMe_ret prof_exportTrace(char *filename);
+
+/**
+ * Export the overdraw heatmap, as the average number of times each 8x8 cell
+ * was drawn per frame (one CSV row per row of cells)
+ * 
+ * @param filename The heatmap file
+ * @return GFraMe error code
+ */
+GFraMe_ret prof_exportOverdraw(char *filename);
+
+/**
+ * Close the draws' CSV
+ */
+void prof_clean();
+
+#endif /* PROFILER */
+
+#endif
+
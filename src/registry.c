@@ -12,6 +12,8 @@
 #include "bullet.h"
 #include "event.h"
 #include "global.h"
+#include "globalVar.h"
+#include "interp.h"
 #include "map.h"
 #include "mob.h"
 #include "object.h"
@@ -56,6 +58,11 @@ BUF_DEFINE(object);
 BUF_DEFINE(mob);
 BUF_DEFINE(wall);
 
+/** What each mob knows about the players (i.e., one entry per mob) */
+static mobPerception *_rg_mobPerception = 0;
+/** How many entries fit on _rg_mobPerception */
+static int _rg_mobPerceptionLen = 0;
+
 /**
  * Initialize every buffer
  * 
@@ -84,6 +91,11 @@ void rg_clean() {
     BUF_CLEAN(object, obj_clean);
     BUF_CLEAN(wall, rg_cleanGfmObj);
     BUF_CLEAN(mob, mob_clean);
+    if (_rg_mobPerception)
+        free(_rg_mobPerception);
+    _rg_mobPerception = 0;
+    _rg_mobPerceptionLen = 0;
+    gv_cleanSubscriptions();
 }
 
 /**
@@ -95,6 +107,8 @@ void rg_reset() {
     BUF_RESET(object);
     BUF_RESET(wall);
     BUF_RESET(mob);
+    // Every object will be replaced, so forget about the previous ones
+    gv_clearSubscriptions();
 }
 
 /**
@@ -122,14 +136,34 @@ void rg_pushEvent() {
 }
 
 /**
- * Add all events to the quadtree
+ * Return how many events there currently is
  * 
+ * @return Used events
+ */
+int rg_getEventsUsed() {
+    return BUF_GET_USED(event);
+}
+
+/**
+ * Get an event
+ * 
+ * @param num The event's index
+ * @return The gotten event
+ */
+event* rg_getEvent(int num) {
+    return BUF_GET_OBJECT(event, num);
+}
+
+/**
+ * Retrieve the next valid event (expanding the buffer as necessary)
+ * 
+ * @param ppO Returns the object
  * @return GFraMe error code
  */
-GFraMe_ret rg_qtAddEvents() {
+GFraMe_ret rg_getNextObject(object **ppO) {
     GFraMe_ret rv;
     
-    BUF_CALL_ALL_RET(event, rv, qt_addEv);
+    BUF_GET_NEXT_REF(object, OBJECT_INC, *ppO, GFraMe_ret_memory_error, obj_getNew);
     
     rv = GFraMe_ret_ok;
 __ret:
@@ -137,15 +171,17 @@ __ret:
 }
 
 /**
- * Retrieve the next valid event (expanding the buffer as necessary)
+ * Push the last object (i.e, increase the counter); It's also subscribed to
+ * its variables, so it's woken whenever any of those changes
  * 
- * @param ppO Returns the object
  * @return GFraMe error code
  */
-GFraMe_ret rg_getNextObject(object **ppO) {
+GFraMe_ret rg_pushObject() {
     GFraMe_ret rv;
     
-    BUF_GET_NEXT_REF(object, OBJECT_INC, *ppO, GFraMe_ret_memory_error, obj_getNew);
+    rv = obj_subscribe(BUF_GET_OBJECT(object, BUF_GET_USED(object)));
+    ASSERT(rv == GFraMe_ret_ok, rv);
+    BUF_PUSH(object);
     
     rv = GFraMe_ret_ok;
 __ret:
@@ -153,10 +189,22 @@ __ret:
 }
 
 /**
- * Push the last object (i.e, increase the counter)
+ * Return how many objects there currently is
+ * 
+ * @return Used objects
  */
-void rg_pushObject() {
-    BUF_PUSH(object);
+int rg_getObjectsUsed() {
+    return BUF_GET_USED(object);
+}
+
+/**
+ * Get an object
+ * 
+ * @param num The object's index
+ * @return The gotten object
+ */
+object* rg_getObject(int num) {
+    return BUF_GET_OBJECT(object, num);
 }
 
 /**
@@ -245,6 +293,15 @@ void rg_pushWall() {
     BUF_PUSH(wall);
 }
 
+/**
+ * Remove a wall; the last wall takes its place
+ * 
+ * @param num The wall's index
+ */
+void rg_removeWall(int num) {
+    BUF_REMOVE(wall, num);
+}
+
 /**
  * Add every wall to the quadtree
  * 
@@ -313,12 +370,58 @@ void rg_pushMob() {
 }
 
 /**
- * Update every mob
+ * Return how many mobs there currently is
+ * 
+ * @return Used mobs
+ */
+int rg_getMobsUsed() {
+    return BUF_GET_USED(mob);
+}
+
+/**
+ * Get a mob
+ * 
+ * @param num The mob's index
+ * @return The gotten mob
+ */
+mob* rg_getMob(int num) {
+    return BUF_GET_OBJECT(mob, num);
+}
+
+/**
+ * Update every mob; What they know about the players is computed for all of
+ * them at once, before any is updated
  * 
  * @param ms Time elapse from the previous frame, in milliseconds
+ * @return GFraMe error code
  */
-void rg_updateMobs(int ms) {
-    BUF_CALL_ALL(mob, mob_update, ms);
+GFraMe_ret rg_updateMobs(int ms) {
+    GFraMe_ret rv;
+    int i;
+    
+    // Expand the perception buffer along with the mobs'
+    if (BUF_GET_USED(mob) > _rg_mobPerceptionLen) {
+        mobPerception *tmp;
+        
+        tmp = (mobPerception*)realloc(_rg_mobPerception,
+            sizeof(mobPerception) * BUF_GET_USED(mob));
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        _rg_mobPerception = tmp;
+        _rg_mobPerceptionLen = BUF_GET_USED(mob);
+    }
+    
+    mob_perceive(_rg_mobPerception, &BUF_GET_OBJECT(mob, 0),
+        BUF_GET_USED(mob));
+    
+    i = 0;
+    while (i < BUF_GET_USED(mob)) {
+        mob_update(BUF_GET_OBJECT(mob, i), _rg_mobPerception + i, ms);
+        i++;
+    }
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
 }
 
 /**
@@ -329,14 +432,26 @@ void rg_drawMobs() {
 }
 
 /**
- * Add every mob to the quadtree
+ * Add every mob updated on this frame to the quadtree (the others couldn't
+ * have moved, since they are asleep or far from the camera)
  * 
  * @return GFraMe error code
  */
 GFraMe_ret rg_qtAddMob() {
     GFraMe_ret rv;
+    int i;
     
-    BUF_CALL_ALL_RET(mob, rv, qt_addMob);
+    i = 0;
+    while (i < BUF_GET_USED(mob)) {
+        // Mobs off the camera that skipped this frame are left out of the
+        // quadtree, so nothing collides against them (e.g., bullets pass
+        // through them) until they are updated again
+        if (mob_didUpdate(BUF_GET_OBJECT(mob, i))) {
+            rv = qt_addMob(BUF_GET_OBJECT(mob, i));
+            ASSERT(rv == GFraMe_ret_ok, rv);
+        }
+        i++;
+    }
     
     rv = GFraMe_ret_ok;
 __ret:
@@ -406,3 +521,65 @@ __ret:
     return rv;
 }
 
+/**
+ * Run a step of interpolating everything in a buffer
+ * 
+ * @param TYPE The buffer's type
+ * @param PREFIX The type's functions prefix (e.g., obj, for object)
+ * @param step Which step should be run
+ * @param alpha How far into the current update
+ */
+#define RG_INTERPOLATE_ALL(TYPE, PREFIX, step, alpha) \
+    do { \
+        int i = 0; \
+        while (i < _##TYPE##_buf.used) { \
+            GFraMe_object *pObj; \
+            ipPos *pPos; \
+            PREFIX##_getObject(&pObj, _##TYPE##_buf.arr[i]); \
+            PREFIX##_getIpPos(&pPos, _##TYPE##_buf.arr[i]); \
+            ip_object(pPos, pObj, step, alpha); \
+            i++; \
+        } \
+    } while (0)
+
+/**
+ * Run a step of interpolating every mob, object and bullet (see ip_object)
+ * 
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+void rg_interpolate(ipStep step, int alpha) {
+    RG_INTERPOLATE_ALL(mob, mob, step, alpha);
+    RG_INTERPOLATE_ALL(object, obj, step, alpha);
+    RG_INTERPOLATE_ALL(bullet, bullet, step, alpha);
+}
+
+/**
+ * Save/restore a wall on a checkpoint
+ * 
+ * @param pWall The wall
+ * @param pCp The checkpoint
+ */
+static void rg_checkpointWall(wall *pWall, checkpoint *pCp) {
+    cp_field(pCp, pWall, sizeof(wall));
+}
+
+/**
+ * Save/restore every mob, object, bullet, event and wall on a checkpoint
+ * (along with how many of each are in use)
+ * 
+ * @param pCp The checkpoint
+ */
+void rg_checkpoint(checkpoint *pCp) {
+    cp_field(pCp, &BUF_GET_USED(mob), sizeof(int));
+    BUF_CALL_ALL(mob, mob_checkpoint, pCp);
+    cp_field(pCp, &BUF_GET_USED(object), sizeof(int));
+    BUF_CALL_ALL(object, obj_checkpoint, pCp);
+    cp_field(pCp, &BUF_GET_USED(bullet), sizeof(int));
+    BUF_CALL_ALL(bullet, bullet_checkpoint, pCp);
+    cp_field(pCp, &BUF_GET_USED(event), sizeof(int));
+    BUF_CALL_ALL(event, event_checkpoint, pCp);
+    cp_field(pCp, &BUF_GET_USED(wall), sizeof(int));
+    BUF_CALL_ALL(wall, rg_checkpointWall, pCp);
+}
+
@@ -10,7 +10,9 @@
 #include <GFraMe/GFraMe_object.h>
 
 #include "bullet.h"
+#include "checkpoint.h"
 #include "event.h"
+#include "interp.h"
 #include "map.h"
 #include "mob.h"
 #include "object.h"
@@ -55,11 +57,19 @@ GFraMe_ret rg_getNextEvent(event **ppE);
 void rg_pushEvent();
 
 /**
- * Add all events to the quadtree
+ * Return how many events there currently is
  * 
- * @return GFraMe error code
+ * @return Used events
+ */
+int rg_getEventsUsed();
+
+/**
+ * Get an event
+ * 
+ * @param num The event's index
+ * @return The gotten event
  */
-GFraMe_ret rg_qtAddEvents();
+event* rg_getEvent(int num);
 
 /**
  * Retrieve the next valid event (expanding the buffer as necessary)
@@ -70,9 +80,27 @@ GFraMe_ret rg_qtAddEvents();
 GFraMe_ret rg_getNextObject(object **ppO);
 
 /**
- * Push the last object (i.e, increase the counter)
+ * Push the last object (i.e, increase the counter); It's also subscribed to
+ * its variables, so it's woken whenever any of those changes
+ * 
+ * @return GFraMe error code
  */
-void rg_pushObject();
+GFraMe_ret rg_pushObject();
+
+/**
+ * Return how many objects there currently is
+ * 
+ * @return Used objects
+ */
+int rg_getObjectsUsed();
+
+/**
+ * Get an object
+ * 
+ * @param num The object's index
+ * @return The gotten object
+ */
+object* rg_getObject(int num);
 
 /**
  * Update every object
@@ -111,6 +139,13 @@ GFraMe_ret rg_getNextWall(GFraMe_object **ppWall);
  */
 void rg_pushWall();
 
+/**
+ * Remove a wall; the last wall takes its place
+ * 
+ * @param num The wall's index
+ */
+void rg_removeWall(int num);
+
 /**
  * Add every wall to the quadtree
  * 
@@ -155,11 +190,28 @@ GFraMe_ret rg_getNextMob(mob **ppM);
 void rg_pushMob();
 
 /**
- * Update every mob
+ * Return how many mobs there currently is
+ * 
+ * @return Used mobs
+ */
+int rg_getMobsUsed();
+
+/**
+ * Get a mob
+ * 
+ * @param num The mob's index
+ * @return The gotten mob
+ */
+mob* rg_getMob(int num);
+
+/**
+ * Update every mob; What they know about the players is computed for all of
+ * them at once, before any is updated
  * 
  * @param ms Time elapse from the previous frame, in milliseconds
+ * @return GFraMe error code
  */
-void rg_updateMobs(int ms);
+GFraMe_ret rg_updateMobs(int ms);
 
 /**
  * Render every mob
@@ -167,7 +219,8 @@ void rg_updateMobs(int ms);
 void rg_drawMobs();
 
 /**
- * Add every mob to the quadtree
+ * Add every mob updated on this frame to the quadtree (the others couldn't
+ * have moved, since they are asleep or far from the camera)
  * 
  * @return GFraMe error code
  */
@@ -208,5 +261,21 @@ void rg_drawBullets();
  */
 GFraMe_ret rg_qtAddBullets();
 
+/**
+ * Run a step of interpolating every mob, object and bullet (see ip_object)
+ * 
+ * @param step Which step should be run
+ * @param alpha How far into the current update, in [0, IP_ONE]
+ */
+void rg_interpolate(ipStep step, int alpha);
+
+/**
+ * Save/restore every mob, object, bullet, event and wall on a checkpoint
+ * (along with how many of each are in use)
+ * 
+ * @param pCp The checkpoint
+ */
+void rg_checkpoint(checkpoint *pCp);
+
 #endif
 
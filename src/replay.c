@@ -0,0 +1,383 @@
+/**
+ * @file src/replay.c
+ * 
+ * Record both players' inputs on every update into a file, and read them back.
+ * The file starts with a header:
+ * 
+ *   "JJRP" | version | cmd | map | number of save slots | save slots... |
+ *   number of pages | values per page | key 0 | page 0's values | key 1 | ...
+ * 
+ * (every field being a 32 bits, little-endian integer) followed by runs of
+ * identical updates, each 6 bytes long:
+ * 
+ *   count (16 bits, little-endian) | pl1 | pl2 | events | elapsed
+ * 
+ * Since both players usually hold the same buttons for many updates, a
+ * minute of gameplay takes only a few KBs.
+ */
+#include <GFraMe/GFraMe_error.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "global.h"
+#include "globalVar.h"
+#include "replay.h"
+#include "save.h"
+
+/** Version of the file format */
+#define RP_VERSION 2
+/** Longest run that may be stored */
+#define RP_MAX_RUN 0xffff
+/** Longest update that may be stored, in milliseconds */
+#define RP_MAX_ELAPSED 0xff
+
+/** An update's inputs */
+struct stRpTick {
+    int pl1;
+    int pl2;
+    int events;
+    int elapsed;
+};
+typedef struct stRpTick rpTick;
+
+/** File set to be recorded (cleared once the recording starts) */
+static char *_rp_recordFn = NULL;
+/** File currently being recorded */
+static FILE *_rp_recordFp = NULL;
+/** Events recorded since the last update */
+static int _rp_events = 0;
+/** File currently being replayed */
+static FILE *_rp_replayFp = NULL;
+/** Current run (either being recorded or replayed) */
+static rpTick _rp_run;
+/** How many updates there are on the current run */
+static int _rp_runLen = 0;
+
+/**
+ * Write a 32 bits integer, in little-endian
+ * 
+ * @param fp The file
+ * @param val The value
+ * @return GFraMe error code
+ */
+static GFraMe_ret rp_writeInt(FILE *fp, int val) {
+    unsigned char buf[4];
+    
+    buf[0] = (unsigned char)(val & 0xff);
+    buf[1] = (unsigned char)((val >> 8) & 0xff);
+    buf[2] = (unsigned char)((val >> 16) & 0xff);
+    buf[3] = (unsigned char)((val >> 24) & 0xff);
+    if (fwrite(buf, sizeof(buf), 1, fp) != 1)
+        return GFraMe_ret_failed;
+    return GFraMe_ret_ok;
+}
+
+/**
+ * Read a 32 bits integer, in little-endian
+ * 
+ * @param pVal Returns the value
+ * @param fp The file
+ * @return GFraMe error code
+ */
+static GFraMe_ret rp_readInt(int *pVal, FILE *fp) {
+    unsigned char buf[4];
+    
+    if (fread(buf, sizeof(buf), 1, fp) != 1)
+        return GFraMe_ret_failed;
+    *pVal = (int)((unsigned int)buf[0] | ((unsigned int)buf[1] << 8)
+        | ((unsigned int)buf[2] << 16) | ((unsigned int)buf[3] << 24));
+    return GFraMe_ret_ok;
+}
+
+/**
+ * Write the current run to the recorded file
+ * 
+ * @return GFraMe error code
+ */
+static GFraMe_ret rp_writeRun() {
+    unsigned char buf[6];
+    
+    if (_rp_runLen == 0)
+        return GFraMe_ret_ok;
+    
+    buf[0] = (unsigned char)(_rp_runLen & 0xff);
+    buf[1] = (unsigned char)((_rp_runLen >> 8) & 0xff);
+    buf[2] = (unsigned char)_rp_run.pl1;
+    buf[3] = (unsigned char)_rp_run.pl2;
+    buf[4] = (unsigned char)_rp_run.events;
+    buf[5] = (unsigned char)_rp_run.elapsed;
+    _rp_runLen = 0;
+    if (fwrite(buf, sizeof(buf), 1, _rp_recordFp) != 1)
+        return GFraMe_ret_failed;
+    return GFraMe_ret_ok;
+}
+
+/**
+ * Set the file where the next playstate will be recorded (only the first
+ * playstate started after this call is recorded)
+ * 
+ * @param filename The file
+ */
+void rp_setRecording(char *filename) {
+    _rp_recordFn = filename;
+}
+
+/**
+ * Start recording, if a file was set; Must be called right after the
+ * playstate was initialized
+ * 
+ * @param cmd In which mode the playstate started
+ * @param map Map where the playstate started
+ * @return GFraMe error code
+ */
+GFraMe_ret rp_beginRecording(playstateCmd cmd, int map) {
+    GFraMe_ret rv;
+    int i, j, key, num, page[GV_PAGE_LEN], slots[GV_MAX];
+    
+    // Check if there's anything to be recorded
+    ASSERT(_rp_recordFn, GFraMe_ret_ok);
+    ASSERT(!_rp_recordFp, GFraMe_ret_ok);
+    
+    _rp_recordFp = fopen(_rp_recordFn, "wb");
+    GFraMe_assertRV(_rp_recordFp, "Failed to open recording file",
+        rv = GFraMe_ret_file_not_found, __ret);
+    GFraMe_assertRV(fwrite("JJRP", 4, 1, _rp_recordFp) == 1,
+        "Failed to write recording", rv = GFraMe_ret_failed, __ret);
+    rv = rp_writeInt(_rp_recordFp, RP_VERSION);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_writeInt(_rp_recordFp, (int)cmd);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_writeInt(_rp_recordFp, map);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_writeInt(_rp_recordFp, GV_MAX);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    
+    // Store the save state (which is loaded when continuing/dying)
+    read_block(BLK_GAME, slots, GV_MAX);
+    i = 0;
+    while (i < GV_MAX) {
+        rv = rp_writeInt(_rp_recordFp, slots[i]);
+        ASSERT_NR(rv == GFraMe_ret_ok);
+        i++;
+    }
+    // And its pages of map variables
+    num = 0;
+    while (read_page(num, &key, 0, 0) == 0)
+        num++;
+    rv = rp_writeInt(_rp_recordFp, num);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_writeInt(_rp_recordFp, GV_PAGE_LEN);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    i = 0;
+    while (i < num) {
+        read_page(i, &key, page, GV_PAGE_LEN);
+        rv = rp_writeInt(_rp_recordFp, key);
+        ASSERT_NR(rv == GFraMe_ret_ok);
+        j = 0;
+        while (j < GV_PAGE_LEN) {
+            rv = rp_writeInt(_rp_recordFp, page[j]);
+            ASSERT_NR(rv == GFraMe_ret_ok);
+            j++;
+        }
+        i++;
+    }
+    
+    _rp_events = 0;
+    _rp_runLen = 0;
+    GFraMe_log("Recording inputs to %s", _rp_recordFn);
+    // Make sure later playstates won't overwrite this one
+    _rp_recordFn = NULL;
+    rv = GFraMe_ret_ok;
+__ret:
+    if (rv != GFraMe_ret_ok && _rp_recordFp) {
+        fclose(_rp_recordFp);
+        _rp_recordFp = NULL;
+    }
+    
+    return rv;
+}
+
+/**
+ * Record an event, which will be stored along the next update
+ * 
+ * @param event The event (one of RP_EV_*)
+ */
+void rp_recordEvent(int event) {
+    if (_rp_recordFp)
+        _rp_events |= event;
+}
+
+/**
+ * Record the inputs for an update
+ * 
+ * @param pl1 Buttons pressed by player 1 (bitmask of CTR_BT_*)
+ * @param pl2 Buttons pressed by player 2 (bitmask of CTR_BT_*)
+ * @param elapsed Duration of the update, in milliseconds
+ */
+void rp_recordTick(int pl1, int pl2, int elapsed) {
+    if (!_rp_recordFp)
+        return;
+    
+    if (elapsed > RP_MAX_ELAPSED)
+        elapsed = RP_MAX_ELAPSED;
+    
+    // Start a new run whenever anything changes
+    if (_rp_runLen > 0 && (_rp_runLen >= RP_MAX_RUN || _rp_run.pl1 != pl1
+            || _rp_run.pl2 != pl2 || _rp_run.events != _rp_events
+            || _rp_run.elapsed != elapsed)) {
+        if (rp_writeRun() != GFraMe_ret_ok) {
+            GFraMe_log("Failed to write recording, stopping it");
+            rp_endRecording();
+            return;
+        }
+    }
+    
+    _rp_run.pl1 = pl1;
+    _rp_run.pl2 = pl2;
+    _rp_run.events = _rp_events;
+    _rp_run.elapsed = elapsed;
+    _rp_runLen++;
+    _rp_events = 0;
+}
+
+/**
+ * Stop recording (if it was recording) and close the file
+ */
+void rp_endRecording() {
+    if (!_rp_recordFp)
+        return;
+    
+    rp_writeRun();
+    fclose(_rp_recordFp);
+    _rp_recordFp = NULL;
+}
+
+/**
+ * Open a recorded file and restore the save state where it started
+ * 
+ * @param pCmd Returns in which mode the playstate started
+ * @param pMap Returns the map where the playstate started
+ * @param filename The file
+ * @return GFraMe error code
+ */
+GFraMe_ret rp_openReplay(playstateCmd *pCmd, int *pMap, char *filename) {
+    char magic[4];
+    GFraMe_ret rv;
+    int cmd, i, j, key, num, page[GV_PAGE_LEN], slots[GV_MAX], tmp;
+    
+    // Sanitize parameters
+    ASSERT(pCmd, GFraMe_ret_bad_param);
+    ASSERT(pMap, GFraMe_ret_bad_param);
+    ASSERT(filename, GFraMe_ret_bad_param);
+    ASSERT(!_rp_replayFp, GFraMe_ret_failed);
+    
+    _rp_replayFp = fopen(filename, "rb");
+    GFraMe_assertRV(_rp_replayFp, "Failed to open replay file",
+        rv = GFraMe_ret_file_not_found, __ret);
+    
+    GFraMe_assertRV(fread(magic, sizeof(magic), 1, _rp_replayFp) == 1
+        && memcmp(magic, "JJRP", sizeof(magic)) == 0, "Invalid replay file",
+        rv = GFraMe_ret_failed, __ret);
+    rv = rp_readInt(&tmp, _rp_replayFp);
+    GFraMe_assertRV(rv == GFraMe_ret_ok && tmp == RP_VERSION,
+        "Unsupported replay version", rv = GFraMe_ret_failed, __ret);
+    rv = rp_readInt(&cmd, _rp_replayFp);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_readInt(pMap, _rp_replayFp);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_readInt(&num, _rp_replayFp);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    GFraMe_assertRV(cmd >= NEWGAME && cmd <= MT_VERSION && num == GV_MAX,
+        "Replay recorded on an incompatible version",
+        rv = GFraMe_ret_failed, __ret);
+    
+    i = 0;
+    while (i < GV_MAX) {
+        rv = rp_readInt(&slots[i], _rp_replayFp);
+        ASSERT_NR(rv == GFraMe_ret_ok);
+        i++;
+    }
+    // Restore the save state
+    write_block(BLK_GAME, slots, GV_MAX);
+    
+    // And its pages of map variables
+    rv = rp_readInt(&num, _rp_replayFp);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    rv = rp_readInt(&tmp, _rp_replayFp);
+    ASSERT_NR(rv == GFraMe_ret_ok);
+    GFraMe_assertRV(num >= 0 && num <= 0xffff && tmp == GV_PAGE_LEN,
+        "Replay recorded on an incompatible version",
+        rv = GFraMe_ret_failed, __ret);
+    reset_pages();
+    i = 0;
+    while (i < num) {
+        rv = rp_readInt(&key, _rp_replayFp);
+        ASSERT_NR(rv == GFraMe_ret_ok);
+        j = 0;
+        while (j < GV_PAGE_LEN) {
+            rv = rp_readInt(&page[j], _rp_replayFp);
+            ASSERT_NR(rv == GFraMe_ret_ok);
+            j++;
+        }
+        write_page(key, page, GV_PAGE_LEN);
+        i++;
+    }
+    flush_block(BLK_GAME);
+    
+    *pCmd = (playstateCmd)cmd;
+    _rp_runLen = 0;
+    rv = GFraMe_ret_ok;
+__ret:
+    if (rv != GFraMe_ret_ok)
+        rp_closeReplay();
+    
+    return rv;
+}
+
+/**
+ * Retrieve the inputs for the next update
+ * 
+ * @param pPl1 Returns the buttons pressed by player 1
+ * @param pPl2 Returns the buttons pressed by player 2
+ * @param pEvents Returns the events that happened before the update
+ * @param pElapsed Returns the duration of the update, in milliseconds
+ * @return 1 if there was another update, 0 on the end of the replay
+ */
+int rp_nextTick(int *pPl1, int *pPl2, int *pEvents, int *pElapsed) {
+    unsigned char buf[6];
+    
+    if (!_rp_replayFp)
+        return 0;
+    
+    if (_rp_runLen == 0) {
+        if (fread(buf, sizeof(buf), 1, _rp_replayFp) != 1)
+            return 0;
+        _rp_runLen = (int)buf[0] | ((int)buf[1] << 8);
+        _rp_run.pl1 = buf[2];
+        _rp_run.pl2 = buf[3];
+        _rp_run.events = buf[4];
+        _rp_run.elapsed = buf[5];
+        if (_rp_runLen == 0)
+            return 0;
+    }
+    
+    *pPl1 = _rp_run.pl1;
+    *pPl2 = _rp_run.pl2;
+    *pEvents = _rp_run.events;
+    *pElapsed = _rp_run.elapsed;
+    _rp_runLen--;
+    
+    return 1;
+}
+
+/**
+ * Close the replayed file
+ */
+void rp_closeReplay() {
+    if (_rp_replayFp)
+        fclose(_rp_replayFp);
+    _rp_replayFp = NULL;
+    _rp_runLen = 0;
+}
+
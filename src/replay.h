@@ -0,0 +1,85 @@
+/**
+ * @file src/replay.h
+ * 
+ * Record both players' inputs on every update (along with the save state and
+ * map where the playstate started) into a file, so the run may be replayed
+ * later
+ */
+#ifndef __REPLAY_H_
+#define __REPLAY_H_
+
+#include <GFraMe/GFraMe_error.h>
+
+#include "playstate.h"
+
+/** Events that happen between updates and must be replayed before the next */
+#define RP_EV_DISMISS_TEXT 0x01
+#define RP_EV_RETRY        0x02
+
+/**
+ * Set the file where the next playstate will be recorded (only the first
+ * playstate started after this call is recorded)
+ * 
+ * @param filename The file
+ */
+void rp_setRecording(char *filename);
+
+/**
+ * Start recording, if a file was set; Must be called right after the
+ * playstate was initialized
+ * 
+ * @param cmd In which mode the playstate started
+ * @param map Map where the playstate started
+ * @return GFraMe error code
+ */
+GFraMe_ret rp_beginRecording(playstateCmd cmd, int map);
+
+/**
+ * Record an event, which will be stored along the next update
+ * 
+ * @param event The event (one of RP_EV_*)
+ */
+void rp_recordEvent(int event);
+
+/**
+ * Record the inputs for an update
+ * 
+ * @param pl1 Buttons pressed by player 1 (bitmask of CTR_BT_*)
+ * @param pl2 Buttons pressed by player 2 (bitmask of CTR_BT_*)
+ * @param elapsed Duration of the update, in milliseconds
+ */
+void rp_recordTick(int pl1, int pl2, int elapsed);
+
+/**
+ * Stop recording (if it was recording) and close the file
+ */
+void rp_endRecording();
+
+/**
+ * Open a recorded file and restore the save state where it started
+ * 
+ * @param pCmd Returns in which mode the playstate started
+ * @param pMap Returns the map where the playstate started
+ * @param filename The file
+ * @return GFraMe error code
+ */
+GFraMe_ret rp_openReplay(playstateCmd *pCmd, int *pMap, char *filename);
+
+/**
+ * Retrieve the inputs for the next update
+ * 
+ * @param pPl1 Returns the buttons pressed by player 1
+ * @param pPl2 Returns the buttons pressed by player 2
+ * @param pEvents Returns the events that happened before the update
+ * @param pElapsed Returns the duration of the update, in milliseconds
+ * @return 1 if there was another update, 0 on the end of the replay
+ */
+int rp_nextTick(int *pPl1, int *pPl2, int *pEvents, int *pElapsed);
+
+/**
+ * Close the replayed file
+ */
+void rp_closeReplay();
+
+#endif
+
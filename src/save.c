@@ -1,6 +1,21 @@
 #include <GFraMe/GFraMe_error.h>
 #include <GFraMe/GFraMe_save.h>
 
+#if !defined(EMCC)
+#  include <SDL2/SDL_filesystem.h>
+#  include <SDL2/SDL_mutex.h>
+#  include <SDL2/SDL_stdinc.h>
+#  include <SDL2/SDL_thread.h>
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "global.h"
 #include "globalVar.h"
 #include "save.h"
@@ -12,9 +27,343 @@ struct conf {
 };
 #undef X
 
+/** Longest path to a save file (or its temporary copy) */
+#define SV_PATH_LEN 1024
+
+/**
+ * The game block is saved twice on its file (copy A, followed by copy B), each
+ * copy being a header followed by every slot, all of those as little-endian
+ * 32 bits integers:
+ * 
+ *   "JJSV" | version | number of slots | checksum | sequence |
+ *   slot 0 | slot 1 | ...
+ * 
+ * The checksum covers the sequence and the slots, so changed slots may be
+ * written in place (followed by the new checksum and sequence). Each save goes
+ * into the copy with the oldest sequence, so if that write is interrupted the
+ * other copy still has the previous save
+ */
+#define SV_MAGIC "JJSV"
+#define SV_VERSION 2
+#define SV_HEADER_LEN 20
+#define SV_CHECKSUM_OFFSET 12
+#define SV_SEQUENCE_OFFSET 16
+/** Length of each copy of the game block */
+#define SV_IMAGE_LEN (SV_HEADER_LEN + GV_MAX * 4)
+
+/**
+ * Pages of map variables are saved on their own file, only rewritten when any
+ * page changed, also as little-endian 32 bits integers:
+ * 
+ *   "JJPG" | version | values per page | number of pages | checksum |
+ *   key 0 | page 0's values | key 1 | page 1's values | ...
+ * 
+ * Both files are replaced separately (the pages, then the game block), so
+ * there's no guarantee that they are in sync: a crash between both writes, or
+ * a torn write of the game block (which loads its previous copy), leaves the
+ * pages one save ahead of the slots
+ */
+#define SV_PAGE_MAGIC "JJPG"
+#define SV_PAGE_VERSION 1
+#define SV_PAGE_HEADER_LEN 20
+/** How many integers each page takes (its key and its values) */
+#define SV_PAGE_INTS (1 + GV_PAGE_LEN)
+/** How many pages are alloc'ed at a time */
+#define SV_PAGE_INC 8
+
 static struct conf _conf;
 static int _gameSlot[GV_MAX];
+/** Slots changed since the game block was last flushed */
+static unsigned int _gameDirty[GV_DIRTY_LEN];
+/** Every page written to the game block (see SV_PAGE_INTS) */
+static int *_gamePages;
+/** How many pages fit on _gamePages */
+static int _gamePagesLen;
+/** How many pages were written */
+static int _gamePagesUsed;
+/** Whether any page changed since the game block was last flushed */
+static int _gamePagesDirty;
+static int _confHasSave;
 static int _gameHasSave;
+static int _isVolatile;
+
+#if !defined(EMCC)
+/** Directory where GFraMe keeps the save files (SDL's pref path) */
+static char *_svPath;
+/** Thread that writes the blocks to their files */
+static SDL_Thread *_svWriter;
+/** Guards every _pending* variable and _stopWriter */
+static SDL_mutex *_svMutex;
+/** Wakes the writer when a block is flushed or when it should stop */
+static SDL_cond *_svCond;
+/** Copies of the last flushed blocks, waiting to be written */
+static struct conf _pendingConf;
+static int _pendingGame[GV_MAX];
+static unsigned int _pendingDirty[GV_DIRTY_LEN];
+static int *_pendingPages;
+static int _pendingPagesLen;
+static int _pendingPagesUsed;
+/** Whether the pages should be written along the pending game block */
+static int _pendingHasPages;
+/** Which blocks were flushed since the writer last woke up (bitmask of
+ *  1 << enBlock) */
+static int _pendingBlocks;
+/** Whether the writer should exit (after writing every pending block) */
+static int _stopWriter;
+/** Copies of the blocks being written (only touched by the writer) */
+static struct conf _writingConf;
+static int _writingGame[GV_MAX];
+static unsigned int _writingDirty[GV_DIRTY_LEN];
+static int *_writingPages;
+static int _writingPagesLen;
+static int _writingPagesUsed;
+/** Both copies on the game's file, as those were last written (only touched
+ *  by whoever writes it, i.e., the writer or whoever flushes when there's no
+ *  writer) */
+static unsigned char _gameImage[2][SV_IMAGE_LEN];
+/** Which copy has the latest save */
+static int _gameCopy;
+/** Slots that differ between both copies (i.e., the ones changed by the
+ *  latest save), which must also be written into the oldest copy */
+static unsigned int _gameCopyDirty[GV_DIRTY_LEN];
+/** Whether the game's file exists with the current layout (and both its
+ *  copies are valid), so changed slots may be written in place */
+static int _gameFileValid;
+
+static void setup_writer();
+static int commit_game(int *pGame, unsigned int *pDirty);
+static int commit_pages(int *pPages, int num);
+#endif /* !EMCC */
+
+/**
+ * Make sure a buffer of pages fits at least some pages
+ * 
+ * @param [in/out]ppPages The buffer
+ * @param [in/out]pLen How many pages fit on the buffer
+ * @param [in]num How many pages it must fit
+ * @return 0 on success, -1 on failure
+ */
+static int expand_pages(int **ppPages, int *pLen, int num) {
+    int *tmp, len;
+    
+    if (num <= *pLen)
+        return 0;
+    
+    len = num + SV_PAGE_INC;
+    tmp = (int*)realloc(*ppPages, len * SV_PAGE_INTS * sizeof(int));
+    if (!tmp)
+        return -1;
+    *ppPages = tmp;
+    *pLen = len;
+    return 0;
+}
+
+#if !defined(EMCC)
+
+/**
+ * Retrieve the full path to a file on the save directory
+ * 
+ * @param [out]dst The path
+ * @param [in]filename The file
+ * @return 0 on success, -1 if the path didn't fit
+ */
+static int get_path(char *dst, char *filename) {
+    int len;
+    
+    len = snprintf(dst, SV_PATH_LEN, "%s%s", _svPath ? _svPath : "",
+            filename);
+    if (len < 0 || len >= SV_PATH_LEN)
+        return -1;
+    return 0;
+}
+
+/**
+ * Store a 32 bits integer, in little-endian
+ * 
+ * @param [out]dst The buffer
+ * @param [in]val The value
+ */
+static void put_int(unsigned char *dst, int val) {
+    dst[0] = (unsigned char)(val & 0xff);
+    dst[1] = (unsigned char)((val >> 8) & 0xff);
+    dst[2] = (unsigned char)((val >> 16) & 0xff);
+    dst[3] = (unsigned char)((val >> 24) & 0xff);
+}
+
+/**
+ * Retrieve a 32 bits integer, in little-endian
+ * 
+ * @param [in]src The buffer
+ * @return The value
+ */
+static int get_int(unsigned char *src) {
+    return (int)((unsigned int)src[0] | ((unsigned int)src[1] << 8)
+        | ((unsigned int)src[2] << 16) | ((unsigned int)src[3] << 24));
+}
+
+/**
+ * Calculate the checksum of some serialized slots (32 bits FNV-1a)
+ * 
+ * @param [in]data The slots
+ * @param [in]len How many bytes there are
+ * @return The checksum
+ */
+static unsigned int get_checksum(unsigned char *data, int len) {
+    unsigned int hash;
+    
+    hash = 2166136261u;
+    while (len > 0) {
+        hash ^= *data;
+        hash *= 16777619u;
+        data++;
+        len--;
+    }
+    
+    return hash;
+}
+
+/**
+ * Check whether a copy of the game block is valid
+ * 
+ * @param [in]pCopy The copy
+ * @param [in]pHeader The first copy's header (both must have the same layout)
+ * @param [in]len The copy's length
+ * @return 1 if it's valid, 0 otherwise
+ */
+static int is_game_copy_valid(unsigned char *pCopy, unsigned char *pHeader,
+        int len) {
+    return memcmp(pCopy, pHeader, SV_CHECKSUM_OFFSET) == 0
+        && get_checksum(pCopy + SV_SEQUENCE_OFFSET, len - SV_SEQUENCE_OFFSET)
+        == (unsigned int)get_int(pCopy + SV_CHECKSUM_OFFSET);
+}
+
+/**
+ * Load the game block from its binary file; If the latest copy is corrupted
+ * (e.g., the game crashed while saving), the previous one is loaded
+ * 
+ * @return 0 on success, 1 if there's no file, -1 if it's invalid
+ */
+static int load_game() {
+    unsigned char header[SV_HEADER_LEN], *pData, *pCopy[2];
+    char path[SV_PATH_LEN];
+    FILE *fp;
+    int copy, gv, len, num, rv, valid[2];
+    
+    fp = 0;
+    pData = 0;
+    if (get_path(path, SAVEFILE_BIN) != 0)
+        return -1;
+    fp = fopen(path, "rb");
+    if (!fp)
+        return 1;
+    
+    GFraMe_assertRV(fread(header, SV_HEADER_LEN, 1, fp) == 1,
+        "Failed to read the save header", rv = -1, __ret);
+    GFraMe_assertRV(memcmp(header, SV_MAGIC, 4) == 0
+        && get_int(header + 4) == SV_VERSION, "Unknown save format",
+        rv = -1, __ret);
+    num = get_int(header + 8);
+    GFraMe_assertRV(num > 0 && num <= 0xffff, "Invalid number of slots",
+        rv = -1, __ret);
+    
+    /* Read both copies at once */
+    len = SV_HEADER_LEN + num * 4;
+    pData = (unsigned char*)malloc(len * 2);
+    GFraMe_assertRV(pData, "Failed to alloc the save slots", rv = -1, __ret);
+    memcpy(pData, header, SV_HEADER_LEN);
+    GFraMe_assertRV(fread(pData + SV_HEADER_LEN, len * 2 - SV_HEADER_LEN, 1,
+        fp) == 1, "Failed to read the save slots", rv = -1, __ret);
+    pCopy[0] = pData;
+    pCopy[1] = pData + len;
+    valid[0] = is_game_copy_valid(pCopy[0], header, len);
+    valid[1] = is_game_copy_valid(pCopy[1], header, len);
+    GFraMe_assertRV(valid[0] || valid[1], "Corrupted save file", rv = -1,
+        __ret);
+    
+    /* Load the latest valid copy (the sequence may wrap around) */
+    if (valid[0] && valid[1])
+        copy = ((int)((unsigned int)get_int(pCopy[1] + SV_SEQUENCE_OFFSET)
+            - (unsigned int)get_int(pCopy[0] + SV_SEQUENCE_OFFSET)) > 0)
+            ? 1 : 0;
+    else {
+        copy = valid[0] ? 0 : 1;
+        GFraMe_log("Corrupted save copy; Loading the previous save");
+    }
+    /* Variables added after the file was written keep their defaults */
+    for (gv = 0; gv < num && gv < GV_MAX; gv++)
+        _gameSlot[gv] = get_int(pCopy[copy] + SV_HEADER_LEN + gv * 4);
+    /* And it must be rewritten if the number of slots ever changes (or to
+     * repair the corrupted copy) */
+    _gameFileValid = (num == GV_MAX && valid[0] && valid[1]);
+    if (_gameFileValid) {
+        memcpy(_gameImage[0], pCopy[0], len);
+        memcpy(_gameImage[1], pCopy[1], len);
+        _gameCopy = copy;
+        memset(_gameCopyDirty, 0x0, sizeof(_gameCopyDirty));
+        for (gv = 0; gv < GV_MAX; gv++)
+            if (memcmp(pCopy[0] + SV_HEADER_LEN + gv * 4,
+                    pCopy[1] + SV_HEADER_LEN + gv * 4, 4) != 0)
+                GV_SET_DIRTY(_gameCopyDirty, gv);
+    }
+    
+    rv = 0;
+__ret:
+    if (rv != 0)
+        GFraMe_log("Ignoring invalid save file");
+    if (pData)
+        free(pData);
+    fclose(fp);
+    
+    return rv;
+}
+
+/**
+ * Load the pages of map variables from their file
+ */
+static void load_pages() {
+    unsigned char header[SV_PAGE_HEADER_LEN], *pData;
+    char path[SV_PATH_LEN];
+    FILE *fp;
+    int i, len, num;
+    
+    pData = 0;
+    if (get_path(path, PAGEFILE) != 0)
+        return;
+    fp = fopen(path, "rb");
+    if (!fp)
+        return;
+    
+    GFraMe_assertRet(fread(header, SV_PAGE_HEADER_LEN, 1, fp) == 1,
+        "Failed to read the pages header", __ret);
+    GFraMe_assertRet(memcmp(header, SV_PAGE_MAGIC, 4) == 0
+        && get_int(header + 4) == SV_PAGE_VERSION
+        && get_int(header + 8) == GV_PAGE_LEN, "Unknown pages format", __ret);
+    num = get_int(header + 12);
+    GFraMe_assertRet(num >= 0 && num <= 0xffff, "Invalid number of pages",
+        __ret);
+    
+    len = num * SV_PAGE_INTS * 4;
+    if (len > 0) {
+        pData = (unsigned char*)malloc(len);
+        GFraMe_assertRet(pData, "Failed to alloc the pages", __ret);
+        GFraMe_assertRet(fread(pData, len, 1, fp) == 1,
+            "Failed to read the pages", __ret);
+    }
+    GFraMe_assertRet(get_checksum(pData, len)
+        == (unsigned int)get_int(header + 16), "Corrupted pages file", __ret);
+    GFraMe_assertRet(expand_pages(&_gamePages, &_gamePagesLen, num) == 0,
+        "Failed to alloc the pages", __ret);
+    
+    for (i = 0; i < num * SV_PAGE_INTS; i++)
+        _gamePages[i] = get_int(pData + i * 4);
+    _gamePagesUsed = num;
+    
+__ret:
+    if (pData)
+        free(pData);
+    fclose(fp);
+}
+#endif /* !EMCC */
 
 static void setup_conf() {
     GFraMe_save sv, *pSv;
@@ -24,6 +373,8 @@ static void setup_conf() {
     rv = GFraMe_save_bind(&sv, CONFFILE);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to open conf file", __ret);
     pSv = &sv;
+    /* Check if anything other than the version is written */
+    _confHasSave = (sv.size > 50);
 
 #define X(type, name) \
     rv = GFraMe_save_read_ ## type(&sv, #name, &_conf.name); \
@@ -36,7 +387,11 @@ __ret:
         GFraMe_save_close(pSv);
 }
 
-static void setup_game() {
+#if !defined(EMCC)
+/**
+ * Read the game block from the key/value file used by older versions
+ */
+static void setup_legacy_game() {
     GFraMe_save sv, *pSv;
     int gv, rv;
     char varname[sizeof("var000")];
@@ -45,6 +400,8 @@ static void setup_game() {
     rv = GFraMe_save_bind(&sv, SAVEFILE);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to open save file", __ret);
     pSv = &sv;
+    /* Check if anything other than the version is written */
+    _gameHasSave = (sv.size > 50);
 
     memset(varname, 0x0, sizeof(varname));
     memcpy(varname, "var", 3);
@@ -63,6 +420,29 @@ __ret:
         GFraMe_save_close(pSv);
 }
 
+static void setup_game() {
+    int rv;
+    
+    rv = load_game();
+    if (rv == 0) {
+        _gameHasSave = 1;
+        load_pages();
+        return;
+    }
+    else if (rv < 0)
+        return;
+    
+    /* There's no binary file yet, so convert the previous one (if any) */
+    setup_legacy_game();
+    if (_gameHasSave) {
+        memset(_gameDirty, 0xff, sizeof(_gameDirty));
+        if (commit_game(_gameSlot, _gameDirty) == 0)
+            GFraMe_log("Converted the save file into " SAVEFILE_BIN);
+        memset(_gameDirty, 0x0, sizeof(_gameDirty));
+    }
+}
+#endif /* !EMCC */
+
 void setup_blocks() {
     /* Initialize every configuration to -1 */
     #define X(type, name) \
@@ -77,14 +457,31 @@ void setup_blocks() {
     _gameSlot[PL2_HP] = 3;
     _gameSlot[SIGL_X] = -1;
     _gameSlot[SIGL_Y] = -1;
+    memset(_gameDirty, 0x0, sizeof(_gameDirty));
+    /* Map variables only exist once they are set */
+    _gamePagesUsed = 0;
+    _gamePagesDirty = 0;
 
     /* Try to initialize both from their files */
 #if !defined(EMCC)
-    setup_conf();
-    setup_game();
+    if (!_isVolatile) {
+        _svPath = SDL_GetPrefPath(ORG, NAME);
+        if (!_svPath)
+            GFraMe_log("Couldn't find the save directory");
+        
+        setup_conf();
+        setup_game();
+        setup_writer();
+    }
 #endif
 }
 
+void setup_volatile_blocks() {
+    _isVolatile = 1;
+    _gameHasSave = 0;
+    setup_blocks();
+}
+
 void write_slot(enum enBlock block, int slot, int val) {
     switch (block) {
     case BLK_CONFIG:
@@ -103,17 +500,77 @@ void write_slot(enum enBlock block, int slot, int val) {
 }
 
 void write_block(enum enBlock block, int *val, int num) {
+    int i, tmp;
+    
     switch (block) {
     case BLK_CONFIG:
         break;
     case BLK_GAME:
-        memset(_gameSlot, 0x0, sizeof(_gameSlot));
-        if (num > sizeof(_gameSlot) / sizeof(_gameSlot[0]))
-            num = sizeof(_gameSlot) / sizeof(_gameSlot[0]);
-        memcpy(_gameSlot, val, num * sizeof(int));
+        for (i = 0; i < GV_MAX; i++) {
+            tmp = (i < num) ? val[i] : 0;
+            if (_gameSlot[i] != tmp) {
+                _gameSlot[i] = tmp;
+                GV_SET_DIRTY(_gameDirty, i);
+            }
+        }
     }
 }
 
+void write_block_slots(enum enBlock block, int *val, unsigned int *dirty,
+        int num) {
+    int i;
+    
+    switch (block) {
+    case BLK_CONFIG:
+        break;
+    case BLK_GAME:
+        if (num > GV_MAX)
+            num = GV_MAX;
+        for (i = 0; i < num; i++) {
+            if (GV_IS_DIRTY(dirty, i)) {
+                _gameSlot[i] = val[i];
+                GV_SET_DIRTY(_gameDirty, i);
+            }
+        }
+    }
+}
+
+void write_page(int key, int *val, int num) {
+    int *pPage, i;
+    
+    if (num > GV_PAGE_LEN)
+        num = GV_PAGE_LEN;
+    
+    /* Pages are only ever added (and saving is rare), so simply search it */
+    pPage = 0;
+    for (i = 0; i < _gamePagesUsed; i++) {
+        if (_gamePages[i * SV_PAGE_INTS] == key) {
+            pPage = _gamePages + i * SV_PAGE_INTS;
+            break;
+        }
+    }
+    if (!pPage) {
+        if (expand_pages(&_gamePages, &_gamePagesLen, _gamePagesUsed + 1)
+                != 0) {
+            GFraMe_log("Failed to alloc a page");
+            return;
+        }
+        pPage = _gamePages + _gamePagesUsed * SV_PAGE_INTS;
+        memset(pPage, 0x0, SV_PAGE_INTS * sizeof(int));
+        pPage[0] = key;
+        _gamePagesUsed++;
+    }
+    
+    memcpy(pPage + 1, val, num * sizeof(int));
+    _gamePagesDirty = 1;
+}
+
+void reset_pages() {
+    if (_gamePagesUsed > 0)
+        _gamePagesDirty = 1;
+    _gamePagesUsed = 0;
+}
+
 int read_slot(enum enBlock block, int slot) {
     switch (block) {
     case BLK_CONFIG:
@@ -145,7 +602,22 @@ void read_block(enum enBlock block, int *val, int num) {
     }
 }
 
-static int flush_conf() {
+int read_page(int index, int *key, int *val, int num) {
+    int *pPage;
+    
+    if (index < 0 || index >= _gamePagesUsed)
+        return -1;
+    
+    pPage = _gamePages + index * SV_PAGE_INTS;
+    *key = pPage[0];
+    if (num > GV_PAGE_LEN)
+        num = GV_PAGE_LEN;
+    if (num > 0)
+        memcpy(val, pPage + 1, num * sizeof(int));
+    return 0;
+}
+
+static int flush_conf(struct conf *pConf, char *filename) {
 #if defined(EMCC)
     return 0;
 #else
@@ -153,12 +625,12 @@ static int flush_conf() {
     int rv;
 
     pSv = 0;
-    rv = GFraMe_save_bind(&sv, CONFFILE);
+    rv = GFraMe_save_bind(&sv, filename);
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to open conf file", __ret);
     pSv = &sv;
 
 #define X(type, name) \
-    rv = GFraMe_save_write_ ## type(&sv, #name, _conf.name); \
+    rv = GFraMe_save_write_ ## type(&sv, #name, pConf->name); \
     GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to write " # name, __ret);
     SAVE_CONF_SLOTS
 #undef X
@@ -172,78 +644,438 @@ __ret:
 #endif
 }
 
-static int flush_game() {
-#if defined(EMCC)
-    return 0;
+#if !defined(EMCC)
+/**
+ * Replace a file on the save directory by another, atomically (so there's
+ * always either the previous or the new file)
+ * 
+ * @param [in]src The new file
+ * @param [in]dst The file being replaced
+ * @return 0 on success, -1 on failure
+ */
+static int replace_file(char *src, char *dst) {
+    char srcPath[SV_PATH_LEN], dstPath[SV_PATH_LEN];
+    
+    if (get_path(srcPath, src) != 0 || get_path(dstPath, dst) != 0)
+        return -1;
+#if defined(_WIN32)
+    if (!MoveFileExA(srcPath, dstPath, MOVEFILE_REPLACE_EXISTING))
+        return -1;
 #else
-    GFraMe_save sv, *pSv;
-    int gv, rv;
-    char varname[sizeof("var000")];
+    if (rename(srcPath, dstPath) != 0)
+        return -1;
+#endif
+    return 0;
+}
 
-    pSv = 0;
-    rv = GFraMe_save_bind(&sv, SAVEFILE);
-    GFraMe_assertRet(rv == GFraMe_ret_ok, "Failed to open save file", __ret);
-    pSv = &sv;
+/**
+ * Write the configuration into a temporary file and rename it over the
+ * previous one, so a crash (or a full disk) while saving never corrupts it
+ * 
+ * @param [in]pConf The configuration
+ * @return 0 on success, anything else on failure
+ */
+static int commit_conf(struct conf *pConf) {
+    char tmpPath[SV_PATH_LEN];
+    int rv;
+    
+    if (get_path(tmpPath, CONFFILE ".tmp") != 0)
+        return -1;
+    /* Start from an empty file, in case a previous write was interrupted */
+    remove(tmpPath);
+    
+    rv = flush_conf(pConf, CONFFILE ".tmp");
+    if (rv == GFraMe_ret_ok) {
+        rv = replace_file(CONFFILE ".tmp", CONFFILE);
+        if (rv != 0)
+            GFraMe_log("Failed to replace " CONFFILE);
+    }
+    
+    return rv;
+}
 
-    memset(varname, 0x0, sizeof(varname));
-    memcpy(varname, "var", 3);
-    for (gv = 0; gv < GV_MAX; gv++) {
-        varname[3] = '0' + ((gv / 100) % 10);
-        varname[4] = '0' + ((gv / 10) % 10);
-        varname[5] = '0' + (gv % 10);
+/**
+ * Write the whole game's file (i.e., both copies) into a temporary file and
+ * rename it over the previous one
+ * 
+ * @return 0 on success, -1 on failure
+ */
+static int write_game_file() {
+    char tmpPath[SV_PATH_LEN];
+    FILE *fp;
+    int rv;
+    
+    if (get_path(tmpPath, SAVEFILE_BIN ".tmp") != 0)
+        return -1;
+    fp = fopen(tmpPath, "wb");
+    if (!fp)
+        return -1;
+    rv = (fwrite(_gameImage, sizeof(_gameImage), 1, fp) == 1) ? 0 : -1;
+    if (fclose(fp) != 0)
+        rv = -1;
+    
+    if (rv == 0)
+        rv = replace_file(SAVEFILE_BIN ".tmp", SAVEFILE_BIN);
+    if (rv != 0)
+        GFraMe_log("Failed to write " SAVEFILE_BIN);
+    return rv;
+}
 
-        rv = GFraMe_save_write_int(pSv, varname, _gameSlot[gv]);
-        GFraMe_assertRet(rv == GFraMe_ret_ok, "Error writing variable", __ret);
+/**
+ * Write only the changed slots (and the checksum) of a copy into the game's
+ * file, in place
+ * 
+ * @param [in]copy Which copy is written
+ * @param [in]pDirty Bitmap of the changed slots
+ * @return 0 on success, -1 on failure
+ */
+static int write_game_slots(int copy, unsigned int *pDirty) {
+    unsigned char *pImage;
+    char path[SV_PATH_LEN];
+    FILE *fp;
+    int base, first, last, rv;
+    
+    if (get_path(path, SAVEFILE_BIN) != 0)
+        return -1;
+    fp = fopen(path, "r+b");
+    if (!fp)
+        return -1;
+    
+    pImage = _gameImage[copy];
+    base = copy * SV_IMAGE_LEN;
+    rv = 0;
+    first = 0;
+    while (rv == 0 && first < GV_MAX) {
+        if (!GV_IS_DIRTY(pDirty, first)) {
+            first++;
+            continue;
+        }
+        /* Write every consecutive changed slot at once */
+        last = first + 1;
+        while (last < GV_MAX && GV_IS_DIRTY(pDirty, last))
+            last++;
+        
+        if (fseek(fp, base + SV_HEADER_LEN + first * 4, SEEK_SET) != 0
+                || fwrite(pImage + SV_HEADER_LEN + first * 4,
+                (last - first) * 4, 1, fp) != 1)
+            rv = -1;
+        first = last;
     }
+    /* The checksum and the sequence go last, so an interrupted write is
+     * detected (and the other copy is loaded instead) */
+    if (rv == 0 && (fseek(fp, base + SV_CHECKSUM_OFFSET, SEEK_SET) != 0
+            || fwrite(pImage + SV_CHECKSUM_OFFSET, 8, 1, fp) != 1))
+        rv = -1;
+    if (fclose(fp) != 0)
+        rv = -1;
+    
+    return rv;
+}
 
-    rv = GFraMe_ret_ok;
-__ret:
-    if (pSv)
-        GFraMe_save_close(pSv);
+/**
+ * Update a copy's checksum and sequence
+ * 
+ * @param [in]pImage The copy
+ * @param [in]seq The copy's sequence
+ */
+static void seal_game_copy(unsigned char *pImage, unsigned int seq) {
+    put_int(pImage + SV_SEQUENCE_OFFSET, (int)seq);
+    put_int(pImage + SV_CHECKSUM_OFFSET, (int)get_checksum(
+            pImage + SV_SEQUENCE_OFFSET, SV_IMAGE_LEN - SV_SEQUENCE_OFFSET));
+}
 
+/**
+ * Write the game block into its file; If the file already exists, only the
+ * changed slots are written into the oldest copy (otherwise, both copies are
+ * written into a temporary file and renamed over the previous one)
+ * 
+ * @param [in]pGame The game's slots
+ * @param [in]pDirty Bitmap of the slots changed since the last write
+ * @return 0 on success, -1 on failure
+ */
+static int commit_game(int *pGame, unsigned int *pDirty) {
+    unsigned int stale[GV_DIRTY_LEN];
+    unsigned char *pImage;
+    unsigned int seq;
+    int copy, gv, i;
+    
+    seq = (unsigned int)get_int(_gameImage[_gameCopy] + SV_SEQUENCE_OFFSET)
+        + 1;
+    if (_gameFileValid) {
+        /* The oldest copy also lacks whatever the latest save changed */
+        copy = 1 - _gameCopy;
+        pImage = _gameImage[copy];
+        for (i = 0; i < GV_DIRTY_LEN; i++)
+            stale[i] = pDirty[i] | _gameCopyDirty[i];
+        for (gv = 0; gv < GV_MAX; gv++)
+            if (GV_IS_DIRTY(stale, gv))
+                put_int(pImage + SV_HEADER_LEN + gv * 4, pGame[gv]);
+        seal_game_copy(pImage, seq);
+        
+        if (write_game_slots(copy, stale) == 0) {
+            _gameCopy = copy;
+            memcpy(_gameCopyDirty, pDirty, sizeof(_gameCopyDirty));
+            return 0;
+        }
+    }
+    
+    /* Either there was no file or it couldn't be updated in place */
+    _gameFileValid = 0;
+    pImage = _gameImage[0];
+    memcpy(pImage, SV_MAGIC, 4);
+    put_int(pImage + 4, SV_VERSION);
+    put_int(pImage + 8, GV_MAX);
+    for (gv = 0; gv < GV_MAX; gv++)
+        put_int(pImage + SV_HEADER_LEN + gv * 4, pGame[gv]);
+    seal_game_copy(pImage, seq);
+    memcpy(_gameImage[1], pImage, SV_IMAGE_LEN);
+    _gameCopy = 0;
+    memset(_gameCopyDirty, 0x0, sizeof(_gameCopyDirty));
+    if (write_game_file() != 0)
+        return -1;
+    _gameFileValid = 1;
+    return 0;
+}
+
+/**
+ * Write every page of map variables into a temporary file and rename it over
+ * the previous one (the whole file is written, but it only grows as pages are
+ * set)
+ * 
+ * @param [in]pPages The pages (see SV_PAGE_INTS)
+ * @param [in]num How many pages there are
+ * @return 0 on success, -1 on failure
+ */
+static int commit_pages(int *pPages, int num) {
+    char tmpPath[SV_PATH_LEN];
+    unsigned char *pData;
+    FILE *fp;
+    int i, len, rv;
+    
+    if (get_path(tmpPath, PAGEFILE ".tmp") != 0)
+        return -1;
+    len = SV_PAGE_HEADER_LEN + num * SV_PAGE_INTS * 4;
+    pData = (unsigned char*)malloc(len);
+    if (!pData)
+        return -1;
+    
+    memcpy(pData, SV_PAGE_MAGIC, 4);
+    put_int(pData + 4, SV_PAGE_VERSION);
+    put_int(pData + 8, GV_PAGE_LEN);
+    put_int(pData + 12, num);
+    for (i = 0; i < num * SV_PAGE_INTS; i++)
+        put_int(pData + SV_PAGE_HEADER_LEN + i * 4, pPages[i]);
+    put_int(pData + 16, (int)get_checksum(pData + SV_PAGE_HEADER_LEN,
+            len - SV_PAGE_HEADER_LEN));
+    
+    rv = -1;
+    fp = fopen(tmpPath, "wb");
+    if (fp) {
+        rv = (fwrite(pData, len, 1, fp) == 1) ? 0 : -1;
+        if (fclose(fp) != 0)
+            rv = -1;
+    }
+    free(pData);
+    
+    if (rv == 0)
+        rv = replace_file(PAGEFILE ".tmp", PAGEFILE);
+    if (rv != 0)
+        GFraMe_log("Failed to write " PAGEFILE);
     return rv;
+}
+
+/**
+ * Write every flushed block to its file, merging any flush requested while
+ * writing into a single write; Only exits after writing every pending block
+ * 
+ * @param [in]pArg Unused
+ * @return Always 0
+ */
+static int writer_loop(void *pArg) {
+    int blocks, hasPages, *tmp, tmpLen;
+    
+    SDL_LockMutex(_svMutex);
+    while (1) {
+        while (!_pendingBlocks && !_stopWriter)
+            SDL_CondWait(_svCond, _svMutex);
+        if (!_pendingBlocks)
+            break;
+        
+        blocks = _pendingBlocks;
+        _pendingBlocks = 0;
+        if (blocks & (1 << BLK_CONFIG))
+            memcpy(&_writingConf, &_pendingConf, sizeof(_pendingConf));
+        if (blocks & (1 << BLK_GAME)) {
+            memcpy(_writingGame, _pendingGame, sizeof(_pendingGame));
+            memcpy(_writingDirty, _pendingDirty, sizeof(_pendingDirty));
+            memset(_pendingDirty, 0x0, sizeof(_pendingDirty));
+        }
+        /* Simply swap the buffers, since pages may take a lot of memory */
+        hasPages = _pendingHasPages;
+        if (hasPages) {
+            tmp = _writingPages;
+            tmpLen = _writingPagesLen;
+            _writingPages = _pendingPages;
+            _writingPagesLen = _pendingPagesLen;
+            _writingPagesUsed = _pendingPagesUsed;
+            _pendingPages = tmp;
+            _pendingPagesLen = tmpLen;
+            _pendingHasPages = 0;
+        }
+        SDL_UnlockMutex(_svMutex);
+        
+        if (blocks & (1 << BLK_CONFIG))
+            commit_conf(&_writingConf);
+        /* Pages go first, so a crash in between leaves the map variables
+         * ahead of the slots, instead of behind those (see SV_PAGE_MAGIC) */
+        if (hasPages)
+            commit_pages(_writingPages, _writingPagesUsed);
+        if (blocks & (1 << BLK_GAME))
+            commit_game(_writingGame, _writingDirty);
+        
+        SDL_LockMutex(_svMutex);
+    }
+    SDL_UnlockMutex(_svMutex);
+    
+    return 0;
+}
+
+/**
+ * Start the thread that writes the blocks; If it fails, blocks are written as
+ * soon as they are flushed
+ */
+static void setup_writer() {
+    _svMutex = SDL_CreateMutex();
+    GFraMe_assertRet(_svMutex, "Failed to create the save mutex", __ret);
+    _svCond = SDL_CreateCond();
+    GFraMe_assertRet(_svCond, "Failed to create the save condition", __ret);
+    
+    _pendingBlocks = 0;
+    _stopWriter = 0;
+    _svWriter = SDL_CreateThread(writer_loop, "save writer", 0);
+    GFraMe_assertRet(_svWriter, "Failed to create the save writer", __ret);
+    
+    return;
+__ret:
+    GFraMe_log("Saving synchronously");
+    if (_svCond)
+        SDL_DestroyCond(_svCond);
+    if (_svMutex)
+        SDL_DestroyMutex(_svMutex);
+    _svCond = 0;
+    _svMutex = 0;
+}
+#endif /* !EMCC */
+
+void clean_blocks() {
+#if !defined(EMCC)
+    if (_svWriter) {
+        SDL_LockMutex(_svMutex);
+        _stopWriter = 1;
+        SDL_CondSignal(_svCond);
+        SDL_UnlockMutex(_svMutex);
+        
+        SDL_WaitThread(_svWriter, 0);
+        _svWriter = 0;
+    }
+    if (_svCond)
+        SDL_DestroyCond(_svCond);
+    if (_svMutex)
+        SDL_DestroyMutex(_svMutex);
+    if (_svPath)
+        SDL_free(_svPath);
+    if (_pendingPages)
+        free(_pendingPages);
+    if (_writingPages)
+        free(_writingPages);
+    _svCond = 0;
+    _svMutex = 0;
+    _svPath = 0;
+    _pendingPages = 0;
+    _pendingPagesLen = 0;
+    _writingPages = 0;
+    _writingPagesLen = 0;
 #endif
+    if (_gamePages)
+        free(_gamePages);
+    _gamePages = 0;
+    _gamePagesLen = 0;
+    _gamePagesUsed = 0;
 }
 
 int flush_block(enum enBlock block) {
+#if !defined(EMCC)
+    int i, rv;
+#endif
+    
+    if (_isVolatile) {
+        if (block == BLK_GAME)
+            _gameHasSave = 1;
+        return 0;
+    }
+    
     switch (block) {
     case BLK_CONFIG:
-        return flush_conf();
+        _confHasSave = 1;
+        break;
     case BLK_GAME:
         _gameHasSave = 1;
-        return flush_game();
+        break;
     default:
         return -1;
     }
-}
 
-int block_has_data(enum enBlock block) {
 #if defined(EMCC)
-    return (block == BLK_GAME && _gameHasSave);
+    return 0;
 #else
-    GFraMe_save sv;
-    int rv;
+    if (!_svWriter) {
+        if (block == BLK_CONFIG)
+            return commit_conf(&_conf);
+        rv = 0;
+        if (_gamePagesDirty)
+            rv = commit_pages(_gamePages, _gamePagesUsed);
+        _gamePagesDirty = 0;
+        if (commit_game(_gameSlot, _gameDirty) != 0)
+            rv = -1;
+        memset(_gameDirty, 0x0, sizeof(_gameDirty));
+        return rv;
+    }
+
+    /* Simply replace whatever was still pending; The writer will only write
+     * the latest values */
+    SDL_LockMutex(_svMutex);
+    if (block == BLK_CONFIG)
+        memcpy(&_pendingConf, &_conf, sizeof(_conf));
+    else {
+        memcpy(_pendingGame, _gameSlot, sizeof(_gameSlot));
+        for (i = 0; i < GV_DIRTY_LEN; i++)
+            _pendingDirty[i] |= _gameDirty[i];
+        memset(_gameDirty, 0x0, sizeof(_gameDirty));
+
+        if (_gamePagesDirty && expand_pages(&_pendingPages, &_pendingPagesLen,
+                _gamePagesUsed) == 0) {
+            memcpy(_pendingPages, _gamePages,
+                    _gamePagesUsed * SV_PAGE_INTS * sizeof(int));
+            _pendingPagesUsed = _gamePagesUsed;
+            _pendingHasPages = 1;
+            _gamePagesDirty = 0;
+        }
+    }
+    _pendingBlocks |= 1 << block;
+    SDL_CondSignal(_svCond);
+    SDL_UnlockMutex(_svMutex);
+    
+    return 0;
+#endif
+}
 
+int block_has_data(enum enBlock block) {
     switch (block) {
     case BLK_CONFIG:
-        rv = GFraMe_save_bind(&sv, CONFFILE);
-        break;
+        return _confHasSave;
     case BLK_GAME:
-        if (_gameHasSave)
-            return 1;
-        rv = GFraMe_save_bind(&sv, SAVEFILE);
-        break;
+        return _gameHasSave;
     default:
         return 0;
     }
-
-    if (rv != GFraMe_ret_ok)
-        return 0;
-
-    /* Check if anything other than the version is written */
-    rv = (sv.size > 50);
-    GFraMe_save_close(&sv);
-
-    return rv;
-#endif
 }
@@ -9,6 +9,12 @@ enum enBlock {
 /** Initialize every block. */
 void setup_blocks();
 
+/**
+ * Initialize every block with its default values, without ever reading from
+ * nor writing to their files (e.g., when running headless).
+ */
+void setup_volatile_blocks();
+
 /**
  * Write the value on a block's slot into a temporary buffer. The
  * value will be ready for reading right after this call.
@@ -32,6 +38,35 @@ void write_slot(enum enBlock block, int slot, int val);
  */
 void write_block(enum enBlock block, int *val, int num);
 
+/**
+ * Write only the changed values on a block's temporary buffer (only the game
+ * block supports it). Only these values (and the ones changed by a previous
+ * 'write_block') are written by the next 'flush_block'.
+ * 
+ * @param [in]block The block.
+ * @param [in]val The values.
+ * @param [in]dirty Bitmap of the changed values (see GV_SET_DIRTY).
+ * @param [in]num How many values are in val.
+ */
+void write_block_slots(enum enBlock block, int *val, unsigned int *dirty,
+        int num);
+
+/**
+ * Write a page of map variables on the game block's temporary buffer (adding
+ * it, if it's new). Pages are saved on their own file by the next
+ * 'flush_block', which is only rewritten if any page changed.
+ * 
+ * @param [in]key The page's key.
+ * @param [in]val The values.
+ * @param [in]num How many values are in val.
+ */
+void write_page(int key, int *val, int num);
+
+/**
+ * Discard every page on the game block (e.g., when starting a new game).
+ */
+void reset_pages();
+
 /**
  * Read a block's slot.
  *
@@ -50,7 +85,24 @@ int read_slot(enum enBlock block, int slot);
 void read_block(enum enBlock block, int *val, int num);
 
 /**
- * Actually save a given block to its file.
+ * Read a page of map variables from the game block, by its position (so
+ * every page may be retrieved by reading from 0 until it fails).
+ * 
+ * @param [in]index The page's position.
+ * @param [out]key The page's key.
+ * @param [out]val The values (may be NULL, if num is 0).
+ * @param [in]num How many values should be read.
+ * @return 0 on success, -1 if there's no such page.
+ */
+int read_page(int index, int *key, int *val, int num);
+
+/**
+ * Actually save a given block to its file. The block is copied and handed to
+ * a writer thread (which only writes the latest copy, if it's flushed many
+ * times while writing), so this never blocks on the disk. If the writer
+ * couldn't be started, the block is written right away.
+ * The game block is saved in a binary file, where only the changed slots are
+ * written (unless the file doesn't exist yet).
  *
  * @param [in]block The block.
  */
@@ -58,11 +110,17 @@ int flush_block(enum enBlock block);
 
 /**
  * Check whether a given block has already had some data written to it.
+ * Answered from memory, without touching the file.
  *
  * @param [in]block The block.
  */
 int block_has_data(enum enBlock block);
 
+/**
+ * Wait until every flushed block was written and stop the writer thread.
+ */
+void clean_blocks();
+
 #define SAVE_CONF_SLOTS \
     X(int, ctr_pl1) \
     X(int, ctr_pl2) \
@@ -73,7 +131,8 @@ int block_has_data(enum enBlock block);
     X(int, ufps) \
     X(int, dfps) \
     X(int, speedrun) \
-    X(int, lang)
+    X(int, lang) \
+    X(int, maxSubsteps)
 
 enum enSaveConf {
 #define X(type, name) \
@@ -10,6 +10,7 @@
 #include "camera.h"
 #include "global.h"
 #include "globalVar.h"
+#include "profiler.h"
 #include "signal.h"
 
 /** List of possible frames */
@@ -138,9 +139,9 @@ void signal_update(int ms) {
 static void signal_intDraw(stSignal *sg) {
     ASSERT_NR(sg->state != SGNL_NONE);
     // Draw the signal's frame (mirroring it to the right"
-    GFraMe_spriteset_draw(gl_sset8x16, sg->frame, sg->x     - cam_x,
+    PROF_SPRITESET_DRAW(HUD, gl_sset8x16, sg->frame, sg->x     - cam_x,
         sg->y - cam_y, 0/*flip*/);
-    GFraMe_spriteset_draw(gl_sset8x16, sg->frame, sg->x + 8 - cam_x,
+    PROF_SPRITESET_DRAW(HUD, gl_sset8x16, sg->frame, sg->x + 8 - cam_x,
         sg->y - cam_y, 1/*flip*/);
 __ret:
     return;
@@ -154,3 +155,13 @@ void signal_draw() {
     signal_intDraw(&tmp);
 }
 
+/**
+ * Save/restore both signals on a checkpoint
+ * 
+ * @param pCp The checkpoint
+ */
+void signal_checkpoint(checkpoint *pCp) {
+    cp_field(pCp, &cur, sizeof(cur));
+    cp_field(pCp, &tmp, sizeof(tmp));
+}
+
@@ -6,6 +6,8 @@
 #ifndef __SIGNAL_H_
 #define __SIGNAL_H_
 
+#include "checkpoint.h"
+
 /**
  * Initialize this submodule
  */
@@ -36,5 +38,12 @@ void signal_update(int ms);
  */
 void signal_draw();
 
+/**
+ * Save/restore both signals on a checkpoint
+ * 
+ * @param pCp The checkpoint
+ */
+void signal_checkpoint(checkpoint *pCp);
+
 #endif
 
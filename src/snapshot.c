@@ -0,0 +1,200 @@
+/**
+ * @file src/snapshot.c
+ * 
+ * Render snapshots. Each one is simply a list of every tile drawn on a frame.
+ * Only the thread recording a frame ever touches the back snapshot and only
+ * the main thread touches the front one, so they must only be swapped while
+ * nothing is being recorded.
+ */
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_sprite.h>
+#include <GFraMe/GFraMe_spriteset.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "snapshot.h"
+
+/** How many tiles a snapshot initially fits (a screen full of 8x8 tiles plus
+ *  some more) */
+#define SN_INIT_LEN 2048
+
+/** A tile drawn on a frame */
+struct stSnCmd {
+    GFraMe_spriteset *pSset;
+    int tile;
+    int x;
+    int y;
+    int flip;
+};
+typedef struct stSnCmd snCmd;
+
+/** Every tile drawn on a frame */
+struct stSnapshot {
+    /** The tiles */
+    snCmd *cmds;
+    /** How many tiles were drawn */
+    int used;
+    /** How many tiles fit on the buffer */
+    int len;
+};
+typedef struct stSnapshot snapshot;
+
+/** Both snapshots */
+static snapshot _sn_bufs[2];
+/** Index of the snapshot being replayed (the other one is recorded) */
+static int _sn_front = 0;
+/** Whether a frame is being recorded */
+static int _sn_isRecording = 0;
+
+/**
+ * Alloc both snapshots
+ * 
+ * @return GFraMe error code
+ */
+GFraMe_ret sn_init() {
+    GFraMe_ret rv;
+    int i;
+    
+    i = 0;
+    while (i < 2) {
+        if (!_sn_bufs[i].cmds) {
+            _sn_bufs[i].cmds = (snCmd*)malloc(sizeof(snCmd) * SN_INIT_LEN);
+            ASSERT(_sn_bufs[i].cmds, GFraMe_ret_memory_error);
+            _sn_bufs[i].len = SN_INIT_LEN;
+        }
+        _sn_bufs[i].used = 0;
+        i++;
+    }
+    _sn_front = 0;
+    _sn_isRecording = 0;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Release both snapshots
+ */
+void sn_clean() {
+    int i;
+    
+    i = 0;
+    while (i < 2) {
+        if (_sn_bufs[i].cmds)
+            free(_sn_bufs[i].cmds);
+        memset(&_sn_bufs[i], 0x0, sizeof(snapshot));
+        i++;
+    }
+    _sn_isRecording = 0;
+}
+
+/**
+ * Start recording a frame into the back snapshot (discarding whatever it
+ * had)
+ */
+void sn_beginRecording() {
+    _sn_bufs[1 - _sn_front].used = 0;
+    _sn_isRecording = 1;
+}
+
+/**
+ * Stop recording a frame
+ */
+void sn_endRecording() {
+    _sn_isRecording = 0;
+}
+
+/**
+ * Swap the snapshots, so the last recorded frame may be replayed
+ */
+void sn_swap() {
+    _sn_front = 1 - _sn_front;
+}
+
+/**
+ * Replay the front snapshot
+ */
+void sn_draw() {
+    snCmd *pCmd;
+    int i;
+    
+    i = 0;
+    while (i < _sn_bufs[_sn_front].used) {
+        pCmd = &_sn_bufs[_sn_front].cmds[i];
+        GFraMe_spriteset_draw(pCmd->pSset, pCmd->tile, pCmd->x, pCmd->y,
+            pCmd->flip);
+        i++;
+    }
+}
+
+/**
+ * Draw a tile from a spriteset (or store it, if recording)
+ * 
+ * @param pSset The spriteset
+ * @param tile The tile
+ * @param x Horizontal position on the screen
+ * @param y Vertical position on the screen
+ * @param flip Whether the tile is flipped
+ * @return GFraMe error code
+ */
+GFraMe_ret sn_spritesetDraw(GFraMe_spriteset *pSset, int tile, int x, int y,
+    int flip) {
+    GFraMe_ret rv;
+    snapshot *pSn;
+    snCmd *pCmd;
+    
+    if (!_sn_isRecording)
+        return GFraMe_spriteset_draw(pSset, tile, x, y, flip);
+    
+    pSn = &_sn_bufs[1 - _sn_front];
+    // Expand the snapshot as necessary
+    if (pSn->used >= pSn->len) {
+        snCmd *tmp;
+        
+        tmp = (snCmd*)realloc(pSn->cmds, sizeof(snCmd) * pSn->len * 2);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        pSn->cmds = tmp;
+        pSn->len *= 2;
+    }
+    
+    pCmd = &pSn->cmds[pSn->used];
+    pCmd->pSset = pSset;
+    pCmd->tile = tile;
+    pCmd->x = x;
+    pCmd->y = y;
+    pCmd->flip = flip;
+    pSn->used++;
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Draw a sprite relative to the camera (or store it, if recording)
+ * 
+ * @param pSpr The sprite
+ * @param camX Camera's horizontal position
+ * @param camY Camera's vertical position
+ * @param w Camera's width
+ * @param h Camera's height
+ */
+void sn_spriteDraw(GFraMe_sprite *pSpr, int camX, int camY, int w, int h) {
+    int x, y;
+    
+    if (!_sn_isRecording) {
+        GFraMe_sprite_draw_camera(pSpr, camX, camY, w, h);
+        return;
+    }
+    
+    // Store only the tile (and only if it's on the camera)
+    x = pSpr->obj.x + pSpr->offset_x - camX;
+    y = pSpr->obj.y + pSpr->offset_y - camY;
+    if (x + pSpr->sset->tw < 0 || x > w || y + pSpr->sset->th < 0 || y > h)
+        return;
+    sn_spritesetDraw(pSpr->sset, pSpr->cur_tile, x, y, pSpr->flipped);
+}
+
@@ -0,0 +1,74 @@
+/**
+ * @file src/snapshot.h
+ * 
+ * Render snapshots. While a frame is being recorded, every tile/sprite drawn
+ * by the playstate is stored (already positioned and animated) instead of
+ * rendered, so it may be replayed later by the main thread. There are two
+ * snapshots, so one may be recorded while the other is replayed.
+ */
+#ifndef __SNAPSHOT_H_
+#define __SNAPSHOT_H_
+
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_sprite.h>
+#include <GFraMe/GFraMe_spriteset.h>
+
+/**
+ * Alloc both snapshots
+ * 
+ * @return GFraMe error code
+ */
+GFraMe_ret sn_init();
+
+/**
+ * Release both snapshots
+ */
+void sn_clean();
+
+/**
+ * Start recording a frame into the back snapshot (discarding whatever it
+ * had)
+ */
+void sn_beginRecording();
+
+/**
+ * Stop recording a frame
+ */
+void sn_endRecording();
+
+/**
+ * Swap the snapshots, so the last recorded frame may be replayed
+ */
+void sn_swap();
+
+/**
+ * Replay the front snapshot
+ */
+void sn_draw();
+
+/**
+ * Draw a tile from a spriteset (or store it, if recording)
+ * 
+ * @param pSset The spriteset
+ * @param tile The tile
+ * @param x Horizontal position on the screen
+ * @param y Vertical position on the screen
+ * @param flip Whether the tile is flipped
+ * @return GFraMe error code
+ */
+GFraMe_ret sn_spritesetDraw(GFraMe_spriteset *pSset, int tile, int x, int y,
+    int flip);
+
+/**
+ * Draw a sprite relative to the camera (or store it, if recording)
+ * 
+ * @param pSpr The sprite
+ * @param camX Camera's horizontal position
+ * @param camY Camera's vertical position
+ * @param w Camera's width
+ * @param h Camera's height
+ */
+void sn_spriteDraw(GFraMe_sprite *pSpr, int camX, int camY, int w, int h);
+
+#endif
+
@@ -210,6 +210,21 @@
 #define BUF_GET_OBJECT(TYPE, NUM) \
     _##TYPE##_buf.arr[NUM]
 
+/**
+ * Remove a object from the buffer, swapping it with the last used one (so the
+ * order of the objects isn't kept)
+ * 
+ * @param TYPE The type
+ * @param NUM The object's index
+ */
+#define BUF_REMOVE(TYPE, NUM) \
+    do { \
+        TYPE *tmp = _##TYPE##_buf.arr[NUM]; \
+        _##TYPE##_buf.used--; \
+        _##TYPE##_buf.arr[NUM] = _##TYPE##_buf.arr[_##TYPE##_buf.used]; \
+        _##TYPE##_buf.arr[_##TYPE##_buf.used] = tmp; \
+    } while (0)
+
 /**
  * Reset the buffer so it restart
  * 
@@ -0,0 +1,231 @@
+/**
+ * @file src/stressMap.c
+ * 
+ * Generator of synthetic maps, for stressing how the game scales with the
+ * number of entities
+ */
+#include <GFraMe/GFraMe_error.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bullet.h"
+#include "global.h"
+#include "registry.h"
+#include "stressMap.h"
+#include "types.h"
+
+/** Empty tile */
+#define SM_TILE_EMPTY "64,"
+/** Wall tile */
+#define SM_TILE_WALL "105,"
+/** Longest that any entity's line may be */
+#define SM_LINE_MAX 160
+/** How many lines each copy of the entities take (5 mobs, 2 objects and 2
+ *  events) */
+#define SM_LINES 9
+/** Variable shared by every door */
+#define SM_DOOR_VAR "map001_door"
+/** Variable shared by every terminal */
+#define SM_TERM_VAR "terminal001"
+
+/**
+ * Retrieve the next pseudo-random number (so every map generated with the same
+ * parameters is equal)
+ * 
+ * @param pSeed The generator's state
+ * @param max The number's upper bound (exclusive)
+ * @return A number in [0, max)
+ */
+static int sm_rand(unsigned int *pSeed, int max) {
+    *pSeed = *pSeed * 1103515245u + 12345u;
+    return (int)((*pSeed >> 8) % (unsigned int)max);
+}
+
+/**
+ * Retrieve the dimensions of a generated map
+ * 
+ * @param pCols Returns how many rooms there are on each row
+ * @param pRows Returns how many rows of rooms there are
+ * @param pParams The map's parameters
+ */
+void sm_getRooms(int *pCols, int *pRows, stressParams *pParams) {
+    int cols, rooms;
+    
+    rooms = pParams->num;
+    if (rooms < 1)
+        rooms = 1;
+    
+    cols = pParams->cols;
+    if (cols < 1) {
+        // Rooms are twice as wide as they are tall, so a square map has twice
+        // as many rows as columns
+        cols = 1;
+        while (2 * cols * cols < rooms)
+            cols++;
+    }
+    
+    *pCols = cols;
+    *pRows = (rooms + cols - 1) / cols;
+}
+
+/**
+ * Generate a map, in the same format as the map files
+ * 
+ * @param ppStr Buffer that will contain the map; It's recycled, so pBufLen
+ *              must have its current size (it's expanded as necessary)
+ * @param pLen Returns the map's length (without the NULL-terminator)
+ * @param pBufLen Buffer's final size (and initial, if ppStr isn't NULL)
+ * @param pParams The map's parameters
+ * @return GFraMe error code
+ */
+GFraMe_ret sm_generate(char **ppStr, int *pLen, int *pBufLen,
+        stressParams *pParams) {
+    char *pCur;
+    GFraMe_ret rv;
+    int cols, h, i, j, k, len, rows, w;
+    unsigned int seed;
+    
+    // Sanitize parameters
+    ASSERT(ppStr, GFraMe_ret_bad_param);
+    ASSERT(pLen, GFraMe_ret_bad_param);
+    ASSERT(pBufLen, GFraMe_ret_bad_param);
+    ASSERT(pParams, GFraMe_ret_bad_param);
+    ASSERT(pParams->num >= 0, GFraMe_ret_bad_param);
+    
+    sm_getRooms(&cols, &rows, pParams);
+    w = cols * SM_ROOM_W;
+    h = rows * SM_ROOM_H;
+    
+    // Expand the buffer as necessary (every tile takes at most 4 characters,
+    // plus a line break on each row)
+    len = 16 + h * (w * 4 + 1) + pParams->num * SM_LINES * SM_LINE_MAX;
+    if (!*ppStr || len > *pBufLen) {
+        char *tmp;
+        
+        tmp = (char*)realloc(*ppStr, len);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        *ppStr = tmp;
+        *pBufLen = len;
+    }
+    pCur = *ppStr;
+    
+    // Every room has a floor and a short wall on its left side
+    memcpy(pCur, "tm:[\n", 5);
+    pCur += 5;
+    j = 0;
+    while (j < h) {
+        i = 0;
+        while (i < w) {
+            int isWall;
+            
+            isWall = (j % SM_ROOM_H == SM_ROOM_H - 1)
+                    || (i % SM_ROOM_W == 0 && j % SM_ROOM_H < 3);
+            if (isWall) {
+                memcpy(pCur, SM_TILE_WALL, sizeof(SM_TILE_WALL) - 1);
+                pCur += sizeof(SM_TILE_WALL) - 1;
+            }
+            else {
+                memcpy(pCur, SM_TILE_EMPTY, sizeof(SM_TILE_EMPTY) - 1);
+                pCur += sizeof(SM_TILE_EMPTY) - 1;
+            }
+            i++;
+        }
+        *pCur = '\n';
+        pCur++;
+        j++;
+    }
+    memcpy(pCur, "]\n", 2);
+    pCur += 2;
+    
+    // Place a copy of every entity on each room
+    seed = pParams->seed;
+    k = 0;
+    while (k < pParams->num) {
+        int x, y;
+        
+        // Room's position, in tiles
+        x = (k % cols) * SM_ROOM_W;
+        y = (k / cols) * SM_ROOM_H;
+        
+        // Mobs are in pixels (and every mob, other than the eye, falls to the
+        // room's floor)
+        pCur += sprintf(pCur, "mob: { x:%i y:%i f:\"jumper\" }\n",
+            x * 8 + 16 + sm_rand(&seed, 88), y * 8 + 32);
+        pCur += sprintf(pCur, "mob: { x:%i y:%i f:\"eye\" }\n",
+            x * 8 + 16 + sm_rand(&seed, 88), y * 8 + 8);
+        pCur += sprintf(pCur, "mob: { x:%i y:%i f:\"charger\" }\n",
+            x * 8 + 16 + sm_rand(&seed, 88), y * 8 + 32);
+        pCur += sprintf(pCur, "mob: { x:%i y:%i f:\"phantom\" }\n",
+            x * 8 + 16 + sm_rand(&seed, 88), y * 8 + 32);
+        pCur += sprintf(pCur, "mob: { x:%i y:%i f:\"bomb\" }\n",
+            x * 8 + 16 + sm_rand(&seed, 88), y * 8 + 32);
+        
+        // Objects and events are in tiles
+        pCur += sprintf(pCur, "obj: { x:%i y:%i w:1 h:4 ce:\"ce_handle_door\" "
+            "f:\"door\"|\"static\" var:\"" SM_DOOR_VAR "\" }\n",
+            x + SM_ROOM_W - 1, y + 3);
+        pCur += sprintf(pCur, "ev: { x:%i y:%i w:2 h:2 ce:\"ce_open_door\" "
+            "int:-1 int:-1 int:-1 int:-1 t:\"is_player\"|\"on_pressed\" "
+            "var:\"" SM_DOOR_VAR "\" }\n", x + SM_ROOM_W - 4, y + 5);
+        pCur += sprintf(pCur, "obj: { x:%i y:%i w:2 h:2 ce:\"ce_set_anim_off\" "
+            "f:\"term\" var:\"" SM_TERM_VAR "\" }\n", x + 2, y + 5);
+        pCur += sprintf(pCur, "ev: { x:%i y:%i w:2 h:2 ce:\"ce_set_gv\" "
+            "int:1 int:-1 int:-1 int:-1 t:\"is_player\"|\"on_pressed\" "
+            "var:\"" SM_TERM_VAR "\" }\n", x + 2, y + 5);
+        
+        k++;
+    }
+    *pCur = '\0';
+    *pLen = (int)(pCur - *ppStr);
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
+/**
+ * Spawn an enemy projectile on each room of a generated map, each one going
+ * in a pseudo-random direction; The map must already be loaded
+ * 
+ * @param pParams The map's parameters
+ * @return GFraMe error code
+ */
+GFraMe_ret sm_spawnBullets(stressParams *pParams) {
+    GFraMe_ret rv;
+    int cols, k, rows;
+    unsigned int seed;
+    
+    // Sanitize parameters
+    ASSERT(pParams, GFraMe_ret_bad_param);
+    
+    sm_getRooms(&cols, &rows, pParams);
+    
+    // Use a different sequence than the one that placed the mobs
+    seed = ~pParams->seed;
+    k = 0;
+    while (k < pParams->num) {
+        bullet *pBul;
+        int cx, cy, dx, dy;
+        
+        cx = (k % cols) * SM_ROOM_W * 8 + 16 + sm_rand(&seed, 96);
+        cy = (k / cols) * SM_ROOM_H * 8 + 24 + sm_rand(&seed, 24);
+        dx = sm_rand(&seed, 64) - 32;
+        dy = sm_rand(&seed, 64) - 32;
+        if (dx == 0 && dy == 0)
+            dx = 1;
+        
+        rv = rg_recycleBullet(&pBul);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        rv = bullet_init(pBul, ID_ENEPROJ, cx, cy, cx + dx, cy + dy);
+        ASSERT(rv == GFraMe_ret_ok, rv);
+        
+        k++;
+    }
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    return rv;
+}
+
@@ -0,0 +1,76 @@
+/**
+ * @file src/stressMap.h
+ * 
+ * Generator of synthetic maps, for stressing how the game scales with the
+ * number of entities. The map is a grid of small rooms (each one with a floor,
+ * a door on its right side and a short wall on its left one) and every room
+ * receives a jumper, an eye, a charger, a phantom, a bomb, a door (plus the
+ * event that opens it) and a terminal (plus the event that turns it off), so
+ * the map grows along with the number of entities. An enemy projectile may
+ * also be spawned on each room.
+ * 
+ * Maps are generated as strings (in the same format as the map files), so
+ * they may be either loaded straight from memory (with map_loads) or written
+ * into a file. Since only indexed maps may declare their own variables, every
+ * door and terminal share a global variable.
+ */
+#ifndef __STRESSMAP_H_
+#define __STRESSMAP_H_
+
+#include <GFraMe/GFraMe_error.h>
+
+/** Room's width, in tiles */
+#define SM_ROOM_W 16
+/** Room's height, in tiles */
+#define SM_ROOM_H 8
+/** Where players should be spawned (inside the first room), in pixels */
+#define SM_SPAWN_X 32
+#define SM_SPAWN_Y 32
+
+/** Parameters of a generated map */
+struct stStressParams {
+    /**
+     * How many rooms (i.e., how many of each entity: jumpers, eyes, chargers,
+     * phantoms, bombs, doors, terminals and projectiles) there are
+     */
+    int num;
+    /** Rooms on each row (0 makes the map roughly square) */
+    int cols;
+    /** Seed for placing entities inside their rooms */
+    unsigned int seed;
+};
+typedef struct stStressParams stressParams;
+
+/**
+ * Retrieve the dimensions of a generated map
+ * 
+ * @param pCols Returns how many rooms there are on each row
+ * @param pRows Returns how many rows of rooms there are
+ * @param pParams The map's parameters
+ */
+void sm_getRooms(int *pCols, int *pRows, stressParams *pParams);
+
+/**
+ * Generate a map, in the same format as the map files
+ * 
+ * @param ppStr Buffer that will contain the map; It's recycled, so pBufLen
+ *              must have its current size (it's expanded as necessary)
+ * @param pLen Returns the map's length (without the NULL-terminator)
+ * @param pBufLen Buffer's final size (and initial, if ppStr isn't NULL)
+ * @param pParams The map's parameters
+ * @return GFraMe error code
+ */
+GFraMe_ret sm_generate(char **ppStr, int *pLen, int *pBufLen,
+    stressParams *pParams);
+
+/**
+ * Spawn an enemy projectile on each room of a generated map, each one going
+ * in a pseudo-random direction; The map must already be loaded
+ * 
+ * @param pParams The map's parameters
+ * @return GFraMe error code
+ */
+GFraMe_ret sm_spawnBullets(stressParams *pParams);
+
+#endif
+
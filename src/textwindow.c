@@ -7,6 +7,7 @@
 
 #include "audio.h"
 #include "global.h"
+#include "profiler.h"
 #include "textwindow.h"
 
 static char *_text;
@@ -111,7 +112,7 @@ void textWnd_draw() {
             else
                 tile = 119;
             
-            GFraMe_spriteset_draw(gl_sset8x8, tile, x, y, 0/*flipped*/);
+            PROF_SPRITESET_DRAW(TEXT, gl_sset8x8, tile, x, y, 0/*flipped*/);
             
             x += 8;
         }
@@ -127,7 +128,7 @@ void textWnd_draw() {
         
         c = _text[i];
         if (c != ' ' && c != '\n')
-            GFraMe_spriteset_draw(gl_sset8x8, c-'!', x, y, 0/*flipped*/);
+            PROF_SPRITESET_DRAW(TEXT, gl_sset8x8, c-'!', x, y, 0/*flipped*/);
         
         i++;
         x += 8;
@@ -8,6 +8,7 @@
 #include <SDL2/SDL_timer.h>
 
 #include "global.h"
+#include "profiler.h"
 #include "timer.h"
 
 static int _curTime;
@@ -45,6 +46,22 @@ void timer_update() {
     }
 }
 
+/**
+ * Advance the timer by a fixed amount, instead of by the time that actually
+ * elapsed (e.g., when running headless)
+ * 
+ * @param ms How many milliseconds should be accumulated
+ */
+void timer_step(int ms) {
+    if (_running) {
+        _curTime += ms;
+        if (_curTime >= 359999999) {
+            _curTime = 359999999;
+            _running = 0;
+        }
+    }
+}
+
 /**
  * Render the timer to the screen
  */
@@ -58,7 +75,7 @@ void timer_draw() {
     y = 7;
     i = 0;
     while (i < 12) {
-        GFraMe_spriteset_draw(gl_sset8x8, str[i], x, y, 0/*flip*/);
+        PROF_SPRITESET_DRAW(HUD, gl_sset8x8, str[i], x, y, 0/*flip*/);
         i++;
         x += 8;
     }
@@ -18,6 +18,14 @@ void timer_init(int iniTime);
  */
 void timer_update();
 
+/**
+ * Advance the timer by a fixed amount, instead of by the time that actually
+ * elapsed (e.g., when running headless)
+ * 
+ * @param ms How many milliseconds should be accumulated
+ */
+void timer_step(int ms);
+
 /**
  * Render the timer to the screen
  */
@@ -6,6 +6,7 @@
 #include <GFraMe/GFraMe_spriteset.h>
 
 #include "global.h"
+#include "profiler.h"
 #include "transition.h"
 
 /** How long a 'row-transition' should take */
@@ -170,8 +171,9 @@ void transition_draw() {
         
         tile = data[i];
         if (tile != 249) {
-            GFraMe_spriteset_draw
+            PROF_SPRITESET_DRAW
                 (
+                 TRANSITION,
                  gl_sset8x8,
                  data[i],
                  x,
@@ -201,8 +203,9 @@ void transition_drawPause() {
     y = 0;
     while (i < DATA_LEN) {
         
-        GFraMe_spriteset_draw
+        PROF_SPRITESET_DRAW
             (
+             TRANSITION,
              gl_sset8x8,
              252/*tile*/,
              x,
@@ -0,0 +1,280 @@
+/**
+ * @file src/triggerGrid.c
+ * 
+ * Static grid of every event on the current map
+ */
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_object.h>
+#include <GFraMe/GFraMe_sprite.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "event.h"
+#include "global.h"
+#include "map.h"
+#include "registry.h"
+#include "triggerGrid.h"
+#include "types.h"
+
+/** Every actor type that may trigger an event */
+#define TG_ACTORS (ID_PL | ID_MOB | ID_OBJ)
+
+/** An event on a cell */
+struct stTgEntry {
+    /** The event's index on the registry */
+    int index;
+    /** Which actor types may trigger it (ID_PL, ID_MOB and/or ID_OBJ) */
+    int actors;
+};
+typedef struct stTgEntry tgEntry;
+
+/** Grid dimensions, in cells */
+static int _tg_cols = 0;
+static int _tg_rows = 0;
+/**
+ * Where each cell's entries start on _tg_entries (the last one, at
+ * _tg_cols * _tg_rows, is how many entries there are)
+ */
+static int *_tg_cellStart = 0;
+/** How many cells fit on _tg_cellStart */
+static int _tg_cellLen = 0;
+/** Every cell's entries, one cell after the other */
+static tgEntry *_tg_entries = 0;
+/** How many entries fit on _tg_entries */
+static int _tg_entriesLen = 0;
+/** Last query that tested each event (so events on many cells are only
+ *  tested once) */
+static int *_tg_stamps = 0;
+/** How many events fit on _tg_stamps */
+static int _tg_stampsLen = 0;
+/** Current query */
+static int _tg_query = 0;
+
+/**
+ * Retrieve the cells touched by an object, clamped to the grid
+ * 
+ * @param pL Returns the leftmost column
+ * @param pT Returns the topmost row
+ * @param pR Returns the rightmost column
+ * @param pB Returns the bottommost row
+ * @param pObj The object
+ * @return Whether the object touches any cell
+ */
+static int tg_getCells(int *pL, int *pT, int *pR, int *pB,
+        GFraMe_object *pObj) {
+    int x, y;
+    
+    x = pObj->x + pObj->hitbox.cx;
+    y = pObj->y + pObj->hitbox.cy;
+    *pL = (x - pObj->hitbox.hw) >> TG_CELL_SHIFT;
+    *pT = (y - pObj->hitbox.hh) >> TG_CELL_SHIFT;
+    *pR = (x + pObj->hitbox.hw - 1) >> TG_CELL_SHIFT;
+    *pB = (y + pObj->hitbox.hh - 1) >> TG_CELL_SHIFT;
+    
+    if (*pR < 0 || *pB < 0 || *pL >= _tg_cols || *pT >= _tg_rows)
+        return 0;
+    if (*pL < 0)
+        *pL = 0;
+    if (*pT < 0)
+        *pT = 0;
+    if (*pR >= _tg_cols)
+        *pR = _tg_cols - 1;
+    if (*pB >= _tg_rows)
+        *pB = _tg_rows - 1;
+    return 1;
+}
+
+/**
+ * Retrieve which actor types may trigger an event
+ * 
+ * @param pEv The event
+ * @return The actor types (0, if none or if the event is inactive)
+ */
+static int tg_getActors(event *pEv) {
+    int actors;
+    
+    actors = 0;
+    if (event_canTrigger(pEv, ID_PL))
+        actors |= ID_PL;
+    if (event_canTrigger(pEv, ID_MOB))
+        actors |= ID_MOB;
+    if (event_canTrigger(pEv, ID_OBJ))
+        actors |= ID_OBJ;
+    return actors;
+}
+
+/**
+ * Build the grid from every event on the registry; Must be called whenever a
+ * map is loaded
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+GFraMe_ret tg_build(map *pM) {
+    GFraMe_object *pObj;
+    GFraMe_ret rv;
+    int b, cells, i, l, num, r, t, total, x, y;
+    
+    // Sanitize parameters
+    ASSERT(pM, GFraMe_ret_bad_param);
+    
+    map_getDimensions(pM, &x, &y);
+    _tg_cols = (x + (1 << TG_CELL_SHIFT) - 1) >> TG_CELL_SHIFT;
+    _tg_rows = (y + (1 << TG_CELL_SHIFT) - 1) >> TG_CELL_SHIFT;
+    if (_tg_cols < 1)
+        _tg_cols = 1;
+    if (_tg_rows < 1)
+        _tg_rows = 1;
+    cells = _tg_cols * _tg_rows;
+    num = rg_getEventsUsed();
+    
+    // Expand the buffers as necessary
+    if (cells + 1 > _tg_cellLen) {
+        int *tmp;
+        
+        tmp = (int*)realloc(_tg_cellStart, sizeof(int) * (cells + 1));
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        _tg_cellStart = tmp;
+        _tg_cellLen = cells + 1;
+    }
+    if (num > _tg_stampsLen) {
+        int *tmp;
+        
+        tmp = (int*)realloc(_tg_stamps, sizeof(int) * num);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        _tg_stamps = tmp;
+        _tg_stampsLen = num;
+    }
+    memset(_tg_cellStart, 0x0, sizeof(int) * (cells + 1));
+    memset(_tg_stamps, 0x0, sizeof(int) * _tg_stampsLen);
+    _tg_query = 0;
+    
+    // Count how many events there are on each cell
+    i = 0;
+    while (i < num) {
+        event *pEv;
+        
+        pEv = rg_getEvent(i);
+        event_getObject(&pObj, pEv);
+        if (tg_getActors(pEv) != 0 && tg_getCells(&l, &t, &r, &b, pObj)) {
+            for (y = t; y <= b; y++)
+                for (x = l; x <= r; x++)
+                    _tg_cellStart[y * _tg_cols + x]++;
+        }
+        i++;
+    }
+    
+    // Turn the counters into where each cell ends
+    total = 0;
+    i = 0;
+    while (i < cells) {
+        total += _tg_cellStart[i];
+        _tg_cellStart[i] = total;
+        i++;
+    }
+    _tg_cellStart[cells] = total;
+    
+    if (total > _tg_entriesLen) {
+        tgEntry *tmp;
+        
+        tmp = (tgEntry*)realloc(_tg_entries, sizeof(tgEntry) * total);
+        ASSERT(tmp, GFraMe_ret_memory_error);
+        _tg_entries = tmp;
+        _tg_entriesLen = total;
+    }
+    
+    // Fill every cell backward, so each one ends up pointing to its start
+    // (and its events are kept in the registry's order)
+    i = num - 1;
+    while (i >= 0) {
+        event *pEv;
+        int actors;
+        
+        pEv = rg_getEvent(i);
+        event_getObject(&pObj, pEv);
+        actors = tg_getActors(pEv);
+        if (actors != 0 && tg_getCells(&l, &t, &r, &b, pObj)) {
+            for (y = t; y <= b; y++) {
+                for (x = l; x <= r; x++) {
+                    tgEntry *pEntry;
+                    
+                    _tg_cellStart[y * _tg_cols + x]--;
+                    pEntry = _tg_entries + _tg_cellStart[y * _tg_cols + x];
+                    pEntry->index = i;
+                    pEntry->actors = actors;
+                }
+            }
+        }
+        i--;
+    }
+    
+    rv = GFraMe_ret_ok;
+__ret:
+    if (rv != GFraMe_ret_ok) {
+        // Leave an empty grid, so nothing is triggered
+        _tg_cols = 0;
+        _tg_rows = 0;
+    }
+    return rv;
+}
+
+/**
+ * Check every event on the cells touched by a sprite (and that accepts the
+ * sprite's type), triggering those it overlaps
+ * 
+ * @param pSpr The sprite
+ */
+void tg_check(GFraMe_sprite *pSpr) {
+    GFraMe_object *pObj;
+    int actor, b, l, r, t, x, y;
+    
+    actor = pSpr->id & TG_ACTORS;
+    pObj = GFraMe_sprite_get_object(pSpr);
+    ASSERT_NR(actor != 0);
+    ASSERT_NR(tg_getCells(&l, &t, &r, &b, pObj));
+    
+    _tg_query++;
+    for (y = t; y <= b; y++) {
+        for (x = l; x <= r; x++) {
+            int cell, i;
+            
+            cell = y * _tg_cols + x;
+            for (i = _tg_cellStart[cell]; i < _tg_cellStart[cell + 1]; i++) {
+                tgEntry *pEntry;
+                
+                pEntry = _tg_entries + i;
+                if (!(pEntry->actors & actor)
+                        || _tg_stamps[pEntry->index] == _tg_query)
+                    continue;
+                _tg_stamps[pEntry->index] = _tg_query;
+                
+                event_check(rg_getEvent(pEntry->index), pSpr);
+            }
+        }
+    }
+
+__ret:
+    return;
+}
+
+/**
+ * Release the grid's memory
+ */
+void tg_clean() {
+    if (_tg_cellStart)
+        free(_tg_cellStart);
+    if (_tg_entries)
+        free(_tg_entries);
+    if (_tg_stamps)
+        free(_tg_stamps);
+    _tg_cellStart = 0;
+    _tg_entries = 0;
+    _tg_stamps = 0;
+    _tg_cellLen = 0;
+    _tg_entriesLen = 0;
+    _tg_stampsLen = 0;
+    _tg_cols = 0;
+    _tg_rows = 0;
+}
+
@@ -0,0 +1,48 @@
+/**
+ * @file src/triggerGrid.h
+ * 
+ * Static grid of every event (i.e., trigger volume) on the current map. It's
+ * built only once, when the map is loaded, and queried by the actors that may
+ * trigger events (instead of inserting every event into the quadtree each
+ * frame and colliding it against everything).
+ * 
+ * Events that are already inactive when the map is loaded (or that no actor
+ * type may trigger) are never added. Each entry stores which actor types
+ * (ID_PL, ID_MOB and/or ID_OBJ) may trigger it, so a query only ever tests
+ * events that accept the querying actor.
+ */
+#ifndef __TRIGGERGRID_H_
+#define __TRIGGERGRID_H_
+
+#include <GFraMe/GFraMe_error.h>
+#include <GFraMe/GFraMe_sprite.h>
+
+#include "map.h"
+
+/** Each cell is (1 << TG_CELL_SHIFT) pixels wide (and tall) */
+#define TG_CELL_SHIFT 5
+
+/**
+ * Build the grid from every event on the registry; Must be called whenever a
+ * map is loaded
+ * 
+ * @param pM The map
+ * @return GFraMe error code
+ */
+GFraMe_ret tg_build(map *pM);
+
+/**
+ * Check every event on the cells touched by a sprite (and that accepts the
+ * sprite's type), triggering those it overlaps
+ * 
+ * @param pSpr The sprite
+ */
+void tg_check(GFraMe_sprite *pSpr);
+
+/**
+ * Release the grid's memory
+ */
+void tg_clean();
+
+#endif
+
@@ -5,242 +5,142 @@
  */
 #include <GFraMe/GFraMe_error.h>
 
-#include <stdio.h>
-#include <string.h>
-
+#include "perfectHash.h"
 #include "types.h"
 
-#define FLAGS_MAX 26
+/**
+ * Every flag that may be used on a map file and its name, as X(flag, name)
+ */
+#define T_FLAGS \
+    X(ID_STATIC, "static") \
+    X(ID_MOVABLE, "movable") \
+    X(ID_HIDDEN, "hidden") \
+    \
+    X(ID_PL1, "pl1") \
+    X(ID_PL2, "pl2") \
+    \
+    X(ID_DOOR, "door") \
+    X(ID_DOOR_HOR, "door-hor") \
+    X(ID_HEARTUP, "heartup") \
+    X(ID_HJUMP_TERM, "hjump-term") \
+    X(ID_TELEP_TERM, "telep-term") \
+    X(ID_SIGNL_TERM, "signl-term") \
+    X(ID_TERM, "term") \
+    \
+    X(ID_JUMPER, "jumper") \
+    X(ID_EYE, "eye") \
+    X(ID_EYE_LEFT, "eyel") \
+    X(ID_CHARGER, "charger") \
+    X(ID_PHANTOM, "phantom") \
+    X(ID_BOMB, "bomb") \
+    X(ID_BOSS_HEAD, "boss_head") \
+    X(ID_BOSS_WHEEL, "boss_wheel") \
+    X(ID_BOSS_TANK, "boss_tank") \
+    X(ID_BOSS_PLAT, "boss_plat") \
+    \
+    X(ID_ENEPROJ, "eneproj") \
+    X(ID_BOSSPROJ, "bossproj") \
+    X(ID_EXPLPROJ, "explproj") \
+    \
+    X(ID_NONE, "none")
 
-static char *_t_flagNames[FLAGS_MAX] = {
-    "static",
-    "movable",
-    "hidden",
-    
-    "pl1",
-    "pl2",
-    
-    "door",
-    "door-hor",
-    "heartup",
-    "hjump-term",
-    "telep-term",
-    "signl-term",
-    "term",
-    
-    "jumper",
-    "eye",
-    "eyel",
-    "charger",
-    "phantom",
-    "bomb",
-    "boss_head",
-    "boss_wheel",
-    "boss_tank",
-    "boss_plat",
-    
-    "eneproj",
-    "bossproj",
-    "explproj",
-    
-    "none"
+/**
+ * Every trigger that may be used on a map file and its name, as
+ * X(trigger, name)
+ */
+#define T_TRIGGERS \
+    X(ON_ENTER_LEFT, "on_enter_left") \
+    X(ON_ENTER_RIGHT, "on_enter_right") \
+    X(ON_ENTER_DOWN, "on_enter_down") \
+    X(ON_ENTER_UP, "on_enter_up") \
+    X(ON_ENTER, "on_enter") \
+    X(ON_PRESSED, "on_pressed") \
+    X(IS_PLAYER, "is_player") \
+    X(IS_MOB, "is_mob") \
+    X(IS_OBJ, "is_obj") \
+    X(KEEP_ACTIVE, "keep_active") \
+    X(TRIGGER_MAX, "trigger_max")
+
+static char *_t_flagNames[] = {
+#define X(val, name) \
+    name,
+    T_FLAGS
+#undef X
 };
 
+#define FLAGS_MAX ((int)(sizeof(_t_flagNames) / sizeof(_t_flagNames[0])))
+
 static flag _t_flags[FLAGS_MAX] = {
-    ID_STATIC,
-    ID_MOVABLE,
-    ID_HIDDEN,
-    
-    ID_PL1,
-    ID_PL2,
-    
-    ID_DOOR,
-    ID_DOOR_HOR,
-    ID_HEARTUP,
-    ID_HJUMP_TERM,
-    ID_TELEP_TERM,
-    ID_SIGNL_TERM,
-    ID_TERM,
-    
-    ID_JUMPER,
-    ID_EYE,
-    ID_EYE_LEFT,
-    ID_CHARGER,
-    ID_PHANTOM,
-    ID_BOMB,
-    ID_BOSS_HEAD,
-    ID_BOSS_WHEEL,
-    ID_BOSS_TANK,
-    ID_BOSS_PLAT,
-    
-    ID_ENEPROJ,
-    ID_BOSSPROJ,
-    ID_EXPLPROJ,
-    
-    ID_NONE
+#define X(val, name) \
+    val,
+    T_FLAGS
+#undef X
 };
 
-#define TRIGGERS_MAX 11
+/** Table for looking up a flag from its name */
+static perfectHash _t_flagHash;
 
-static char *_t_triggerNames[TRIGGERS_MAX] = {
-    "on_enter_left",
-    "on_enter_right",
-    "on_enter_down",
-    "on_enter_up",
-    "on_enter",
-    "on_pressed",
-    "is_player",
-    "is_mob",
-    "is_obj",
-    "keep_active",
-    "trigger_max"
+static char *_t_triggerNames[] = {
+#define X(val, name) \
+    name,
+    T_TRIGGERS
+#undef X
 };
 
+#define TRIGGERS_MAX ((int)(sizeof(_t_triggerNames) / \
+    sizeof(_t_triggerNames[0])))
+
 static trigger _t_triggers[TRIGGERS_MAX] = {
-    ON_ENTER_LEFT,
-    ON_ENTER_RIGHT,
-    ON_ENTER_DOWN,
-    ON_ENTER_UP,
-    ON_ENTER,
-    ON_PRESSED,
-    IS_PLAYER,
-    IS_MOB,
-    IS_OBJ,
-    KEEP_ACTIVE,
-    TRIGGER_MAX
+#define X(val, name) \
+    val,
+    T_TRIGGERS
+#undef X
 };
 
+/** Table for looking up a trigger from its name */
+static perfectHash _t_triggerHash;
+
 /**
- * Parse a flag from a file pointer.
+ * Retrieve a flag from its name
  * 
- * @param fp The file with the flags
- * @return The parsed flag or 0, on error
+ * @param str The flag's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The flag or 0, on error
  */
-flag t_getFlagFromFile(FILE *fp) {
+flag t_getFlagFromString(char *str, int len) {
     flag f;
-    fpos_t pos;
-    int c, i, irv;
-    
-    // Sanitize parameter
-    GFraMe_assertRV(fp, "Invalid file!", f = 0, __ret);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    GFraMe_assertRV(irv == 0, "Error getting file position!", f = 0, __ret);
+    int i;
     
-    // Check every possible flag
-    i = 0;
-    while (i < FLAGS_MAX) {
-        int len, j;
-        
-        c = fgetc(fp);
-        GFraMe_assertRV(c != EOF, "Reached end-of-file!", f = 0, __ret);
-        GFraMe_assertRV(c == '"', "Not a string!", f = 0, __ret);
-    
-        // Try to read as many character as there are in the name
-        len = strlen(_t_flagNames[i]);
-        j = 0;
-        while (j < len) {
-            int c;
-            
-            // Check that the characters match
-            c = fgetc(fp);
-            GFraMe_assertRV(c != EOF, "Reached end-of-file!", f = 0, __ret);
-            if (c != _t_flagNames[i][j])
-                break;
-            j++;
-        }
-        // Stop, if a match was found
-        if (j == len) {
-            int c;
-            // Check that the string is finished by a '"'
-            c = fgetc(fp);
-            GFraMe_assertRV(c != EOF, "Reached end-of-file!", f = 0, __ret);
-            if (c == '"')
-                break;
-        }
-
-        // Return to the string's begin
-        irv = fsetpos(fp, &pos);
-        GFraMe_assertRV(irv == 0, "Error setting file position!", f = 0, __ret);
-        
-        // Go to the next flag
-        i++;
-    }
+    // Sanitize parameters
+    GFraMe_assertRV(str, "Invalid string!", f = 0, __ret);
     
     // Check if a flag was actually found and return
-    GFraMe_assertRV(i < FLAGS_MAX, "Failed to find type", f = 0, __ret);
+    i = ph_find(&_t_flagHash, _t_flagNames, FLAGS_MAX, str, len);
+    GFraMe_assertRV(i >= 0, "Failed to find type", f = 0, __ret);
     f = _t_flags[i];
 __ret:
     return f;
 }
 
 /**
- * Parse a trigger from a file pointer.
+ * Retrieve a trigger from its name
  * 
- * @param fp The file with the triggers
- * @return The parsed trigger or 0, on error
+ * @param str The trigger's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The trigger or 0, on error
  */
-trigger t_getTriggerFromFile(FILE *fp) {
-    fpos_t pos;
-    int c, i, irv;
+trigger t_getTriggerFromString(char *str, int len) {
+    int i;
     trigger t;
     
-    // Sanitize parameter
-    GFraMe_assertRV(fp, "Invalid file!", t = 0, __ret);
-    
-    // Get the current position, to "backtrack" on error
-    irv = fgetpos(fp, &pos);
-    GFraMe_assertRV(irv == 0, "Error getting file position!", t = 0, __ret);
-    
-    // Check every possible flag
-    i = 0;
-    while (i < TRIGGERS_MAX) {
-        int len, j;
-        
-        c = fgetc(fp);
-        GFraMe_assertRV(c != EOF, "Reached end-of-file!", t = 0, __ret);
-        GFraMe_assertRV(c == '"', "Not a string!", t = 0, __ret);
-    
-        // Try to read as many character as there are in the name
-        len = strlen(_t_triggerNames[i]);
-        j = 0;
-        while (j < len) {
-            int c;
-            
-            // Check that the characters match
-            c = fgetc(fp);
-            GFraMe_assertRV(c != EOF, "Reached end-of-file!", t = 0, __ret);
-            if (c != _t_triggerNames[i][j])
-                break;
-            j++;
-        }
-        // Stop, if a match was found
-        if (j == len) {
-            int c;
-            // Check that the string is finished by a '"'
-            c = fgetc(fp);
-            GFraMe_assertRV(c != EOF, "Reached end-of-file!", t = 0, __ret);
-            if (c == '"')
-                break;
-        }
-
-        // Return to the string's begin
-        irv = fsetpos(fp, &pos);
-        GFraMe_assertRV(irv == 0, "Error setting file position!", t = 0, __ret);
-        
-        // Go to the next flag
-        i++;
-    }
+    // Sanitize parameters
+    GFraMe_assertRV(str, "Invalid string!", t = 0, __ret);
     
     // Check if a trigger was actually found and return
-    GFraMe_assertRV(i < TRIGGERS_MAX, "Failed to find type", t = 0, __ret);
+    i = ph_find(&_t_triggerHash, _t_triggerNames, TRIGGERS_MAX, str, len);
+    GFraMe_assertRV(i >= 0, "Failed to find type", t = 0, __ret);
     t = _t_triggers[i];
 __ret:
-    // Backtrack on error
-    if (t == 0)
-        fsetpos(fp, &pos);
-    
     return t;
 }
 
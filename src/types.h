@@ -113,27 +113,23 @@ enum enJjatError {
 typedef enum enJjatError jjatError;
 
 
-//#  ifdef __PARSER_H_
-
-#include <stdio.h>
-
 /**
- * Parse a flag from a file pointer.
+ * Retrieve a flag from its name
  * 
- * @param fp The file with the flags
- * @return The parsed flag or 0, on error
+ * @param str The flag's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The flag or 0, on error
  */
-flag t_getFlagFromFile(FILE *fp);
+flag t_getFlagFromString(char *str, int len);
 
 /**
- * Parse a trigger from a file pointer.
+ * Retrieve a trigger from its name
  * 
- * @param fp The file with the triggers
- * @return The parsed trigger or 0, on error
+ * @param str The trigger's name (not necessarily NULL-terminated)
+ * @param len The name's length
+ * @return The trigger or 0, on error
  */
-trigger t_getTriggerFromFile(FILE *fp);
-
-//#  endif
+trigger t_getTriggerFromString(char *str, int len);
 
 #endif
 
@@ -3,6 +3,7 @@
  */
 #include "global.h"
 #include "globalVar.h"
+#include "profiler.h"
 #include "types.h"
 #include "ui.h"
 
@@ -139,16 +140,16 @@ void ui_draw() {
     // Render every gotten itens
     x = 84;
     y = 4;
-    GFraMe_spriteset_draw(gl_sset8x16, RECT_L, x, y, 0);
+    PROF_SPRITESET_DRAW(UI, gl_sset8x16, RECT_L, x, y, 0);
     x += 8;
     i = 0;
     //while (i < 22) {
     while (i < 4) {
-        GFraMe_spriteset_draw(gl_sset8x16, RECT_C, x, y, 0);
+        PROF_SPRITESET_DRAW(UI, gl_sset8x16, RECT_C, x, y, 0);
         i++;
         x += 8;
     }
-    GFraMe_spriteset_draw(gl_sset8x16, RECT_R, x, y, 0);
+    PROF_SPRITESET_DRAW(UI, gl_sset8x16, RECT_R, x, y, 0);
     
     // Get every found item
     items = gv_getValue(ITEMS);
@@ -195,7 +196,8 @@ void ui_draw() {
  */
 static void ui_drawHearts(struct stHeartArray *pData) {
     while (pData->i < pData->l) {
-        GFraMe_spriteset_draw(gl_sset8x8, pData->tile, pData->x, pData->y, 0);
+        PROF_SPRITESET_DRAW(UI, gl_sset8x8, pData->tile, pData->x,
+            pData->y, 0);
         pData->i++;
         pData->x += pData->horInc;
         if (pData->i % pData->horMax == 0) {
@@ -214,7 +216,7 @@ static void ui_drawHearts(struct stHeartArray *pData) {
  */
 static void ui_drawItemBox(int item, int x, int y) {
     ui_drawItem(item, x + 4, y + 3);
-    GFraMe_spriteset_draw(gl_sset16x16, BOX/*tile*/, x, y, 0/*flip*/);
+    PROF_SPRITESET_DRAW(UI, gl_sset16x16, BOX/*tile*/, x, y, 0/*flip*/);
 }
 
 /**
@@ -236,6 +238,6 @@ static void ui_drawItem(int item, int x, int y) {
         // TODO Render item
         default: return;
     }
-    GFraMe_spriteset_draw(gl_sset8x8, tile, x, y, 0/*flip*/);
+    PROF_SPRITESET_DRAW(UI, gl_sset8x8, tile, x, y, 0/*flip*/);
 }
 